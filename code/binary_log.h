@@ -0,0 +1,155 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// NOTE(sbalse): Binary log format, written when O3D_BINARY_LOG is defined (see log.h) and read by the decoder in
+// tools/log_decoder.cpp. A message costs a compile-time ID of its format string and a copy of its arguments, the
+// text is only produced by the decoder.
+//
+// File layout (little endian):
+//   BinaryLogHeader
+//   records, each starting with a BinaryLogRecordType byte:
+//     Format:  u64 id, u32 length, char format[length]       (once per format string, before its first use)
+//     Message: u64 id, u64 time, u8 level, u16 size, u8 args[size]
+//     Dropped: u64 count                                     (messages lost because a log ring was full)
+//
+// The arguments are a sequence of BinaryLogArgType tags, each followed by its value. Integers are stored with
+// their own width, floating point values as doubles and strings as a u16 length and the characters.
+
+constexpr std::uint32_t BINARY_LOG_MAGIC = 0x4c44334f; // "O3DL"
+constexpr std::uint32_t BINARY_LOG_VERSION = 1;
+
+struct BinaryLogHeader
+{
+    std::uint32_t m_Magic;
+    std::uint32_t m_Version;
+    std::uint64_t m_SteadyStart; // Steady clock at the start of the log, in nanoseconds.
+    std::int64_t m_WallStart;    // Wall clock at the same moment, in nanoseconds since the UNIX epoch.
+};
+
+enum class BinaryLogRecordType : std::uint8_t
+{
+    Format = 1,
+    Message = 2,
+    Dropped = 3,
+};
+
+enum class BinaryLogArgType : std::uint8_t
+{
+    Int32,
+    UInt32,
+    Int64,
+    UInt64,
+    Double,
+    Pointer,
+    String,
+};
+
+// 64-bit FNV-1a.
+constexpr std::uint64_t HashLogFormat(const char* const format)
+{
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char* c = format; *c != '\0'; ++c)
+    {
+        hash = (hash ^ std::uint8_t(*c)) * 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+// A format string literal with its ID computed at compile time. Formats that aren't constant don't compile.
+struct LogFormatString
+{
+    const char* m_Format;
+    std::uint64_t m_Id;
+
+    template<size_t N>
+    consteval LogFormatString(const char (&format)[N]) : m_Format(format), m_Id(HashLogFormat(format)) {}
+};
+
+template<typename T>
+constexpr BinaryLogArgType GetBinaryLogArgType()
+{
+    if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>)
+    {
+        return BinaryLogArgType::String;
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+        return BinaryLogArgType::Double;
+    }
+    else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>)
+    {
+        return BinaryLogArgType::Pointer;
+    }
+    else if constexpr (std::is_enum_v<T>)
+    {
+        return GetBinaryLogArgType<std::underlying_type_t<T>>();
+    }
+    else
+    {
+        static_assert(std::is_integral_v<T>, "Unsupported log argument type.");
+        if constexpr (sizeof(T) <= 4)
+        {
+            return std::is_signed_v<T> ? BinaryLogArgType::Int32 : BinaryLogArgType::UInt32;
+        }
+        else
+        {
+            return std::is_signed_v<T> ? BinaryLogArgType::Int64 : BinaryLogArgType::UInt64;
+        }
+    }
+}
+
+// Appends one tagged argument, returns the new size. Strings are cut to the space left in the buffer.
+template<typename T>
+size_t EncodeBinaryLogArg(std::uint8_t* const buffer, const size_t capacity, size_t size, const T value)
+{
+    constexpr BinaryLogArgType type = GetBinaryLogArgType<T>();
+    if (size + 1 + sizeof(std::uint64_t) > capacity)
+    {
+        return size;
+    }
+
+    buffer[size++] = std::uint8_t(type);
+
+    if constexpr (type == BinaryLogArgType::String)
+    {
+        const char* const text = value ? value : "(null)";
+        const size_t space = capacity - size - sizeof(std::uint16_t);
+        const std::uint16_t length = std::uint16_t(std::min(std::strlen(text), std::min<size_t>(space, 0xffff)));
+        std::memcpy(buffer + size, &length, sizeof(length));
+        std::memcpy(buffer + size + sizeof(length), text, length);
+        return size + sizeof(length) + length;
+    }
+    else if constexpr (type == BinaryLogArgType::Double)
+    {
+        const double converted = double(value);
+        std::memcpy(buffer + size, &converted, sizeof(converted));
+        return size + sizeof(converted);
+    }
+    else if constexpr (type == BinaryLogArgType::Pointer)
+    {
+        std::uint64_t converted = 0;
+        if constexpr (!std::is_null_pointer_v<T>)
+        {
+            converted = std::uint64_t(reinterpret_cast<std::uintptr_t>(value));
+        }
+        std::memcpy(buffer + size, &converted, sizeof(converted));
+        return size + sizeof(converted);
+    }
+    else if constexpr (type == BinaryLogArgType::Int32 || type == BinaryLogArgType::UInt32)
+    {
+        const std::uint32_t converted = std::uint32_t(value);
+        std::memcpy(buffer + size, &converted, sizeof(converted));
+        return size + sizeof(converted);
+    }
+    else
+    {
+        const std::uint64_t converted = std::uint64_t(value);
+        std::memcpy(buffer + size, &converted, sizeof(converted));
+        return size + sizeof(converted);
+    }
+}
@@ -44,10 +44,11 @@ void UpdateCameraMatrix(
     );
 
     camera.m_CameraMatrix = proj * view;
+    camera.m_ViewMatrix = view;
+    camera.m_ProjectionMatrix = proj;
+    camera.m_FovDegrees = fovDegrees;
 }
 
-static bool g_CameraFirstClick = true;
-
 void ExportCameraMatrixToShader(
     const Camera& camera,
     const u32 shader,
@@ -62,75 +63,37 @@ void ExportCameraMatrixToShader(
     );
 }
 
-void UpdateCameraInput(Camera &camera, GLFWwindow *window, const float dt)
+void MoveCamera(Camera& camera, const glm::vec3& direction, const float dt)
 {
     const glm::vec3 right = glm::normalize(glm::cross(camera.m_Orientation, camera.m_Up));
 
-    // Handle keyboard input.
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-    {
-        camera.m_Position += (camera.m_Speed * dt) * camera.m_Orientation;
-    }
-    else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-    {
-        camera.m_Position += (-camera.m_Speed * dt) * camera.m_Orientation;
-    }
-
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-    {
-        camera.m_Position += (camera.m_Speed * dt) * -right;
-    }
-    else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-    {
-        camera.m_Position += (camera.m_Speed * dt) * right;
-    }
+    camera.m_Position += (camera.m_Speed * dt * direction.x) * right;
+    camera.m_Position += (camera.m_Speed * dt * direction.y) * camera.m_Up;
+    camera.m_Position += (camera.m_Speed * dt * direction.z) * camera.m_Orientation;
+}
 
-    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
-    {
-        camera.m_Position += (camera.m_Speed * dt) * camera.m_Up;
-    }
-    else if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
+void RotateCamera(Camera& camera, const float deltaX, const float deltaY)
+{
+    if (deltaX == 0.0f && deltaY == 0.0f)
     {
-        camera.m_Position += (-camera.m_Speed * dt) * camera.m_Up;
+        return;
     }
 
-    // Handle mouse input.
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
-    {
-        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
-
-        if (g_CameraFirstClick)
-        {
-            glfwSetCursorPos(window, (camera.m_WindowWidth / 2.0), (camera.m_WindowHeight / 2.0));
-            g_CameraFirstClick = false;
-        }
-
-        double mouseX, mouseY;
-        glfwGetCursorPos(window, &mouseX, &mouseY);
-
-        const float rotX = camera.m_Sensitivity
-            * scast<float>(mouseY - (camera.m_WindowHeight / 2.0f)) / camera.m_WindowHeight;
-        const float rotY = camera.m_Sensitivity
-            * scast<float>(mouseX - (camera.m_WindowWidth / 2.0f)) / camera.m_WindowWidth;
-
-        const glm::vec3 newOrientation = glm::rotate(
-            camera.m_Orientation,
-            glm::radians(-rotX),
-            right
-        );
+    const glm::vec3 right = glm::normalize(glm::cross(camera.m_Orientation, camera.m_Up));
 
-        if (std::abs(glm::angle(newOrientation, camera.m_Up) - glm::radians(90.0f)) <= glm::radians(85.0f))
-        {
-            camera.m_Orientation = newOrientation;
-        }
+    const float rotX = camera.m_Sensitivity * deltaY / camera.m_WindowHeight;
+    const float rotY = camera.m_Sensitivity * deltaX / camera.m_WindowWidth;
 
-        camera.m_Orientation = glm::rotate(camera.m_Orientation, glm::radians(-rotY), camera.m_Up);
+    const glm::vec3 newOrientation = glm::rotate(
+        camera.m_Orientation,
+        glm::radians(-rotX),
+        right
+    );
 
-        glfwSetCursorPos(window, (camera.m_WindowWidth / 2.0), (camera.m_WindowHeight / 2.0));
-    }
-    else if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE)
+    if (std::abs(glm::angle(newOrientation, camera.m_Up) - glm::radians(90.0f)) <= glm::radians(85.0f))
     {
-        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-        g_CameraFirstClick = true;
+        camera.m_Orientation = newOrientation;
     }
+
+    camera.m_Orientation = glm::rotate(camera.m_Orientation, glm::radians(-rotY), camera.m_Up);
 }
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
 #include "common.h"
@@ -11,7 +10,10 @@ struct Camera
     glm::vec3 m_Position;
     glm::vec3 m_Orientation = glm::vec3(0.0f, 0.0f, -1.0f);
     glm::vec3 m_Up = glm::vec3(0.0f, 1.0f, 0.0f);
-    glm::mat4 m_CameraMatrix = glm::mat4(1.0f);
+    glm::mat4 m_CameraMatrix = glm::mat4(1.0f);     // Projection * view.
+    glm::mat4 m_ViewMatrix = glm::mat4(1.0f);
+    glm::mat4 m_ProjectionMatrix = glm::mat4(1.0f);
+    float m_FovDegrees = 45.0f; // Vertical FOV of the last UpdateCameraMatrix().
 
     int m_WindowWidth;
     int m_WindowHeight;
@@ -42,4 +44,8 @@ void ExportCameraMatrixToShader(
     const char* const uniform
 );
 
-void UpdateCameraInput(Camera& camera, GLFWwindow* window, const float dt);
+// Moves the camera along its right (x), up (y) and forward (z) axes, `direction` components are in [-1, 1].
+void MoveCamera(Camera& camera, const glm::vec3& direction, const float dt);
+
+// Turns the camera by a mouse movement in pixels.
+void RotateCamera(Camera& camera, const float deltaX, const float deltaY);
@@ -0,0 +1,130 @@
+#include "core/budgets.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+static const char* GetBudgetStatisticName(const BudgetStatistic statistic)
+{
+    switch (statistic)
+    {
+    case BudgetStatistic::Mean: return "mean";
+    case BudgetStatistic::P50: return "p50";
+    case BudgetStatistic::P95: return "p95";
+    case BudgetStatistic::P99: return "p99";
+    case BudgetStatistic::Max: return "max";
+    }
+
+    return "?";
+}
+
+static double GetBudgetStatistic(const MetricSummary& summary, const BudgetStatistic statistic)
+{
+    switch (statistic)
+    {
+    case BudgetStatistic::Mean: return summary.m_Mean;
+    case BudgetStatistic::P50: return summary.m_P50;
+    case BudgetStatistic::P95: return summary.m_P95;
+    case BudgetStatistic::P99: return summary.m_P99;
+    case BudgetStatistic::Max: return summary.m_Max;
+    }
+
+    return 0.0;
+}
+
+bool LoadMetricBudgets(const char* const fileName, std::vector<MetricBudget>& outBudgets)
+{
+    std::ifstream in(fileName);
+    if (!in)
+    {
+        LOG_ERROR("Failed to open budgets: %s.", fileName);
+        return false;
+    }
+
+    outBudgets.clear();
+
+    std::string line;
+    for (u32 lineNumber = 1; std::getline(in, line); ++lineNumber)
+    {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+
+        std::string metricName;
+        std::string statisticName;
+        MetricBudget budget = {};
+        std::istringstream fields(line);
+        if (!(fields >> metricName >> statisticName >> budget.m_Limit))
+        {
+            LOG_ERROR("%s(%u): Expected \"<metric> <statistic> <limit>\".", fileName, lineNumber);
+            return false;
+        }
+
+        u32 metric = 0;
+        while (metric < scast<u32>(Metric::Count) && metricName != GetMetricName(scast<Metric>(metric)))
+        {
+            ++metric;
+        }
+
+        u32 statistic = 0;
+        while (statistic <= scast<u32>(BudgetStatistic::Max)
+            && statisticName != GetBudgetStatisticName(scast<BudgetStatistic>(statistic)))
+        {
+            ++statistic;
+        }
+
+        if (metric == scast<u32>(Metric::Count) || statistic > scast<u32>(BudgetStatistic::Max))
+        {
+            LOG_ERROR(
+                "%s(%u): Unknown metric or statistic \"%s %s\".",
+                fileName,
+                lineNumber,
+                metricName.c_str(),
+                statisticName.c_str()
+            );
+            return false;
+        }
+
+        budget.m_Metric = scast<Metric>(metric);
+        budget.m_Statistic = scast<BudgetStatistic>(statistic);
+        outBudgets.push_back(budget);
+    }
+
+    return true;
+}
+
+bool CheckMetricBudgets(const std::vector<MetricBudget>& budgets)
+{
+    if (GetMetricsFrameCount() == 0)
+    {
+        LOG_ERROR("No frames were measured, the budgets can't be checked.");
+        return false;
+    }
+
+    u32 exceeded = 0;
+    for (const MetricBudget& budget : budgets)
+    {
+        const double value = GetBudgetStatistic(GetMetricSummary(budget.m_Metric), budget.m_Statistic);
+        if (value > budget.m_Limit)
+        {
+            LOG_ERROR(
+                "Over budget: %s %s is %.3f, the budget is %.3f.",
+                GetMetricName(budget.m_Metric),
+                GetBudgetStatisticName(budget.m_Statistic),
+                value,
+                budget.m_Limit
+            );
+            exceeded++;
+        }
+    }
+
+    if (exceeded > 0)
+    {
+        return false;
+    }
+
+    LOG_INFO("All %zu budgets are met over %u frames.", budgets.size(), GetMetricsFrameCount());
+    return true;
+}
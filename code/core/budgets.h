@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include "common.h"
+#include "core/metrics.h"
+
+// Upper limits on the metrics of a run, e.g. the p95 frame time or the largest number of draw calls per frame.
+// Budget files have one budget per line: "<metric> <statistic> <limit>", where the metric is named as in the
+// metrics exports and the statistic is one of mean, p50, p95, p99 or max. Empty lines and lines starting with '#'
+// are skipped.
+
+enum class BudgetStatistic : u32
+{
+    Mean,
+    P50,
+    P95,
+    P99,
+    Max,
+};
+
+struct MetricBudget
+{
+    Metric m_Metric;
+    BudgetStatistic m_Statistic;
+    double m_Limit;
+};
+
+bool LoadMetricBudgets(const char* const fileName, std::vector<MetricBudget>& outBudgets);
+
+// Checks the budgets against the metrics window and logs every one that is exceeded. Returns false if any is.
+bool CheckMetricBudgets(const std::vector<MetricBudget>& budgets);
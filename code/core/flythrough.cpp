@@ -0,0 +1,124 @@
+#include "core/flythrough.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "core/profiler.h"
+
+void RecordFlythroughFrame(
+    FlythroughRecorder& recorder,
+    const u64 profilerFrame,
+    const double time,
+    const glm::vec3& cameraPosition)
+{
+    if (!recorder.m_Frames.empty())
+    {
+        GetLastFrameMetrics(recorder.m_Frames.back().m_Metrics);
+    }
+
+    FlythroughFrame& frame = recorder.m_Frames.emplace_back();
+    frame.m_ProfilerFrame = profilerFrame;
+    frame.m_Time = time;
+    frame.m_CameraPosition = cameraPosition;
+    frame.m_GpuMs = -1.0;
+}
+
+static void CopyFlythroughGpuTimes(FlythroughRecorder& recorder, const bool final)
+{
+    const u64 currentFrame = GetProfilerFrameIndex();
+    while (recorder.m_FirstPendingGpu < recorder.m_Frames.size())
+    {
+        FlythroughFrame& frame = recorder.m_Frames[recorder.m_FirstPendingGpu];
+
+        u64 gpuTime = 0;
+        if (GetProfilerGpuFrameTime(frame.m_ProfilerFrame, gpuTime))
+        {
+            frame.m_GpuMs = scast<double>(gpuTime) / 1000000.0;
+        }
+        else if (!final && frame.m_ProfilerFrame + PROFILER_GPU_LATENCY >= currentFrame)
+        {
+            break; // Still in flight.
+        }
+
+        recorder.m_FirstPendingGpu++;
+    }
+}
+
+void UpdateFlythroughGpuTimes(FlythroughRecorder& recorder)
+{
+    CopyFlythroughGpuTimes(recorder, false);
+}
+
+void FinishFlythrough(FlythroughRecorder& recorder)
+{
+    if (!recorder.m_Frames.empty())
+    {
+        GetLastFrameMetrics(recorder.m_Frames.back().m_Metrics);
+    }
+
+    FlushProfilerGpuFrames();
+    CopyFlythroughGpuTimes(recorder, true);
+}
+
+bool SaveFlythroughCsv(const FlythroughRecorder& recorder, const char* const fileName)
+{
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out)
+    {
+        LOG_ERROR("Failed to open file for writing: %s.", fileName);
+        return false;
+    }
+
+    out << "frame,time_s,camera_x,camera_y,camera_z";
+    for (u32 i = 0; i < scast<u32>(Metric::Count); ++i)
+    {
+        out << ',' << GetMetricName(scast<Metric>(i));
+    }
+    out << ",gpu_ms\n";
+
+    char value[64];
+    for (size_t index = 0; index < recorder.m_Frames.size(); ++index)
+    {
+        const FlythroughFrame& frame = recorder.m_Frames[index];
+
+        snprintf(
+            value,
+            sizeof(value),
+            "%zu,%.4f,%.4f,%.4f,%.4f",
+            index,
+            frame.m_Time,
+            frame.m_CameraPosition.x,
+            frame.m_CameraPosition.y,
+            frame.m_CameraPosition.z
+        );
+        out << value;
+
+        for (u32 i = 0; i < scast<u32>(Metric::Count); ++i)
+        {
+            snprintf(value, sizeof(value), IsTimeMetric(scast<Metric>(i)) ? ",%.4f" : ",%.0f", frame.m_Metrics[i]);
+            out << value;
+        }
+
+        // Frames without GPU timings leave the column empty.
+        if (frame.m_GpuMs >= 0.0)
+        {
+            snprintf(value, sizeof(value), ",%.4f", frame.m_GpuMs);
+            out << value;
+        }
+        else
+        {
+            out << ',';
+        }
+        out << '\n';
+    }
+
+    if (!out)
+    {
+        LOG_ERROR("Failed to write the flythrough results: %s.", fileName);
+        return false;
+    }
+
+    LOG_INFO("Saved %zu flythrough frames to \"%s\".", recorder.m_Frames.size(), fileName);
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "common.h"
+#include "core/metrics.h"
+
+// Per-frame results of a scripted benchmark run. Every frame copies the metrics of the frame before it, whose snapshot
+// has just been drawn, and waits for the GPU time of its profiler frame, which arrives a few frames later. The rows are saved as CSV once the run is over, so
+// nothing is written to disk while it is measured.
+struct FlythroughFrame
+{
+    u64 m_ProfilerFrame;
+    double m_Time;                                  // Simulation seconds.
+    glm::vec3 m_CameraPosition;
+    double m_Metrics[scast<u32>(Metric::Count)];
+    double m_GpuMs;                                 // Negative until it is known, or if it never arrives.
+};
+
+struct FlythroughRecorder
+{
+    std::vector<FlythroughFrame> m_Frames;
+    u32 m_FirstPendingGpu = 0; // Frames before it have their GPU time.
+};
+
+// Call after EndMetricsFrame() with the index the profiler frame had before EndProfilerFrame(). The metrics of the
+// frame are copied by the next call, or by FinishFlythrough().
+void RecordFlythroughFrame(
+    FlythroughRecorder& recorder,
+    const u64 profilerFrame,
+    const double time,
+    const glm::vec3& cameraPosition
+);
+
+// Copies the GPU times that have arrived. Frames older than the profiler keeps queries for are given up on.
+void UpdateFlythroughGpuTimes(FlythroughRecorder& recorder);
+
+// Waits for the GPU and copies the GPU times of all frames, at the end of the run. Call after EndMetricsRenderFrame(),
+// so the last frame gets its metrics.
+void FinishFlythrough(FlythroughRecorder& recorder);
+
+bool SaveFlythroughCsv(const FlythroughRecorder& recorder, const char* const fileName);
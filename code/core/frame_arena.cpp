@@ -0,0 +1,208 @@
+#include "core/frame_arena.h"
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+
+#include "core/jobs.h"
+#include "core/metrics.h"
+
+// Arena memory and heap fallbacks are aligned to this, so is the largest alignment an allocation can ask for.
+constexpr u64 FRAME_ARENA_ALIGNMENT = 64;
+// Growth is rounded up to this, so a frame a few bytes over the high-water mark doesn't grow the arena again.
+constexpr u64 FRAME_ARENA_GROW_GRANULARITY = 64 * 1024;
+
+// One thread's memory for one frame. Aligned to a cache line so workers never write to the same one.
+struct alignas(64) FrameArena
+{
+    u8* m_Base = nullptr;
+    u64 m_Capacity = 0;
+    u64 m_Offset = 0;
+    u64 m_HeapBytes = 0;           // Allocated on the heap since the reset, counted as if they fit.
+    u64 m_HighWater = 0;           // Most bytes used in any frame before this one.
+    u32 m_HeapAllocations = 0;
+    std::vector<void*> m_HeapBlocks; // Freed on the next reset.
+};
+
+struct FrameArenaState
+{
+    // FRAME_ARENA_FRAMES rows of one arena per job worker, plus the shared arena at the end of each row.
+    std::vector<FrameArena> m_Arenas;
+    u32 m_ThreadCount = 0;
+    u32 m_Frame = 0;
+    u32 m_GrowCount = 0;
+    std::mutex m_SharedMutex;
+};
+
+static FrameArenaState g_FrameArena;
+
+static u8* AllocateArenaBlock(const u64 size)
+{
+    return scast<u8*>(::operator new(size, std::align_val_t(FRAME_ARENA_ALIGNMENT)));
+}
+
+static void FreeArenaBlock(void* const block)
+{
+    ::operator delete(block, std::align_val_t(FRAME_ARENA_ALIGNMENT));
+}
+
+static FrameArena& GetFrameArena(const u32 frame, const u32 thread)
+{
+    return g_FrameArena.m_Arenas[frame * g_FrameArena.m_ThreadCount + thread];
+}
+
+static void* AllocateFromArena(FrameArena& arena, const u64 size, const u64 alignment)
+{
+    const u64 offset = (arena.m_Offset + alignment - 1) & ~(alignment - 1);
+    if (offset + size <= arena.m_Capacity)
+    {
+        arena.m_Offset = offset + size;
+        return arena.m_Base + offset;
+    }
+
+    // Too large for the rest of the arena this frame. The padding is counted too, so the grown arena fits it.
+    void* const block = AllocateArenaBlock(size);
+    arena.m_HeapBlocks.push_back(block);
+    arena.m_HeapBytes += size + alignment;
+    arena.m_HeapAllocations++;
+    return block;
+}
+
+static void ResetFrameArena(FrameArena& arena)
+{
+    arena.m_HighWater = std::max(arena.m_HighWater, arena.m_Offset + arena.m_HeapBytes);
+
+    for (void* const block : arena.m_HeapBlocks)
+    {
+        FreeArenaBlock(block);
+    }
+    arena.m_HeapBlocks.clear();
+
+    // The frame didn't fit, make room for the most any frame needed. The old contents are dead already.
+    if (arena.m_HeapBytes > 0)
+    {
+        const u64 capacity = (arena.m_HighWater + FRAME_ARENA_GROW_GRANULARITY - 1)
+            & ~(FRAME_ARENA_GROW_GRANULARITY - 1);
+        FreeArenaBlock(arena.m_Base);
+        arena.m_Base = AllocateArenaBlock(capacity);
+        arena.m_Capacity = capacity;
+        g_FrameArena.m_GrowCount++;
+    }
+
+    arena.m_Offset = 0;
+    arena.m_HeapBytes = 0;
+    arena.m_HeapAllocations = 0;
+}
+
+void InitializeFrameArena(const u64 bytesPerThread)
+{
+    g_FrameArena.m_ThreadCount = GetJobWorkerCount() + 1;
+    g_FrameArena.m_Frame = 0;
+    g_FrameArena.m_GrowCount = 0;
+    g_FrameArena.m_Arenas = std::vector<FrameArena>(FRAME_ARENA_FRAMES * g_FrameArena.m_ThreadCount);
+
+    const u64 capacity = std::max<u64>(bytesPerThread, FRAME_ARENA_ALIGNMENT);
+    for (FrameArena& arena : g_FrameArena.m_Arenas)
+    {
+        arena.m_Base = AllocateArenaBlock(capacity);
+        arena.m_Capacity = capacity;
+    }
+
+    LOG_INFO(
+        "Frame arena: %u threads x %u frames x %llu KB.",
+        g_FrameArena.m_ThreadCount,
+        FRAME_ARENA_FRAMES,
+        scast<unsigned long long>(capacity / 1024)
+    );
+}
+
+void ShutdownFrameArena()
+{
+    if (g_FrameArena.m_ThreadCount == 0)
+    {
+        return;
+    }
+
+    const FrameArenaStats stats = GetFrameArenaStats();
+    LOG_INFO(
+        "Frame arena high-water mark: %llu bytes of %llu KB per arena, grown %u times.",
+        scast<unsigned long long>(stats.m_HighWaterBytes),
+        scast<unsigned long long>(stats.m_CapacityBytes / g_FrameArena.m_Arenas.size() / 1024),
+        stats.m_GrowCount
+    );
+
+    for (const FrameArena& arena : g_FrameArena.m_Arenas)
+    {
+        for (void* const block : arena.m_HeapBlocks)
+        {
+            FreeArenaBlock(block);
+        }
+        FreeArenaBlock(arena.m_Base);
+    }
+
+    g_FrameArena.m_Arenas.clear();
+    g_FrameArena.m_ThreadCount = 0;
+}
+
+void AdvanceFrameArena()
+{
+    u64 usedBytes = 0;
+    u32 heapAllocations = 0;
+    for (u32 thread = 0; thread < g_FrameArena.m_ThreadCount; ++thread)
+    {
+        const FrameArena& arena = GetFrameArena(g_FrameArena.m_Frame, thread);
+        usedBytes += arena.m_Offset + arena.m_HeapBytes;
+        heapAllocations += arena.m_HeapAllocations;
+    }
+    AddMetric(Metric::FrameArenaBytes, usedBytes);
+    AddMetric(Metric::FrameArenaHeapAllocations, heapAllocations);
+
+    g_FrameArena.m_Frame = (g_FrameArena.m_Frame + 1) % FRAME_ARENA_FRAMES;
+    for (u32 thread = 0; thread < g_FrameArena.m_ThreadCount; ++thread)
+    {
+        ResetFrameArena(GetFrameArena(g_FrameArena.m_Frame, thread));
+    }
+}
+
+void* AllocateFrameMemory(const u64 size, const u64 alignment)
+{
+    if (alignment > FRAME_ARENA_ALIGNMENT)
+    {
+        LOG_ERROR("Frame memory can't be aligned to %llu bytes.", scast<unsigned long long>(alignment));
+        return nullptr;
+    }
+
+    const u32 worker = GetCurrentJobWorker();
+    if (worker < g_FrameArena.m_ThreadCount - 1)
+    {
+        return AllocateFromArena(GetFrameArena(g_FrameArena.m_Frame, worker), size, alignment);
+    }
+
+    const std::lock_guard<std::mutex> lock(g_FrameArena.m_SharedMutex);
+    return AllocateFromArena(GetFrameArena(g_FrameArena.m_Frame, g_FrameArena.m_ThreadCount - 1), size, alignment);
+}
+
+FrameArenaStats GetFrameArenaStats()
+{
+    FrameArenaStats stats = {};
+    stats.m_GrowCount = g_FrameArena.m_GrowCount;
+
+    for (u32 frame = 0; frame < FRAME_ARENA_FRAMES && g_FrameArena.m_ThreadCount > 0; ++frame)
+    {
+        for (u32 thread = 0; thread < g_FrameArena.m_ThreadCount; ++thread)
+        {
+            const FrameArena& arena = GetFrameArena(frame, thread);
+            const u64 used = arena.m_Offset + arena.m_HeapBytes;
+            stats.m_HighWaterBytes = std::max({ stats.m_HighWaterBytes, arena.m_HighWater, used });
+            stats.m_CapacityBytes += arena.m_Capacity;
+
+            if (frame == g_FrameArena.m_Frame)
+            {
+                stats.m_UsedBytes += used;
+                stats.m_HeapAllocations += arena.m_HeapAllocations;
+            }
+        }
+    }
+
+    return stats;
+}
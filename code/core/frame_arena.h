@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "common.h"
+
+// Linear allocators for data that only lives for a frame, e.g. culling lists, sort keys and render graph passes.
+// Every job worker bumps a pointer in its own arena, threads outside the job system share one arena behind a mutex.
+// Nothing is freed on its own: AdvanceFrameArena() resets all the arenas of a frame at once.
+//
+// The arenas are FRAME_ARENA_FRAMES deep, so the memory of a frame is only reused FRAME_ARENA_FRAMES - 1 frames
+// later, once the GPU is done reading it. An allocation that doesn't fit goes to the heap and the arena grows to its
+// high-water mark when it is next reset, so after the first frames of a scene no frame touches the heap.
+
+constexpr u32 FRAME_ARENA_FRAMES = 3;
+constexpr u64 FRAME_ARENA_DEFAULT_SIZE = 256 * 1024; // Bytes per thread and frame.
+
+struct FrameArenaStats
+{
+    u64 m_UsedBytes;         // Allocated by every thread in the current frame.
+    u64 m_HighWaterBytes;    // Most bytes a single arena needed in any frame.
+    u64 m_CapacityBytes;     // Reserved by all the arenas.
+    u32 m_HeapAllocations;   // Allocations that didn't fit in the current frame.
+    u32 m_GrowCount;         // Arenas grown since the start.
+};
+
+// Reserves the arenas of every job worker, so call it after InitializeJobSystem(), on the main thread.
+void InitializeFrameArena(const u64 bytesPerThread);
+
+void ShutdownFrameArena();
+
+// Starts a new frame and resets the arenas it reuses. The memory allocated FRAME_ARENA_FRAMES frames ago is invalid
+// afterwards. Call at the end of the frame on the main thread, while no other thread allocates.
+void AdvanceFrameArena();
+
+// Returns memory valid until the frame is reset. Can be called from any thread between InitializeFrameArena() and
+// ShutdownFrameArena(), with alignments up to 64 bytes.
+void* AllocateFrameMemory(const u64 size, const u64 alignment);
+
+FrameArenaStats GetFrameArenaStats();
+
+// Uninitialized array of `count` T. Only for types that need no destructor.
+template<typename T>
+T* AllocateFrameArray(const u64 count)
+{
+    static_assert(std::is_trivially_destructible_v<T>, "Frame memory is never destroyed.");
+    return scast<T*>(AllocateFrameMemory(sizeof(T) * count, alignof(T)));
+}
+
+// Standard allocator drawing from the frame arena, for containers that don't outlive the frame. Deallocating does
+// nothing, so a growing container leaves its old storage in the arena until the reset; reserve when the size is
+// known.
+template<typename T>
+struct FrameAllocator
+{
+    using value_type = T;
+
+    FrameAllocator() = default;
+
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U>&) {}
+
+    T* allocate(const size_t count)
+    {
+        return scast<T*>(AllocateFrameMemory(sizeof(T) * count, alignof(T)));
+    }
+
+    void deallocate(T* const, const size_t) {}
+
+    template<typename U>
+    bool operator==(const FrameAllocator<U>&) const { return true; }
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,165 @@
+#include "core/frame_pacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include <GLFW/glfw3.h>
+
+constexpr double FRAME_PACER_SLEEP_STEP = 0.001;
+
+void QueryPresentModes(FramePacer& pacer)
+{
+    pacer.m_AdaptiveVSyncSupported = glfwExtensionSupported("WGL_EXT_swap_control_tear")
+        || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+}
+
+PresentMode SetPresentMode(FramePacer& pacer, const PresentMode mode)
+{
+    PresentMode result = mode;
+
+    if (result == PresentMode::AdaptiveVSync && !pacer.m_AdaptiveVSyncSupported)
+    {
+        LOG_ERROR("Adaptive vsync is not supported, using vsync instead.");
+        result = PresentMode::VSync;
+    }
+
+    pacer.m_PresentMode = result;
+
+    return result;
+}
+
+void ApplyPresentMode(const PresentMode mode)
+{
+    switch (mode)
+    {
+    case PresentMode::VSync: glfwSwapInterval(1); break;
+    case PresentMode::Immediate: glfwSwapInterval(0); break;
+    case PresentMode::AdaptiveVSync: glfwSwapInterval(-1); break;
+    }
+}
+
+void SetTargetFrameRate(FramePacer& pacer, const double fps)
+{
+    pacer.m_TargetFrameTime = fps > 0.0 ? 1.0 / fps : 0.0;
+    pacer.m_NextFrameTime = 0.0;
+}
+
+// Sleeps for one step and updates the estimate of how long such a sleep really takes.
+static void SleepFramePacerStep(FramePacer& pacer)
+{
+    const double start = glfwGetTime();
+    std::this_thread::sleep_for(std::chrono::duration<double>(FRAME_PACER_SLEEP_STEP));
+    const double observed = glfwGetTime() - start;
+
+    pacer.m_SleepCount++;
+    const double delta = observed - pacer.m_SleepMean;
+    pacer.m_SleepMean += delta / pacer.m_SleepCount;
+    pacer.m_SleepM2 += delta * (observed - pacer.m_SleepMean);
+
+    const double deviation = pacer.m_SleepCount > 1 ? std::sqrt(pacer.m_SleepM2 / (pacer.m_SleepCount - 1)) : 0.0;
+    pacer.m_SleepEstimate = pacer.m_SleepMean + deviation;
+}
+
+double WaitForNextFrame(FramePacer& pacer)
+{
+    const double waitStart = glfwGetTime();
+    double now = waitStart;
+
+    if (pacer.m_TargetFrameTime > 0.0)
+    {
+        // Start over instead of rushing through frames after a hitch.
+        if (pacer.m_NextFrameTime == 0.0 || now - pacer.m_NextFrameTime > pacer.m_TargetFrameTime)
+        {
+            pacer.m_NextFrameTime = now;
+        }
+
+        // Sleep while a sleep is unlikely to overshoot the deadline, then spin for the rest.
+        while (pacer.m_NextFrameTime - now > pacer.m_SleepEstimate)
+        {
+            SleepFramePacerStep(pacer);
+            now = glfwGetTime();
+        }
+
+        while (now < pacer.m_NextFrameTime)
+        {
+            std::this_thread::yield();
+            now = glfwGetTime();
+        }
+
+        pacer.m_NextFrameTime += pacer.m_TargetFrameTime;
+    }
+
+    // The previous frame is complete now that its successor starts.
+    if (pacer.m_LastFrameStart > 0.0)
+    {
+        pacer.m_FrameTimes[pacer.m_HistoryIndex] = scast<float>((now - pacer.m_LastFrameStart) * 1000.0);
+        pacer.m_WorkTimes[pacer.m_HistoryIndex] = scast<float>(pacer.m_LastWorkTime * 1000.0);
+        pacer.m_WaitTimes[pacer.m_HistoryIndex] = scast<float>(pacer.m_LastWaitTime * 1000.0);
+        pacer.m_HistoryIndex = (pacer.m_HistoryIndex + 1) % FRAME_PACER_HISTORY_SIZE;
+        pacer.m_HistoryCount = std::min(pacer.m_HistoryCount + 1, FRAME_PACER_HISTORY_SIZE);
+    }
+
+    pacer.m_LastFrameStart = now;
+    pacer.m_LastWaitTime = now - waitStart;
+    pacer.m_LastWorkTime = 0.0;
+
+    return now;
+}
+
+void EndFrame(FramePacer& pacer, const double presentTime)
+{
+    pacer.m_LastWorkTime = std::max(glfwGetTime() - pacer.m_LastFrameStart - presentTime, 0.0);
+}
+
+FrameStats GetFrameStats(const FramePacer& pacer)
+{
+    FrameStats result = {};
+
+    const u32 count = pacer.m_HistoryCount;
+    if (count == 0)
+    {
+        return result;
+    }
+
+    float frameTimes[FRAME_PACER_HISTORY_SIZE];
+    float totalFrameMs = 0.0f;
+    float totalWorkMs = 0.0f;
+    float totalWaitMs = 0.0f;
+    result.m_MinMs = pacer.m_FrameTimes[0];
+    result.m_MaxMs = pacer.m_FrameTimes[0];
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        frameTimes[i] = pacer.m_FrameTimes[i];
+        totalFrameMs += pacer.m_FrameTimes[i];
+        totalWorkMs += pacer.m_WorkTimes[i];
+        totalWaitMs += pacer.m_WaitTimes[i];
+        result.m_MinMs = std::min(result.m_MinMs, pacer.m_FrameTimes[i]);
+        result.m_MaxMs = std::max(result.m_MaxMs, pacer.m_FrameTimes[i]);
+    }
+
+    const u32 p99Index = std::min(count - 1, scast<u32>(count * 0.99f));
+    std::nth_element(frameTimes, frameTimes + p99Index, frameTimes + count);
+
+    result.m_AverageMs = totalFrameMs / count;
+    result.m_P99Ms = frameTimes[p99Index];
+    result.m_Fps = result.m_AverageMs > 0.0f ? 1000.0f / result.m_AverageMs : 0.0f;
+    result.m_AverageWorkMs = totalWorkMs / count;
+    result.m_AverageWaitMs = totalWaitMs / count;
+
+    return result;
+}
+
+const char* GetPresentModeName(const PresentMode mode)
+{
+    switch (mode)
+    {
+    case PresentMode::VSync: return "VSync";
+    case PresentMode::Immediate: return "Immediate";
+    case PresentMode::AdaptiveVSync: return "Adaptive VSync";
+    }
+
+    return "Unknown";
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "common.h"
+
+// Presentation mode control, a CPU frame limiter and frame time statistics.
+// The limiter sleeps most of the remaining frame time and spins the rest. How long it can sleep safely is learned
+// from the observed oversleep of the OS timer, so it stays precise with coarse timers too.
+
+constexpr u32 FRAME_PACER_HISTORY_SIZE = 256; // Frames kept for the statistics.
+
+enum class PresentMode
+{
+    VSync,
+    Immediate,
+    AdaptiveVSync, // VSync, but late frames are shown right away instead of waiting for the next refresh.
+};
+
+struct FrameStats
+{
+    float m_AverageMs;
+    float m_MinMs;
+    float m_MaxMs;
+    float m_P99Ms;
+    float m_Fps;
+    float m_AverageWorkMs; // Time between the end of the wait and the end of the frame, without the present.
+    float m_AverageWaitMs; // Time spent in the limiter.
+};
+
+struct FramePacer
+{
+    PresentMode m_PresentMode = PresentMode::VSync;
+    bool m_AdaptiveVSyncSupported = false;
+    double m_TargetFrameTime = 0.0; // In seconds, 0 disables the limiter.
+    double m_NextFrameTime = 0.0;   // Deadline of the next frame.
+
+    // Running estimate of how long a 1 ms sleep actually takes (Welford's algorithm).
+    double m_SleepEstimate = 0.002;
+    double m_SleepMean = 0.001;
+    double m_SleepM2 = 0.0;
+    u64 m_SleepCount = 0;
+
+    double m_LastFrameStart = 0.0;
+    double m_LastWaitTime = 0.0;
+    double m_LastWorkTime = 0.0;
+    float m_FrameTimes[FRAME_PACER_HISTORY_SIZE] = {};
+    float m_WorkTimes[FRAME_PACER_HISTORY_SIZE] = {};
+    float m_WaitTimes[FRAME_PACER_HISTORY_SIZE] = {};
+    u32 m_HistoryIndex = 0;
+    u32 m_HistoryCount = 0;
+};
+
+// Finds out which present modes the driver supports. Call with the OpenGL context current.
+void QueryPresentModes(FramePacer& pacer);
+
+// Picks the present mode. Adaptive vsync falls back to vsync when the driver doesn't support it. Returns the mode
+// that is actually used. Doesn't touch OpenGL, see ApplyPresentMode().
+PresentMode SetPresentMode(FramePacer& pacer, const PresentMode mode);
+
+// Sets the swap interval of the OpenGL context current on the calling thread.
+void ApplyPresentMode(const PresentMode mode);
+
+// Limits the frame rate to `fps` frames per second, 0 removes the limit.
+void SetTargetFrameRate(FramePacer& pacer, const double fps);
+
+// Waits until the next frame is due and returns its start time in seconds. Call right before sampling input, so
+// the time spent waiting doesn't add to the input latency.
+double WaitForNextFrame(FramePacer& pacer);
+
+// Records the frame that started at the last WaitForNextFrame() and has just been presented. `presentTime` is how
+// long the frame was blocked on the buffer swap, e.g. waiting for vsync, which isn't counted as work.
+void EndFrame(FramePacer& pacer, const double presentTime);
+
+FrameStats GetFrameStats(const FramePacer& pacer);
+
+const char* GetPresentModeName(const PresentMode mode);
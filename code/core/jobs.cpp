@@ -0,0 +1,494 @@
+#include "core/jobs.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+
+#include "core/profiler.h"
+
+constexpr u32 JOB_SPIN_COUNT = 64; // Failed searches before an idle worker goes to sleep.
+
+static_assert((JOB_POOL_SIZE & (JOB_POOL_SIZE - 1)) == 0, "The job pool size must be a power of two.");
+static_assert((JOB_DEQUE_CAPACITY & (JOB_DEQUE_CAPACITY - 1)) == 0, "The job deque capacity must be a power of two.");
+
+// Fixed size Chase-Lev deque. The owner pushes and pops at the bottom, other threads steal from the top.
+struct JobDeque
+{
+    alignas(64) std::atomic<i64> m_Top = 0;
+    alignas(64) std::atomic<i64> m_Bottom = 0;
+    std::atomic<Job*> m_Jobs[JOB_DEQUE_CAPACITY];
+};
+
+struct JobWorker
+{
+    JobDeque m_Deque;
+    Job m_Pool[JOB_POOL_SIZE];
+    u32 m_PoolIndex = 0;
+    u32 m_RandomState = 1;
+    std::thread m_Thread;
+};
+
+struct JobSystem
+{
+    std::vector<std::unique_ptr<JobWorker>> m_Workers;
+    std::atomic<bool> m_Running = false;
+
+    // Jobs with main thread affinity.
+    std::mutex m_MainQueueMutex;
+    std::deque<Job*> m_MainQueue;
+
+    // Jobs submitted from threads that aren't workers, and the pool they are allocated from.
+    std::mutex m_ExternalQueueMutex;
+    std::deque<Job*> m_ExternalQueue;
+    std::atomic<u32> m_ExternalQueueSize = 0;
+    std::atomic<u32> m_ExternalPoolIndex = 0;
+    Job m_ExternalPool[JOB_POOL_SIZE];
+
+    // Idle workers sleep until the epoch changes.
+    std::mutex m_SleepMutex;
+    std::condition_variable m_WakeCondition;
+    std::atomic<u64> m_WakeEpoch = 0;
+    std::atomic<u32> m_SleepingWorkers = 0;
+};
+
+static JobSystem g_JobSystem;
+static thread_local u32 t_JobWorkerIndex = JOB_INVALID_WORKER;
+static thread_local u32 t_JobRandomState = 0x9E3779B9u;
+
+// SECTION: Deque
+static bool PushJobDeque(JobDeque& deque, Job* const job)
+{
+    const i64 bottom = deque.m_Bottom.load(std::memory_order_relaxed);
+    const i64 top = deque.m_Top.load(std::memory_order_acquire);
+
+    if (bottom - top >= JOB_DEQUE_CAPACITY)
+    {
+        return false;
+    }
+
+    deque.m_Jobs[bottom & (JOB_DEQUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    deque.m_Bottom.store(bottom + 1, std::memory_order_release); // Publishes the job to the thieves.
+
+    return true;
+}
+
+static Job* PopJobDeque(JobDeque& deque)
+{
+    const i64 bottom = deque.m_Bottom.load(std::memory_order_relaxed) - 1;
+    deque.m_Bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    i64 top = deque.m_Top.load(std::memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        deque.m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* result = deque.m_Jobs[bottom & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (top == bottom)
+    {
+        // Last job, race the thieves for it.
+        if (!deque.m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            result = nullptr;
+        }
+        deque.m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    return result;
+}
+
+static Job* StealJobDeque(JobDeque& deque)
+{
+    i64 top = deque.m_Top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const i64 bottom = deque.m_Bottom.load(std::memory_order_acquire);
+
+    if (top >= bottom)
+    {
+        return nullptr;
+    }
+
+    Job* const result = deque.m_Jobs[top & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (!deque.m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+
+    return result;
+}
+
+// SECTION: Scheduling
+static void WakeJobWorkers()
+{
+    g_JobSystem.m_WakeEpoch.fetch_add(1);
+
+    if (g_JobSystem.m_SleepingWorkers.load() > 0)
+    {
+        // Taking the lock makes sure a worker between checking the epoch and waiting doesn't miss the notify.
+        {
+            const std::lock_guard<std::mutex> lock(g_JobSystem.m_SleepMutex);
+        }
+        g_JobSystem.m_WakeCondition.notify_one();
+    }
+}
+
+static void ExecuteJob(Job* const job);
+
+// Hands a job whose counter has already been incremented to a queue.
+static void EnqueueJob(Job* const job)
+{
+    if (!g_JobSystem.m_Running.load(std::memory_order_acquire))
+    {
+        // Without workers everything runs inline on the submitting thread.
+        ExecuteJob(job);
+        return;
+    }
+
+    if (job->m_Affinity == JobAffinity::MainThread)
+    {
+        const std::lock_guard<std::mutex> lock(g_JobSystem.m_MainQueueMutex);
+        g_JobSystem.m_MainQueue.push_back(job);
+        return;
+    }
+
+    const u32 worker = t_JobWorkerIndex;
+    if (worker == JOB_INVALID_WORKER)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(g_JobSystem.m_ExternalQueueMutex);
+            g_JobSystem.m_ExternalQueue.push_back(job);
+            g_JobSystem.m_ExternalQueueSize.fetch_add(1);
+        }
+        WakeJobWorkers();
+        return;
+    }
+
+    if (!PushJobDeque(g_JobSystem.m_Workers[worker]->m_Deque, job))
+    {
+        // The deque is full, so there is plenty of work queued already.
+        ExecuteJob(job);
+        return;
+    }
+
+    WakeJobWorkers();
+}
+
+static void FinishJobCounter(JobCounter& counter)
+{
+    counter.m_Finishing.fetch_add(1);
+
+    if (counter.m_Value.fetch_sub(1) == 1)
+    {
+        std::vector<Job*> dependents;
+        {
+            const std::lock_guard<std::mutex> lock(counter.m_DependentsMutex);
+            dependents.swap(counter.m_Dependents);
+        }
+
+        for (Job* const dependent : dependents)
+        {
+            EnqueueJob(dependent);
+        }
+    }
+
+    counter.m_Finishing.fetch_sub(1);
+}
+
+static void ExecuteJob(Job* const job)
+{
+    JobCounter* const counter = job->m_Counter;
+    job->m_Function(job->m_Data);
+
+    if (counter)
+    {
+        FinishJobCounter(*counter);
+    }
+}
+
+static u32 NextJobRandom(u32& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static Job* FindJob(const u32 worker)
+{
+    if (worker == 0)
+    {
+        const std::lock_guard<std::mutex> lock(g_JobSystem.m_MainQueueMutex);
+        if (!g_JobSystem.m_MainQueue.empty())
+        {
+            Job* const job = g_JobSystem.m_MainQueue.front();
+            g_JobSystem.m_MainQueue.pop_front();
+            return job;
+        }
+    }
+
+    if (worker != JOB_INVALID_WORKER)
+    {
+        if (Job* const job = PopJobDeque(g_JobSystem.m_Workers[worker]->m_Deque); job)
+        {
+            return job;
+        }
+    }
+
+    if (g_JobSystem.m_ExternalQueueSize.load() > 0)
+    {
+        const std::lock_guard<std::mutex> lock(g_JobSystem.m_ExternalQueueMutex);
+        if (!g_JobSystem.m_ExternalQueue.empty())
+        {
+            Job* const job = g_JobSystem.m_ExternalQueue.front();
+            g_JobSystem.m_ExternalQueue.pop_front();
+            g_JobSystem.m_ExternalQueueSize.fetch_sub(1);
+            return job;
+        }
+    }
+
+    // Steal, starting at a random victim so the workers don't all pile onto the same deque.
+    const u32 workerCount = scast<u32>(g_JobSystem.m_Workers.size());
+    if (workerCount == 0)
+    {
+        return nullptr;
+    }
+
+    u32& randomState = worker != JOB_INVALID_WORKER ? g_JobSystem.m_Workers[worker]->m_RandomState : t_JobRandomState;
+    const u32 start = NextJobRandom(randomState) % workerCount;
+    for (u32 i = 0; i < workerCount; ++i)
+    {
+        const u32 victim = (start + i) % workerCount;
+        if (victim == worker)
+        {
+            continue;
+        }
+
+        if (Job* const job = StealJobDeque(g_JobSystem.m_Workers[victim]->m_Deque); job)
+        {
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+static void JobWorkerLoop(const u32 worker)
+{
+    t_JobWorkerIndex = worker;
+
+    char name[PROFILER_THREAD_NAME_SIZE];
+    std::snprintf(name, sizeof(name), "Job Worker %u", worker);
+    SetProfilerThreadName(name);
+
+    u32 failedSearches = 0;
+    while (g_JobSystem.m_Running.load(std::memory_order_acquire))
+    {
+        if (Job* const job = FindJob(worker); job)
+        {
+            ExecuteJob(job);
+            failedSearches = 0;
+            continue;
+        }
+
+        if (++failedSearches < JOB_SPIN_COUNT)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Announce the sleep before the last look, so a job pushed in between bumps the epoch and wakes us.
+        const u64 epoch = g_JobSystem.m_WakeEpoch.load();
+        g_JobSystem.m_SleepingWorkers.fetch_add(1);
+
+        if (Job* const job = FindJob(worker); job)
+        {
+            g_JobSystem.m_SleepingWorkers.fetch_sub(1);
+            ExecuteJob(job);
+            failedSearches = 0;
+            continue;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(g_JobSystem.m_SleepMutex);
+            g_JobSystem.m_WakeCondition.wait(lock, [epoch]()
+            {
+                return g_JobSystem.m_WakeEpoch.load() != epoch || !g_JobSystem.m_Running.load();
+            });
+        }
+
+        g_JobSystem.m_SleepingWorkers.fetch_sub(1);
+        failedSearches = 0;
+    }
+
+    t_JobWorkerIndex = JOB_INVALID_WORKER;
+}
+
+// SECTION: Public interface
+void InitializeJobSystem(const u32 workerCount)
+{
+    if (g_JobSystem.m_Running.load())
+    {
+        LOG_ERROR("The job system is already running.");
+        return;
+    }
+
+    u32 count = workerCount;
+    if (count == 0)
+    {
+        count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    g_JobSystem.m_Workers.clear();
+    for (u32 i = 0; i < count; ++i)
+    {
+        std::unique_ptr<JobWorker> worker = std::make_unique<JobWorker>();
+        worker->m_RandomState = (i + 1) * 0x9E3779B9u;
+        g_JobSystem.m_Workers.push_back(std::move(worker));
+    }
+
+    t_JobWorkerIndex = 0;
+    g_JobSystem.m_Running.store(true, std::memory_order_release);
+
+    for (u32 i = 1; i < count; ++i)
+    {
+        g_JobSystem.m_Workers[i]->m_Thread = std::thread(JobWorkerLoop, i);
+    }
+
+    LOG_INFO("Started the job system with %u workers.", count);
+}
+
+void ShutdownJobSystem()
+{
+    if (!g_JobSystem.m_Running.load())
+    {
+        return;
+    }
+
+    // Anything still queued for the main thread has to run before the workers go away.
+    RunMainThreadJobs();
+
+    {
+        const std::lock_guard<std::mutex> lock(g_JobSystem.m_SleepMutex);
+        g_JobSystem.m_Running.store(false, std::memory_order_release);
+    }
+    g_JobSystem.m_WakeCondition.notify_all();
+
+    for (std::unique_ptr<JobWorker>& worker : g_JobSystem.m_Workers)
+    {
+        if (worker->m_Thread.joinable())
+        {
+            worker->m_Thread.join();
+        }
+    }
+
+    g_JobSystem.m_Workers.clear();
+    t_JobWorkerIndex = JOB_INVALID_WORKER;
+}
+
+u32 GetJobWorkerCount()
+{
+    return g_JobSystem.m_Running.load() ? scast<u32>(g_JobSystem.m_Workers.size()) : 1;
+}
+
+u32 GetCurrentJobWorker()
+{
+    return t_JobWorkerIndex;
+}
+
+Job* AllocateJob(const JobFunction function, JobCounter* const counter, const JobAffinity affinity)
+{
+    Job* result = nullptr;
+
+    const u32 worker = t_JobWorkerIndex;
+    if (worker != JOB_INVALID_WORKER)
+    {
+        JobWorker& owner = *g_JobSystem.m_Workers[worker];
+        result = &owner.m_Pool[owner.m_PoolIndex++ & (JOB_POOL_SIZE - 1)];
+    }
+    else
+    {
+        const u32 index = g_JobSystem.m_ExternalPoolIndex.fetch_add(1);
+        result = &g_JobSystem.m_ExternalPool[index & (JOB_POOL_SIZE - 1)];
+    }
+
+    result->m_Function = function;
+    result->m_Counter = counter;
+    result->m_Affinity = affinity;
+
+    return result;
+}
+
+void SubmitJob(Job* const job)
+{
+    if (job->m_Counter)
+    {
+        job->m_Counter->m_Value.fetch_add(1);
+    }
+
+    EnqueueJob(job);
+}
+
+void SubmitJobAfter(JobCounter& dependency, Job* const job)
+{
+    if (job->m_Counter)
+    {
+        job->m_Counter->m_Value.fetch_add(1);
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(dependency.m_DependentsMutex);
+        if (dependency.m_Value.load() > 0)
+        {
+            dependency.m_Dependents.push_back(job);
+            return;
+        }
+    }
+
+    EnqueueJob(job);
+}
+
+void WaitForCounter(JobCounter& counter)
+{
+    const u32 worker = t_JobWorkerIndex;
+
+    while (counter.m_Value.load() > 0 || counter.m_Finishing.load() > 0)
+    {
+        if (Job* const job = FindJob(worker); job)
+        {
+            ExecuteJob(job);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void RunMainThreadJobs()
+{
+    if (t_JobWorkerIndex != 0)
+    {
+        LOG_ERROR("Main thread jobs can only run on the main thread.");
+        return;
+    }
+
+    for (;;)
+    {
+        Job* job = nullptr;
+        {
+            const std::lock_guard<std::mutex> lock(g_JobSystem.m_MainQueueMutex);
+            if (g_JobSystem.m_MainQueue.empty())
+            {
+                return;
+            }
+
+            job = g_JobSystem.m_MainQueue.front();
+            g_JobSystem.m_MainQueue.pop_front();
+        }
+
+        ExecuteJob(job);
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+
+// Work-stealing job system.
+// Every worker thread (and the main thread, which is worker 0) owns a Chase-Lev deque: the owner pushes and pops
+// jobs at the bottom without locks, idle workers steal from the top of the others. Completion is tracked with
+// counters, and a job can be held back until another counter reaches zero. Jobs with main thread affinity (e.g.
+// OpenGL uploads while loading, before the render thread takes the context) go to a separate queue that only the
+// main thread drains.
+//
+// Jobs are allocated from a per-thread ring of JOB_POOL_SIZE entries, so a single thread must not have more
+// than that many jobs in flight.
+
+constexpr u32 JOB_DATA_SIZE = 48;
+constexpr u32 JOB_POOL_SIZE = 4096;
+constexpr u32 JOB_DEQUE_CAPACITY = 4096;
+constexpr u32 JOB_INVALID_WORKER = ~0u;
+
+using JobFunction = void (*)(void* data);
+
+enum class JobAffinity
+{
+    Any,
+    MainThread,
+};
+
+struct Job;
+
+// Counts the jobs that still have to run. Must outlive the jobs it tracks.
+struct JobCounter
+{
+    std::atomic<i32> m_Value = 0;
+    std::atomic<i32> m_Finishing = 0; // Workers still touching the counter after decrementing it.
+    std::mutex m_DependentsMutex;
+    std::vector<Job*> m_Dependents;   // Jobs released when m_Value reaches zero.
+};
+
+struct alignas(64) Job
+{
+    JobFunction m_Function;
+    JobCounter* m_Counter;
+    JobAffinity m_Affinity;
+    alignas(16) u8 m_Data[JOB_DATA_SIZE];
+};
+
+// Starts the worker threads. `workerCount` includes the main thread; 0 uses one worker per hardware thread.
+// Must be called from the main thread.
+void InitializeJobSystem(const u32 workerCount);
+
+void ShutdownJobSystem();
+
+// Number of workers including the main thread, 1 when the job system isn't running.
+u32 GetJobWorkerCount();
+
+// Index of the calling worker (0 is the main thread), or JOB_INVALID_WORKER for other threads.
+u32 GetCurrentJobWorker();
+
+// Returns a job from the calling thread's pool with room for JOB_DATA_SIZE bytes of data.
+Job* AllocateJob(const JobFunction function, JobCounter* const counter, const JobAffinity affinity);
+
+// Queues a job. The counter (if any) is incremented here and decremented once the job has run.
+void SubmitJob(Job* const job);
+
+// Queues a job once `dependency` reaches zero. The job's counter is incremented right away.
+void SubmitJobAfter(JobCounter& dependency, Job* const job);
+
+// Runs other jobs until the counter reaches zero.
+void WaitForCounter(JobCounter& counter);
+
+// Runs the queued main thread jobs. Call once per frame from the main thread.
+void RunMainThreadJobs();
+
+// Wraps a callable into a job. The callable is stored inside the job, so it has to be small and trivially
+// destructible, e.g. a lambda capturing a few references.
+template<typename Fn>
+Job* CreateJob(Fn&& fn, JobCounter* const counter, const JobAffinity affinity)
+{
+    using Callable = std::decay_t<Fn>;
+    static_assert(sizeof(Callable) <= JOB_DATA_SIZE, "Job callable is too large.");
+    static_assert(alignof(Callable) <= 16, "Job callable is over-aligned.");
+    static_assert(std::is_trivially_destructible_v<Callable>, "Job callables are never destroyed.");
+
+    Job* const result = AllocateJob(
+        [](void* const data) { (*std::launder(rcast<Callable*>(data)))(); },
+        counter,
+        affinity
+    );
+    new (result->m_Data) Callable(std::forward<Fn>(fn));
+
+    return result;
+}
+
+template<typename Fn>
+void RunJob(Fn&& fn, JobCounter* const counter, const JobAffinity affinity)
+{
+    SubmitJob(CreateJob(std::forward<Fn>(fn), counter, affinity));
+}
+
+template<typename Fn>
+void RunJobAfter(JobCounter& dependency, Fn&& fn, JobCounter* const counter, const JobAffinity affinity)
+{
+    SubmitJobAfter(dependency, CreateJob(std::forward<Fn>(fn), counter, affinity));
+}
+
+// Calls `fn(begin, end)` for consecutive ranges of [0, count) on all workers and returns once every range is done.
+// Every range starts at a multiple of `batchSize`; ranges hold `batchSize` elements unless that would need more jobs
+// than the pool can hold.
+template<typename Fn>
+void ParallelFor(const u32 count, const u32 batchSize, const Fn& fn)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (count <= batchSize || GetJobWorkerCount() == 1)
+    {
+        fn(0u, count);
+        return;
+    }
+
+    // Keep the number of jobs well below the size of the job pool.
+    const u32 maxJobs = JOB_POOL_SIZE / 4;
+    const u32 batchCount = (count + batchSize - 1) / batchSize;
+    const u32 actualBatchSize = batchSize * ((batchCount + maxJobs - 1) / maxJobs);
+
+    JobCounter counter;
+    for (u32 begin = actualBatchSize; begin < count; begin += actualBatchSize)
+    {
+        const u32 end = begin + actualBatchSize < count ? begin + actualBatchSize : count;
+        RunJob([&fn, begin, end]() { fn(begin, end); }, &counter, JobAffinity::Any);
+    }
+
+    // The calling thread takes the first batch itself instead of idling.
+    fn(0u, actualBatchSize);
+
+    WaitForCounter(counter);
+}
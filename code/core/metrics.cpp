@@ -0,0 +1,549 @@
+#include "core/metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// NOTE(sbalse): This file is kept out of the unity build (see o3d.vcxproj), the socket headers pull in <windows.h>
+// and its macros would leak into the files that follow it.
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NOGDI
+#include <winsock2.h>
+#include <afunix.h>
+
+using MetricsSocket = SOCKET;
+constexpr MetricsSocket INVALID_METRICS_SOCKET = INVALID_SOCKET;
+#else
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using MetricsSocket = int;
+constexpr MetricsSocket INVALID_METRICS_SOCKET = -1;
+#endif
+
+constexpr u32 METRIC_COUNT = scast<u32>(Metric::Count);
+constexpr u32 METRICS_QUERY_SIZE = 64;
+constexpr int METRICS_POLL_MS = 100;           // How often the server checks whether it should stop.
+constexpr int METRICS_RECEIVE_TIMEOUT_MS = 1000;
+
+struct MetricsFrame
+{
+    u64 m_Index;
+    double m_Values[METRIC_COUNT];
+};
+
+struct Metrics
+{
+    std::atomic<u64> m_Current[METRIC_COUNT] = {};
+
+    // One more slot than the window for the last frame closed, whose snapshot is still being drawn.
+    std::mutex m_HistoryMutex;
+    MetricsFrame m_History[METRICS_HISTORY_SIZE + 1] = {};
+    u64 m_FrameIndex = 0;         // The frame being recorded.
+    u64 m_CompleteFrameCount = 0; // Frames whose snapshot has been drawn, the window ends with them.
+
+    std::thread m_Server;
+    std::atomic<bool> m_StopServer = false;
+    MetricsSocket m_ListenSocket = INVALID_METRICS_SOCKET;
+    std::string m_SocketPath;
+    bool m_SocketsStarted = false; // WSAStartup() succeeded, on Windows.
+};
+
+static Metrics g_Metrics = {};
+
+bool IsTimeMetric(const Metric metric)
+{
+    return metric <= Metric::SwapBuffersTime;
+}
+
+bool IsRenderThreadMetric(const Metric metric)
+{
+    return metric >= Metric::RenderTime && metric <= Metric::UploadBytes;
+}
+
+const char* GetMetricName(const Metric metric)
+{
+    switch (metric)
+    {
+    case Metric::FrameTime: return "frame_time_ms";
+    case Metric::ProcessInputTime: return "process_input_ms";
+    case Metric::UpdateTime: return "update_ms";
+    case Metric::SnapshotTime: return "snapshot_ms";
+    case Metric::RenderTime: return "render_ms";
+    case Metric::SwapBuffersTime: return "swap_buffers_ms";
+    case Metric::DrawCalls: return "draw_calls";
+    case Metric::Triangles: return "triangles";
+    case Metric::StateChanges: return "state_changes";
+    case Metric::UploadBytes: return "upload_bytes";
+    case Metric::FrameArenaBytes: return "frame_arena_bytes";
+    case Metric::FrameArenaHeapAllocations: return "frame_arena_heap_allocs";
+    default: return "unknown";
+    }
+}
+
+void AddMetric(const Metric metric, const u64 amount)
+{
+    g_Metrics.m_Current[scast<u32>(metric)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+u64 GetMetricsTime()
+{
+    return scast<u64>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count()
+    );
+}
+
+static double TakeMetric(const u32 metric)
+{
+    const u64 value = g_Metrics.m_Current[metric].exchange(0, std::memory_order_relaxed);
+    return IsTimeMetric(scast<Metric>(metric)) ? scast<double>(value) / 1000000.0 : scast<double>(value);
+}
+
+// Moves the render thread's values into the last frame closed, the one whose snapshot it has drawn. Expects the
+// history lock.
+static void CloseMetricsRenderFrame()
+{
+    if (g_Metrics.m_CompleteFrameCount == g_Metrics.m_FrameIndex)
+    {
+        return;
+    }
+
+    MetricsFrame& frame = g_Metrics.m_History[(g_Metrics.m_FrameIndex - 1) % (METRICS_HISTORY_SIZE + 1)];
+    for (u32 i = 0; i < METRIC_COUNT; ++i)
+    {
+        if (IsRenderThreadMetric(scast<Metric>(i)))
+        {
+            frame.m_Values[i] = TakeMetric(i);
+        }
+    }
+    g_Metrics.m_CompleteFrameCount = g_Metrics.m_FrameIndex;
+}
+
+void EndMetricsFrame(const double frameTime)
+{
+    const std::lock_guard<std::mutex> lock(g_Metrics.m_HistoryMutex);
+
+    // The render thread drew the previous frame while this one was recorded. Before the first frame it only uploaded
+    // the scene, which is left to count in the first frame.
+    CloseMetricsRenderFrame();
+
+    MetricsFrame frame = {};
+    frame.m_Index = g_Metrics.m_FrameIndex;
+    for (u32 i = 0; i < METRIC_COUNT; ++i)
+    {
+        if (!IsRenderThreadMetric(scast<Metric>(i)))
+        {
+            frame.m_Values[i] = TakeMetric(i);
+        }
+    }
+    frame.m_Values[scast<u32>(Metric::FrameTime)] = frameTime * 1000.0;
+
+    g_Metrics.m_History[g_Metrics.m_FrameIndex % (METRICS_HISTORY_SIZE + 1)] = frame;
+    g_Metrics.m_FrameIndex++;
+}
+
+void EndMetricsRenderFrame()
+{
+    const std::lock_guard<std::mutex> lock(g_Metrics.m_HistoryMutex);
+    CloseMetricsRenderFrame();
+}
+
+// Copies the window, oldest frame first. Can be called from any thread.
+static std::vector<MetricsFrame> CopyMetricsHistory()
+{
+    const std::lock_guard<std::mutex> lock(g_Metrics.m_HistoryMutex);
+
+    const u64 end = g_Metrics.m_CompleteFrameCount;
+    const u64 count = std::min<u64>(end, METRICS_HISTORY_SIZE);
+    std::vector<MetricsFrame> result;
+    result.reserve(count);
+    for (u64 index = end - count; index < end; ++index)
+    {
+        result.push_back(g_Metrics.m_History[index % (METRICS_HISTORY_SIZE + 1)]);
+    }
+
+    return result;
+}
+
+u32 GetMetricsFrameCount()
+{
+    const std::lock_guard<std::mutex> lock(g_Metrics.m_HistoryMutex);
+    return scast<u32>(std::min<u64>(g_Metrics.m_CompleteFrameCount, METRICS_HISTORY_SIZE));
+}
+
+void GetLastFrameMetrics(double (&outValues)[METRIC_COUNT])
+{
+    const std::lock_guard<std::mutex> lock(g_Metrics.m_HistoryMutex);
+    if (g_Metrics.m_CompleteFrameCount == 0)
+    {
+        std::fill(std::begin(outValues), std::end(outValues), 0.0);
+        return;
+    }
+
+    const MetricsFrame& frame = g_Metrics.m_History[(g_Metrics.m_CompleteFrameCount - 1) % (METRICS_HISTORY_SIZE + 1)];
+    std::copy(std::begin(frame.m_Values), std::end(frame.m_Values), std::begin(outValues));
+}
+
+static MetricSummary SummarizeMetric(const std::vector<MetricsFrame>& frames, const Metric metric)
+{
+    MetricSummary result = {};
+    if (frames.empty())
+    {
+        return result;
+    }
+
+    std::vector<double> sorted;
+    sorted.reserve(frames.size());
+    double sum = 0.0;
+    for (const MetricsFrame& frame : frames)
+    {
+        sorted.push_back(frame.m_Values[scast<u32>(metric)]);
+        sum += sorted.back();
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    // Nearest rank.
+    auto percentile = [&sorted](const double fraction)
+    {
+        const size_t rank = scast<size_t>(fraction * scast<double>(sorted.size()));
+        return sorted[std::min(rank, sorted.size() - 1)];
+    };
+
+    result.m_Min = sorted.front();
+    result.m_Mean = sum / scast<double>(sorted.size());
+    result.m_P50 = percentile(0.50);
+    result.m_P95 = percentile(0.95);
+    result.m_P99 = percentile(0.99);
+    result.m_Max = sorted.back();
+    return result;
+}
+
+MetricSummary GetMetricSummary(const Metric metric)
+{
+    return SummarizeMetric(CopyMetricsHistory(), metric);
+}
+
+std::string FormatMetricsCsv()
+{
+    const std::vector<MetricsFrame> frames = CopyMetricsHistory();
+
+    std::string result = "frame";
+    for (u32 i = 0; i < METRIC_COUNT; ++i)
+    {
+        result += ',';
+        result += GetMetricName(scast<Metric>(i));
+    }
+    result += '\n';
+
+    char value[64];
+    for (const MetricsFrame& frame : frames)
+    {
+        result += std::to_string(frame.m_Index);
+        for (u32 i = 0; i < METRIC_COUNT; ++i)
+        {
+            snprintf(value, sizeof(value), IsTimeMetric(scast<Metric>(i)) ? ",%.4f" : ",%.0f", frame.m_Values[i]);
+            result += value;
+        }
+        result += '\n';
+    }
+
+    return result;
+}
+
+std::string FormatMetricsJson()
+{
+    const std::vector<MetricsFrame> frames = CopyMetricsHistory();
+
+    std::string result = "{\n  \"frames\": " + std::to_string(frames.size()) + ",\n  \"metrics\": {\n";
+
+    char line[256];
+    for (u32 i = 0; i < METRIC_COUNT; ++i)
+    {
+        const MetricSummary summary = SummarizeMetric(frames, scast<Metric>(i));
+        snprintf(
+            line,
+            sizeof(line),
+            "    \"%s\": { \"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, "
+            "\"max\": %.4f }%s\n",
+            GetMetricName(scast<Metric>(i)),
+            summary.m_Min,
+            summary.m_Mean,
+            summary.m_P50,
+            summary.m_P95,
+            summary.m_P99,
+            summary.m_Max,
+            i + 1 < METRIC_COUNT ? "," : ""
+        );
+        result += line;
+    }
+
+    result += "  }\n}\n";
+    return result;
+}
+
+static bool SaveMetricsText(const char* const fileName, const std::string& text)
+{
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out)
+    {
+        LOG_ERROR("Failed to open file for writing: %s.", fileName);
+        return false;
+    }
+
+    out.write(text.data(), scast<std::streamsize>(text.size()));
+    if (!out)
+    {
+        LOG_ERROR("Failed to write metrics: %s.", fileName);
+        return false;
+    }
+
+    return true;
+}
+
+bool SaveMetricsCsv(const char* const fileName)
+{
+    return SaveMetricsText(fileName, FormatMetricsCsv());
+}
+
+bool SaveMetricsJson(const char* const fileName)
+{
+    return SaveMetricsText(fileName, FormatMetricsJson());
+}
+
+// SECTION: Query server.
+
+static void CloseMetricsSocket(const MetricsSocket socket)
+{
+#if defined(_WIN32)
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+static bool SendMetricsReply(const MetricsSocket socket, const std::string& reply)
+{
+#if defined(MSG_NOSIGNAL)
+    constexpr int flags = MSG_NOSIGNAL; // A client that hangs up early mustn't kill the engine with SIGPIPE.
+#else
+    constexpr int flags = 0;
+#endif
+
+    size_t sent = 0;
+    while (sent < reply.size())
+    {
+#if defined(_WIN32)
+        const int result = send(socket, reply.data() + sent, scast<int>(reply.size() - sent), flags);
+#else
+        const ssize_t result = send(socket, reply.data() + sent, reply.size() - sent, flags);
+#endif
+        if (result <= 0)
+        {
+            return false;
+        }
+
+        sent += scast<size_t>(result);
+    }
+
+    return true;
+}
+
+// Reads one query line and answers it.
+static void AnswerMetricsQuery(const MetricsSocket client)
+{
+#if defined(_WIN32)
+    const DWORD timeout = METRICS_RECEIVE_TIMEOUT_MS;
+#else
+    const timeval timeout = { METRICS_RECEIVE_TIMEOUT_MS / 1000, (METRICS_RECEIVE_TIMEOUT_MS % 1000) * 1000 };
+#endif
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, rcast<const char*>(&timeout), sizeof(timeout));
+
+    char query[METRICS_QUERY_SIZE] = {};
+    size_t length = 0;
+    while (length < METRICS_QUERY_SIZE - 1)
+    {
+        const auto received = recv(client, query + length, scast<int>(METRICS_QUERY_SIZE - 1 - length), 0);
+        if (received <= 0)
+        {
+            break;
+        }
+
+        length += scast<size_t>(received);
+        if (std::memchr(query, '\n', length) != nullptr)
+        {
+            break;
+        }
+    }
+
+    std::string command(query, length);
+    command.erase(command.find_last_not_of(" \t\r\n") + 1);
+
+    if (command == "csv")
+    {
+        SendMetricsReply(client, FormatMetricsCsv());
+    }
+    else if (command == "json" || command.empty())
+    {
+        SendMetricsReply(client, FormatMetricsJson());
+    }
+    else
+    {
+        SendMetricsReply(client, "Unknown query \"" + command + "\", expected \"json\" or \"csv\".\n");
+    }
+}
+
+static void MetricsServerLoop()
+{
+    while (!g_Metrics.m_StopServer.load(std::memory_order_acquire))
+    {
+        // Wait with a timeout, so the server notices when it should stop.
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(g_Metrics.m_ListenSocket, &readable);
+        timeval timeout = { 0, METRICS_POLL_MS * 1000 };
+        if (select(scast<int>(g_Metrics.m_ListenSocket + 1), &readable, nullptr, nullptr, &timeout) <= 0)
+        {
+            continue;
+        }
+
+        const MetricsSocket client = accept(g_Metrics.m_ListenSocket, nullptr, nullptr);
+        if (client == INVALID_METRICS_SOCKET)
+        {
+            continue;
+        }
+
+        AnswerMetricsQuery(client);
+        CloseMetricsSocket(client);
+    }
+}
+
+// A socket file nobody listens on is left over from a run that didn't shut down. One that accepts connections belongs
+// to a running instance and must be left alone.
+static bool IsStaleMetricsSocket(const sockaddr_un& address)
+{
+    const MetricsSocket probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe == INVALID_METRICS_SOCKET)
+    {
+        return false;
+    }
+
+    bool refused = false;
+    if (connect(probe, rcast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+#if defined(_WIN32)
+        refused = WSAGetLastError() == WSAECONNREFUSED;
+#else
+        refused = errno == ECONNREFUSED;
+#endif
+    }
+    CloseMetricsSocket(probe);
+
+    return refused;
+}
+
+static bool StartMetricsServer(const char* const socketPath)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (std::strlen(socketPath) >= sizeof(address.sun_path))
+    {
+        LOG_ERROR("Metrics socket path is too long: %s.", socketPath);
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath, std::strlen(socketPath) + 1);
+
+#if defined(_WIN32)
+    WSADATA data = {};
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+    {
+        LOG_ERROR("Failed to initialize Winsock for the metrics socket.");
+        return false;
+    }
+#endif
+    g_Metrics.m_SocketsStarted = true;
+
+    // A socket file left behind by an earlier run would make bind() fail.
+    if (IsStaleMetricsSocket(address))
+    {
+        std::error_code error;
+        std::filesystem::remove(socketPath, error);
+    }
+
+    const MetricsSocket listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenSocket == INVALID_METRICS_SOCKET)
+    {
+        LOG_ERROR("Failed to create the metrics socket.");
+        return false;
+    }
+
+    if (bind(listenSocket, rcast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listenSocket, 4) != 0)
+    {
+        LOG_ERROR("Failed to listen on the metrics socket %s, another instance may be serving it.", socketPath);
+        CloseMetricsSocket(listenSocket);
+        return false;
+    }
+
+    g_Metrics.m_ListenSocket = listenSocket;
+    g_Metrics.m_SocketPath = socketPath;
+    g_Metrics.m_StopServer.store(false, std::memory_order_release);
+    g_Metrics.m_Server = std::thread(MetricsServerLoop);
+
+    LOG_INFO("Serving metrics on \"%s\".", socketPath);
+    return true;
+}
+
+void InitializeMetrics(const char* const socketPath)
+{
+    for (std::atomic<u64>& value : g_Metrics.m_Current)
+    {
+        value.store(0, std::memory_order_relaxed);
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(g_Metrics.m_HistoryMutex);
+        g_Metrics.m_FrameIndex = 0;
+        g_Metrics.m_CompleteFrameCount = 0;
+    }
+
+    if (socketPath != nullptr)
+    {
+        StartMetricsServer(socketPath);
+    }
+}
+
+void ShutdownMetrics()
+{
+    if (g_Metrics.m_Server.joinable())
+    {
+        g_Metrics.m_StopServer.store(true, std::memory_order_release);
+        g_Metrics.m_Server.join();
+
+        CloseMetricsSocket(g_Metrics.m_ListenSocket);
+        g_Metrics.m_ListenSocket = INVALID_METRICS_SOCKET;
+
+        std::error_code error;
+        std::filesystem::remove(g_Metrics.m_SocketPath, error);
+    }
+
+    if (g_Metrics.m_SocketsStarted)
+    {
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+        g_Metrics.m_SocketsStarted = false;
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+
+#include "common.h"
+
+// Always-on frame metrics, cheap enough to leave running in release builds.
+// Every frame the phase times and the render counters are collected into one sample. The render thread draws a frame's
+// snapshot while the next frame is simulated, so its metrics are added to the sample of the snapshot's frame when that
+// draw is done, and a frame only enters the window then. The last METRICS_HISTORY_SIZE samples form a rolling window,
+// from which the percentiles are computed when they are queried.
+// The window can be saved as CSV (one row per frame) or JSON (percentiles per metric), or queried while the
+// engine runs through a local UNIX socket: connect, send "json" or "csv" and read the reply until the socket closes.
+
+constexpr u32 METRICS_HISTORY_SIZE = 1024; // Frames in the rolling window.
+
+enum class Metric : u32
+{
+    FrameTime,          // Milliseconds between the starts of two frames.
+    ProcessInputTime,   // Milliseconds of CPU time per phase.
+    UpdateTime,
+    SnapshotTime,       // Culling and recording the draws on the main thread, see graphics/render_thread.h.
+    RenderTime,         // Submitting the frame on the render thread.
+    SwapBuffersTime,
+    DrawCalls,
+    Triangles,
+    StateChanges,       // Shader, vertex array and texture bindings.
+    UploadBytes,        // Bytes handed to OpenGL in buffer and texture uploads.
+    FrameArenaBytes,    // Transient memory allocated in the frame, see core/frame_arena.h.
+    FrameArenaHeapAllocations,
+    Count,
+};
+
+struct MetricSummary
+{
+    double m_Min;
+    double m_Mean;
+    double m_P50;
+    double m_P95;
+    double m_P99;
+    double m_Max;
+};
+
+// Starts the query server on `socketPath`, or no server if it is null. Call on the main thread.
+void InitializeMetrics(const char* const socketPath);
+void ShutdownMetrics();
+
+// Name of the metric in the exports, with its unit.
+const char* GetMetricName(const Metric metric);
+
+// Time metrics are exported in milliseconds, the others are counts.
+bool IsTimeMetric(const Metric metric);
+
+// Metrics added by the render thread, from RenderTime to UploadBytes.
+bool IsRenderThreadMetric(const Metric metric);
+
+// Adds to the value of the metric in the current frame. Can be called from any thread.
+void AddMetric(const Metric metric, const u64 amount);
+
+// Nanoseconds on the metrics clock.
+u64 GetMetricsTime();
+
+// Closes the current frame, on the main thread, once the render thread has drawn the previous one. That previous
+// frame gets the render thread's values and is added to the window.
+void EndMetricsFrame(const double frameTime);
+
+// Adds the last frame to the window, once the render thread has stopped after drawing it.
+void EndMetricsRenderFrame();
+
+// Number of frames in the window.
+u32 GetMetricsFrameCount();
+
+// Values of the last frame in the window, indexed by Metric, in the units of the exports.
+void GetLastFrameMetrics(double (&outValues)[scast<u32>(Metric::Count)]);
+
+MetricSummary GetMetricSummary(const Metric metric);
+
+std::string FormatMetricsCsv();
+std::string FormatMetricsJson();
+bool SaveMetricsCsv(const char* const fileName);
+bool SaveMetricsJson(const char* const fileName);
+
+// Adds the time until the end of the enclosing block to a time metric.
+struct MetricScope
+{
+    Metric m_Metric;
+    u64 m_Start;
+
+    explicit MetricScope(const Metric metric) : m_Metric(metric), m_Start(GetMetricsTime()) {}
+    ~MetricScope() { AddMetric(m_Metric, GetMetricsTime() - m_Start); }
+};
+
+#define METRIC_CONCAT_INNER(a, b) a##b
+#define METRIC_CONCAT(a, b) METRIC_CONCAT_INNER(a, b)
+
+#define METRIC_SCOPE(metric) const MetricScope METRIC_CONCAT(metricScope, __LINE__)(metric)
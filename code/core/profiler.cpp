@@ -0,0 +1,639 @@
+#include "core/profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <glad/glad.h>
+
+constexpr u32 PROFILER_GPU_CALIBRATION_INTERVAL = 256; // Frames between GPU clock calibrations.
+constexpr u32 PROFILER_INVALID_GPU_SCOPE = ~0u;
+
+static_assert(
+    (PROFILER_THREAD_CAPACITY & (PROFILER_THREAD_CAPACITY - 1)) == 0,
+    "The profiler thread capacity must be a power of two."
+);
+
+// Single producer, single consumer ring of one thread's events. The thread writes, the main thread reads.
+struct ProfilerThread
+{
+    alignas(64) std::atomic<u32> m_WriteIndex = 0;
+    alignas(64) std::atomic<u32> m_ReadIndex = 0;
+    std::atomic<u32> m_Dropped = 0;
+    u32 m_Index = 0;
+    char m_Name[PROFILER_THREAD_NAME_SIZE] = {};
+    ProfileEvent m_Events[PROFILER_THREAD_CAPACITY];
+};
+
+// The GPU scopes of one frame, resolved once its last query is available.
+struct GpuQueryFrame
+{
+    u64 m_FrameIndex = 0;
+    u32 m_ScopeCount = 0;
+    u32 m_LastQuery = 0; // Latest query issued in the frame.
+    bool m_Pending = false;
+    const char* m_Names[PROFILER_MAX_GPU_SCOPES] = {};
+    bool m_Closed[PROFILER_MAX_GPU_SCOPES] = {};
+};
+
+// GPU scopes read back from the queries, waiting for the main thread to add them to the history.
+struct GpuFrameResult
+{
+    u64 m_FrameIndex = 0;
+    std::vector<ProfileEvent> m_Events;
+};
+
+struct Profiler
+{
+    std::mutex m_ThreadsMutex;
+    std::vector<std::unique_ptr<ProfilerThread>> m_Threads;
+    u32 m_MainThread = 0;
+
+    ProfilerFrame m_History[PROFILER_HISTORY_SIZE];
+    u64 m_FrameIndex = 0; // The frame being recorded.
+    u64 m_FrameStart = 0;
+
+    // Only touched by the thread the OpenGL context is current on.
+    bool m_GpuEnabled = false;
+    u32 m_GpuQueries[PROFILER_GPU_LATENCY][PROFILER_MAX_GPU_SCOPES * 2] = {};
+    GpuQueryFrame m_GpuFrames[PROFILER_GPU_LATENCY];
+    u64 m_GpuFrameIndex = 0;  // The frame GPU scopes are recorded for.
+    i64 m_GpuClockOffset = 0; // Profiler clock minus GPU clock.
+    u64 m_DroppedGpuFrames = 0;
+
+    std::mutex m_GpuResultsMutex;
+    std::vector<GpuFrameResult> m_GpuResults;
+};
+
+static Profiler g_Profiler;
+static thread_local ProfilerThread* t_ProfilerThread = nullptr;
+
+static ProfilerThread* GetProfilerThread()
+{
+    if (t_ProfilerThread == nullptr)
+    {
+        std::unique_ptr<ProfilerThread> thread = std::make_unique<ProfilerThread>();
+
+        const std::lock_guard<std::mutex> lock(g_Profiler.m_ThreadsMutex);
+        thread->m_Index = scast<u32>(g_Profiler.m_Threads.size());
+        std::snprintf(thread->m_Name, PROFILER_THREAD_NAME_SIZE, "Thread %u", thread->m_Index);
+        t_ProfilerThread = thread.get();
+        g_Profiler.m_Threads.push_back(std::move(thread));
+    }
+
+    return t_ProfilerThread;
+}
+
+static void CalibrateGpuClock()
+{
+    GLint64 gpuTime = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+    g_Profiler.m_GpuClockOffset = scast<i64>(GetProfilerTime()) - gpuTime;
+}
+
+void InitializeProfiler()
+{
+    SetProfilerThreadName("Main");
+    g_Profiler.m_MainThread = GetProfilerThread()->m_Index;
+
+    glGenQueries(PROFILER_GPU_LATENCY * PROFILER_MAX_GPU_SCOPES * 2, &g_Profiler.m_GpuQueries[0][0]);
+    g_Profiler.m_GpuEnabled = true;
+    CalibrateGpuClock();
+}
+
+void ShutdownProfiler()
+{
+    if (g_Profiler.m_GpuEnabled)
+    {
+        glDeleteQueries(PROFILER_GPU_LATENCY * PROFILER_MAX_GPU_SCOPES * 2, &g_Profiler.m_GpuQueries[0][0]);
+        g_Profiler.m_GpuEnabled = false;
+    }
+}
+
+void SetProfilerThreadName(const char* const name)
+{
+    ProfilerThread* const thread = GetProfilerThread();
+
+    const std::lock_guard<std::mutex> lock(g_Profiler.m_ThreadsMutex);
+    std::snprintf(thread->m_Name, PROFILER_THREAD_NAME_SIZE, "%s", name);
+}
+
+u64 GetProfilerTime()
+{
+    return scast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count());
+}
+
+void RecordProfileEvent(const char* const name, const u64 start, const u64 end)
+{
+    ProfilerThread* const thread = GetProfilerThread();
+
+    const u32 write = thread->m_WriteIndex.load(std::memory_order_relaxed);
+    if (write - thread->m_ReadIndex.load(std::memory_order_acquire) >= PROFILER_THREAD_CAPACITY)
+    {
+        thread->m_Dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    thread->m_Events[write & (PROFILER_THREAD_CAPACITY - 1)] = { name, start, end, thread->m_Index };
+    thread->m_WriteIndex.store(write + 1, std::memory_order_release);
+}
+
+// SECTION: GPU scopes
+static GpuQueryFrame& GetCurrentGpuFrame()
+{
+    return g_Profiler.m_GpuFrames[g_Profiler.m_GpuFrameIndex % PROFILER_GPU_LATENCY];
+}
+
+u32 BeginGpuProfileScope(const char* const name)
+{
+    const u32 slot = g_Profiler.m_GpuFrameIndex % PROFILER_GPU_LATENCY;
+    GpuQueryFrame& frame = g_Profiler.m_GpuFrames[slot];
+    if (!g_Profiler.m_GpuEnabled || frame.m_ScopeCount == PROFILER_MAX_GPU_SCOPES)
+    {
+        return PROFILER_INVALID_GPU_SCOPE;
+    }
+
+    const u32 scope = frame.m_ScopeCount++;
+    frame.m_Names[scope] = name;
+    frame.m_Closed[scope] = false;
+    frame.m_LastQuery = scope * 2;
+
+    glQueryCounter(g_Profiler.m_GpuQueries[slot][scope * 2], GL_TIMESTAMP);
+    return scope;
+}
+
+void EndGpuProfileScope(const u32 scope)
+{
+    if (scope == PROFILER_INVALID_GPU_SCOPE)
+    {
+        return;
+    }
+
+    const u32 slot = g_Profiler.m_GpuFrameIndex % PROFILER_GPU_LATENCY;
+    GpuQueryFrame& frame = g_Profiler.m_GpuFrames[slot];
+    frame.m_Closed[scope] = true;
+    frame.m_LastQuery = scope * 2 + 1;
+
+    glQueryCounter(g_Profiler.m_GpuQueries[slot][scope * 2 + 1], GL_TIMESTAMP);
+}
+
+// Reads the GPU scopes of an earlier frame if the GPU is done with them. Never waits.
+static void ResolveGpuFrame(const u32 slot)
+{
+    GpuQueryFrame& frame = g_Profiler.m_GpuFrames[slot];
+    const u32* const queries = g_Profiler.m_GpuQueries[slot];
+
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(queries[frame.m_LastQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE)
+    {
+        return;
+    }
+
+    frame.m_Pending = false;
+
+    GpuFrameResult result = {};
+    result.m_FrameIndex = frame.m_FrameIndex;
+    for (u32 scope = 0; scope < frame.m_ScopeCount; ++scope)
+    {
+        if (!frame.m_Closed[scope])
+        {
+            continue;
+        }
+
+        GLuint64 start = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(queries[scope * 2], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(queries[scope * 2 + 1], GL_QUERY_RESULT, &end);
+
+        result.m_Events.push_back({
+            frame.m_Names[scope],
+            scast<u64>(scast<i64>(start) + g_Profiler.m_GpuClockOffset),
+            scast<u64>(scast<i64>(end) + g_Profiler.m_GpuClockOffset),
+            PROFILER_GPU_THREAD
+        });
+    }
+
+    const std::lock_guard<std::mutex> lock(g_Profiler.m_GpuResultsMutex);
+    g_Profiler.m_GpuResults.push_back(std::move(result));
+}
+
+// Resolves the pending GPU frames at least `minAge` frames older than the one being recorded, oldest first.
+static void ResolveGpuFrames(const u32 minAge)
+{
+    for (u32 age = PROFILER_GPU_LATENCY - 1; age + 1 > minAge; --age)
+    {
+        if (g_Profiler.m_GpuFrameIndex < age)
+        {
+            continue;
+        }
+
+        const u32 slot = (g_Profiler.m_GpuFrameIndex - age) % PROFILER_GPU_LATENCY;
+        if (g_Profiler.m_GpuFrames[slot].m_Pending)
+        {
+            ResolveGpuFrame(slot);
+        }
+    }
+}
+
+// Adds the GPU scopes read back so far to their frames in the history, on the main thread.
+static void MergeGpuResults()
+{
+    const std::lock_guard<std::mutex> lock(g_Profiler.m_GpuResultsMutex);
+    for (GpuFrameResult& result : g_Profiler.m_GpuResults)
+    {
+        ProfilerFrame& target = g_Profiler.m_History[result.m_FrameIndex % PROFILER_HISTORY_SIZE];
+        if (target.m_Index != result.m_FrameIndex)
+        {
+            continue; // Already gone from the history.
+        }
+
+        target.m_Events.insert(target.m_Events.end(), result.m_Events.begin(), result.m_Events.end());
+        target.m_GpuResolved = true;
+    }
+    g_Profiler.m_GpuResults.clear();
+}
+
+// SECTION: Frames
+void BeginProfilerFrame()
+{
+    g_Profiler.m_FrameStart = GetProfilerTime();
+}
+
+void EndProfilerFrame()
+{
+    ProfilerFrame& frame = g_Profiler.m_History[g_Profiler.m_FrameIndex % PROFILER_HISTORY_SIZE];
+    frame.m_Index = g_Profiler.m_FrameIndex;
+    frame.m_Start = g_Profiler.m_FrameStart;
+    frame.m_End = GetProfilerTime();
+    frame.m_Events.clear();
+    frame.m_GpuResolved = false;
+
+    {
+        const std::lock_guard<std::mutex> lock(g_Profiler.m_ThreadsMutex);
+        for (const std::unique_ptr<ProfilerThread>& thread : g_Profiler.m_Threads)
+        {
+            const u32 write = thread->m_WriteIndex.load(std::memory_order_acquire);
+            const u32 read = thread->m_ReadIndex.load(std::memory_order_relaxed);
+            for (u32 i = read; i != write; ++i)
+            {
+                frame.m_Events.push_back(thread->m_Events[i & (PROFILER_THREAD_CAPACITY - 1)]);
+            }
+            thread->m_ReadIndex.store(write, std::memory_order_release);
+        }
+    }
+
+    MergeGpuResults();
+
+    g_Profiler.m_FrameIndex++;
+}
+
+void BeginProfilerGpuFrame(const u64 frameIndex)
+{
+    if (!g_Profiler.m_GpuEnabled)
+    {
+        return;
+    }
+
+    g_Profiler.m_GpuFrameIndex = frameIndex;
+
+    // The GPU clock drifts from the CPU one, so the offset is refreshed now and then.
+    if (frameIndex % PROFILER_GPU_CALIBRATION_INTERVAL == 0)
+    {
+        CalibrateGpuClock();
+    }
+
+    GpuQueryFrame& frame = GetCurrentGpuFrame();
+    if (frame.m_Pending)
+    {
+        g_Profiler.m_DroppedGpuFrames++; // The results didn't arrive in time, the queries are reused.
+    }
+
+    frame.m_FrameIndex = frameIndex;
+    frame.m_ScopeCount = 0;
+    frame.m_Pending = false;
+}
+
+void EndProfilerGpuFrame()
+{
+    if (!g_Profiler.m_GpuEnabled)
+    {
+        return;
+    }
+
+    GetCurrentGpuFrame().m_Pending = GetCurrentGpuFrame().m_ScopeCount > 0;
+
+    // The current frame is resolved in a later one.
+    ResolveGpuFrames(1);
+}
+
+u64 GetProfilerFrameIndex()
+{
+    return g_Profiler.m_FrameIndex;
+}
+
+bool GetProfilerGpuFrameTime(const u64 frameIndex, u64& outNanoseconds)
+{
+    const ProfilerFrame& frame = g_Profiler.m_History[frameIndex % PROFILER_HISTORY_SIZE];
+    if (frame.m_Index != frameIndex || frameIndex >= g_Profiler.m_FrameIndex || !frame.m_GpuResolved)
+    {
+        return false;
+    }
+
+    u64 start = ~0ull;
+    u64 end = 0;
+    for (const ProfileEvent& event : frame.m_Events)
+    {
+        if (event.m_Thread == PROFILER_GPU_THREAD)
+        {
+            start = std::min(start, event.m_Start);
+            end = std::max(end, event.m_End);
+        }
+    }
+
+    outNanoseconds = end > start ? end - start : 0;
+    return true;
+}
+
+void FlushProfilerGpuFrames()
+{
+    if (!g_Profiler.m_GpuEnabled)
+    {
+        return;
+    }
+
+    glFinish();
+    ResolveGpuFrames(0);
+    MergeGpuResults();
+}
+
+// SECTION: Export
+// Calls `fn` for the frames in the history, oldest first.
+template<typename Fn>
+static void ForEachProfilerFrame(Fn&& fn)
+{
+    const u64 count = std::min<u64>(g_Profiler.m_FrameIndex, PROFILER_HISTORY_SIZE);
+    for (u64 index = g_Profiler.m_FrameIndex - count; index < g_Profiler.m_FrameIndex; ++index)
+    {
+        fn(g_Profiler.m_History[index % PROFILER_HISTORY_SIZE]);
+    }
+}
+
+static void WriteJsonString(std::ofstream& out, const char* const text)
+{
+    out << '"';
+    for (const char* c = text; *c != '\0'; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            out << '\\';
+        }
+        out << *c;
+    }
+    out << '"';
+}
+
+static void WriteTraceEvent(
+    std::ofstream& out,
+    const char* const name,
+    const u32 pid,
+    const u32 tid,
+    const u64 start,
+    const u64 end,
+    const u64 base
+)
+{
+    char times[96];
+    std::snprintf(
+        times,
+        sizeof(times),
+        "\"ts\":%.3f,\"dur\":%.3f",
+        (scast<i64>(start - base)) / 1000.0,
+        (scast<i64>(end - start)) / 1000.0
+    );
+
+    out << ",\n{\"name\":";
+    WriteJsonString(out, name);
+    out << ",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << tid << "," << times << "}";
+}
+
+bool SaveChromeTrace(const char* const fileName)
+{
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out)
+    {
+        LOG_ERROR("Failed to open file for writing: %s.", fileName);
+        return false;
+    }
+
+    u64 base = ~0ull;
+    ForEachProfilerFrame([&base](const ProfilerFrame& frame) { base = std::min(base, frame.m_Start); });
+
+    // Process and thread names. CPU threads are process 0, the GPU is process 1.
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+    {
+        const std::lock_guard<std::mutex> lock(g_Profiler.m_ThreadsMutex);
+        for (const std::unique_ptr<ProfilerThread>& thread : g_Profiler.m_Threads)
+        {
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread->m_Index;
+            out << ",\"args\":{\"name\":";
+            WriteJsonString(out, thread->m_Name);
+            out << "}}";
+        }
+    }
+
+    ForEachProfilerFrame([&out, base](const ProfilerFrame& frame)
+    {
+        WriteTraceEvent(out, "Frame", 0, g_Profiler.m_MainThread, frame.m_Start, frame.m_End, base);
+
+        for (const ProfileEvent& event : frame.m_Events)
+        {
+            const bool gpu = event.m_Thread == PROFILER_GPU_THREAD;
+            WriteTraceEvent(out, event.m_Name, gpu ? 1 : 0, gpu ? 0 : event.m_Thread, event.m_Start, event.m_End, base);
+        }
+    });
+
+    out << "\n]}\n";
+
+    if (!out)
+    {
+        LOG_ERROR("Failed to write trace: %s.", fileName);
+        return false;
+    }
+
+    return true;
+}
+
+// Per frame totals of one scope.
+struct ProfileScopeSamples
+{
+    bool m_Gpu;
+    std::vector<float> m_Milliseconds;
+    u64 m_Calls;
+};
+
+static float GetSortedPercentile(const std::vector<float>& sorted, const float percentile)
+{
+    const size_t index = scast<size_t>(percentile * (sorted.size() - 1) + 0.5f);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static std::vector<std::string> BuildProfilerSummary()
+{
+    std::unordered_map<std::string, ProfileScopeSamples> scopes;
+    std::unordered_map<std::string, float> frameTotals;
+    std::vector<float> frameTimes;
+
+    ForEachProfilerFrame([&](const ProfilerFrame& frame)
+    {
+        frameTimes.push_back((frame.m_End - frame.m_Start) / 1e6f);
+
+        frameTotals.clear();
+        for (const ProfileEvent& event : frame.m_Events)
+        {
+            const bool gpu = event.m_Thread == PROFILER_GPU_THREAD;
+            std::string key = std::string(gpu ? "GPU " : "CPU ") + event.m_Name;
+            frameTotals[key] += (event.m_End - event.m_Start) / 1e6f;
+
+            ProfileScopeSamples& samples = scopes[key];
+            samples.m_Gpu = gpu;
+            samples.m_Calls++;
+        }
+
+        for (const auto& [key, total] : frameTotals)
+        {
+            scopes[key].m_Milliseconds.push_back(total);
+        }
+    });
+
+    std::vector<std::string> lines;
+    if (frameTimes.empty())
+    {
+        lines.push_back("No profiled frames.");
+        return lines;
+    }
+
+    char line[256];
+    std::snprintf(
+        line,
+        sizeof(line),
+        "%-36s %9s %9s %9s %9s %9s %8s",
+        "Scope (ms per frame)",
+        "avg",
+        "p50",
+        "p95",
+        "p99",
+        "max",
+        "calls"
+    );
+    lines.push_back(line);
+
+    auto addLine = [&line, &lines](const std::string& name, std::vector<float>& samples, const double calls)
+    {
+        std::sort(samples.begin(), samples.end());
+
+        double sum = 0.0;
+        for (const float sample : samples)
+        {
+            sum += sample;
+        }
+
+        std::snprintf(
+            line,
+            sizeof(line),
+            "%-36.36s %9.3f %9.3f %9.3f %9.3f %9.3f %8.1f",
+            name.c_str(),
+            sum / samples.size(),
+            GetSortedPercentile(samples, 0.5f),
+            GetSortedPercentile(samples, 0.95f),
+            GetSortedPercentile(samples, 0.99f),
+            samples.back(),
+            calls
+        );
+        lines.push_back(line);
+    };
+
+    const size_t frameCount = frameTimes.size();
+    addLine("Frame", frameTimes, 1.0);
+
+    // Most expensive scopes first.
+    std::vector<std::pair<double, std::string>> order;
+    for (const auto& [key, samples] : scopes)
+    {
+        double sum = 0.0;
+        for (const float sample : samples.m_Milliseconds)
+        {
+            sum += sample;
+        }
+        order.push_back({ -sum, key });
+    }
+    std::sort(order.begin(), order.end());
+
+    for (const auto& [negativeSum, key] : order)
+    {
+        ProfileScopeSamples& samples = scopes[key];
+        addLine(key, samples.m_Milliseconds, scast<double>(samples.m_Calls) / samples.m_Milliseconds.size());
+    }
+
+    u64 droppedEvents = 0;
+    {
+        const std::lock_guard<std::mutex> lock(g_Profiler.m_ThreadsMutex);
+        for (const std::unique_ptr<ProfilerThread>& thread : g_Profiler.m_Threads)
+        {
+            droppedEvents += thread->m_Dropped.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::snprintf(
+        line,
+        sizeof(line),
+        "%zu frames, %llu dropped CPU events, %llu dropped GPU frames.",
+        frameCount,
+        scast<unsigned long long>(droppedEvents),
+        scast<unsigned long long>(g_Profiler.m_DroppedGpuFrames)
+    );
+    lines.push_back(line);
+
+    return lines;
+}
+
+bool SaveProfilerSummary(const char* const fileName)
+{
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out)
+    {
+        LOG_ERROR("Failed to open file for writing: %s.", fileName);
+        return false;
+    }
+
+    for (const std::string& line : BuildProfilerSummary())
+    {
+        out << line << '\n';
+    }
+
+    if (!out)
+    {
+        LOG_ERROR("Failed to write profiler summary: %s.", fileName);
+        return false;
+    }
+
+    return true;
+}
+
+void LogProfilerSummary()
+{
+    for (const std::string& line : BuildProfilerSummary())
+    {
+        LOG_INFO("%s", line.c_str());
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+
+#include "common.h"
+
+// CPU and GPU frame profiler.
+// CPU scopes are written into a ring owned by the calling thread, so recording never takes a lock. The main thread
+// collects the rings once per frame. GPU scopes are timestamp queries kept in flight for a few frames and read back
+// only once they are available, so the profiler never waits for the GPU. They are recorded and read back by the
+// thread the OpenGL context is current on, which can be another thread than the main one, e.g. the render thread.
+// A history of recent frames can be saved as a Chrome trace (chrome://tracing, ui.perfetto.dev) or as a summary
+// of percentiles per scope.
+
+constexpr u32 PROFILER_HISTORY_SIZE = 256;       // Frames kept for the exports.
+constexpr u32 PROFILER_THREAD_CAPACITY = 4096;   // Unread events per thread before new ones are dropped.
+constexpr u32 PROFILER_MAX_GPU_SCOPES = 64;      // GPU scopes per frame.
+constexpr u32 PROFILER_GPU_LATENCY = 4;          // Frames the GPU queries stay in flight.
+constexpr u32 PROFILER_THREAD_NAME_SIZE = 32;
+
+struct ProfileEvent
+{
+    const char* m_Name; // Must outlive the profiler, e.g. a string literal.
+    u64 m_Start;        // Nanoseconds on the profiler clock.
+    u64 m_End;
+    u32 m_Thread;       // Index of the recording thread, GPU events use PROFILER_GPU_THREAD.
+};
+
+constexpr u32 PROFILER_GPU_THREAD = ~0u;
+
+struct ProfilerFrame
+{
+    u64 m_Index;
+    u64 m_Start;
+    u64 m_End;
+    std::vector<ProfileEvent> m_Events;
+    bool m_GpuResolved; // The GPU scopes of the frame have been added to m_Events.
+};
+
+// Call on the main thread once the OpenGL context is current.
+void InitializeProfiler();
+void ShutdownProfiler();
+
+// Names the calling thread in the exports.
+void SetProfilerThreadName(const char* const name);
+
+// Nanoseconds on the profiler clock.
+u64 GetProfilerTime();
+
+// Frame boundaries, on the main thread. The end collects the CPU scopes of all threads and the GPU scopes of
+// earlier frames whose results have arrived.
+void BeginProfilerFrame();
+void EndProfilerFrame();
+
+// GPU scopes between these go to the frame `frameIndex`, which must be a frame the main thread has started. Call on
+// the thread the OpenGL context is current on. The end reads back the earlier frames whose results have arrived.
+void BeginProfilerGpuFrame(const u64 frameIndex);
+void EndProfilerGpuFrame();
+
+// Index of the frame being recorded.
+u64 GetProfilerFrameIndex();
+
+void RecordProfileEvent(const char* const name, const u64 start, const u64 end);
+
+// Nanoseconds from the start of the first GPU scope of a frame to the end of its last one. Returns false if the GPU
+// results of the frame haven't been read yet or the frame is no longer in the history.
+bool GetProfilerGpuFrameTime(const u64 frameIndex, u64& outNanoseconds);
+
+// Waits for the GPU and reads the GPU scopes of all finished frames, e.g. before the results of a benchmark run
+// are saved. Call on the main thread with the OpenGL context current and no GPU frame being recorded.
+void FlushProfilerGpuFrames();
+
+// GPU scopes can nest but must be opened and closed on the thread the OpenGL context is current on, between
+// BeginProfilerGpuFrame() and EndProfilerGpuFrame(). Returns an ID for EndGpuProfileScope().
+u32 BeginGpuProfileScope(const char* const name);
+void EndGpuProfileScope(const u32 scope);
+
+bool SaveChromeTrace(const char* const fileName);
+bool SaveProfilerSummary(const char* const fileName);
+void LogProfilerSummary();
+
+struct ProfileScope
+{
+    const char* m_Name;
+    u64 m_Start;
+
+    explicit ProfileScope(const char* const name) : m_Name(name), m_Start(GetProfilerTime()) {}
+    ~ProfileScope() { RecordProfileEvent(m_Name, m_Start, GetProfilerTime()); }
+};
+
+struct GpuProfileScope
+{
+    u32 m_Scope;
+
+    explicit GpuProfileScope(const char* const name) : m_Scope(BeginGpuProfileScope(name)) {}
+    ~GpuProfileScope() { EndGpuProfileScope(m_Scope); }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing block.
+#define PROFILE_SCOPE(name) const ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) const GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
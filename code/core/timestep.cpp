@@ -0,0 +1,39 @@
+#include "core/timestep.h"
+
+#include <algorithm>
+
+FixedTimestep CreateFixedTimestep(const double ticksPerSecond, const u32 maxTicksPerFrame)
+{
+    FixedTimestep result = {};
+
+    result.m_TickDuration = 1.0 / ticksPerSecond;
+    result.m_MaxTicksPerFrame = maxTicksPerFrame > 0 ? maxTicksPerFrame : 1;
+
+    return result;
+}
+
+u32 AdvanceFixedTimestep(FixedTimestep& timestep, const double frameTime)
+{
+    timestep.m_Accumulator += frameTime > 0.0 ? frameTime : 0.0;
+
+    u32 result = scast<u32>(timestep.m_Accumulator / timestep.m_TickDuration);
+    if (result > timestep.m_MaxTicksPerFrame)
+    {
+        // Fall behind real time instead of trying to catch up, e.g. after a breakpoint or a window drag.
+        const double dropped = timestep.m_Accumulator - timestep.m_MaxTicksPerFrame * timestep.m_TickDuration;
+        timestep.m_DroppedTime += dropped;
+        timestep.m_Accumulator -= dropped;
+        result = timestep.m_MaxTicksPerFrame;
+    }
+
+    timestep.m_Accumulator -= result * timestep.m_TickDuration;
+    timestep.m_TickCount += result;
+
+    return result;
+}
+
+float GetFixedTimestepAlpha(const FixedTimestep& timestep)
+{
+    const double alpha = timestep.m_Accumulator / timestep.m_TickDuration;
+    return scast<float>(std::clamp(alpha, 0.0, 0.999999));
+}
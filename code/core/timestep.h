@@ -0,0 +1,23 @@
+#pragma once
+
+#include "common.h"
+
+// Fixed timestep accumulator. Frame time is collected and consumed in ticks of constant length, so the
+// simulation behaves the same at any frame rate. The leftover time is used to interpolate between the last two
+// simulation states when rendering.
+struct FixedTimestep
+{
+    double m_TickDuration;
+    double m_Accumulator = 0.0;
+    u32 m_MaxTicksPerFrame;     // Caps the catch-up work after a long frame, so slow ticks can't snowball.
+    u64 m_TickCount = 0;
+    double m_DroppedTime = 0.0; // Total time thrown away because of m_MaxTicksPerFrame.
+};
+
+FixedTimestep CreateFixedTimestep(const double ticksPerSecond, const u32 maxTicksPerFrame);
+
+// Adds the duration of a frame and returns the number of ticks to simulate this frame.
+u32 AdvanceFixedTimestep(FixedTimestep& timestep, const double frameTime);
+
+// Fraction of a tick accumulated after the last simulated tick, in [0, 1).
+float GetFixedTimestepAlpha(const FixedTimestep& timestep);
@@ -0,0 +1,70 @@
+#include "ecs/command_buffer.h"
+
+u8* PushEntityCommand(EntityCommandBuffer& buffer, const EntityCommandHeader& header)
+{
+    const size_t offset = buffer.m_Data.size();
+    buffer.m_Data.resize(offset + sizeof(EntityCommandHeader) + header.m_Size);
+    std::memcpy(buffer.m_Data.data() + offset, &header, sizeof(EntityCommandHeader));
+    buffer.m_CommandCount++;
+
+    return buffer.m_Data.data() + offset + sizeof(EntityCommandHeader);
+}
+
+void PlaybackCommands(World& world, EntityCommandBuffer& buffer)
+{
+    Entity pending = NULL_ENTITY;
+
+    size_t offset = 0;
+    while (offset < buffer.m_Data.size())
+    {
+        // The stream has no alignment guarantees, so copy the header out.
+        EntityCommandHeader header = {};
+        std::memcpy(&header, buffer.m_Data.data() + offset, sizeof(EntityCommandHeader));
+        const u8* const payload = buffer.m_Data.data() + offset + sizeof(EntityCommandHeader);
+        offset += sizeof(EntityCommandHeader) + header.m_Size;
+
+        const Entity entity = header.m_Entity == PENDING_ENTITY ? pending : header.m_Entity;
+
+        switch (header.m_Type)
+        {
+        case EntityCommandType::Create:
+        {
+            pending = CreateEntity(world, header.m_Mask);
+        } break;
+
+        case EntityCommandType::Destroy:
+        {
+            DestroyEntity(world, entity);
+        } break;
+
+        case EntityCommandType::AddComponent:
+        {
+            if (void* const component = AddComponentData(world, entity, header.m_Component); component)
+            {
+                std::memcpy(component, payload, header.m_Size);
+            }
+        } break;
+
+        case EntityCommandType::SetComponent:
+        {
+            if (void* const component = GetComponentData(world, entity, header.m_Component); component)
+            {
+                std::memcpy(component, payload, header.m_Size);
+            }
+        } break;
+
+        case EntityCommandType::RemoveComponent:
+        {
+            RemoveComponentData(world, entity, header.m_Component);
+        } break;
+
+        default:
+        {
+            LOG_ERROR("Unknown entity command type %u.", scast<u32>(header.m_Type));
+        } break;
+        }
+    }
+
+    buffer.m_Data.clear();
+    buffer.m_CommandCount = 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include "common.h"
+#include "ecs/ecs.h"
+
+// Records structural changes while a query is running, to be applied afterwards with PlaybackCommands().
+// Commands are packed back to back in a byte stream together with their component data. Use one buffer per
+// thread when recording from parallel queries.
+
+enum class EntityCommandType : u32
+{
+    Create,          // Creates an entity with m_Mask. Following SetComponent commands with PENDING_ENTITY target it.
+    Destroy,
+    AddComponent,    // Followed by m_Size bytes of component data.
+    SetComponent,    // Followed by m_Size bytes of component data.
+    RemoveComponent,
+};
+
+// Refers to the entity created by the last Create command of the same buffer.
+constexpr Entity PENDING_ENTITY = { ECS_INVALID_INDEX, ECS_INVALID_INDEX };
+
+struct EntityCommandHeader
+{
+    EntityCommandType m_Type;
+    ComponentId m_Component;
+    Entity m_Entity;
+    ComponentMask m_Mask;
+    u32 m_Size;
+};
+
+struct EntityCommandBuffer
+{
+    std::vector<u8> m_Data;
+    u32 m_CommandCount = 0;
+};
+
+// Appends a command and returns a pointer to its `size` bytes of payload.
+u8* PushEntityCommand(EntityCommandBuffer& buffer, const EntityCommandHeader& header);
+
+// Applies the recorded commands in order and clears the buffer.
+void PlaybackCommands(World& world, EntityCommandBuffer& buffer);
+
+inline void DeferDestroyEntity(EntityCommandBuffer& buffer, const Entity entity)
+{
+    PushEntityCommand(buffer, { EntityCommandType::Destroy, 0, entity, 0, 0 });
+}
+
+template<typename T>
+void DeferAddComponent(EntityCommandBuffer& buffer, const Entity entity, const T& component)
+{
+    u8* const payload = PushEntityCommand(
+        buffer,
+        { EntityCommandType::AddComponent, GetComponentId<T>(), entity, 0, sizeof(T) }
+    );
+    std::memcpy(payload, &component, sizeof(T));
+}
+
+template<typename T>
+void DeferRemoveComponent(EntityCommandBuffer& buffer, const Entity entity)
+{
+    PushEntityCommand(buffer, { EntityCommandType::RemoveComponent, GetComponentId<T>(), entity, 0, 0 });
+}
+
+// Records the creation of an entity directly in the archetype of the given components.
+template<typename... Ts>
+void DeferCreateEntity(EntityCommandBuffer& buffer, const Ts&... components)
+{
+    PushEntityCommand(buffer, { EntityCommandType::Create, 0, PENDING_ENTITY, MakeComponentMask<Ts...>(), 0 });
+
+    auto setComponent = [&](const ComponentId id, const void* const data, const u32 size)
+    {
+        u8* const payload = PushEntityCommand(buffer, { EntityCommandType::SetComponent, id, PENDING_ENTITY, 0, size });
+        std::memcpy(payload, data, size);
+    };
+
+    (setComponent(GetComponentId<Ts>(), &components, sizeof(Ts)), ...);
+}
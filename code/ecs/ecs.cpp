@@ -0,0 +1,344 @@
+#include "ecs/ecs.h"
+
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+constexpr u32 ECS_CHUNK_ALIGNMENT = 64;
+constexpr u32 ECS_MIN_ARRAY_ALIGNMENT = 16; // Keeps every component array usable with aligned SIMD loads.
+
+struct ComponentInfo
+{
+    u32 m_Size;
+    u32 m_Alignment;
+};
+
+static std::mutex g_ComponentRegistryMutex;
+static std::vector<ComponentInfo> g_ComponentRegistry;
+
+ComponentId RegisterComponent(const u32 size, const u32 alignment)
+{
+    const std::lock_guard<std::mutex> lock(g_ComponentRegistryMutex);
+
+    // Every ID is a bit of ComponentMask, so there is none left to hand out. Sharing one would store the new type in
+    // another type's arrays.
+    if (g_ComponentRegistry.size() >= ECS_MAX_COMPONENTS)
+    {
+        LOG_ERROR("Too many component types, the limit is %u.", ECS_MAX_COMPONENTS);
+        std::abort();
+    }
+
+    const ComponentId result = scast<ComponentId>(g_ComponentRegistry.size());
+    g_ComponentRegistry.push_back({ size, alignment });
+
+    return result;
+}
+
+static u32 AlignChunkOffset(const u32 value, const u32 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Returns ECS_INVALID_INDEX when a row of the components doesn't fit in a chunk.
+static u32 GetOrCreateArchetype(World& world, const ComponentMask mask)
+{
+    if (const auto it = world.m_ArchetypeIndices.find(mask); it != world.m_ArchetypeIndices.end())
+    {
+        return it->second;
+    }
+
+    std::unique_ptr<Archetype> archetype = std::make_unique<Archetype>();
+    archetype->m_Mask = mask;
+    archetype->m_EntityCount = 0;
+
+    const std::lock_guard<std::mutex> lock(g_ComponentRegistryMutex);
+
+    u32 rowSize = sizeof(Entity);
+    for (ComponentMask bits = mask; bits != 0; bits &= bits - 1)
+    {
+        const ComponentId id = scast<ComponentId>(std::countr_zero(bits));
+        archetype->m_Components.push_back(id);
+        archetype->m_ComponentSizes[id] = g_ComponentRegistry[id].m_Size;
+        rowSize += g_ComponentRegistry[id].m_Size;
+    }
+
+    // Start from the capacity ignoring padding and shrink until the aligned arrays fit in a chunk.
+    u32 capacity = ECS_CHUNK_SIZE / rowSize;
+    for (; capacity > 0; --capacity)
+    {
+        u32 offset = capacity * sizeof(Entity);
+        for (const ComponentId id : archetype->m_Components)
+        {
+            const u32 alignment = std::max(g_ComponentRegistry[id].m_Alignment, ECS_MIN_ARRAY_ALIGNMENT);
+            offset = AlignChunkOffset(offset, alignment);
+            archetype->m_Offsets[id] = offset;
+            offset += archetype->m_ComponentSizes[id] * capacity;
+        }
+
+        if (offset <= ECS_CHUNK_SIZE)
+        {
+            break;
+        }
+    }
+
+    // Not registered, so every later attempt fails the same way instead of writing past a chunk.
+    if (capacity == 0)
+    {
+        LOG_ERROR("Archetype 0x%llx does not fit in a %u byte chunk.", scast<unsigned long long>(mask), ECS_CHUNK_SIZE);
+        return ECS_INVALID_INDEX;
+    }
+
+    archetype->m_ChunkCapacity = capacity;
+
+    const u32 result = scast<u32>(world.m_Archetypes.size());
+    world.m_Archetypes.push_back(std::move(archetype));
+    world.m_ArchetypeIndices.emplace(mask, result);
+
+    return result;
+}
+
+static u8* AllocateChunkMemory()
+{
+    return scast<u8*>(::operator new(ECS_CHUNK_SIZE, std::align_val_t(ECS_CHUNK_ALIGNMENT)));
+}
+
+static void FreeChunkMemory(u8* const data)
+{
+    ::operator delete(data, std::align_val_t(ECS_CHUNK_ALIGNMENT));
+}
+
+static u8* GetChunkComponentPointer(const Archetype& archetype, const ArchetypeChunk& chunk, const ComponentId id, const u32 row)
+{
+    return chunk.m_Data + archetype.m_Offsets[id] + row * archetype.m_ComponentSizes[id];
+}
+
+// Appends a row with zeroed components to the archetype.
+static void AllocateArchetypeRow(Archetype& archetype, const Entity entity, u32& outChunk, u32& outRow)
+{
+    if (archetype.m_Chunks.empty() || archetype.m_Chunks.back().m_Count == archetype.m_ChunkCapacity)
+    {
+        archetype.m_Chunks.push_back({ AllocateChunkMemory(), 0 });
+    }
+
+    ArchetypeChunk& chunk = archetype.m_Chunks.back();
+    outChunk = scast<u32>(archetype.m_Chunks.size() - 1);
+    outRow = chunk.m_Count++;
+    archetype.m_EntityCount++;
+
+    rcast<Entity*>(chunk.m_Data)[outRow] = entity;
+    for (const ComponentId id : archetype.m_Components)
+    {
+        std::memset(GetChunkComponentPointer(archetype, chunk, id, outRow), 0, archetype.m_ComponentSizes[id]);
+    }
+}
+
+// Removes a row by moving the last row of the archetype into it, so the chunks stay densely packed.
+static void RemoveArchetypeRow(World& world, Archetype& archetype, const u32 chunkIndex, const u32 row)
+{
+    ArchetypeChunk& chunk = archetype.m_Chunks[chunkIndex];
+    ArchetypeChunk& last = archetype.m_Chunks.back();
+    const u32 lastRow = last.m_Count - 1;
+
+    if (&chunk != &last || row != lastRow)
+    {
+        const Entity moved = rcast<Entity*>(last.m_Data)[lastRow];
+        rcast<Entity*>(chunk.m_Data)[row] = moved;
+
+        for (const ComponentId id : archetype.m_Components)
+        {
+            std::memcpy(
+                GetChunkComponentPointer(archetype, chunk, id, row),
+                GetChunkComponentPointer(archetype, last, id, lastRow),
+                archetype.m_ComponentSizes[id]
+            );
+        }
+
+        EntityRecord& record = world.m_Entities[moved.m_Index];
+        record.m_Chunk = chunkIndex;
+        record.m_Row = row;
+    }
+
+    last.m_Count--;
+    archetype.m_EntityCount--;
+
+    if (last.m_Count == 0)
+    {
+        FreeChunkMemory(last.m_Data);
+        archetype.m_Chunks.pop_back();
+    }
+}
+
+Entity CreateEntity(World& world, const ComponentMask mask)
+{
+    const u32 archetype = GetOrCreateArchetype(world, mask);
+    if (archetype == ECS_INVALID_INDEX)
+    {
+        return NULL_ENTITY;
+    }
+
+    Entity result = {};
+
+    if (!world.m_FreeEntities.empty())
+    {
+        result.m_Index = world.m_FreeEntities.back();
+        world.m_FreeEntities.pop_back();
+    }
+    else
+    {
+        result.m_Index = scast<u32>(world.m_Entities.size());
+        world.m_Entities.push_back({ ECS_INVALID_INDEX, 0, 0, 0 });
+    }
+
+    EntityRecord& record = world.m_Entities[result.m_Index];
+    result.m_Generation = record.m_Generation;
+
+    record.m_Archetype = archetype;
+    AllocateArchetypeRow(*world.m_Archetypes[record.m_Archetype], result, record.m_Chunk, record.m_Row);
+
+    return result;
+}
+
+void DestroyEntity(World& world, const Entity entity)
+{
+    if (!IsEntityAlive(world, entity))
+    {
+        return;
+    }
+
+    EntityRecord& record = world.m_Entities[entity.m_Index];
+    RemoveArchetypeRow(world, *world.m_Archetypes[record.m_Archetype], record.m_Chunk, record.m_Row);
+
+    record.m_Archetype = ECS_INVALID_INDEX;
+    record.m_Generation++;
+    world.m_FreeEntities.push_back(entity.m_Index);
+}
+
+bool IsEntityAlive(const World& world, const Entity entity)
+{
+    return entity.m_Index < world.m_Entities.size()
+        && world.m_Entities[entity.m_Index].m_Generation == entity.m_Generation
+        && world.m_Entities[entity.m_Index].m_Archetype != ECS_INVALID_INDEX;
+}
+
+void* GetComponentData(World& world, const Entity entity, const ComponentId component)
+{
+    if (!IsEntityAlive(world, entity))
+    {
+        return nullptr;
+    }
+
+    const EntityRecord& record = world.m_Entities[entity.m_Index];
+    const Archetype& archetype = *world.m_Archetypes[record.m_Archetype];
+
+    if ((archetype.m_Mask & (ComponentMask(1) << component)) == 0)
+    {
+        return nullptr;
+    }
+
+    return GetChunkComponentPointer(archetype, archetype.m_Chunks[record.m_Chunk], component, record.m_Row);
+}
+
+// Moves an entity to the archetype of `newMask`, keeping the components both archetypes have. Returns false and
+// leaves the entity where it is if that archetype can't be created.
+static bool MoveEntityToArchetype(World& world, const Entity entity, const ComponentMask newMask)
+{
+    EntityRecord& record = world.m_Entities[entity.m_Index];
+
+    const u32 newArchetypeIndex = GetOrCreateArchetype(world, newMask);
+    if (newArchetypeIndex == ECS_INVALID_INDEX)
+    {
+        return false;
+    }
+
+    Archetype& oldArchetype = *world.m_Archetypes[record.m_Archetype];
+    Archetype& newArchetype = *world.m_Archetypes[newArchetypeIndex];
+
+    u32 newChunk = 0;
+    u32 newRow = 0;
+    AllocateArchetypeRow(newArchetype, entity, newChunk, newRow);
+
+    const ArchetypeChunk& oldChunkData = oldArchetype.m_Chunks[record.m_Chunk];
+    const ArchetypeChunk& newChunkData = newArchetype.m_Chunks[newChunk];
+    for (const ComponentId id : newArchetype.m_Components)
+    {
+        if (oldArchetype.m_Mask & (ComponentMask(1) << id))
+        {
+            std::memcpy(
+                GetChunkComponentPointer(newArchetype, newChunkData, id, newRow),
+                GetChunkComponentPointer(oldArchetype, oldChunkData, id, record.m_Row),
+                newArchetype.m_ComponentSizes[id]
+            );
+        }
+    }
+
+    RemoveArchetypeRow(world, oldArchetype, record.m_Chunk, record.m_Row);
+
+    record.m_Archetype = newArchetypeIndex;
+    record.m_Chunk = newChunk;
+    record.m_Row = newRow;
+
+    return true;
+}
+
+void* AddComponentData(World& world, const Entity entity, const ComponentId component)
+{
+    if (!IsEntityAlive(world, entity))
+    {
+        return nullptr;
+    }
+
+    const ComponentMask mask = world.m_Archetypes[world.m_Entities[entity.m_Index].m_Archetype]->m_Mask;
+    const ComponentMask bit = ComponentMask(1) << component;
+    if ((mask & bit) == 0 && !MoveEntityToArchetype(world, entity, mask | bit))
+    {
+        return nullptr;
+    }
+
+    return GetComponentData(world, entity, component);
+}
+
+void RemoveComponentData(World& world, const Entity entity, const ComponentId component)
+{
+    if (!IsEntityAlive(world, entity))
+    {
+        return;
+    }
+
+    const ComponentMask mask = world.m_Archetypes[world.m_Entities[entity.m_Index].m_Archetype]->m_Mask;
+    const ComponentMask bit = ComponentMask(1) << component;
+    if (mask & bit)
+    {
+        MoveEntityToArchetype(world, entity, mask & ~bit);
+    }
+}
+
+void CollectChunks(World& world, const ComponentMask mask, std::vector<ChunkRef>& outChunks)
+{
+    for (const std::unique_ptr<Archetype>& archetype : world.m_Archetypes)
+    {
+        if ((archetype->m_Mask & mask) != mask)
+        {
+            continue;
+        }
+
+        for (ArchetypeChunk& chunk : archetype->m_Chunks)
+        {
+            outChunks.push_back({ archetype.get(), &chunk });
+        }
+    }
+}
+
+void DestroyWorld(World& world)
+{
+    for (const std::unique_ptr<Archetype>& archetype : world.m_Archetypes)
+    {
+        for (const ArchetypeChunk& chunk : archetype->m_Chunks)
+        {
+            FreeChunkMemory(chunk.m_Data);
+        }
+    }
+
+    world = {};
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+#include "core/jobs.h"
+
+// Archetype based entity-component system.
+// Entities with the same set of components share an archetype. An archetype stores its entities in fixed size
+// chunks, and every chunk holds one contiguous array per component, so queries walk linear memory.
+// Components must be trivially copyable since they are moved between chunks with memcpy.
+// Structural changes (creating/destroying entities, adding/removing components) invalidate component pointers
+// and must not happen while iterating a query; record them in an EntityCommandBuffer instead.
+
+using ComponentId = u32;
+using ComponentMask = u64;
+
+constexpr u32 ECS_CHUNK_SIZE = 16 * 1024;
+constexpr u32 ECS_MAX_COMPONENTS = 64;
+constexpr u32 ECS_INVALID_INDEX = ~0u;
+
+struct Entity
+{
+    u32 m_Index;
+    u32 m_Generation;
+};
+
+constexpr Entity NULL_ENTITY = { ECS_INVALID_INDEX, 0 };
+
+inline bool operator==(const Entity a, const Entity b)
+{
+    return a.m_Index == b.m_Index && a.m_Generation == b.m_Generation;
+}
+
+struct ArchetypeChunk
+{
+    u8* m_Data; // ECS_CHUNK_SIZE bytes: the entity array followed by one array per component.
+    u32 m_Count;
+};
+
+struct Archetype
+{
+    ComponentMask m_Mask;
+    std::vector<ComponentId> m_Components;
+    u32 m_Offsets[ECS_MAX_COMPONENTS];        // Offset of each component array in a chunk, indexed by ComponentId.
+    u32 m_ComponentSizes[ECS_MAX_COMPONENTS]; // Indexed by ComponentId.
+    u32 m_ChunkCapacity;
+    std::vector<ArchetypeChunk> m_Chunks;     // Only the last chunk may be partially filled.
+    u32 m_EntityCount;
+};
+
+struct EntityRecord
+{
+    u32 m_Archetype;
+    u32 m_Chunk;
+    u32 m_Row;
+    u32 m_Generation;
+};
+
+struct World
+{
+    std::vector<std::unique_ptr<Archetype>> m_Archetypes;
+    std::unordered_map<ComponentMask, u32> m_ArchetypeIndices;
+    std::vector<EntityRecord> m_Entities;
+    std::vector<u32> m_FreeEntities;
+};
+
+// A chunk matched by a query.
+struct ChunkRef
+{
+    Archetype* m_Archetype;
+    ArchetypeChunk* m_Chunk;
+};
+
+// Registers a component type and returns its ID. Use GetComponentId<T>() instead. Registering more than
+// ECS_MAX_COMPONENTS types aborts.
+ComponentId RegisterComponent(const u32 size, const u32 alignment);
+
+template<typename T>
+ComponentId GetComponentId()
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Components are moved with memcpy.");
+    static const ComponentId id = RegisterComponent(sizeof(T), alignof(T));
+    return id;
+}
+
+template<typename... Ts>
+ComponentMask MakeComponentMask()
+{
+    return (ComponentMask(0) | ... | (ComponentMask(1) << GetComponentId<Ts>()));
+}
+
+// Creates an entity with zero initialized components. Returns NULL_ENTITY if a row of the components doesn't fit in
+// a chunk.
+Entity CreateEntity(World& world, const ComponentMask mask);
+
+void DestroyEntity(World& world, const Entity entity);
+
+bool IsEntityAlive(const World& world, const Entity entity);
+
+// Returns the component of the entity, or nullptr if the entity doesn't have it.
+void* GetComponentData(World& world, const Entity entity, const ComponentId component);
+
+// Moves the entity to the archetype with the component and returns the zero initialized component.
+// Returns the existing component if the entity already has it, nullptr if the entity isn't alive or the resulting
+// row doesn't fit in a chunk.
+void* AddComponentData(World& world, const Entity entity, const ComponentId component);
+
+void RemoveComponentData(World& world, const Entity entity, const ComponentId component);
+
+// Appends the non-empty chunks of all archetypes that have every component in `mask`.
+void CollectChunks(World& world, const ComponentMask mask, std::vector<ChunkRef>& outChunks);
+
+// Destroys every entity and frees all chunks.
+void DestroyWorld(World& world);
+
+template<typename T>
+T* GetComponent(World& world, const Entity entity)
+{
+    return scast<T*>(GetComponentData(world, entity, GetComponentId<T>()));
+}
+
+// Returns nullptr when the component can't be added, see AddComponentData().
+template<typename T>
+T* AddComponent(World& world, const Entity entity, const T& value)
+{
+    T* const result = scast<T*>(AddComponentData(world, entity, GetComponentId<T>()));
+    if (result != nullptr)
+    {
+        *result = value;
+    }
+
+    return result;
+}
+
+template<typename T>
+void RemoveComponent(World& world, const Entity entity)
+{
+    RemoveComponentData(world, entity, GetComponentId<T>());
+}
+
+// Creates an entity directly in the archetype of the given components. Returns NULL_ENTITY on failure, see
+// CreateEntity().
+template<typename... Ts>
+Entity CreateEntityWith(World& world, const Ts&... components)
+{
+    const Entity result = CreateEntity(world, MakeComponentMask<Ts...>());
+    if (result == NULL_ENTITY)
+    {
+        return result;
+    }
+
+    ((*GetComponent<Ts>(world, result) = components), ...);
+    return result;
+}
+
+inline const Entity* GetChunkEntities(const ArchetypeChunk& chunk)
+{
+    return rcast<const Entity*>(chunk.m_Data);
+}
+
+template<typename T>
+T* GetChunkComponents(const Archetype& archetype, const ArchetypeChunk& chunk)
+{
+    return rcast<T*>(chunk.m_Data + archetype.m_Offsets[GetComponentId<T>()]);
+}
+
+// Calls `fn(count, entities, components...)` once per chunk of the entities that have all of `Ts`,
+// where `components` are pointers to the contiguous component arrays of the chunk.
+template<typename... Ts, typename Fn>
+void ForEachChunk(World& world, Fn&& fn)
+{
+    const ComponentMask mask = MakeComponentMask<Ts...>();
+
+    for (const std::unique_ptr<Archetype>& archetype : world.m_Archetypes)
+    {
+        if ((archetype->m_Mask & mask) != mask)
+        {
+            continue;
+        }
+
+        for (ArchetypeChunk& chunk : archetype->m_Chunks)
+        {
+            fn(chunk.m_Count, GetChunkEntities(chunk), GetChunkComponents<Ts>(*archetype, chunk)...);
+        }
+    }
+}
+
+// Calls `fn(entity, components...)` for every entity that has all of `Ts`.
+template<typename... Ts, typename Fn>
+void ForEach(World& world, Fn&& fn)
+{
+    ForEachChunk<Ts...>(world, [&](const u32 count, const Entity* const entities, Ts* const... components)
+    {
+        for (u32 i = 0; i < count; ++i)
+        {
+            fn(entities[i], components[i]...);
+        }
+    });
+}
+
+// Same as ForEachChunk() but the chunks are distributed over the job system workers.
+// `fn` must only touch the chunk it is given.
+template<typename... Ts, typename Fn>
+void ForEachChunkParallel(World& world, Fn&& fn)
+{
+    std::vector<ChunkRef> chunks;
+    CollectChunks(world, MakeComponentMask<Ts...>(), chunks);
+
+    ParallelFor(scast<u32>(chunks.size()), 1, [&](const u32 begin, const u32 end)
+    {
+        for (u32 i = begin; i < end; ++i)
+        {
+            const ChunkRef& ref = chunks[i];
+            fn(ref.m_Chunk->m_Count, GetChunkEntities(*ref.m_Chunk), GetChunkComponents<Ts>(*ref.m_Archetype, *ref.m_Chunk)...);
+        }
+    });
+}
@@ -0,0 +1,190 @@
+#include "geometry/mesh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <fstream>
+
+#include <glm/glm.hpp>
+
+#include "geometry/simplify.h"
+
+// LODs that remove less than this fraction of the previous triangles aren't worth a level.
+constexpr float MESH_LOD_MIN_REDUCTION = 0.1f;
+
+LODMesh BuildMeshLODs(
+    const float* const vertices,
+    const u32 vertexCount,
+    const u32 stride,
+    const u32* const indices,
+    const u32 indexCount,
+    const u32 maxLODs,
+    const float reduction,
+    const float* const attributeWeights
+)
+{
+    LODMesh result = {};
+    result.m_Vertices.assign(vertices, vertices + vertexCount * stride);
+    result.m_Stride = stride;
+    result.m_VertexCount = vertexCount;
+    result.m_Indices.assign(indices, indices + indexCount);
+    result.m_LODs.push_back({ 0, indexCount, 0.0f });
+
+    // Every level is simplified from the original mesh, so the errors are measured against LOD 0 and don't add up.
+    std::vector<u32> lodIndices;
+    u32 previousCount = indexCount;
+    const u32 lodLimit = std::min(maxLODs, MESH_MAX_LODS);
+    while (result.m_LODs.size() < lodLimit)
+    {
+        const u32 targetCount = scast<u32>(previousCount * reduction) / 3 * 3;
+        const float error = SimplifyMesh(
+            vertices,
+            vertexCount,
+            stride,
+            indices,
+            indexCount,
+            targetCount,
+            FLT_MAX,
+            attributeWeights,
+            lodIndices
+        );
+
+        const u32 lodCount = scast<u32>(lodIndices.size());
+        if (lodCount == 0 || lodCount > previousCount * (1.0f - MESH_LOD_MIN_REDUCTION))
+        {
+            break;
+        }
+
+        result.m_LODs.push_back({ scast<u32>(result.m_Indices.size()), lodCount, error });
+        result.m_Indices.insert(result.m_Indices.end(), lodIndices.begin(), lodIndices.end());
+        previousCount = lodCount;
+    }
+
+    return result;
+}
+
+bool SaveMeshFile(const char* const fileName, const LODMesh& mesh)
+{
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out)
+    {
+        LOG_ERROR("Failed to open file for writing: %s.", fileName);
+        return false;
+    }
+
+    const MeshFileHeader header =
+    {
+        .m_Magic = MESH_FILE_MAGIC,
+        .m_Version = MESH_FILE_VERSION,
+        .m_Stride = mesh.m_Stride,
+        .m_VertexCount = mesh.m_VertexCount,
+        .m_IndexCount = scast<u32>(mesh.m_Indices.size()),
+        .m_LODCount = scast<u32>(mesh.m_LODs.size()),
+    };
+
+    out.write(rcast<const char*>(&header), sizeof(header));
+    out.write(rcast<const char*>(mesh.m_Vertices.data()), mesh.m_Vertices.size() * sizeof(float));
+    out.write(rcast<const char*>(mesh.m_Indices.data()), mesh.m_Indices.size() * sizeof(u32));
+    out.write(rcast<const char*>(mesh.m_LODs.data()), mesh.m_LODs.size() * sizeof(MeshLOD));
+
+    if (!out)
+    {
+        LOG_ERROR("Failed to write mesh file: %s.", fileName);
+        return false;
+    }
+
+    return true;
+}
+
+bool LoadMeshFile(const char* const fileName, LODMesh& mesh)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in)
+    {
+        LOG_ERROR("Failed to open file: %s.", fileName);
+        return false;
+    }
+
+    MeshFileHeader header = {};
+    in.read(rcast<char*>(&header), sizeof(header));
+    if (!in || header.m_Magic != MESH_FILE_MAGIC || header.m_Version != MESH_FILE_VERSION)
+    {
+        LOG_ERROR("Not a supported mesh file: %s.", fileName);
+        return false;
+    }
+
+    if (header.m_Stride < 3 || header.m_LODCount == 0 || header.m_LODCount > MESH_MAX_LODS)
+    {
+        LOG_ERROR("Invalid mesh file header: %s.", fileName);
+        return false;
+    }
+
+    mesh.m_Stride = header.m_Stride;
+    mesh.m_VertexCount = header.m_VertexCount;
+    mesh.m_Vertices.resize(scast<size_t>(header.m_VertexCount) * header.m_Stride);
+    mesh.m_Indices.resize(header.m_IndexCount);
+    mesh.m_LODs.resize(header.m_LODCount);
+
+    in.read(rcast<char*>(mesh.m_Vertices.data()), mesh.m_Vertices.size() * sizeof(float));
+    in.read(rcast<char*>(mesh.m_Indices.data()), mesh.m_Indices.size() * sizeof(u32));
+    in.read(rcast<char*>(mesh.m_LODs.data()), mesh.m_LODs.size() * sizeof(MeshLOD));
+    if (!in)
+    {
+        LOG_ERROR("Truncated mesh file: %s.", fileName);
+        return false;
+    }
+
+    // Don't trust the ranges, they end up in draw calls.
+    for (const MeshLOD& lod : mesh.m_LODs)
+    {
+        if (scast<u64>(lod.m_IndexOffset) + lod.m_IndexCount > header.m_IndexCount)
+        {
+            LOG_ERROR("Invalid LOD range in mesh file: %s.", fileName);
+            return false;
+        }
+    }
+    for (const u32 index : mesh.m_Indices)
+    {
+        if (index >= header.m_VertexCount)
+        {
+            LOG_ERROR("Invalid index in mesh file: %s.", fileName);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+u32 SelectMeshLOD(
+    const MeshLOD* const lods,
+    const u32 lodCount,
+    const Camera& camera,
+    const float distance,
+    const float scale,
+    const u32 currentLOD
+)
+{
+    if (lodCount <= 1 || distance <= 0.0f)
+    {
+        return 0;
+    }
+
+    // World units to pixels at `distance` for a perspective projection with a vertical FOV.
+    const float pixelsPerUnit = camera.m_WindowHeight
+        / (2.0f * distance * std::tan(glm::radians(camera.m_FovDegrees) * 0.5f));
+
+    // Errors grow with the LOD index, so the first acceptable LOD from the coarse end is the coarsest one.
+    for (u32 lod = lodCount - 1; lod > 0; --lod)
+    {
+        const float threshold = lod > currentLOD
+            ? MESH_LOD_PIXEL_ERROR * (1.0f - MESH_LOD_HYSTERESIS)
+            : MESH_LOD_PIXEL_ERROR;
+
+        if (lods[lod].m_Error * scale * pixelsPerUnit <= threshold)
+        {
+            return lod;
+        }
+    }
+
+    return 0;
+}
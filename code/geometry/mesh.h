@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+
+#include "common.h"
+#include "camera.h"
+
+// Meshes with a chain of levels of detail.
+// Every LOD is a range of the shared index buffer over the same vertices, so a mesh is uploaded once and a LOD is
+// picked per draw by changing the index range. LOD 0 is the original mesh.
+//
+// File format (.o3dmesh, little endian):
+//   MeshFileHeader
+//   float vertices[vertexCount * stride]
+//   u32 indices[indexCount]
+//   MeshLOD lods[lodCount]
+
+constexpr u32 MESH_FILE_MAGIC = 0x4d44334f; // "O3DM"
+constexpr u32 MESH_FILE_VERSION = 1;
+constexpr u32 MESH_MAX_LODS = 8;
+
+constexpr float MESH_LOD_PIXEL_ERROR = 1.0f;  // Largest acceptable projected error in pixels.
+constexpr float MESH_LOD_HYSTERESIS = 0.25f;  // A coarser LOD needs to be this much under the threshold.
+
+struct MeshFileHeader
+{
+    u32 m_Magic;
+    u32 m_Version;
+    u32 m_Stride; // In floats.
+    u32 m_VertexCount;
+    u32 m_IndexCount;
+    u32 m_LODCount;
+};
+
+struct MeshLOD
+{
+    u32 m_IndexOffset;
+    u32 m_IndexCount;
+    float m_Error; // Geometric error against LOD 0, in the units of the positions.
+};
+
+struct LODMesh
+{
+    std::vector<float> m_Vertices;
+    u32 m_Stride = 0; // In floats.
+    u32 m_VertexCount = 0;
+    std::vector<u32> m_Indices; // The indices of all LODs, one after the other.
+    std::vector<MeshLOD> m_LODs;
+};
+
+// Builds the LOD chain of an indexed triangle mesh. Every LOD targets `reduction` of the triangles of the previous
+// one. The chain ends at `maxLODs` levels or when simplification stops making progress. `attributeWeights` is
+// passed to SimplifyMesh().
+LODMesh BuildMeshLODs(
+    const float* const vertices,
+    const u32 vertexCount,
+    const u32 stride,
+    const u32* const indices,
+    const u32 indexCount,
+    const u32 maxLODs,
+    const float reduction,
+    const float* const attributeWeights
+);
+
+bool SaveMeshFile(const char* const fileName, const LODMesh& mesh);
+bool LoadMeshFile(const char* const fileName, LODMesh& mesh);
+
+// Picks the coarsest LOD whose error, projected at `distance` from the camera, stays under MESH_LOD_PIXEL_ERROR.
+// `scale` is the largest world scale of the mesh. `currentLOD` is the LOD used last frame: switching to a coarser
+// LOD needs some margin so objects near a threshold don't flicker between two levels.
+u32 SelectMeshLOD(
+    const MeshLOD* const lods,
+    const u32 lodCount,
+    const Camera& camera,
+    const float distance,
+    const float scale,
+    const u32 currentLOD
+);
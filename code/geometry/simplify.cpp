@@ -0,0 +1,347 @@
+#include "geometry/simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+// Border planes are weighted heavily so open borders don't shrink.
+constexpr double SIMPLIFY_BORDER_WEIGHT = 10.0;
+
+// Symmetric 4x4 matrix of a sum of squared plane distances, plus the total weight of the planes.
+struct Quadric
+{
+    double m_A2, m_AB, m_AC, m_AD;
+    double m_B2, m_BC, m_BD;
+    double m_C2, m_CD;
+    double m_D2;
+    double m_Weight;
+};
+
+struct SimplifyCollapse
+{
+    double m_Cost;
+    double m_Error;
+    u32 m_From;
+    u32 m_To;
+};
+
+static void AddQuadricPlane(Quadric& quadric, const glm::dvec3& normal, const double distance, const double weight)
+{
+    quadric.m_A2 += weight * normal.x * normal.x;
+    quadric.m_AB += weight * normal.x * normal.y;
+    quadric.m_AC += weight * normal.x * normal.z;
+    quadric.m_AD += weight * normal.x * distance;
+    quadric.m_B2 += weight * normal.y * normal.y;
+    quadric.m_BC += weight * normal.y * normal.z;
+    quadric.m_BD += weight * normal.y * distance;
+    quadric.m_C2 += weight * normal.z * normal.z;
+    quadric.m_CD += weight * normal.z * distance;
+    quadric.m_D2 += weight * distance * distance;
+    quadric.m_Weight += weight;
+}
+
+static void AddQuadric(Quadric& target, const Quadric& source)
+{
+    target.m_A2 += source.m_A2;
+    target.m_AB += source.m_AB;
+    target.m_AC += source.m_AC;
+    target.m_AD += source.m_AD;
+    target.m_B2 += source.m_B2;
+    target.m_BC += source.m_BC;
+    target.m_BD += source.m_BD;
+    target.m_C2 += source.m_C2;
+    target.m_CD += source.m_CD;
+    target.m_D2 += source.m_D2;
+    target.m_Weight += source.m_Weight;
+}
+
+// Weighted mean squared distance of a point to the planes of the quadric.
+static double EvaluateQuadric(const Quadric& q, const glm::dvec3& p)
+{
+    const double result = q.m_A2 * p.x * p.x + q.m_B2 * p.y * p.y + q.m_C2 * p.z * p.z
+        + 2.0 * (q.m_AB * p.x * p.y + q.m_AC * p.x * p.z + q.m_BC * p.y * p.z)
+        + 2.0 * (q.m_AD * p.x + q.m_BD * p.y + q.m_CD * p.z)
+        + q.m_D2;
+
+    return q.m_Weight > 0.0 ? std::max(result, 0.0) / q.m_Weight : 0.0;
+}
+
+static u64 MakeSimplifyEdgeKey(const u32 a, const u32 b)
+{
+    return a < b ? (u64(a) << 32) | b : (u64(b) << 32) | a;
+}
+
+static glm::dvec3 GetSimplifyPosition(const float* const vertices, const u32 stride, const u32 vertex)
+{
+    const float* const position = vertices + vertex * stride;
+    return glm::dvec3(position[0], position[1], position[2]);
+}
+
+// Returns false if replacing `from` by `to` flips or collapses one of the triangles around `from`.
+static bool IsCollapseValid(
+    const float* const vertices,
+    const u32 stride,
+    const std::vector<u32>& indices,
+    const std::vector<u32>& triangleOffsets,
+    const std::vector<u32>& vertexTriangles,
+    const u32 from,
+    const u32 to
+)
+{
+    const glm::dvec3 target = GetSimplifyPosition(vertices, stride, to);
+
+    for (u32 i = triangleOffsets[from]; i < triangleOffsets[from + 1]; ++i)
+    {
+        const u32* const triangle = indices.data() + vertexTriangles[i] * 3;
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+        {
+            continue; // Removed by the collapse.
+        }
+
+        glm::dvec3 before[3], after[3];
+        for (u32 corner = 0; corner < 3; ++corner)
+        {
+            before[corner] = GetSimplifyPosition(vertices, stride, triangle[corner]);
+            after[corner] = triangle[corner] == from ? target : before[corner];
+        }
+
+        const glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+        const glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+        if (glm::dot(normalBefore, normalAfter) <= 0.0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+float SimplifyMesh(
+    const float* const vertices,
+    const u32 vertexCount,
+    const u32 stride,
+    const u32* const indices,
+    const u32 indexCount,
+    const u32 targetIndexCount,
+    const float maxError,
+    const float* const attributeWeights,
+    std::vector<u32>& outIndices
+)
+{
+    outIndices.assign(indices, indices + indexCount);
+
+    // SECTION: Quadrics of the original triangles and borders.
+    std::vector<Quadric> quadrics(vertexCount, Quadric{});
+    std::unordered_map<u64, u32> edgeUses;
+
+    for (u32 i = 0; i + 2 < indexCount; i += 3)
+    {
+        const glm::dvec3 p0 = GetSimplifyPosition(vertices, stride, indices[i]);
+        const glm::dvec3 p1 = GetSimplifyPosition(vertices, stride, indices[i + 1]);
+        const glm::dvec3 p2 = GetSimplifyPosition(vertices, stride, indices[i + 2]);
+
+        const glm::dvec3 cross = glm::cross(p1 - p0, p2 - p0);
+        const double length = glm::length(cross);
+        if (length <= 0.0)
+        {
+            continue;
+        }
+
+        const glm::dvec3 normal = cross / length;
+        for (u32 corner = 0; corner < 3; ++corner)
+        {
+            AddQuadricPlane(quadrics[indices[i + corner]], normal, -glm::dot(normal, p0), length * 0.5);
+            edgeUses[MakeSimplifyEdgeKey(indices[i + corner], indices[i + (corner + 1) % 3])]++;
+        }
+    }
+
+    std::vector<u8> border(vertexCount, 0);
+    for (u32 i = 0; i + 2 < indexCount; i += 3)
+    {
+        for (u32 corner = 0; corner < 3; ++corner)
+        {
+            const u32 a = indices[i + corner];
+            const u32 b = indices[i + (corner + 1) % 3];
+            if (edgeUses[MakeSimplifyEdgeKey(a, b)] != 1)
+            {
+                continue;
+            }
+
+            // A plane through the border edge, perpendicular to the triangle.
+            const glm::dvec3 pa = GetSimplifyPosition(vertices, stride, a);
+            const glm::dvec3 pb = GetSimplifyPosition(vertices, stride, b);
+            const glm::dvec3 pc = GetSimplifyPosition(vertices, stride, indices[i + (corner + 2) % 3]);
+            const glm::dvec3 edge = pb - pa;
+            const glm::dvec3 planeNormal = glm::cross(edge, glm::cross(edge, pc - pa));
+            const double planeLength = glm::length(planeNormal);
+            if (planeLength <= 0.0)
+            {
+                continue;
+            }
+
+            const glm::dvec3 normal = planeNormal / planeLength;
+            const double weight = glm::dot(edge, edge) * SIMPLIFY_BORDER_WEIGHT;
+            AddQuadricPlane(quadrics[a], normal, -glm::dot(normal, pa), weight);
+            AddQuadricPlane(quadrics[b], normal, -glm::dot(normal, pa), weight);
+            border[a] = 1;
+            border[b] = 1;
+        }
+    }
+
+    // SECTION: Collapse passes. Every pass collapses the cheapest edges whose neighbourhoods don't overlap.
+    const double maxErrorSquared = scast<double>(maxError) * maxError;
+    double resultError = 0.0;
+
+    std::vector<u32> remap(vertexCount);
+    std::vector<u8> locked(vertexCount);
+    std::vector<u32> triangleOffsets(vertexCount + 1);
+    std::vector<u32> vertexTriangles;
+    std::vector<SimplifyCollapse> collapses;
+
+    while (outIndices.size() > targetIndexCount)
+    {
+        const u32 triangleCount = scast<u32>(outIndices.size() / 3);
+
+        // Triangles around every vertex.
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (const u32 index : outIndices)
+        {
+            triangleOffsets[index + 1]++;
+        }
+        for (u32 v = 0; v < vertexCount; ++v)
+        {
+            triangleOffsets[v + 1] += triangleOffsets[v];
+        }
+        vertexTriangles.resize(outIndices.size());
+        std::vector<u32> cursor(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (u32 i = 0; i < outIndices.size(); ++i)
+        {
+            vertexTriangles[cursor[outIndices[i]]++] = i / 3;
+        }
+
+        // Cheapest allowed direction of every edge.
+        edgeUses.clear();
+        for (u32 i = 0; i < outIndices.size(); ++i)
+        {
+            edgeUses[MakeSimplifyEdgeKey(outIndices[i], outIndices[i - i % 3 + (i + 1) % 3])]++;
+        }
+
+        collapses.clear();
+        for (const auto& [key, uses] : edgeUses)
+        {
+            const u32 a = scast<u32>(key >> 32);
+            const u32 b = scast<u32>(key & 0xffffffffu);
+
+            SimplifyCollapse best = { -1.0, 0.0, 0, 0 };
+            for (u32 direction = 0; direction < 2; ++direction)
+            {
+                const u32 from = direction == 0 ? a : b;
+                const u32 to = direction == 0 ? b : a;
+
+                // Border vertices may only slide along their border.
+                if (border[from] && (!border[to] || uses != 1))
+                {
+                    continue;
+                }
+
+                Quadric combined = quadrics[from];
+                AddQuadric(combined, quadrics[to]);
+                const double error = EvaluateQuadric(combined, GetSimplifyPosition(vertices, stride, to));
+
+                double attributeCost = 0.0;
+                if (attributeWeights)
+                {
+                    for (u32 k = 3; k < stride; ++k)
+                    {
+                        const double difference = vertices[from * stride + k] - vertices[to * stride + k];
+                        attributeCost += attributeWeights[k - 3] * difference * difference;
+                    }
+                }
+
+                const double cost = error + attributeCost;
+                if (best.m_Cost < 0.0 || cost < best.m_Cost)
+                {
+                    best = { cost, error, from, to };
+                }
+            }
+
+            if (best.m_Cost >= 0.0 && best.m_Error <= maxErrorSquared)
+            {
+                collapses.push_back(best);
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const SimplifyCollapse& a, const SimplifyCollapse& b)
+        {
+            return a.m_Cost < b.m_Cost;
+        });
+
+        for (u32 v = 0; v < vertexCount; ++v)
+        {
+            remap[v] = v;
+        }
+        std::fill(locked.begin(), locked.end(), 0);
+
+        u32 remainingIndices = scast<u32>(outIndices.size());
+        u32 collapseCount = 0;
+        for (const SimplifyCollapse& collapse : collapses)
+        {
+            if (remainingIndices <= targetIndexCount)
+            {
+                break;
+            }
+
+            if (locked[collapse.m_From] || locked[collapse.m_To]
+                || !IsCollapseValid(vertices, stride, outIndices, triangleOffsets, vertexTriangles, collapse.m_From, collapse.m_To))
+            {
+                continue;
+            }
+
+            // Lock the whole neighbourhood, its triangles are stale until the next pass.
+            for (u32 i = triangleOffsets[collapse.m_From]; i < triangleOffsets[collapse.m_From + 1]; ++i)
+            {
+                const u32* const triangle = outIndices.data() + vertexTriangles[i] * 3;
+                if (triangle[0] == collapse.m_To || triangle[1] == collapse.m_To || triangle[2] == collapse.m_To)
+                {
+                    remainingIndices -= 3;
+                }
+
+                locked[triangle[0]] = 1;
+                locked[triangle[1]] = 1;
+                locked[triangle[2]] = 1;
+            }
+
+            remap[collapse.m_From] = collapse.m_To;
+            AddQuadric(quadrics[collapse.m_To], quadrics[collapse.m_From]);
+            resultError = std::max(resultError, collapse.m_Error);
+            collapseCount++;
+        }
+
+        if (collapseCount == 0)
+        {
+            break;
+        }
+
+        // Apply the collapses and drop the degenerate triangles.
+        u32 writeIndex = 0;
+        for (u32 t = 0; t < triangleCount; ++t)
+        {
+            const u32 a = remap[outIndices[t * 3]];
+            const u32 b = remap[outIndices[t * 3 + 1]];
+            const u32 c = remap[outIndices[t * 3 + 2]];
+            if (a == b || b == c || a == c)
+            {
+                continue;
+            }
+
+            outIndices[writeIndex++] = a;
+            outIndices[writeIndex++] = b;
+            outIndices[writeIndex++] = c;
+        }
+        outIndices.resize(writeIndex);
+    }
+
+    return scast<float>(std::sqrt(resultError));
+}
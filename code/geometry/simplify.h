@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+
+#include "common.h"
+
+// Quadric error metric mesh simplification (Garland & Heckbert).
+// Edges are collapsed onto one of their endpoints, so the simplified mesh only needs a new index buffer and keeps
+// using the original vertices. The cost of a collapse is the quadric error of the kept position plus the weighted
+// squared difference of the vertex attributes, so collapses across UV or normal discontinuities are avoided.
+// Open borders are kept in place.
+
+// Simplifies the triangle list in `indices` down to about `targetIndexCount` indices, never exceeding `maxError`
+// (in the units of the positions). Positions are the first 3 floats of each vertex and `stride` is in floats.
+// `attributeWeights` holds one weight per float after the position (stride - 3 values) or is null to ignore the
+// attributes. Returns the geometric error of the result.
+float SimplifyMesh(
+    const float* const vertices,
+    const u32 vertexCount,
+    const u32 stride,
+    const u32* const indices,
+    const u32 indexCount,
+    const u32 targetIndexCount,
+    const float maxError,
+    const float* const attributeWeights,
+    std::vector<u32>& outIndices
+);
@@ -0,0 +1,329 @@
+#include "graphics/clustered_lighting.h"
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define O3D_CLUSTER_SSE 1
+#include <emmintrin.h>
+#endif
+
+#include <glad/glad.h>
+
+#include "core/metrics.h"
+
+void CreateClusteredLighting(ClusteredLighting& lighting)
+{
+    glGenBuffers(1, &lighting.m_LightBuffer);
+    glGenBuffers(1, &lighting.m_RecordBuffer);
+    glGenBuffers(1, &lighting.m_IndexBuffer);
+
+    lighting.m_MinX.resize(CLUSTER_COUNT);
+    lighting.m_MinY.resize(CLUSTER_COUNT);
+    lighting.m_MinZ.resize(CLUSTER_COUNT);
+    lighting.m_MaxX.resize(CLUSTER_COUNT);
+    lighting.m_MaxY.resize(CLUSTER_COUNT);
+    lighting.m_MaxZ.resize(CLUSTER_COUNT);
+    lighting.m_Records.resize(CLUSTER_COUNT * 2);
+}
+
+void DeleteClusteredLighting(ClusteredLighting& lighting)
+{
+    glDeleteBuffers(1, &lighting.m_LightBuffer);
+    glDeleteBuffers(1, &lighting.m_RecordBuffer);
+    glDeleteBuffers(1, &lighting.m_IndexBuffer);
+
+    lighting = {};
+}
+
+// SECTION: Cluster bounds
+
+static float GetClusterSliceDepth(const float nearPlane, const float farPlane, const u32 slice)
+{
+    return nearPlane * std::pow(farPlane / nearPlane, scast<float>(slice) / CLUSTER_GRID_Z);
+}
+
+void UpdateClusterBounds(
+    ClusteredLighting& lighting,
+    const glm::mat4& projection,
+    const float nearPlane,
+    const float farPlane,
+    const i32 screenWidth,
+    const i32 screenHeight)
+{
+    lighting.m_ScreenWidth = screenWidth;
+    lighting.m_ScreenHeight = screenHeight;
+
+    if (projection == lighting.m_Projection && nearPlane == lighting.m_Near && farPlane == lighting.m_Far)
+    {
+        return;
+    }
+
+    lighting.m_Projection = projection;
+    lighting.m_Near = nearPlane;
+    lighting.m_Far = farPlane;
+
+    // View space direction through a point on the near plane, scaled to a depth of 1.
+    const glm::mat4 inverse = glm::inverse(projection);
+    auto viewRay = [&inverse](const float ndcX, const float ndcY)
+    {
+        const glm::vec4 point = inverse * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+        const glm::vec3 position = glm::vec3(point) / point.w;
+        return position / -position.z;
+    };
+
+    for (u32 z = 0; z < CLUSTER_GRID_Z; ++z)
+    {
+        const float sliceNear = GetClusterSliceDepth(nearPlane, farPlane, z);
+        const float sliceFar = GetClusterSliceDepth(nearPlane, farPlane, z + 1);
+
+        for (u32 y = 0; y < CLUSTER_GRID_Y; ++y)
+        {
+            const float ndcY0 = -1.0f + 2.0f * y / CLUSTER_GRID_Y;
+            const float ndcY1 = -1.0f + 2.0f * (y + 1) / CLUSTER_GRID_Y;
+
+            for (u32 x = 0; x < CLUSTER_GRID_X; ++x)
+            {
+                const float ndcX0 = -1.0f + 2.0f * x / CLUSTER_GRID_X;
+                const float ndcX1 = -1.0f + 2.0f * (x + 1) / CLUSTER_GRID_X;
+
+                const glm::vec3 rays[4] =
+                {
+                    viewRay(ndcX0, ndcY0),
+                    viewRay(ndcX1, ndcY0),
+                    viewRay(ndcX0, ndcY1),
+                    viewRay(ndcX1, ndcY1),
+                };
+
+                glm::vec3 boundsMin = glm::vec3(FLT_MAX);
+                glm::vec3 boundsMax = glm::vec3(-FLT_MAX);
+                for (const glm::vec3& ray : rays)
+                {
+                    boundsMin = glm::min(boundsMin, glm::min(ray * sliceNear, ray * sliceFar));
+                    boundsMax = glm::max(boundsMax, glm::max(ray * sliceNear, ray * sliceFar));
+                }
+
+                const u32 cluster = (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x;
+                lighting.m_MinX[cluster] = boundsMin.x;
+                lighting.m_MinY[cluster] = boundsMin.y;
+                lighting.m_MinZ[cluster] = boundsMin.z;
+                lighting.m_MaxX[cluster] = boundsMax.x;
+                lighting.m_MaxY[cluster] = boundsMax.y;
+                lighting.m_MaxZ[cluster] = boundsMax.z;
+            }
+        }
+    }
+}
+
+// SECTION: Light assignment
+
+// Tests a view space sphere against the CLUSTER_GRID_X clusters of a row starting at `first`. Returns a mask with a
+// bit set for every cluster the sphere touches.
+static u32 TestClusterRow(
+    const ClusteredLighting& lighting,
+    const u32 first,
+    const glm::vec3& center,
+    const float radius)
+{
+    u32 result = 0;
+
+#if O3D_CLUSTER_SSE
+    const __m128 centerX = _mm_set1_ps(center.x);
+    const __m128 centerY = _mm_set1_ps(center.y);
+    const __m128 centerZ = _mm_set1_ps(center.z);
+    const __m128 radiusSquared = _mm_set1_ps(radius * radius);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (u32 x = 0; x < CLUSTER_GRID_X; x += 4)
+    {
+        const u32 i = first + x;
+
+        // Distance from the sphere center to the box, per axis.
+        const __m128 dx = _mm_max_ps(
+            _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&lighting.m_MinX[i]), centerX),
+                       _mm_sub_ps(centerX, _mm_loadu_ps(&lighting.m_MaxX[i]))),
+            zero
+        );
+        const __m128 dy = _mm_max_ps(
+            _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&lighting.m_MinY[i]), centerY),
+                       _mm_sub_ps(centerY, _mm_loadu_ps(&lighting.m_MaxY[i]))),
+            zero
+        );
+        const __m128 dz = _mm_max_ps(
+            _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&lighting.m_MinZ[i]), centerZ),
+                       _mm_sub_ps(centerZ, _mm_loadu_ps(&lighting.m_MaxZ[i]))),
+            zero
+        );
+
+        const __m128 distanceSquared = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+            _mm_mul_ps(dz, dz)
+        );
+        result |= scast<u32>(_mm_movemask_ps(_mm_cmple_ps(distanceSquared, radiusSquared))) << x;
+    }
+#else
+    for (u32 x = 0; x < CLUSTER_GRID_X; ++x)
+    {
+        const u32 i = first + x;
+        const float dx = std::max(std::max(lighting.m_MinX[i] - center.x, center.x - lighting.m_MaxX[i]), 0.0f);
+        const float dy = std::max(std::max(lighting.m_MinY[i] - center.y, center.y - lighting.m_MaxY[i]), 0.0f);
+        const float dz = std::max(std::max(lighting.m_MinZ[i] - center.z, center.z - lighting.m_MaxZ[i]), 0.0f);
+        if (dx * dx + dy * dy + dz * dz <= radius * radius)
+        {
+            result |= 1u << x;
+        }
+    }
+#endif
+
+    return result;
+}
+
+// Depth slice containing a view space depth, clamped to the grid.
+static u32 GetClusterSlice(const ClusteredLighting& lighting, const float depth)
+{
+    const float slice = std::log(depth / lighting.m_Near) / std::log(lighting.m_Far / lighting.m_Near) * CLUSTER_GRID_Z;
+    return scast<u32>(std::clamp(slice, 0.0f, scast<float>(CLUSTER_GRID_Z - 1)));
+}
+
+void AssignLightsToClusters(
+    ClusteredLighting& lighting,
+    const glm::mat4& view,
+    const PointLight* const lights,
+    const u32 lightCount)
+{
+    const u32 usedCount = std::min(lightCount, CLUSTER_MAX_LIGHTS);
+    lighting.m_Lights.assign(lights, lights + usedCount);
+    lighting.m_DroppedLights = lightCount - usedCount;
+
+    // SECTION: Find the clusters every light touches. Only the depth slices the light overlaps are tested.
+    lighting.m_Pairs.clear();
+    for (u32 light = 0; light < usedCount; ++light)
+    {
+        const glm::vec3 center = glm::vec3(view * glm::vec4(lighting.m_Lights[light].m_Position, 1.0f));
+        const float radius = lighting.m_Lights[light].m_Radius;
+        const float depth = -center.z;
+        if (depth + radius < lighting.m_Near || depth - radius > lighting.m_Far)
+        {
+            continue;
+        }
+
+        const u32 firstSlice = GetClusterSlice(lighting, std::max(depth - radius, lighting.m_Near));
+        const u32 lastSlice = GetClusterSlice(lighting, std::min(depth + radius, lighting.m_Far));
+        for (u32 z = firstSlice; z <= lastSlice; ++z)
+        {
+            for (u32 y = 0; y < CLUSTER_GRID_Y; ++y)
+            {
+                const u32 first = (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X;
+                for (u32 mask = TestClusterRow(lighting, first, center, radius); mask != 0; mask &= mask - 1)
+                {
+                    const u32 cluster = first + std::countr_zero(mask);
+                    lighting.m_Pairs.push_back((cluster << 16) | light);
+                }
+            }
+        }
+    }
+
+    if (lighting.m_Pairs.size() > CLUSTER_MAX_LIGHT_INDICES)
+    {
+        // The pairs are in light order, so the last lights lose their references first.
+        lighting.m_DroppedLights += scast<u32>(lighting.m_Pairs.size() - CLUSTER_MAX_LIGHT_INDICES);
+        lighting.m_Pairs.resize(CLUSTER_MAX_LIGHT_INDICES);
+    }
+
+    // SECTION: Counting sort of the pairs by cluster into the per-cluster lists.
+    std::fill(lighting.m_Records.begin(), lighting.m_Records.end(), 0u);
+    for (const u32 pair : lighting.m_Pairs)
+    {
+        lighting.m_Records[(pair >> 16) * 2 + 1]++;
+    }
+
+    u32 offset = 0;
+    for (u32 cluster = 0; cluster < CLUSTER_COUNT; ++cluster)
+    {
+        lighting.m_Records[cluster * 2] = offset;
+        offset += lighting.m_Records[cluster * 2 + 1];
+        lighting.m_Records[cluster * 2 + 1] = 0;
+    }
+
+    lighting.m_LightIndices.resize(lighting.m_Pairs.size());
+    for (const u32 pair : lighting.m_Pairs)
+    {
+        u32* const record = &lighting.m_Records[(pair >> 16) * 2];
+        lighting.m_LightIndices[record[0] + record[1]++] = pair & 0xffff;
+    }
+}
+
+// SECTION: Upload
+
+// Orphans the storage of the buffer, so the driver doesn't have to wait for the frames still reading it.
+static void UploadStorageBuffer(
+    const u32 buffer,
+    const u32 binding,
+    const void* const data,
+    const size_t size,
+    const size_t capacity)
+{
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+    if (size > 0)
+    {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+
+    AddMetric(Metric::UploadBytes, size);
+}
+
+void UploadClusteredLighting(ClusteredLighting& lighting)
+{
+    UploadStorageBuffer(
+        lighting.m_LightBuffer,
+        CLUSTER_LIGHTS_BINDING,
+        lighting.m_Lights.data(),
+        lighting.m_Lights.size() * sizeof(PointLight),
+        CLUSTER_MAX_LIGHTS * sizeof(PointLight)
+    );
+    UploadStorageBuffer(
+        lighting.m_RecordBuffer,
+        CLUSTER_RECORDS_BINDING,
+        lighting.m_Records.data(),
+        lighting.m_Records.size() * sizeof(u32),
+        CLUSTER_COUNT * 2 * sizeof(u32)
+    );
+    UploadStorageBuffer(
+        lighting.m_IndexBuffer,
+        CLUSTER_INDICES_BINDING,
+        lighting.m_LightIndices.data(),
+        lighting.m_LightIndices.size() * sizeof(u32),
+        CLUSTER_MAX_LIGHT_INDICES * sizeof(u32)
+    );
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void SetClusterUniforms(const ClusteredLighting& lighting, const u32 shader)
+{
+    // slice = log(depth) * scale + bias, the inverse of GetClusterSliceDepth().
+    const float logRatio = std::log(lighting.m_Far / lighting.m_Near);
+    const float depthScale = scast<float>(CLUSTER_GRID_Z) / logRatio;
+    const float depthBias = -depthScale * std::log(lighting.m_Near);
+
+    glProgramUniform3ui(
+        shader,
+        glGetUniformLocation(shader, "clusterGrid"),
+        CLUSTER_GRID_X,
+        CLUSTER_GRID_Y,
+        CLUSTER_GRID_Z
+    );
+    glProgramUniform2f(
+        shader,
+        glGetUniformLocation(shader, "clusterScreenSize"),
+        scast<float>(lighting.m_ScreenWidth),
+        scast<float>(lighting.m_ScreenHeight)
+    );
+    glProgramUniform1f(shader, glGetUniformLocation(shader, "clusterDepthScale"), depthScale);
+    glProgramUniform1f(shader, glGetUniformLocation(shader, "clusterDepthBias"), depthBias);
+    glProgramUniform1f(shader, glGetUniformLocation(shader, "clusterNear"), lighting.m_Near);
+    glProgramUniform1f(shader, glGetUniformLocation(shader, "clusterFar"), lighting.m_Far);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "common.h"
+
+// Clustered forward lighting.
+// The view frustum is split into a grid of froxels: CLUSTER_GRID_X by CLUSTER_GRID_Y screen tiles, and
+// CLUSTER_GRID_Z depth slices spaced exponentially between the near and far planes so the clusters stay roughly
+// cubic. Every frame the point lights are assigned to the clusters they touch on the CPU, and the light list of
+// every cluster is uploaded to shader storage buffers. A fragment finds its cluster from its window position and
+// depth and only shades the lights in that cluster.
+//
+// Shader interface (see default.frag):
+//   binding CLUSTER_LIGHTS_BINDING:  PointLight lights[]
+//   binding CLUSTER_RECORDS_BINDING: uvec2 clusters[] (offset into the light indices, light count)
+//   binding CLUSTER_INDICES_BINDING: uint lightIndices[]
+//   uniforms clusterGrid, clusterScreenSize, clusterDepthScale, clusterDepthBias, clusterNear, clusterFar.
+
+constexpr u32 CLUSTER_GRID_X = 16;
+constexpr u32 CLUSTER_GRID_Y = 9;
+constexpr u32 CLUSTER_GRID_Z = 24;
+constexpr u32 CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+
+constexpr u32 CLUSTER_MAX_LIGHTS = 1024;                   // Lights per frame, the rest are dropped.
+constexpr u32 CLUSTER_MAX_LIGHT_INDICES = CLUSTER_COUNT * 32; // Light references summed over all clusters.
+
+constexpr u32 CLUSTER_LIGHTS_BINDING = 0;
+constexpr u32 CLUSTER_RECORDS_BINDING = 1;
+constexpr u32 CLUSTER_INDICES_BINDING = 2;
+
+static_assert(CLUSTER_GRID_X % 4 == 0, "Rows of clusters are tested 4 at a time.");
+static_assert(CLUSTER_MAX_LIGHTS <= 0x10000 && CLUSTER_COUNT <= 0x10000, "Cluster and light indices are packed.");
+
+// Layout matches the std430 struct in the shaders.
+struct PointLight
+{
+    glm::vec3 m_Position; // World space.
+    float m_Radius;       // The light has no effect past this distance.
+    glm::vec3 m_Color;
+    float m_Intensity;
+};
+
+static_assert(sizeof(PointLight) == 32, "PointLight must match the std430 layout.");
+
+struct ClusteredLighting
+{
+    // View space bounds of every cluster, x fastest, in structure-of-arrays layout for the SIMD assignment.
+    std::vector<float> m_MinX;
+    std::vector<float> m_MinY;
+    std::vector<float> m_MinZ;
+    std::vector<float> m_MaxX;
+    std::vector<float> m_MaxY;
+    std::vector<float> m_MaxZ;
+
+    glm::mat4 m_Projection = glm::mat4(0.0f); // Projection the bounds were built for.
+    float m_Near = 0.0f;
+    float m_Far = 0.0f;
+    i32 m_ScreenWidth = 0;
+    i32 m_ScreenHeight = 0;
+
+    // Assignment results of the current frame.
+    std::vector<PointLight> m_Lights;      // Lights of the frame, at most CLUSTER_MAX_LIGHTS.
+    std::vector<u32> m_Pairs;              // Cluster << 16 | light, for every light touching a cluster.
+    std::vector<u32> m_Records;            // Offset and count per cluster.
+    std::vector<u32> m_LightIndices;
+    u32 m_DroppedLights = 0;               // Lights or light references over the limits, this frame.
+
+    u32 m_LightBuffer = 0;
+    u32 m_RecordBuffer = 0;
+    u32 m_IndexBuffer = 0;
+};
+
+// Creates the storage buffers. Needs OpenGL 4.3.
+void CreateClusteredLighting(ClusteredLighting& lighting);
+void DeleteClusteredLighting(ClusteredLighting& lighting);
+
+// Rebuilds the cluster bounds if the projection or the near and far planes changed since the last call.
+void UpdateClusterBounds(
+    ClusteredLighting& lighting,
+    const glm::mat4& projection,
+    const float nearPlane,
+    const float farPlane,
+    const i32 screenWidth,
+    const i32 screenHeight
+);
+
+// Assigns the lights to the clusters they touch. Call after UpdateClusterBounds() with the view matrix of the frame.
+void AssignLightsToClusters(
+    ClusteredLighting& lighting,
+    const glm::mat4& view,
+    const PointLight* const lights,
+    const u32 lightCount
+);
+
+// Uploads the light lists and binds the storage buffers.
+void UploadClusteredLighting(ClusteredLighting& lighting);
+
+// Sets the cluster uniforms of a shader using clustered lighting.
+void SetClusterUniforms(const ClusteredLighting& lighting, const u32 shader);
@@ -0,0 +1,217 @@
+#include "graphics/command_list.h"
+
+#include <cstring>
+
+#include <glad/glad.h>
+
+#include "core/frame_arena.h"
+#include "core/metrics.h"
+#include "graphics/shader.h"
+#include "graphics/vao.h"
+
+// Until InitializeCommandLists() asks the driver, the largest alignment OpenGL allows an implementation to require.
+static u32 g_UniformStreamAlignment = 256;
+static u32 g_UniformStreamBuffer = 0;
+
+// Bindings made by the commands replayed so far.
+struct RenderStateCache
+{
+    u32 m_Program;
+    u32 m_VertexArray;
+    u32 m_Textures[COMMAND_LIST_MAX_TEXTURE_UNITS];
+    u32 m_BlockOffsets[COMMAND_LIST_MAX_UNIFORM_BINDINGS];
+    u32 m_BlockSizes[COMMAND_LIST_MAX_UNIFORM_BINDINGS];
+};
+
+static RenderCommand& AppendCommand(CommandList& list, const RenderCommandType type)
+{
+    if (list.m_Count == list.m_Capacity)
+    {
+        // The old commands stay in the frame arena until it is reset.
+        const u32 capacity = list.m_Capacity > 0 ? list.m_Capacity * 2 : COMMAND_LIST_INITIAL_CAPACITY;
+        RenderCommand* const commands = AllocateFrameArray<RenderCommand>(capacity);
+        if (list.m_Count > 0)
+        {
+            std::memcpy(commands, list.m_Commands, list.m_Count * sizeof(RenderCommand));
+        }
+        list.m_Commands = commands;
+        list.m_Capacity = capacity;
+    }
+
+    RenderCommand& command = list.m_Commands[list.m_Count++];
+    command = {};
+    command.m_Type = type;
+    return command;
+}
+
+void InitializeCommandLists()
+{
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0)
+    {
+        g_UniformStreamAlignment = scast<u32>(alignment);
+    }
+
+    glGenBuffers(1, &g_UniformStreamBuffer);
+}
+
+void ShutdownCommandLists()
+{
+    glDeleteBuffers(1, &g_UniformStreamBuffer);
+    g_UniformStreamBuffer = 0;
+}
+
+UniformStream CreateUniformStream(const u32 slotCount, const u32 bytesPerSlot)
+{
+    UniformStream result = {};
+    result.m_SlotSize = (bytesPerSlot + g_UniformStreamAlignment - 1) / g_UniformStreamAlignment
+        * g_UniformStreamAlignment;
+    result.m_SlotCount = slotCount;
+    result.m_Data = AllocateFrameArray<u8>(scast<u64>(result.m_SlotSize) * slotCount);
+    return result;
+}
+
+u8* GetUniformSlot(const UniformStream& stream, const u32 slot)
+{
+    return stream.m_Data + scast<u64>(stream.m_SlotSize) * slot;
+}
+
+void RecordBindProgram(CommandList& list, const u32 program)
+{
+    AppendCommand(list, RenderCommandType::BindProgram).m_Object = program;
+}
+
+void RecordBindVertexArray(CommandList& list, const u32 vertexArray)
+{
+    AppendCommand(list, RenderCommandType::BindVertexArray).m_Object = vertexArray;
+}
+
+void RecordBindTexture(CommandList& list, const Texture texture)
+{
+    if (texture.m_Unit >= COMMAND_LIST_MAX_TEXTURE_UNITS)
+    {
+        LOG_ERROR("Texture unit %u is over the command list limit.", texture.m_Unit);
+        return;
+    }
+
+    RenderCommand& command = AppendCommand(list, RenderCommandType::BindTexture);
+    command.m_Slot = scast<u8>(texture.m_Unit);
+    command.m_Object = texture.m_TextureId;
+}
+
+void RecordUniformBlockRange(CommandList& list, const u32 binding, const UniformStream& stream, const u32 slot)
+{
+    if (binding >= COMMAND_LIST_MAX_UNIFORM_BINDINGS)
+    {
+        LOG_ERROR("Uniform block binding %u is over the command list limit.", binding);
+        return;
+    }
+
+    RenderCommand& command = AppendCommand(list, RenderCommandType::SetUniformBlockRange);
+    command.m_Slot = scast<u8>(binding);
+    command.m_Offset = stream.m_SlotSize * slot;
+    command.m_Count = stream.m_SlotSize;
+}
+
+void RecordDrawIndexed(CommandList& list, const u32 firstIndex, const u32 indexCount)
+{
+    RenderCommand& command = AppendCommand(list, RenderCommandType::DrawIndexed);
+    command.m_Offset = firstIndex;
+    command.m_Count = indexCount;
+}
+
+void UploadUniformStream(const UniformStream& stream)
+{
+    const u64 size = scast<u64>(stream.m_SlotSize) * stream.m_SlotCount;
+    if (size == 0)
+    {
+        return;
+    }
+
+    // Orphans last frame's storage, so the upload never waits for the draws still reading it.
+    glBindBuffer(GL_UNIFORM_BUFFER, g_UniformStreamBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, stream.m_Data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    AddMetric(Metric::UploadBytes, size);
+}
+
+void ExecuteCommandLists(const CommandList* const lists, const u32 count)
+{
+    // Nothing is known to be bound yet. No object or uniform offset is ~0u.
+    RenderStateCache cache = {};
+    std::memset(&cache, 0xFF, sizeof(cache));
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        const CommandList& list = lists[i];
+        for (u32 c = 0; c < list.m_Count; ++c)
+        {
+            const RenderCommand& command = list.m_Commands[c];
+            switch (command.m_Type)
+            {
+            case RenderCommandType::BindProgram:
+            {
+                if (cache.m_Program != command.m_Object)
+                {
+                    ActivateShader(command.m_Object);
+                    cache.m_Program = command.m_Object;
+                }
+            } break;
+
+            case RenderCommandType::BindVertexArray:
+            {
+                if (cache.m_VertexArray != command.m_Object)
+                {
+                    BindVAO(command.m_Object);
+                    cache.m_VertexArray = command.m_Object;
+                }
+            } break;
+
+            case RenderCommandType::BindTexture:
+            {
+                if (cache.m_Textures[command.m_Slot] != command.m_Object)
+                {
+                    BindTexture({ command.m_Object, GL_TEXTURE_2D, command.m_Slot });
+                    cache.m_Textures[command.m_Slot] = command.m_Object;
+                }
+            } break;
+
+            case RenderCommandType::SetUniformBlockRange:
+            {
+                if (cache.m_BlockOffsets[command.m_Slot] != command.m_Offset
+                    || cache.m_BlockSizes[command.m_Slot] != command.m_Count)
+                {
+                    glBindBufferRange(
+                        GL_UNIFORM_BUFFER,
+                        command.m_Slot,
+                        g_UniformStreamBuffer,
+                        command.m_Offset,
+                        command.m_Count
+                    );
+                    cache.m_BlockOffsets[command.m_Slot] = command.m_Offset;
+                    cache.m_BlockSizes[command.m_Slot] = command.m_Count;
+                }
+            } break;
+
+            case RenderCommandType::DrawIndexed:
+            {
+                glDrawElements(
+                    GL_TRIANGLES,
+                    command.m_Count,
+                    GL_UNSIGNED_INT,
+                    rcast<const void*>(scast<size_t>(command.m_Offset) * sizeof(u32))
+                );
+                AddMetric(Metric::DrawCalls, 1);
+                AddMetric(Metric::Triangles, command.m_Count / 3);
+            } break;
+
+            default:
+            {
+                LOG_ERROR("Unknown render command type %u.", scast<u32>(command.m_Type));
+            } break;
+            }
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "common.h"
+#include "graphics/texture.h"
+
+// Draw command lists, recorded on any thread and replayed on the thread owning the OpenGL context.
+// Working out the draws of a frame (LODs, transforms, which program draws what) doesn't need OpenGL, only submitting
+// them does. Job workers each record their share of the draws into their own CommandList, a flat array of 16-byte
+// POD commands in frame memory, and write the per-draw uniforms into their own slots of a UniformStream. The render
+// thread uploads the stream with one call and replays the lists in order, so the result is the same as recording
+// them on one thread.
+//
+// Replaying goes through a state cache: a program, vertex array, texture or uniform block range that is already bound
+// is not bound again. The cache starts empty on every ExecuteCommandLists(), so state changed in between is never
+// assumed.
+
+constexpr u32 COMMAND_LIST_INITIAL_CAPACITY = 256;  // Commands, the list doubles from there.
+constexpr u32 COMMAND_LIST_MAX_TEXTURE_UNITS = 8;
+constexpr u32 COMMAND_LIST_MAX_UNIFORM_BINDINGS = 8;
+
+enum class RenderCommandType : u8
+{
+    BindProgram,
+    BindVertexArray,
+    BindTexture,
+    SetUniformBlockRange,
+    DrawIndexed,
+};
+
+struct RenderCommand
+{
+    RenderCommandType m_Type;
+    u8 m_Slot;      // Texture unit or uniform block binding.
+    u32 m_Object;   // Program, vertex array or texture.
+    u32 m_Offset;   // Byte offset into the uniform stream, or first index of the draw.
+    u32 m_Count;    // Bytes of the uniform block, or indices of the draw.
+};
+
+static_assert(sizeof(RenderCommand) == 16, "Render commands are kept compact.");
+
+struct CommandList
+{
+    RenderCommand* m_Commands; // Frame memory, see core/frame_arena.h.
+    u32 m_Count;
+    u32 m_Capacity;
+};
+
+// Uniform blocks of a frame. Every slot starts at a multiple of the uniform buffer offset alignment, so threads can
+// fill different slots at the same time and each slot can be bound on its own.
+struct UniformStream
+{
+    u8* m_Data; // Frame memory.
+    u32 m_SlotSize;
+    u32 m_SlotCount;
+};
+
+// Creates the buffer the uniform streams are uploaded to and queries its offset alignment. Call with the context
+// current, before any stream is created.
+void InitializeCommandLists();
+void ShutdownCommandLists();
+
+// Reserves `slotCount` slots of at least `bytesPerSlot` bytes in frame memory. Can be called from any thread.
+UniformStream CreateUniformStream(const u32 slotCount, const u32 bytesPerSlot);
+
+u8* GetUniformSlot(const UniformStream& stream, const u32 slot);
+
+// The record functions append a command. A list must only be recorded on one thread at a time.
+void RecordBindProgram(CommandList& list, const u32 program);
+void RecordBindVertexArray(CommandList& list, const u32 vertexArray);
+void RecordBindTexture(CommandList& list, const Texture texture);
+
+// Binds `slot` of the stream to the uniform block `binding`.
+void RecordUniformBlockRange(CommandList& list, const u32 binding, const UniformStream& stream, const u32 slot);
+
+// Draws `indexCount` indices of the bound vertex array as triangles, starting at `firstIndex`.
+void RecordDrawIndexed(CommandList& list, const u32 firstIndex, const u32 indexCount);
+
+// Uploads the stream for the lists recorded against it. Call on the thread owning the context, once every list is
+// recorded and before they are executed.
+void UploadUniformStream(const UniformStream& stream);
+
+// Replays the lists in order. Call on the thread owning the context.
+void ExecuteCommandLists(const CommandList* const lists, const u32 count);
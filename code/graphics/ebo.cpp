@@ -2,12 +2,15 @@
 
 #include <glad/glad.h>
 
+#include "core/metrics.h"
+
 u32 CreateEBO(const u32* const indices, const size_t size)
 {
     u32 result = -1;
     glGenBuffers(1, &result);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, result);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, GL_STATIC_DRAW);
+    AddMetric(Metric::UploadBytes, size);
     return result;
 }
 
@@ -0,0 +1,204 @@
+#include "graphics/framebuffer.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#include <glad/glad.h>
+
+#include "core/metrics.h"
+
+Framebuffer CreateFramebuffer(const i32 width, const i32 height)
+{
+    Framebuffer result = {};
+    result.m_Width = width;
+    result.m_Height = height;
+
+    glGenTextures(1, &result.m_ColorTexture);
+    glBindTexture(GL_TEXTURE_2D, result.m_ColorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &result.m_DepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, result.m_DepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &result.m_Id);
+    glBindFramebuffer(GL_FRAMEBUFFER, result.m_Id);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, result.m_ColorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, result.m_DepthBuffer);
+
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOG_ERROR("Framebuffer of %dx%d is incomplete: 0x%x.", width, height, status);
+        DeleteFramebuffer(result);
+        return {};
+    }
+
+    return result;
+}
+
+void BindFramebuffer(const Framebuffer& framebuffer)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.m_Id);
+    AddMetric(Metric::StateChanges, 1);
+}
+
+void UnbindFramebuffer()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool ReadFramebufferPixels(const Framebuffer& framebuffer, std::vector<u8>& outPixels)
+{
+    if (framebuffer.m_Id == 0)
+    {
+        return false;
+    }
+
+    const size_t rowSize = scast<size_t>(framebuffer.m_Width) * 4;
+    outPixels.resize(rowSize * framebuffer.m_Height);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer.m_Id);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, framebuffer.m_Width, framebuffer.m_Height, GL_RGBA, GL_UNSIGNED_BYTE, outPixels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, scast<u32>(previous));
+
+    // OpenGL returns the bottom row first.
+    std::vector<u8> row(rowSize);
+    for (i32 y = 0; y < framebuffer.m_Height / 2; ++y)
+    {
+        u8* const top = outPixels.data() + rowSize * y;
+        u8* const bottom = outPixels.data() + rowSize * (framebuffer.m_Height - 1 - y);
+        std::memcpy(row.data(), top, rowSize);
+        std::memcpy(top, bottom, rowSize);
+        std::memcpy(bottom, row.data(), rowSize);
+    }
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+bool SaveImagePPM(const char* const fileName, const u8* const pixels, const i32 width, const i32 height)
+{
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out)
+    {
+        LOG_ERROR("Failed to open file for writing: %s.", fileName);
+        return false;
+    }
+
+    const std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    out.write(header.data(), scast<std::streamsize>(header.size()));
+
+    std::vector<u8> row(scast<size_t>(width) * 3);
+    for (i32 y = 0; y < height; ++y)
+    {
+        const u8* const source = pixels + scast<size_t>(y) * width * 4;
+        for (i32 x = 0; x < width; ++x)
+        {
+            row[x * 3 + 0] = source[x * 4 + 0];
+            row[x * 3 + 1] = source[x * 4 + 1];
+            row[x * 3 + 2] = source[x * 4 + 2];
+        }
+        out.write(rcast<const char*>(row.data()), scast<std::streamsize>(row.size()));
+    }
+
+    if (!out)
+    {
+        LOG_ERROR("Failed to write image: %s.", fileName);
+        return false;
+    }
+
+    return true;
+}
+
+// Reads the next number of a PPM header, skipping whitespace and comments.
+static bool ReadPPMHeaderValue(std::istream& in, i32& outValue)
+{
+    for (;;)
+    {
+        in >> std::ws;
+        if (in.peek() != '#')
+        {
+            break;
+        }
+        in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+
+    return scast<bool>(in >> outValue);
+}
+
+bool LoadImagePPM(const char* const fileName, std::vector<u8>& outPixels, i32& outWidth, i32& outHeight)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in)
+    {
+        LOG_ERROR("Failed to open file: %s.", fileName);
+        return false;
+    }
+
+    char magic[2] = {};
+    in.read(magic, sizeof(magic));
+
+    i32 width = 0;
+    i32 height = 0;
+    i32 maxValue = 0;
+    if (!in || magic[0] != 'P' || magic[1] != '6'
+        || !ReadPPMHeaderValue(in, width)
+        || !ReadPPMHeaderValue(in, height)
+        || !ReadPPMHeaderValue(in, maxValue)
+        || width <= 0 || height <= 0 || maxValue != 255)
+    {
+        LOG_ERROR("Not a supported PPM image: %s.", fileName);
+        return false;
+    }
+    in.get(); // The single whitespace character before the pixels.
+
+    const size_t pixelCount = scast<size_t>(width) * height;
+    std::vector<u8> rgb(pixelCount * 3);
+    in.read(rcast<char*>(rgb.data()), scast<std::streamsize>(rgb.size()));
+    if (!in)
+    {
+        LOG_ERROR("Truncated PPM image: %s.", fileName);
+        return false;
+    }
+
+    outPixels.resize(pixelCount * 4);
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        outPixels[i * 4 + 0] = rgb[i * 3 + 0];
+        outPixels[i * 4 + 1] = rgb[i * 3 + 1];
+        outPixels[i * 4 + 2] = rgb[i * 3 + 2];
+        outPixels[i * 4 + 3] = 255;
+    }
+
+    outWidth = width;
+    outHeight = height;
+    return true;
+}
+
+void DeleteFramebuffer(const Framebuffer& framebuffer)
+{
+    if (framebuffer.m_Id != 0)
+    {
+        glDeleteFramebuffers(1, &framebuffer.m_Id);
+    }
+    if (framebuffer.m_DepthBuffer != 0)
+    {
+        glDeleteRenderbuffers(1, &framebuffer.m_DepthBuffer);
+    }
+    if (framebuffer.m_ColorTexture != 0)
+    {
+        glDeleteTextures(1, &framebuffer.m_ColorTexture);
+    }
+}
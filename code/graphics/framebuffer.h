@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "common.h"
+
+// Offscreen render target with an RGBA8 color texture and a 24-bit depth buffer.
+struct Framebuffer
+{
+    u32 m_Id;
+    u32 m_ColorTexture;
+    u32 m_DepthBuffer;
+    i32 m_Width;
+    i32 m_Height;
+};
+
+// Returns a framebuffer with an ID of 0 if it can't be created.
+Framebuffer CreateFramebuffer(const i32 width, const i32 height);
+
+// Draws go to the framebuffer until it is unbound.
+void BindFramebuffer(const Framebuffer& framebuffer);
+
+// Binds the default framebuffer of the window again.
+void UnbindFramebuffer();
+
+// Reads back the color buffer as RGBA8, top row first. Waits for the GPU to finish drawing.
+bool ReadFramebufferPixels(const Framebuffer& framebuffer, std::vector<u8>& outPixels);
+
+// Writes RGBA8 pixels, top row first, as a binary PPM. The alpha channel is dropped.
+bool SaveImagePPM(const char* const fileName, const u8* const pixels, const i32 width, const i32 height);
+
+// Reads a binary PPM with 8-bit channels as RGBA8, top row first, with an opaque alpha channel.
+bool LoadImagePPM(const char* const fileName, std::vector<u8>& outPixels, i32& outWidth, i32& outHeight);
+
+void DeleteFramebuffer(const Framebuffer& framebuffer);
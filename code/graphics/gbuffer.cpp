@@ -0,0 +1,39 @@
+#include "graphics/gbuffer.h"
+
+#include <glad/glad.h>
+
+#include "core/metrics.h"
+
+GBuffer CreateGBufferTargets(RenderGraph& graph, const i32 width, const i32 height)
+{
+    GBuffer result = {};
+    result.m_Normal = CreateRenderTarget(graph, "GBufferNormal", { width, height, GL_RG16 });
+    result.m_AlbedoSpec = CreateRenderTarget(graph, "GBufferAlbedoSpec", { width, height, GL_RGBA8 });
+    result.m_Depth = CreateRenderTarget(graph, "GBufferDepth", { width, height, GL_DEPTH_COMPONENT24 });
+    return result;
+}
+
+void WriteGBuffer(RenderGraph& graph, const u32 pass, GBuffer& gbuffer)
+{
+    gbuffer.m_Normal = WriteRenderTarget(graph, pass, gbuffer.m_Normal);
+    gbuffer.m_AlbedoSpec = WriteRenderTarget(graph, pass, gbuffer.m_AlbedoSpec);
+    gbuffer.m_Depth = WriteDepthTarget(graph, pass, gbuffer.m_Depth);
+}
+
+void ReadGBuffer(RenderGraph& graph, const u32 pass, const GBuffer& gbuffer)
+{
+    ReadRenderTarget(graph, pass, gbuffer.m_Normal);
+    ReadRenderTarget(graph, pass, gbuffer.m_AlbedoSpec);
+    ReadRenderTarget(graph, pass, gbuffer.m_Depth);
+}
+
+void BindGBufferTextures(const RenderGraph& graph, const GBuffer& gbuffer)
+{
+    glActiveTexture(GL_TEXTURE0 + GBUFFER_NORMAL_UNIT);
+    glBindTexture(GL_TEXTURE_2D, GetRenderTargetTexture(graph, gbuffer.m_Normal));
+    glActiveTexture(GL_TEXTURE0 + GBUFFER_ALBEDO_SPEC_UNIT);
+    glBindTexture(GL_TEXTURE_2D, GetRenderTargetTexture(graph, gbuffer.m_AlbedoSpec));
+    glActiveTexture(GL_TEXTURE0 + GBUFFER_DEPTH_UNIT);
+    glBindTexture(GL_TEXTURE_2D, GetRenderTargetTexture(graph, gbuffer.m_Depth));
+    AddMetric(Metric::StateChanges, 3);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "common.h"
+#include "graphics/render_graph.h"
+
+// G-buffer of the deferred shading path, 8 bytes of color per pixel plus depth:
+//   m_Normal:     RG16, the normal in octahedral encoding, remapped from [-1, 1] to [0, 1].
+//   m_AlbedoSpec: RGBA8, the albedo of tex0 in rgb and the specular intensity of tex1 in a.
+//   m_Depth:      24-bit depth. There is no position target, the lighting pass rebuilds the position from the depth
+//                 and the inverse camera matrix.
+// The targets are transient render graph targets, so their textures and framebuffer are pooled across frames.
+struct GBuffer
+{
+    u32 m_Normal;     // Render graph resources.
+    u32 m_AlbedoSpec;
+    u32 m_Depth;
+};
+
+// Texture units of the targets in the lighting pass, see BindGBufferTextures().
+constexpr u32 GBUFFER_NORMAL_UNIT = 0;
+constexpr u32 GBUFFER_ALBEDO_SPEC_UNIT = 1;
+constexpr u32 GBUFFER_DEPTH_UNIT = 2;
+
+// Declares the targets of a G-buffer in the frame.
+GBuffer CreateGBufferTargets(RenderGraph& graph, const i32 width, const i32 height);
+
+// The pass draws into all the targets. Updates `gbuffer` to the written versions.
+void WriteGBuffer(RenderGraph& graph, const u32 pass, GBuffer& gbuffer);
+
+// The pass samples all the targets.
+void ReadGBuffer(RenderGraph& graph, const u32 pass, const GBuffer& gbuffer);
+
+// Binds the targets to the GBUFFER_*_UNIT texture units, while the graph executes.
+void BindGBufferTextures(const RenderGraph& graph, const GBuffer& gbuffer);
@@ -0,0 +1,252 @@
+#include "graphics/headless.h"
+
+#include <cstring>
+#include <vector>
+
+#if O3D_HEADLESS && O3D_HEADLESS_OSMESA
+#include <glad/glad.h> // Before osmesa.h, which would include GL/gl.h otherwise.
+#include <GL/osmesa.h>
+#elif O3D_HEADLESS
+#define EGL_NO_X11 // Keeps the Xlib macros out, the surfaceless platform doesn't use them.
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+constexpr i32 HEADLESS_GL_MAJOR = 4;
+constexpr i32 HEADLESS_GL_MINOR = 3; // Shader storage buffers, see graphics/clustered_lighting.h.
+
+#if O3D_HEADLESS && O3D_HEADLESS_OSMESA
+
+struct HeadlessContext
+{
+    OSMesaContext m_Context = nullptr;
+    std::vector<u8> m_Buffer; // OSMesa wants a color buffer to make the context current, nothing is drawn into it.
+    i32 m_Width = 0;
+    i32 m_Height = 0;
+};
+
+static HeadlessContext g_HeadlessContext = {};
+
+bool CreateHeadlessContext(const i32 width, const i32 height)
+{
+    const int attributes[] =
+    {
+        OSMESA_FORMAT, OSMESA_RGBA,
+        OSMESA_DEPTH_BITS, 24,
+        OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+        OSMESA_CONTEXT_MAJOR_VERSION, HEADLESS_GL_MAJOR,
+        OSMESA_CONTEXT_MINOR_VERSION, HEADLESS_GL_MINOR,
+        0,
+    };
+
+    g_HeadlessContext.m_Context = OSMesaCreateContextAttribs(attributes, nullptr);
+    if (g_HeadlessContext.m_Context == nullptr)
+    {
+        LOG_ERROR("Failed to create an OSMesa OpenGL %d.%d core context.", HEADLESS_GL_MAJOR, HEADLESS_GL_MINOR);
+        return false;
+    }
+
+    g_HeadlessContext.m_Buffer.resize(scast<size_t>(width) * height * 4);
+    g_HeadlessContext.m_Width = width;
+    g_HeadlessContext.m_Height = height;
+    if (!SetHeadlessContextCurrent(true))
+    {
+        DestroyHeadlessContext();
+        return false;
+    }
+
+    LOG_INFO("Created a headless OSMesa context.");
+    return true;
+}
+
+void DestroyHeadlessContext()
+{
+    if (g_HeadlessContext.m_Context != nullptr)
+    {
+        OSMesaDestroyContext(g_HeadlessContext.m_Context);
+    }
+
+    g_HeadlessContext = {};
+}
+
+bool SetHeadlessContextCurrent(const bool current)
+{
+    // A null context unbinds the current one.
+    if (!OSMesaMakeCurrent(
+        current ? g_HeadlessContext.m_Context : nullptr,
+        current ? g_HeadlessContext.m_Buffer.data() : nullptr,
+        GL_UNSIGNED_BYTE,
+        current ? g_HeadlessContext.m_Width : 0,
+        current ? g_HeadlessContext.m_Height : 0))
+    {
+        LOG_ERROR("Failed to make the OSMesa context current.");
+        return false;
+    }
+
+    return true;
+}
+
+void* GetHeadlessProcAddress(const char* const name)
+{
+    return rcast<void*>(OSMesaGetProcAddress(name));
+}
+
+#elif O3D_HEADLESS
+
+struct HeadlessContext
+{
+    EGLDisplay m_Display = EGL_NO_DISPLAY;
+    EGLContext m_Context = EGL_NO_CONTEXT;
+};
+
+static HeadlessContext g_HeadlessContext = {};
+
+static bool HasEGLExtension(const char* const extensions, const char* const name)
+{
+    const size_t length = std::strlen(name);
+    for (const char* match = extensions ? std::strstr(extensions, name) : nullptr;
+         match != nullptr;
+         match = std::strstr(match + length, name))
+    {
+        if ((match == extensions || match[-1] == ' ') && (match[length] == ' ' || match[length] == '\0'))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CreateHeadlessContext(const i32 width, const i32 height)
+{
+    // SECTION: Display on the surfaceless platform, which needs neither a window system nor a GPU.
+    const char* const clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    const auto getPlatformDisplay =
+        rcast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay == nullptr || !HasEGLExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+    {
+        LOG_ERROR("EGL_MESA_platform_surfaceless is not supported.");
+        return false;
+    }
+
+    g_HeadlessContext.m_Display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    EGLint major = 0;
+    EGLint minor = 0;
+    if (g_HeadlessContext.m_Display == EGL_NO_DISPLAY || !eglInitialize(g_HeadlessContext.m_Display, &major, &minor))
+    {
+        LOG_ERROR("Failed to initialize the EGL display.");
+        DestroyHeadlessContext();
+        return false;
+    }
+
+    const char* const displayExtensions = eglQueryString(g_HeadlessContext.m_Display, EGL_EXTENSIONS);
+    if (!HasEGLExtension(displayExtensions, "EGL_KHR_surfaceless_context")
+        || !HasEGLExtension(displayExtensions, "EGL_KHR_create_context")
+        || !eglBindAPI(EGL_OPENGL_API))
+    {
+        LOG_ERROR("EGL %d.%d can't create surfaceless desktop OpenGL contexts.", major, minor);
+        DestroyHeadlessContext();
+        return false;
+    }
+
+    // SECTION: Context. Nothing is drawn to an EGL surface, so any config will do when one is needed at all.
+    EGLConfig config = nullptr;
+    if (!HasEGLExtension(displayExtensions, "EGL_KHR_no_config_context"))
+    {
+        const EGLint configAttributes[] =
+        {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE,
+        };
+        EGLint configCount = 0;
+        if (!eglChooseConfig(g_HeadlessContext.m_Display, configAttributes, &config, 1, &configCount)
+            || configCount == 0)
+        {
+            LOG_ERROR("No EGL config supports desktop OpenGL.");
+            DestroyHeadlessContext();
+            return false;
+        }
+    }
+
+    const EGLint contextAttributes[] =
+    {
+        EGL_CONTEXT_MAJOR_VERSION_KHR, HEADLESS_GL_MAJOR,
+        EGL_CONTEXT_MINOR_VERSION_KHR, HEADLESS_GL_MINOR,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+        EGL_NONE,
+    };
+    g_HeadlessContext.m_Context = eglCreateContext(
+        g_HeadlessContext.m_Display,
+        config,
+        EGL_NO_CONTEXT,
+        contextAttributes
+    );
+    if (g_HeadlessContext.m_Context == EGL_NO_CONTEXT
+        || !eglMakeCurrent(g_HeadlessContext.m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, g_HeadlessContext.m_Context))
+    {
+        LOG_ERROR("Failed to create an EGL OpenGL %d.%d core context.", HEADLESS_GL_MAJOR, HEADLESS_GL_MINOR);
+        DestroyHeadlessContext();
+        return false;
+    }
+
+    LOG_INFO("Created a headless EGL %d.%d context for a %dx%d target.", major, minor, width, height);
+    return true;
+}
+
+void DestroyHeadlessContext()
+{
+    if (g_HeadlessContext.m_Display != EGL_NO_DISPLAY)
+    {
+        eglMakeCurrent(g_HeadlessContext.m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (g_HeadlessContext.m_Context != EGL_NO_CONTEXT)
+        {
+            eglDestroyContext(g_HeadlessContext.m_Display, g_HeadlessContext.m_Context);
+        }
+        eglTerminate(g_HeadlessContext.m_Display);
+    }
+
+    g_HeadlessContext = {};
+}
+
+bool SetHeadlessContextCurrent(const bool current)
+{
+    const EGLContext context = current ? g_HeadlessContext.m_Context : EGL_NO_CONTEXT;
+    if (!eglMakeCurrent(g_HeadlessContext.m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+    {
+        LOG_ERROR("Failed to make the EGL context current: 0x%x.", eglGetError());
+        return false;
+    }
+
+    return true;
+}
+
+void* GetHeadlessProcAddress(const char* const name)
+{
+    return rcast<void*>(eglGetProcAddress(name));
+}
+
+#else
+
+bool CreateHeadlessContext(const i32 width, const i32 height)
+{
+    LOG_ERROR("This build has no headless backend, build with O3D_HEADLESS defined.");
+    return false;
+}
+
+void DestroyHeadlessContext()
+{
+}
+
+bool SetHeadlessContextCurrent(const bool current)
+{
+    return false;
+}
+
+void* GetHeadlessProcAddress(const char* const name)
+{
+    return nullptr;
+}
+
+#endif // O3D_HEADLESS
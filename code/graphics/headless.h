@@ -0,0 +1,20 @@
+#pragma once
+
+#include "common.h"
+
+// OpenGL context without a window or a display, for machines like build agents that have neither.
+// Built with O3D_HEADLESS defined, the context is created through EGL on the Mesa surfaceless platform, or through
+// OSMesa if O3D_HEADLESS_OSMESA is defined too. Both run on llvmpipe when there is no GPU. Without O3D_HEADLESS
+// creating the context fails.
+// There is no default framebuffer to draw into, render into a Framebuffer (see framebuffer.h) instead.
+
+// Creates an OpenGL 4.3 core context and makes it current on the calling thread.
+bool CreateHeadlessContext(const i32 width, const i32 height);
+void DestroyHeadlessContext();
+
+// Makes the context current on the calling thread, or releases it from the calling thread so another one can take
+// it, e.g. the render thread.
+bool SetHeadlessContextCurrent(const bool current);
+
+// Loader for gladLoadGLLoader() while the headless context is current.
+void* GetHeadlessProcAddress(const char* const name);
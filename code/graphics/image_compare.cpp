@@ -0,0 +1,95 @@
+#include "graphics/image_compare.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+// sRGB (D65) to CIELAB.
+static glm::vec3 SRGBToLab(const u8* const pixel)
+{
+    auto linear = [](const u8 value)
+    {
+        const float c = scast<float>(value) / 255.0f;
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    };
+
+    const float r = linear(pixel[0]);
+    const float g = linear(pixel[1]);
+    const float b = linear(pixel[2]);
+
+    // XYZ relative to the D65 white point.
+    const glm::vec3 xyz = glm::vec3(
+        (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f,
+        (0.2126f * r + 0.7152f * g + 0.0722f * b),
+        (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f
+    );
+
+    auto f = [](const float t)
+    {
+        return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+    };
+
+    const float fx = f(xyz.x);
+    const float fy = f(xyz.y);
+    const float fz = f(xyz.z);
+    return glm::vec3(116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz));
+}
+
+ImageDiff CompareImages(
+    const u8* const expected,
+    const u8* const actual,
+    const i32 width,
+    const i32 height,
+    const ImageTolerance& tolerance,
+    std::vector<u8>* const outDiffImage)
+{
+    const size_t pixelCount = scast<size_t>(width) * height;
+    if (outDiffImage != nullptr)
+    {
+        outDiffImage->resize(pixelCount * 4);
+    }
+
+    ImageDiff result = {};
+    double totalDeltaE = 0.0;
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        const u8* const a = expected + i * 4;
+        const u8* const b = actual + i * 4;
+
+        float deltaE = 0.0f;
+        if (a[0] != b[0] || a[1] != b[1] || a[2] != b[2])
+        {
+            deltaE = glm::length(SRGBToLab(a) - SRGBToLab(b));
+        }
+
+        const bool different = deltaE > tolerance.m_MaxDeltaE;
+        result.m_DifferentPixels += different ? 1 : 0;
+        result.m_MaxDeltaE = std::max(result.m_MaxDeltaE, deltaE);
+        totalDeltaE += deltaE;
+
+        if (outDiffImage != nullptr)
+        {
+            // The expected image is dimmed as a backdrop.
+            u8* const out = outDiffImage->data() + i * 4;
+            const u8 gray = scast<u8>((scast<u32>(a[0]) + a[1] + a[2]) / 12);
+            out[0] = different ? 255 : gray;
+            out[1] = different ? 0 : gray;
+            out[2] = different ? 0 : gray;
+            out[3] = 255;
+        }
+    }
+
+    if (pixelCount > 0)
+    {
+        result.m_DifferentFraction = scast<float>(result.m_DifferentPixels) / scast<float>(pixelCount);
+        result.m_MeanDeltaE = scast<float>(totalDeltaE / scast<double>(pixelCount));
+    }
+
+    return result;
+}
+
+bool IsImageDiffWithinTolerance(const ImageDiff& diff, const ImageTolerance& tolerance)
+{
+    return diff.m_DifferentFraction <= tolerance.m_MaxDifferentFraction;
+}
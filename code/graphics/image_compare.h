@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+
+#include "common.h"
+
+// Perceptual comparison of rendered images, for checking frames against golden images. Pixels are compared by
+// their color difference in CIELAB (CIE76 delta E), where a difference of about 2.3 is just noticeable. A few
+// pixels are allowed to differ by more, since rasterization rules and filtering differ a little between GPUs and
+// drivers.
+
+struct ImageTolerance
+{
+    float m_MaxDeltaE = 2.3f;                  // Pixels that differ by more are counted as different.
+    float m_MaxDifferentFraction = 0.005f;     // Fraction of the pixels that may differ.
+};
+
+struct ImageDiff
+{
+    u32 m_DifferentPixels;
+    float m_DifferentFraction;
+    float m_MeanDeltaE;
+    float m_MaxDeltaE;
+};
+
+// Compares two RGBA8 images of the same size, the alpha channel is ignored. If `outDiffImage` isn't null it
+// receives an RGBA8 image of the differences: gray where they match, red where they differ.
+ImageDiff CompareImages(
+    const u8* const expected,
+    const u8* const actual,
+    const i32 width,
+    const i32 height,
+    const ImageTolerance& tolerance,
+    std::vector<u8>* const outDiffImage
+);
+
+bool IsImageDiffWithinTolerance(const ImageDiff& diff, const ImageTolerance& tolerance);
@@ -0,0 +1,593 @@
+#include "graphics/render_graph.h"
+
+#include <glad/glad.h>
+
+#include "core/metrics.h"
+#include "core/profiler.h"
+
+void BeginRenderGraph(RenderGraph& graph)
+{
+    graph.m_Resources.clear();
+    graph.m_Passes.clear();
+    graph.m_Order.clear();
+    graph.m_Frame++;
+    graph.m_Stats = {};
+}
+
+static u32 AddResourceVersion(RenderGraph& graph, const char* const name, const u32 target, const u32 producer)
+{
+    RenderGraphResource resource = {};
+    resource.m_Name = name;
+    resource.m_Target = target == RENDER_GRAPH_INVALID ? scast<u32>(graph.m_Resources.size()) : target;
+    resource.m_Producer = producer;
+    resource.m_ImportedFramebuffer = RENDER_GRAPH_INVALID;
+    resource.m_Texture = 0;
+    resource.m_FirstUse = RENDER_GRAPH_INVALID;
+    resource.m_LastUse = 0;
+    graph.m_Resources.push_back(resource);
+    return scast<u32>(graph.m_Resources.size() - 1);
+}
+
+u32 CreateRenderTarget(RenderGraph& graph, const char* const name, const RenderTargetDesc& desc)
+{
+    const u32 result = AddResourceVersion(graph, name, RENDER_GRAPH_INVALID, RENDER_GRAPH_INVALID);
+    graph.m_Resources[result].m_Desc = desc;
+    return result;
+}
+
+u32 ImportRenderTarget(
+    RenderGraph& graph,
+    const char* const name,
+    const u32 framebuffer,
+    const i32 width,
+    const i32 height)
+{
+    const u32 result = AddResourceVersion(graph, name, RENDER_GRAPH_INVALID, RENDER_GRAPH_INVALID);
+    RenderGraphResource& resource = graph.m_Resources[result];
+    resource.m_Desc = { width, height, 0 };
+    resource.m_Imported = true;
+    resource.m_ImportedFramebuffer = framebuffer;
+    return result;
+}
+
+u32 AddRenderPassFunction(RenderGraph& graph, const char* const name, const RenderPassFunction function)
+{
+    RenderGraphPass& pass = graph.m_Passes.emplace_back();
+    pass.m_Name = name;
+    pass.m_Function = function;
+    pass.m_ColorTargetCount = 0;
+    pass.m_DepthTarget = RENDER_GRAPH_INVALID;
+    pass.m_SideEffect = false;
+    pass.m_Culled = true;
+    pass.m_Framebuffer = RENDER_GRAPH_INVALID;
+    return scast<u32>(graph.m_Passes.size() - 1);
+}
+
+u32 ReadRenderTarget(RenderGraph& graph, const u32 pass, const u32 resource)
+{
+    graph.m_Passes[pass].m_Reads.push_back(resource);
+    return resource;
+}
+
+u32 WriteRenderTarget(RenderGraph& graph, const u32 pass, const u32 resource)
+{
+    RenderGraphPass& renderPass = graph.m_Passes[pass];
+    if (renderPass.m_ColorTargetCount == RENDER_PASS_MAX_COLOR_TARGETS)
+    {
+        LOG_ERROR("Render pass \"%s\" has too many color targets.", renderPass.m_Name);
+        return resource;
+    }
+
+    const RenderGraphResource& previous = graph.m_Resources[resource];
+    const u32 result = AddResourceVersion(graph, previous.m_Name, previous.m_Target, pass);
+    renderPass.m_Writes.push_back(resource);
+    renderPass.m_ColorTargets[renderPass.m_ColorTargetCount++] = result;
+    return result;
+}
+
+u32 WriteDepthTarget(RenderGraph& graph, const u32 pass, const u32 resource)
+{
+    const RenderGraphResource& previous = graph.m_Resources[resource];
+    const u32 result = AddResourceVersion(graph, previous.m_Name, previous.m_Target, pass);
+    graph.m_Passes[pass].m_Writes.push_back(resource);
+    graph.m_Passes[pass].m_DepthTarget = result;
+    return result;
+}
+
+void SetRenderPassSideEffect(RenderGraph& graph, const u32 pass)
+{
+    graph.m_Passes[pass].m_SideEffect = true;
+}
+
+// SECTION: Compilation
+
+static u32 GetFormatSize(const u32 format)
+{
+    switch (format)
+    {
+        case GL_R8: return 1;
+        case GL_RG8: return 2;
+        case GL_RGBA16F: return 8;
+        case GL_RGBA32F: return 16;
+        default: return 4; // RGBA8, RG16, R32F, 24 and 32-bit depth.
+    }
+}
+
+static bool IsImportedPass(const RenderGraph& graph, const RenderGraphPass& pass)
+{
+    for (const u32 resource : pass.m_Writes)
+    {
+        if (graph.m_Resources[graph.m_Resources[resource].m_Target].m_Imported)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Keeps the passes writing an imported target or with side effects, and every pass producing something they use.
+static void CullRenderPasses(RenderGraph& graph)
+{
+    FrameVector<u32> stack;
+    stack.reserve(graph.m_Passes.size());
+    for (u32 i = 0; i < graph.m_Passes.size(); ++i)
+    {
+        RenderGraphPass& pass = graph.m_Passes[i];
+        pass.m_Culled = !pass.m_SideEffect && !IsImportedPass(graph, pass);
+        if (!pass.m_Culled)
+        {
+            stack.push_back(i);
+        }
+    }
+
+    auto keepProducer = [&graph, &stack](const u32 resource)
+    {
+        const u32 producer = graph.m_Resources[resource].m_Producer;
+        if (producer != RENDER_GRAPH_INVALID && graph.m_Passes[producer].m_Culled)
+        {
+            graph.m_Passes[producer].m_Culled = false;
+            stack.push_back(producer);
+        }
+    };
+
+    while (!stack.empty())
+    {
+        const RenderGraphPass& pass = graph.m_Passes[stack.back()];
+        stack.pop_back();
+
+        // Writes keep the contents, so the pass also needs whoever wrote the version it draws over.
+        for (const u32 resource : pass.m_Reads)
+        {
+            keepProducer(resource);
+        }
+        for (const u32 resource : pass.m_Writes)
+        {
+            keepProducer(resource);
+        }
+    }
+}
+
+// Orders the kept passes so every pass runs after the passes writing what it reads or writes over, and after the
+// passes reading what it writes over. Ties go to the pass declared first. Returns false on a cycle.
+static bool SortRenderPasses(RenderGraph& graph)
+{
+    const u32 passCount = scast<u32>(graph.m_Passes.size());
+
+    FrameVector<FrameVector<u32>> readers(graph.m_Resources.size());
+    for (u32 i = 0; i < passCount; ++i)
+    {
+        if (!graph.m_Passes[i].m_Culled)
+        {
+            for (const u32 resource : graph.m_Passes[i].m_Reads)
+            {
+                readers[resource].push_back(i);
+            }
+        }
+    }
+
+    FrameVector<FrameVector<u32>> successors(passCount);
+    FrameVector<u32> predecessorCounts(passCount, 0);
+    auto addEdge = [&successors, &predecessorCounts](const u32 from, const u32 to)
+    {
+        if (from != RENDER_GRAPH_INVALID && from != to)
+        {
+            successors[from].push_back(to);
+            predecessorCounts[to]++;
+        }
+    };
+
+    u32 keptCount = 0;
+    for (u32 i = 0; i < passCount; ++i)
+    {
+        const RenderGraphPass& pass = graph.m_Passes[i];
+        if (pass.m_Culled)
+        {
+            continue;
+        }
+
+        keptCount++;
+        for (const u32 resource : pass.m_Reads)
+        {
+            addEdge(graph.m_Resources[resource].m_Producer, i);
+        }
+        for (const u32 resource : pass.m_Writes)
+        {
+            addEdge(graph.m_Resources[resource].m_Producer, i);
+            for (const u32 reader : readers[resource])
+            {
+                addEdge(reader, i);
+            }
+        }
+    }
+
+    // Kahn's algorithm. Graphs are a handful of passes, so the ready list is searched linearly.
+    FrameVector<u32> ready;
+    ready.reserve(passCount);
+    for (u32 i = 0; i < passCount; ++i)
+    {
+        if (!graph.m_Passes[i].m_Culled && predecessorCounts[i] == 0)
+        {
+            ready.push_back(i);
+        }
+    }
+
+    while (!ready.empty())
+    {
+        u32 first = 0;
+        for (u32 i = 1; i < ready.size(); ++i)
+        {
+            first = ready[i] < ready[first] ? i : first;
+        }
+
+        const u32 pass = ready[first];
+        ready[first] = ready.back();
+        ready.pop_back();
+        graph.m_Order.push_back(pass);
+
+        for (const u32 successor : successors[pass])
+        {
+            if (--predecessorCounts[successor] == 0)
+            {
+                ready.push_back(successor);
+            }
+        }
+    }
+
+    if (graph.m_Order.size() != keptCount)
+    {
+        LOG_ERROR(
+            "The render graph has a cycle, %u of %u passes can't be ordered.",
+            keptCount - scast<u32>(graph.m_Order.size()),
+            keptCount
+        );
+        return false;
+    }
+
+    return true;
+}
+
+static u32 CreatePooledTexture(RenderGraph& graph, const RenderTargetDesc& desc)
+{
+    RenderGraphTexture texture = {};
+    texture.m_Desc = desc;
+
+    glGenTextures(1, &texture.m_Texture);
+    glBindTexture(GL_TEXTURE_2D, texture.m_Texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, desc.m_Format, desc.m_Width, desc.m_Height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    graph.m_Textures.push_back(texture);
+    graph.m_Stats.m_CreatedTextureCount++;
+    return scast<u32>(graph.m_Textures.size() - 1);
+}
+
+// Gives every transient target a pooled texture for its lifetime. A texture is handed to the next target with the
+// same description once the last pass using its current target has run.
+static void AllocateRenderTargets(RenderGraph& graph)
+{
+    FrameVector<u32> targets;
+    for (u32 position = 0; position < graph.m_Order.size(); ++position)
+    {
+        const RenderGraphPass& pass = graph.m_Passes[graph.m_Order[position]];
+        auto use = [&graph, &targets, position](const u32 version)
+        {
+            RenderGraphResource& target = graph.m_Resources[graph.m_Resources[version].m_Target];
+            if (target.m_Imported)
+            {
+                return;
+            }
+            if (target.m_FirstUse == RENDER_GRAPH_INVALID)
+            {
+                target.m_FirstUse = position;
+                targets.push_back(graph.m_Resources[version].m_Target);
+            }
+            target.m_LastUse = position;
+        };
+
+        for (const u32 resource : pass.m_Reads)
+        {
+            use(resource);
+        }
+        for (const u32 resource : pass.m_Writes)
+        {
+            use(resource);
+        }
+    }
+
+    for (RenderGraphTexture& texture : graph.m_Textures)
+    {
+        texture.m_Assigned = false;
+    }
+
+    FrameVector<u32> textureOfTarget(graph.m_Resources.size(), RENDER_GRAPH_INVALID);
+    for (u32 position = 0; position < graph.m_Order.size(); ++position)
+    {
+        for (const u32 target : targets)
+        {
+            RenderGraphResource& resource = graph.m_Resources[target];
+            if (resource.m_FirstUse != position)
+            {
+                continue;
+            }
+
+            u32 texture = RENDER_GRAPH_INVALID;
+            for (u32 i = 0; i < graph.m_Textures.size(); ++i)
+            {
+                if (!graph.m_Textures[i].m_Assigned && graph.m_Textures[i].m_Desc == resource.m_Desc)
+                {
+                    texture = i;
+                    break;
+                }
+            }
+            if (texture == RENDER_GRAPH_INVALID)
+            {
+                texture = CreatePooledTexture(graph, resource.m_Desc);
+            }
+
+            const u64 size = scast<u64>(resource.m_Desc.m_Width) * resource.m_Desc.m_Height
+                * GetFormatSize(resource.m_Desc.m_Format);
+            RenderGraphTexture& pooled = graph.m_Textures[texture];
+            if (pooled.m_LastUsedFrame != graph.m_Frame)
+            {
+                graph.m_Stats.m_TextureCount++;
+                graph.m_Stats.m_TextureBytes += size;
+            }
+            pooled.m_Assigned = true;
+            pooled.m_LastUsedFrame = graph.m_Frame;
+            resource.m_Texture = pooled.m_Texture;
+            textureOfTarget[target] = texture;
+
+            graph.m_Stats.m_TransientTargetCount++;
+            graph.m_Stats.m_UnaliasedTextureBytes += size;
+        }
+
+        // Released after the allocations, so the inputs and outputs of a pass never share a texture.
+        for (const u32 target : targets)
+        {
+            if (graph.m_Resources[target].m_LastUse == position)
+            {
+                graph.m_Textures[textureOfTarget[target]].m_Assigned = false;
+            }
+        }
+    }
+}
+
+// Finds or creates the framebuffer with the targets of a pass attached.
+static bool ResolvePassFramebuffer(RenderGraph& graph, RenderGraphPass& pass)
+{
+    if (pass.m_ColorTargetCount == 0 && pass.m_DepthTarget == RENDER_GRAPH_INVALID)
+    {
+        pass.m_Framebuffer = RENDER_GRAPH_INVALID; // Keeps whatever is bound.
+        return true;
+    }
+
+    if (IsImportedPass(graph, pass))
+    {
+        const u32 target = graph.m_Resources[pass.m_Writes[0]].m_Target;
+        for (const u32 resource : pass.m_Writes)
+        {
+            if (graph.m_Resources[resource].m_Target != target)
+            {
+                LOG_ERROR("Render pass \"%s\" mixes an imported target with other targets.", pass.m_Name);
+                return false;
+            }
+        }
+
+        pass.m_Framebuffer = graph.m_Resources[target].m_ImportedFramebuffer;
+        return true;
+    }
+
+    RenderGraphFramebuffer key = {};
+    key.m_ColorTextureCount = pass.m_ColorTargetCount;
+    for (u32 i = 0; i < pass.m_ColorTargetCount; ++i)
+    {
+        key.m_ColorTextures[i] = graph.m_Resources[graph.m_Resources[pass.m_ColorTargets[i]].m_Target].m_Texture;
+    }
+    key.m_DepthTexture = pass.m_DepthTarget == RENDER_GRAPH_INVALID
+        ? 0
+        : graph.m_Resources[graph.m_Resources[pass.m_DepthTarget].m_Target].m_Texture;
+
+    for (RenderGraphFramebuffer& cached : graph.m_Framebuffers)
+    {
+        bool match = cached.m_ColorTextureCount == key.m_ColorTextureCount
+            && cached.m_DepthTexture == key.m_DepthTexture;
+        for (u32 i = 0; match && i < key.m_ColorTextureCount; ++i)
+        {
+            match = cached.m_ColorTextures[i] == key.m_ColorTextures[i];
+        }
+
+        if (match)
+        {
+            cached.m_LastUsedFrame = graph.m_Frame;
+            pass.m_Framebuffer = cached.m_Framebuffer;
+            return true;
+        }
+    }
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+
+    glGenFramebuffers(1, &key.m_Framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, key.m_Framebuffer);
+
+    GLenum drawBuffers[RENDER_PASS_MAX_COLOR_TARGETS] = {};
+    for (u32 i = 0; i < key.m_ColorTextureCount; ++i)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, key.m_ColorTextures[i], 0);
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    if (key.m_DepthTexture != 0)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, key.m_DepthTexture, 0);
+    }
+
+    if (key.m_ColorTextureCount > 0)
+    {
+        glDrawBuffers(scast<GLsizei>(key.m_ColorTextureCount), drawBuffers);
+    }
+    else
+    {
+        glDrawBuffer(GL_NONE);
+    }
+
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, scast<u32>(previous));
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOG_ERROR("Framebuffer of render pass \"%s\" is incomplete: 0x%x.", pass.m_Name, status);
+        glDeleteFramebuffers(1, &key.m_Framebuffer);
+        return false;
+    }
+
+    key.m_LastUsedFrame = graph.m_Frame;
+    graph.m_Framebuffers.push_back(key);
+    graph.m_Stats.m_CreatedFramebufferCount++;
+    pass.m_Framebuffer = key.m_Framebuffer;
+    return true;
+}
+
+// Deletes the pooled objects that weren't used for a while. A framebuffer is never used more recently than its
+// textures, so it goes no later than they do.
+static void TrimRenderGraphPools(RenderGraph& graph)
+{
+    std::erase_if(graph.m_Framebuffers, [&graph](const RenderGraphFramebuffer& framebuffer)
+    {
+        if (framebuffer.m_LastUsedFrame + RENDER_GRAPH_IDLE_FRAMES >= graph.m_Frame)
+        {
+            return false;
+        }
+
+        glDeleteFramebuffers(1, &framebuffer.m_Framebuffer);
+        return true;
+    });
+
+    std::erase_if(graph.m_Textures, [&graph](const RenderGraphTexture& texture)
+    {
+        if (texture.m_LastUsedFrame + RENDER_GRAPH_IDLE_FRAMES >= graph.m_Frame)
+        {
+            return false;
+        }
+
+        glDeleteTextures(1, &texture.m_Texture);
+        return true;
+    });
+}
+
+bool CompileRenderGraph(RenderGraph& graph)
+{
+    PROFILE_SCOPE("CompileRenderGraph");
+
+    CullRenderPasses(graph);
+    if (!SortRenderPasses(graph))
+    {
+        graph.m_Order.clear();
+        return false;
+    }
+
+    AllocateRenderTargets(graph);
+    for (const u32 pass : graph.m_Order)
+    {
+        if (!ResolvePassFramebuffer(graph, graph.m_Passes[pass]))
+        {
+            graph.m_Order.clear();
+            return false;
+        }
+    }
+
+    TrimRenderGraphPools(graph);
+
+    graph.m_Stats.m_PassCount = scast<u32>(graph.m_Passes.size());
+    graph.m_Stats.m_CulledPassCount = scast<u32>(graph.m_Passes.size() - graph.m_Order.size());
+
+    // Happens on the first frame and when the targets change, e.g. on a resize.
+    if (graph.m_Stats.m_CreatedTextureCount > 0 || graph.m_Stats.m_CreatedFramebufferCount > 0)
+    {
+        LOG_INFO(
+            "Render graph created %u textures and %u framebuffers: %u targets in %u textures of %llu KB (%llu KB "
+            "without aliasing).",
+            graph.m_Stats.m_CreatedTextureCount,
+            graph.m_Stats.m_CreatedFramebufferCount,
+            graph.m_Stats.m_TransientTargetCount,
+            graph.m_Stats.m_TextureCount,
+            scast<unsigned long long>(graph.m_Stats.m_TextureBytes / 1024),
+            scast<unsigned long long>(graph.m_Stats.m_UnaliasedTextureBytes / 1024)
+        );
+    }
+
+    return true;
+}
+
+// SECTION: Execution
+
+void ExecuteRenderGraph(RenderGraph& graph)
+{
+    GLint bound = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &bound);
+
+    for (const u32 index : graph.m_Order)
+    {
+        RenderGraphPass& pass = graph.m_Passes[index];
+        PROFILE_SCOPE(pass.m_Name);
+
+        if (pass.m_Framebuffer != RENDER_GRAPH_INVALID)
+        {
+            const u32 target = pass.m_ColorTargetCount > 0 ? pass.m_ColorTargets[0] : pass.m_DepthTarget;
+            const RenderTargetDesc& desc = graph.m_Resources[graph.m_Resources[target].m_Target].m_Desc;
+            glViewport(0, 0, desc.m_Width, desc.m_Height);
+
+            if (scast<u32>(bound) != pass.m_Framebuffer)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, pass.m_Framebuffer);
+                AddMetric(Metric::StateChanges, 1);
+                bound = scast<GLint>(pass.m_Framebuffer);
+            }
+        }
+
+        pass.m_Function(graph, pass.m_Data);
+    }
+}
+
+u32 GetRenderTargetTexture(const RenderGraph& graph, const u32 resource)
+{
+    return graph.m_Resources[graph.m_Resources[resource].m_Target].m_Texture;
+}
+
+void DestroyRenderGraph(RenderGraph& graph)
+{
+    for (const RenderGraphFramebuffer& framebuffer : graph.m_Framebuffers)
+    {
+        glDeleteFramebuffers(1, &framebuffer.m_Framebuffer);
+    }
+    for (const RenderGraphTexture& texture : graph.m_Textures)
+    {
+        glDeleteTextures(1, &texture.m_Texture);
+    }
+
+    graph = {};
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+#include "core/frame_arena.h"
+
+// Frame graph of the render passes.
+// Every frame the passes are declared with the render targets they read and write, then the graph is compiled and
+// executed:
+// - Writing a target returns a new version of it, and a pass depends on the pass that wrote each version it reads
+//   or writes over. The passes run in a topological order of these dependencies, not in declaration order.
+// - Passes that nothing needs are culled: only passes writing an imported target (e.g. the window) or marked with
+//   SetRenderPassSideEffect() are kept, along with everything they depend on.
+// - Targets created in the graph are transient: they only live from the first to the last pass using them. Targets
+//   with the same size and format whose lifetimes don't overlap share one texture.
+// - Textures and framebuffers persist across frames in pools and are only created when no pooled one fits. Pooled
+//   objects that go unused for RENDER_GRAPH_IDLE_FRAMES frames are deleted, e.g. after a window resize.
+// - The dependency lists of the passes and everything the compilation needs for itself come from the frame arena, so
+//   a frame with warm pools allocates nothing on the heap.
+
+constexpr u32 RENDER_GRAPH_INVALID = ~0u;
+constexpr u32 RENDER_PASS_DATA_SIZE = 48;
+constexpr u32 RENDER_PASS_MAX_COLOR_TARGETS = 4;
+constexpr u64 RENDER_GRAPH_IDLE_FRAMES = 8;
+
+struct RenderGraph;
+
+using RenderPassFunction = void (*)(const RenderGraph& graph, void* data);
+
+struct RenderTargetDesc
+{
+    i32 m_Width;
+    i32 m_Height;
+    u32 m_Format; // Sized internal format, e.g. GL_RGBA8 or GL_DEPTH_COMPONENT24.
+
+    bool operator==(const RenderTargetDesc&) const = default;
+};
+
+// A render target as declared in the frame. Every write creates a new version with the same m_Target.
+struct RenderGraphResource
+{
+    const char* m_Name;
+    u32 m_Target;   // Index of the first version, which holds the state shared by all versions.
+    u32 m_Producer; // Pass writing this version, RENDER_GRAPH_INVALID for the first version.
+
+    // First version only.
+    RenderTargetDesc m_Desc;
+    bool m_Imported;
+    u32 m_ImportedFramebuffer; // Framebuffer an imported target is drawn through.
+    u32 m_Texture;             // Pooled texture of a transient target, after compiling.
+    u32 m_FirstUse;            // Lifetime of a transient target in positions of the execution order.
+    u32 m_LastUse;
+};
+
+struct RenderGraphPass
+{
+    const char* m_Name; // Also the name of the pass in the profiler, so it must outlive the frame.
+    RenderPassFunction m_Function;
+    alignas(16) u8 m_Data[RENDER_PASS_DATA_SIZE];
+
+    FrameVector<u32> m_Reads;  // Resource versions sampled by the pass.
+    FrameVector<u32> m_Writes; // Resource versions written over, color targets in attachment order.
+    u32 m_ColorTargets[RENDER_PASS_MAX_COLOR_TARGETS];
+    u32 m_ColorTargetCount;
+    u32 m_DepthTarget;         // RENDER_GRAPH_INVALID without one.
+    bool m_SideEffect;
+
+    bool m_Culled;
+    u32 m_Framebuffer;         // Resolved while compiling.
+};
+
+struct RenderGraphTexture
+{
+    u32 m_Texture;
+    RenderTargetDesc m_Desc;
+    u64 m_LastUsedFrame;
+    bool m_Assigned; // Holds a live transient target at the current point of the compilation.
+};
+
+struct RenderGraphFramebuffer
+{
+    u32 m_Framebuffer;
+    u32 m_ColorTextures[RENDER_PASS_MAX_COLOR_TARGETS];
+    u32 m_ColorTextureCount;
+    u32 m_DepthTexture;
+    u64 m_LastUsedFrame;
+};
+
+struct RenderGraphStats
+{
+    u32 m_PassCount;
+    u32 m_CulledPassCount;
+    u32 m_TransientTargetCount;
+    u32 m_TextureCount;          // Pooled textures used this frame, fewer than the transient targets when aliasing.
+    u64 m_TextureBytes;          // Size of the textures used this frame.
+    u64 m_UnaliasedTextureBytes; // Size they would have without aliasing.
+    u32 m_CreatedTextureCount;   // Textures and framebuffers created this frame, 0 once the pools are warm.
+    u32 m_CreatedFramebufferCount;
+};
+
+struct RenderGraph
+{
+    // Declarations of the current frame.
+    std::vector<RenderGraphResource> m_Resources;
+    std::vector<RenderGraphPass> m_Passes;
+    std::vector<u32> m_Order; // Passes that survived culling, in execution order.
+
+    // Persistent across frames.
+    std::vector<RenderGraphTexture> m_Textures;
+    std::vector<RenderGraphFramebuffer> m_Framebuffers;
+    u64 m_Frame = 0;
+
+    RenderGraphStats m_Stats = {};
+};
+
+// Starts declaring the passes of a new frame.
+void BeginRenderGraph(RenderGraph& graph);
+
+// Declares a transient target. Its contents are undefined until a pass writes it.
+u32 CreateRenderTarget(RenderGraph& graph, const char* const name, const RenderTargetDesc& desc);
+
+// Declares a framebuffer created outside the graph, e.g. the window's (0). It is never culled away or aliased.
+u32 ImportRenderTarget(
+    RenderGraph& graph,
+    const char* const name,
+    const u32 framebuffer,
+    const i32 width,
+    const i32 height
+);
+
+// Adds a pass with a raw callback. See AddRenderPass() for wrapping a lambda.
+u32 AddRenderPassFunction(RenderGraph& graph, const char* const name, const RenderPassFunction function);
+
+// The pass samples `resource`. Returns `resource` for chaining.
+u32 ReadRenderTarget(RenderGraph& graph, const u32 pass, const u32 resource);
+
+// The pass draws into `resource` as its next color target, keeping the contents. Returns the new version.
+u32 WriteRenderTarget(RenderGraph& graph, const u32 pass, const u32 resource);
+
+// The pass depth tests against `resource` and writes it. Returns the new version.
+u32 WriteDepthTarget(RenderGraph& graph, const u32 pass, const u32 resource);
+
+// Keeps the pass even if nothing reads what it writes, e.g. a pass reading back pixels.
+void SetRenderPassSideEffect(RenderGraph& graph, const u32 pass);
+
+// Culls, orders and allocates the frame. Returns false if the passes depend on each other in a cycle or a pass
+// can't get a framebuffer; nothing should be executed then.
+bool CompileRenderGraph(RenderGraph& graph);
+
+// Runs the passes in order, each with its framebuffer bound and the viewport set to its targets.
+void ExecuteRenderGraph(RenderGraph& graph);
+
+// Texture of a transient target, for passes sampling it. Only valid while executing.
+u32 GetRenderTargetTexture(const RenderGraph& graph, const u32 resource);
+
+// Deletes the pooled textures and framebuffers.
+void DestroyRenderGraph(RenderGraph& graph);
+
+// Adds a pass running `fn(graph)`. The callable is stored inside the pass, so it has to be small and trivially
+// destructible, e.g. a lambda capturing a few references.
+template<typename Fn>
+u32 AddRenderPass(RenderGraph& graph, const char* const name, Fn&& fn)
+{
+    using Callable = std::decay_t<Fn>;
+    static_assert(sizeof(Callable) <= RENDER_PASS_DATA_SIZE, "Render pass callable is too large.");
+    static_assert(alignof(Callable) <= 16, "Render pass callable is over-aligned.");
+    static_assert(std::is_trivially_destructible_v<Callable>, "Render pass callables are never destroyed.");
+
+    const u32 pass = AddRenderPassFunction(
+        graph,
+        name,
+        [](const RenderGraph& renderGraph, void* const data) { (*std::launder(rcast<Callable*>(data)))(renderGraph); }
+    );
+    new (graph.m_Passes[pass].m_Data) Callable(std::forward<Fn>(fn));
+
+    return pass;
+}
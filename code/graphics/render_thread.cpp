@@ -0,0 +1,143 @@
+#include "graphics/render_thread.h"
+
+#include <functional>
+
+#include "core/profiler.h"
+
+static void RenderThreadLoop(RenderThread& thread)
+{
+    SetProfilerThreadName("Render");
+
+    const bool contextCurrent = thread.m_SetContextCurrent(true);
+    {
+        const std::lock_guard<std::mutex> lock(thread.m_Mutex);
+        thread.m_Started = true;
+        thread.m_ContextCurrent = contextCurrent;
+    }
+    thread.m_RenderedCondition.notify_all();
+
+    if (!contextCurrent)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(thread.m_Mutex);
+    while (true)
+    {
+        thread.m_SubmittedCondition.wait(lock, [&thread]()
+        {
+            return thread.m_Stop || thread.m_RenderedCount < thread.m_SubmittedCount;
+        });
+
+        // Stopping, and every submitted frame has been rendered.
+        if (thread.m_RenderedCount == thread.m_SubmittedCount)
+        {
+            break;
+        }
+
+        // The game thread doesn't touch this snapshot until the count below moves on.
+        const void* const snapshot = thread.m_Snapshots[thread.m_RenderedCount % RENDER_SNAPSHOT_COUNT];
+        lock.unlock();
+        thread.m_RenderFrame(snapshot);
+        lock.lock();
+
+        thread.m_RenderedCount++;
+        thread.m_RenderedCondition.notify_all();
+    }
+    lock.unlock();
+
+    thread.m_SetContextCurrent(false);
+}
+
+bool StartRenderThread(
+    RenderThread& thread,
+    const RenderFrameFunction renderFrame,
+    const RenderContextFunction setContextCurrent,
+    void* const (&snapshots)[RENDER_SNAPSHOT_COUNT])
+{
+    thread.m_RenderFrame = renderFrame;
+    thread.m_SetContextCurrent = setContextCurrent;
+    for (u32 i = 0; i < RENDER_SNAPSHOT_COUNT; ++i)
+    {
+        thread.m_Snapshots[i] = snapshots[i];
+    }
+    thread.m_SubmittedCount = 0;
+    thread.m_RenderedCount = 0;
+    thread.m_Started = false;
+    thread.m_ContextCurrent = false;
+    thread.m_Stop = false;
+
+    if (!setContextCurrent(false))
+    {
+        return false;
+    }
+
+    thread.m_Thread = std::thread(RenderThreadLoop, std::ref(thread));
+
+    bool contextCurrent = false;
+    {
+        std::unique_lock<std::mutex> lock(thread.m_Mutex);
+        thread.m_RenderedCondition.wait(lock, [&thread]() { return thread.m_Started; });
+        contextCurrent = thread.m_ContextCurrent;
+    }
+
+    if (!contextCurrent)
+    {
+        LOG_ERROR("The render thread can't make the OpenGL context current.");
+        thread.m_Thread.join();
+        setContextCurrent(true);
+        return false;
+    }
+
+    LOG_INFO("Started the render thread.");
+    return true;
+}
+
+void StopRenderThread(RenderThread& thread)
+{
+    if (!thread.m_Thread.joinable())
+    {
+        return;
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(thread.m_Mutex);
+        thread.m_Stop = true;
+    }
+    thread.m_SubmittedCondition.notify_all();
+    thread.m_Thread.join();
+
+    thread.m_SetContextCurrent(true);
+    LOG_INFO(
+        "Stopped the render thread after %llu frames.",
+        scast<unsigned long long>(thread.m_RenderedCount)
+    );
+}
+
+void* AcquireRenderSnapshot(RenderThread& thread)
+{
+    std::unique_lock<std::mutex> lock(thread.m_Mutex);
+
+    // The snapshot was last read by the frame submitted RENDER_SNAPSHOT_COUNT frames ago.
+    thread.m_RenderedCondition.wait(lock, [&thread]()
+    {
+        return thread.m_SubmittedCount - thread.m_RenderedCount < RENDER_SNAPSHOT_COUNT;
+    });
+
+    return thread.m_Snapshots[thread.m_SubmittedCount % RENDER_SNAPSHOT_COUNT];
+}
+
+void SubmitRenderSnapshot(RenderThread& thread)
+{
+    {
+        const std::lock_guard<std::mutex> lock(thread.m_Mutex);
+        thread.m_SubmittedCount++;
+    }
+    thread.m_SubmittedCondition.notify_one();
+}
+
+void WaitForRenderThread(RenderThread& thread)
+{
+    std::unique_lock<std::mutex> lock(thread.m_Mutex);
+    thread.m_RenderedCondition.wait(lock, [&thread]() { return thread.m_RenderedCount == thread.m_SubmittedCount; });
+}
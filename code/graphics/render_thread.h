@@ -0,0 +1,59 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "common.h"
+
+// Thread submitting the frames to OpenGL, so the game thread can simulate the next frame while this one is drawn.
+// The game thread writes everything a frame draws into a snapshot and hands it over. The render thread owns the
+// OpenGL context while it runs and only reads the snapshot, never the game state. There are RENDER_SNAPSHOT_COUNT
+// snapshots, so the game thread fills one while the render thread reads the other.
+
+constexpr u32 RENDER_SNAPSHOT_COUNT = 2;
+
+using RenderFrameFunction = void (*)(const void* snapshot);
+
+// Makes the OpenGL context current on the calling thread, or releases it from the calling thread.
+using RenderContextFunction = bool (*)(const bool current);
+
+struct RenderThread
+{
+    std::thread m_Thread;
+    std::mutex m_Mutex;
+    std::condition_variable m_SubmittedCondition; // A snapshot was submitted, or the thread should stop.
+    std::condition_variable m_RenderedCondition;  // A snapshot was rendered.
+
+    RenderFrameFunction m_RenderFrame = nullptr;
+    RenderContextFunction m_SetContextCurrent = nullptr;
+    void* m_Snapshots[RENDER_SNAPSHOT_COUNT] = {};
+
+    u64 m_SubmittedCount = 0;
+    u64 m_RenderedCount = 0;
+    bool m_Started = false;        // The thread has tried to make the context current.
+    bool m_ContextCurrent = false; // It succeeded.
+    bool m_Stop = false;
+};
+
+// Releases the OpenGL context from the calling thread and starts the render thread, which makes it current there.
+// `renderFrame` is called on the render thread with one of `snapshots` for every submitted frame.
+bool StartRenderThread(
+    RenderThread& thread,
+    const RenderFrameFunction renderFrame,
+    const RenderContextFunction setContextCurrent,
+    void* const (&snapshots)[RENDER_SNAPSHOT_COUNT]
+);
+
+// Renders the submitted frames, stops the thread and makes the OpenGL context current on the calling thread again.
+// Does nothing if the thread isn't running.
+void StopRenderThread(RenderThread& thread);
+
+// Snapshot to fill for the next frame. Waits until the render thread is done reading it.
+void* AcquireRenderSnapshot(RenderThread& thread);
+
+// Hands the acquired snapshot to the render thread.
+void SubmitRenderSnapshot(RenderThread& thread);
+
+// Waits until every submitted frame has been rendered.
+void WaitForRenderThread(RenderThread& thread);
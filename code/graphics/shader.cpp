@@ -5,7 +5,9 @@
 
 #include <glad/glad.h>
 
-static std::string GetFileContents(const char* const fileName)
+#include "core/metrics.h"
+
+std::string GetFileContents(const char* const fileName)
 {
     std::ifstream in(fileName, std::ios::binary);
     if (!in)
@@ -111,6 +113,7 @@ u32 CreateShader(const char* const vertexFile, const char* const fragmentFile)
 void ActivateShader(const u32 id)
 {
     glUseProgram(id);
+    AddMetric(Metric::StateChanges, 1);
 }
 
 void DeleteShader(const u32 id)
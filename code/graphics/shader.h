@@ -1,7 +1,12 @@
 #pragma once
 
+#include <string>
+
 #include "common.h"
 
+// Reads a whole file, e.g. a shader source. Returns an empty string if the file can't be opened.
+std::string GetFileContents(const char* const fileName);
+
 u32 CreateShader(const char* const vertexFile, const char* const fragmentFile);
 void ActivateShader(const u32 id);
 void DeleteShader(const u32 id);
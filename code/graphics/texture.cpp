@@ -2,10 +2,31 @@
 
 #include <stb_image.h>
 
+#include "core/metrics.h"
 #include "graphics/shader.h"
 
-Texture CreateTexture(
-    const char *const fileName,
+bool LoadTextureImage(const char* const fileName, TextureImage& outImage)
+{
+    outImage = {};
+    outImage.m_Pixels = stbi_load(fileName, &outImage.m_Width, &outImage.m_Height, &outImage.m_Channels, 0);
+
+    if (!outImage.m_Pixels)
+    {
+        LOG_ERROR("Failed to load image %s: %s", fileName, stbi_failure_reason());
+        return false;
+    }
+
+    return true;
+}
+
+void FreeTextureImage(TextureImage& image)
+{
+    stbi_image_free(image.m_Pixels);
+    image = {};
+}
+
+Texture CreateTextureFromImage(
+    const TextureImage& image,
     const GLenum texType,
     const GLenum slot,
     const GLenum format,
@@ -17,11 +38,6 @@ Texture CreateTexture(
     result.m_Type = texType;
     result.m_Unit = slot;
 
-    i32 imgWidth, imgHeight, numOfColorChannels;
-    u8* const imgBytes = stbi_load(
-        fileName, &imgWidth, &imgHeight, &numOfColorChannels, 0
-    );
-
     glGenTextures(1, &result.m_TextureId);
     glActiveTexture(GL_TEXTURE0 + slot);
 
@@ -33,16 +49,33 @@ Texture CreateTexture(
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, imgWidth, imgHeight, 0, format, GL_UNSIGNED_BYTE, imgBytes);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.m_Width, image.m_Height, 0, format, GL_UNSIGNED_BYTE, image.m_Pixels);
     glGenerateMipmap(GL_TEXTURE_2D);
-
-    stbi_image_free(imgBytes);
+    AddMetric(Metric::UploadBytes, scast<u64>(image.m_Width) * image.m_Height * image.m_Channels);
 
     glBindTexture(GL_TEXTURE_2D, 0);
 
     return result;
 }
 
+Texture CreateTexture(
+    const char *const fileName,
+    const GLenum texType,
+    const GLenum slot,
+    const GLenum format,
+    const GLenum pixelType
+)
+{
+    TextureImage image = {};
+    LoadTextureImage(fileName, image);
+
+    const Texture result = CreateTextureFromImage(image, texType, slot, format, pixelType);
+
+    FreeTextureImage(image);
+
+    return result;
+}
+
 void SetTextureUnit(const u32 shaderId, const char *const uniform, const u32 unit)
 {
     const u32 texUniform = glGetUniformLocation(shaderId, uniform);
@@ -54,6 +87,7 @@ void BindTexture(const Texture texture)
 {
     glActiveTexture(GL_TEXTURE0 + texture.m_Unit);
     glBindTexture(GL_TEXTURE_2D, texture.m_TextureId);
+    AddMetric(Metric::StateChanges, 1);
 }
 
 void UnbindTexture(const Texture texture)
@@ -11,6 +11,31 @@ struct Texture
     u32 m_Unit;
 };
 
+// Pixels of a decoded image file.
+struct TextureImage
+{
+    u8* m_Pixels;
+    i32 m_Width;
+    i32 m_Height;
+    i32 m_Channels;
+};
+
+// Decodes an image file. Doesn't touch OpenGL, so it can run on any thread.
+bool LoadTextureImage(const char* const fileName, TextureImage& outImage);
+
+// Frees the pixels of a decoded image.
+void FreeTextureImage(TextureImage& image);
+
+// Uploads a decoded image to a new texture.
+Texture CreateTextureFromImage(
+    const TextureImage& image,
+    const GLenum texType,
+    const GLenum slot,
+    const GLenum format,
+    const GLenum pixelType
+);
+
+// Decodes and uploads an image file.
 Texture CreateTexture(
     const char* const fileName,
     const GLenum texType,
@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include "core/metrics.h"
+
 u32 CreateVAO()
 {
     u32 result = -1;
@@ -28,6 +30,7 @@ void LinkAttrib(
 void BindVAO(const u32 vaoID)
 {
     glBindVertexArray(vaoID);
+    AddMetric(Metric::StateChanges, 1);
 }
 
 void UnbindVAO()
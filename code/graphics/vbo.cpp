@@ -2,12 +2,15 @@
 
 #include <glad/glad.h>
 
+#include "core/metrics.h"
+
 u32 CreateVBO(const float* const vertices, const size_t size)
 {
     u32 result = -1;
     glGenBuffers(1, &result);
     glBindBuffer(GL_ARRAY_BUFFER, result);
     glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+    AddMetric(Metric::UploadBytes, size);
     return result;
 }
 
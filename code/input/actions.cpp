@@ -0,0 +1,104 @@
+#include "input/actions.h"
+
+void BindAction(ActionMap& map, const InputAction action, const InputBindingType type, const i32 code)
+{
+    map.m_Bindings.push_back({ action, type, code });
+}
+
+void BindDefaultActions(ActionMap& map)
+{
+    BindAction(map, InputAction::MoveForward, InputBindingType::Key, GLFW_KEY_W);
+    BindAction(map, InputAction::MoveBackward, InputBindingType::Key, GLFW_KEY_S);
+    BindAction(map, InputAction::MoveLeft, InputBindingType::Key, GLFW_KEY_A);
+    BindAction(map, InputAction::MoveRight, InputBindingType::Key, GLFW_KEY_D);
+    BindAction(map, InputAction::MoveUp, InputBindingType::Key, GLFW_KEY_Q);
+    BindAction(map, InputAction::MoveDown, InputBindingType::Key, GLFW_KEY_E);
+    BindAction(map, InputAction::Look, InputBindingType::MouseButton, GLFW_MOUSE_BUTTON_LEFT);
+    BindAction(map, InputAction::Pick, InputBindingType::MouseButton, GLFW_MOUSE_BUTTON_RIGHT);
+    BindAction(map, InputAction::Quit, InputBindingType::Key, GLFW_KEY_ESCAPE);
+    BindAction(map, InputAction::WireframeMode, InputBindingType::Key, GLFW_KEY_1);
+    BindAction(map, InputAction::FillMode, InputBindingType::Key, GLFW_KEY_2);
+    BindAction(map, InputAction::ForwardShading, InputBindingType::Key, GLFW_KEY_3);
+    BindAction(map, InputAction::DeferredShading, InputBindingType::Key, GLFW_KEY_4);
+    BindAction(map, InputAction::CyclePresentMode, InputBindingType::Key, GLFW_KEY_V);
+    BindAction(map, InputAction::ToggleFrameLimiter, InputBindingType::Key, GLFW_KEY_L);
+    BindAction(map, InputAction::ToggleOcclusionCulling, InputBindingType::Key, GLFW_KEY_O);
+    BindAction(map, InputAction::SaveProfile, InputBindingType::Key, GLFW_KEY_P);
+    BindAction(map, InputAction::SaveMetrics, InputBindingType::Key, GLFW_KEY_M);
+}
+
+static void ApplyActionBinding(ActionMap& map, const InputBindingType type, const i32 code, const i32 action)
+{
+    for (const InputBinding& binding : map.m_Bindings)
+    {
+        if (binding.m_Type != type || binding.m_Code != code)
+        {
+            continue;
+        }
+
+        const u32 index = scast<u32>(binding.m_Action);
+        if (action == GLFW_PRESS)
+        {
+            map.m_Down[index] = 1;
+            map.m_Pressed[index]++;
+        }
+        else if (action == GLFW_RELEASE)
+        {
+            map.m_Down[index] = 0;
+        }
+    }
+}
+
+void ProcessInputEvents(ActionMap& map, const InputQueue& queue)
+{
+    for (const InputEvent& event : queue.m_Events)
+    {
+        switch (event.m_Type)
+        {
+        case InputEventType::Key:
+        {
+            ApplyActionBinding(map, InputBindingType::Key, event.m_Code, event.m_Action);
+        } break;
+
+        case InputEventType::MouseButton:
+        {
+            ApplyActionBinding(map, InputBindingType::MouseButton, event.m_Code, event.m_Action);
+        } break;
+
+        case InputEventType::MouseMotion:
+        {
+            if (map.m_Down[scast<u32>(InputAction::Look)])
+            {
+                map.m_LookX += event.m_X;
+                map.m_LookY += event.m_Y;
+            }
+        } break;
+
+        case InputEventType::Scroll:
+        {
+        } break;
+        }
+    }
+}
+
+bool IsActionDown(const ActionMap& map, const InputAction action)
+{
+    return map.m_Down[scast<u32>(action)] != 0;
+}
+
+bool ConsumeActionPress(ActionMap& map, const InputAction action)
+{
+    u32& pressed = map.m_Pressed[scast<u32>(action)];
+    const bool result = pressed > 0;
+    pressed = 0;
+
+    return result;
+}
+
+void ConsumeLookDelta(ActionMap& map, float& outX, float& outY)
+{
+    outX = map.m_LookX;
+    outY = map.m_LookY;
+    map.m_LookX = 0.0f;
+    map.m_LookY = 0.0f;
+}
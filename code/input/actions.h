@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+
+#include "common.h"
+#include "input/input.h"
+
+// Maps raw input events to the actions the engine cares about, so gameplay code never looks at key codes.
+
+enum class InputAction : u32
+{
+    MoveForward,
+    MoveBackward,
+    MoveLeft,
+    MoveRight,
+    MoveUp,
+    MoveDown,
+    Look,               // While held, mouse motion turns the camera.
+    Pick,
+    Quit,
+    WireframeMode,
+    FillMode,
+    ForwardShading,
+    DeferredShading,
+    CyclePresentMode,
+    ToggleFrameLimiter,
+    ToggleOcclusionCulling,
+    SaveProfile,
+    SaveMetrics,
+    Count,
+};
+
+enum class InputBindingType : u32
+{
+    Key,
+    MouseButton,
+};
+
+struct InputBinding
+{
+    InputAction m_Action;
+    InputBindingType m_Type;
+    i32 m_Code;
+};
+
+struct ActionMap
+{
+    std::vector<InputBinding> m_Bindings;
+
+    u8 m_Down[scast<u32>(InputAction::Count)] = {};
+    u32 m_Pressed[scast<u32>(InputAction::Count)] = {};  // Presses since the action was last consumed.
+
+    // Mouse motion while Look is held, accumulated until consumed.
+    float m_LookX = 0.0f;
+    float m_LookY = 0.0f;
+};
+
+void BindAction(ActionMap& map, const InputAction action, const InputBindingType type, const i32 code);
+
+// Binds the default controls, see README.md.
+void BindDefaultActions(ActionMap& map);
+
+// Applies the queued events in order to the action states.
+void ProcessInputEvents(ActionMap& map, const InputQueue& queue);
+
+bool IsActionDown(const ActionMap& map, const InputAction action);
+
+// Returns true if the action was pressed since the last call, even if it was released again in between.
+bool ConsumeActionPress(ActionMap& map, const InputAction action);
+
+// Returns the accumulated look motion in pixels and resets it.
+void ConsumeLookDelta(ActionMap& map, float& outX, float& outY);
@@ -0,0 +1,107 @@
+#include "input/input.h"
+
+static InputQueue* g_AttachedInputQueue = nullptr;
+
+static void PushInputEvent(const InputEventType type, const i32 code, const i32 action, const float x, const float y)
+{
+    if (g_AttachedInputQueue == nullptr)
+    {
+        return;
+    }
+
+    g_AttachedInputQueue->m_Events.push_back({ type, glfwGetTime(), code, action, x, y });
+}
+
+static void InputKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    // Key repeat is a text input concept.
+    if (action != GLFW_REPEAT)
+    {
+        PushInputEvent(InputEventType::Key, key, action, 0.0f, 0.0f);
+    }
+}
+
+static void InputMouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+    PushInputEvent(InputEventType::MouseButton, button, action, 0.0f, 0.0f);
+}
+
+static void InputCursorPosCallback(GLFWwindow* window, double x, double y)
+{
+    if (g_AttachedInputQueue == nullptr)
+    {
+        return;
+    }
+
+    const float deltaX = scast<float>(x - g_AttachedInputQueue->m_CursorX);
+    const float deltaY = scast<float>(y - g_AttachedInputQueue->m_CursorY);
+    g_AttachedInputQueue->m_CursorX = x;
+    g_AttachedInputQueue->m_CursorY = y;
+
+    PushInputEvent(InputEventType::MouseMotion, 0, 0, deltaX, deltaY);
+}
+
+static void InputScrollCallback(GLFWwindow* window, double x, double y)
+{
+    PushInputEvent(InputEventType::Scroll, 0, 0, scast<float>(x), scast<float>(y));
+}
+
+void AttachInputQueue(InputQueue& queue, GLFWwindow* const window)
+{
+    queue.m_Window = window;
+    queue.m_RawMotion = glfwRawMouseMotionSupported() == GLFW_TRUE;
+    glfwGetCursorPos(window, &queue.m_CursorX, &queue.m_CursorY);
+
+    if (!queue.m_RawMotion)
+    {
+        LOG_INFO("Raw mouse motion is not supported, using the regular cursor motion.");
+    }
+
+    g_AttachedInputQueue = &queue;
+
+    glfwSetKeyCallback(window, InputKeyCallback);
+    glfwSetMouseButtonCallback(window, InputMouseButtonCallback);
+    glfwSetCursorPosCallback(window, InputCursorPosCallback);
+    glfwSetScrollCallback(window, InputScrollCallback);
+}
+
+void DetachInputQueue(InputQueue& queue)
+{
+    if (queue.m_Window)
+    {
+        glfwSetKeyCallback(queue.m_Window, nullptr);
+        glfwSetMouseButtonCallback(queue.m_Window, nullptr);
+        glfwSetCursorPosCallback(queue.m_Window, nullptr);
+        glfwSetScrollCallback(queue.m_Window, nullptr);
+    }
+
+    if (g_AttachedInputQueue == &queue)
+    {
+        g_AttachedInputQueue = nullptr;
+    }
+
+    queue.m_Window = nullptr;
+}
+
+void SetCursorCaptured(InputQueue& queue, const bool captured)
+{
+    if (queue.m_Window == nullptr || queue.m_CursorCaptured == captured)
+    {
+        return;
+    }
+
+    glfwSetInputMode(queue.m_Window, GLFW_CURSOR, captured ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
+    if (queue.m_RawMotion)
+    {
+        glfwSetInputMode(queue.m_Window, GLFW_RAW_MOUSE_MOTION, captured ? GLFW_TRUE : GLFW_FALSE);
+    }
+
+    // Switching modes moves the virtual cursor, which must not show up as motion.
+    glfwGetCursorPos(queue.m_Window, &queue.m_CursorX, &queue.m_CursorY);
+    queue.m_CursorCaptured = captured;
+}
+
+void ClearInputEvents(InputQueue& queue)
+{
+    queue.m_Events.clear();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+
+#include <GLFW/glfw3.h>
+
+#include "common.h"
+
+// Timestamped input events collected by the GLFW callbacks. Nothing is polled: every key change and every bit of
+// mouse motion between two frames ends up in the queue in the order it happened.
+
+enum class InputEventType : u32
+{
+    Key,
+    MouseButton,
+    MouseMotion, // m_X and m_Y hold the cursor movement since the previous motion event.
+    Scroll,      // m_X and m_Y hold the scroll offsets.
+};
+
+struct InputEvent
+{
+    InputEventType m_Type;
+    double m_Time;  // glfwGetTime() when the event arrived.
+    i32 m_Code;     // GLFW key or mouse button.
+    i32 m_Action;   // GLFW_PRESS or GLFW_RELEASE.
+    float m_X;
+    float m_Y;
+};
+
+struct InputQueue
+{
+    GLFWwindow* m_Window = nullptr;
+    std::vector<InputEvent> m_Events;
+    double m_CursorX = 0.0;
+    double m_CursorY = 0.0;
+    bool m_CursorCaptured = false;
+    bool m_RawMotion = false; // Raw (unaccelerated) motion is used while the cursor is captured.
+};
+
+// Installs the input callbacks on the window. Only one queue can be attached at a time.
+void AttachInputQueue(InputQueue& queue, GLFWwindow* const window);
+
+void DetachInputQueue(InputQueue& queue);
+
+// Hides and locks the cursor so mouse motion is unbounded, or gives it back.
+void SetCursorCaptured(InputQueue& queue, const bool captured);
+
+// Drops the events that have been processed.
+void ClearInputEvents(InputQueue& queue);
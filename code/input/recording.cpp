@@ -0,0 +1,188 @@
+#include "input/recording.h"
+
+#include <cstring>
+#include <iterator>
+
+bool StartInputRecording(InputRecorder& recorder, const char* const fileName, const double tickDuration)
+{
+    recorder.m_File.open(fileName, std::ios::binary);
+    if (!recorder.m_File)
+    {
+        LOG_ERROR("Failed to open file for writing: %s.", fileName);
+        return false;
+    }
+
+    const InputRecordingHeader header =
+    {
+        .m_Magic = INPUT_RECORDING_MAGIC,
+        .m_Version = INPUT_RECORDING_VERSION,
+        .m_TickDuration = tickDuration,
+    };
+    recorder.m_File.write(rcast<const char*>(&header), sizeof(header));
+
+    recorder.m_StartTime = glfwGetTime();
+    recorder.m_FrameCount = 0;
+
+    LOG_INFO("Recording the input to \"%s\".", fileName);
+    return true;
+}
+
+void RecordInputFrame(InputRecorder& recorder, const u32 frame, const double frameTime, const InputQueue& queue)
+{
+    if (!recorder.m_File.is_open())
+    {
+        return;
+    }
+
+    const double now = glfwGetTime();
+    const InputFrameRecord record =
+    {
+        .m_Frame = frame,
+        .m_EventCount = scast<u32>(queue.m_Events.size()),
+        .m_FrameTime = frameTime,
+        .m_Time = now - recorder.m_StartTime,
+    };
+
+    recorder.m_Events.clear();
+    for (const InputEvent& event : queue.m_Events)
+    {
+        recorder.m_Events.push_back({
+            .m_Time = scast<float>(event.m_Time - now),
+            .m_X = event.m_X,
+            .m_Y = event.m_Y,
+            .m_Code = scast<i16>(event.m_Code),
+            .m_Type = scast<u8>(event.m_Type),
+            .m_Action = scast<u8>(event.m_Action),
+        });
+    }
+
+    recorder.m_File.write(rcast<const char*>(&record), sizeof(record));
+    recorder.m_File.write(
+        rcast<const char*>(recorder.m_Events.data()),
+        recorder.m_Events.size() * sizeof(InputEventRecord)
+    );
+
+    if (!recorder.m_File)
+    {
+        LOG_ERROR("Failed to write the input recording, recording stopped.");
+        recorder.m_File.close();
+        return;
+    }
+
+    recorder.m_FrameCount++;
+}
+
+void StopInputRecording(InputRecorder& recorder)
+{
+    if (!recorder.m_File.is_open())
+    {
+        return;
+    }
+
+    recorder.m_File.close();
+    LOG_INFO("Recorded the input of %u frames.", recorder.m_FrameCount);
+}
+
+bool LoadInputReplay(InputReplay& replay, const char* const fileName, const double tickDuration)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in)
+    {
+        LOG_ERROR("Failed to open file: %s.", fileName);
+        return false;
+    }
+
+    replay.m_Data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    InputRecordingHeader header = {};
+    if (replay.m_Data.size() < sizeof(header))
+    {
+        LOG_ERROR("Not a supported input recording: %s.", fileName);
+        return false;
+    }
+
+    std::memcpy(&header, replay.m_Data.data(), sizeof(header));
+    if (header.m_Magic != INPUT_RECORDING_MAGIC || header.m_Version != INPUT_RECORDING_VERSION)
+    {
+        LOG_ERROR("Not a supported input recording: %s.", fileName);
+        return false;
+    }
+
+    if (header.m_TickDuration != tickDuration)
+    {
+        LOG_ERROR(
+            "The input recording %s was made at %.2f ticks per second, it can't be replayed at %.2f.",
+            fileName,
+            1.0 / header.m_TickDuration,
+            1.0 / tickDuration
+        );
+        return false;
+    }
+
+    // Count the complete frames. A recording cut short by a crash ends in a partial frame, which is left out.
+    replay.m_FrameCount = 0;
+    size_t offset = sizeof(header);
+    while (offset + sizeof(InputFrameRecord) <= replay.m_Data.size())
+    {
+        InputFrameRecord record = {};
+        std::memcpy(&record, replay.m_Data.data() + offset, sizeof(record));
+
+        const size_t size = sizeof(record) + scast<size_t>(record.m_EventCount) * sizeof(InputEventRecord);
+        if (record.m_Frame != replay.m_FrameCount || size > replay.m_Data.size() - offset)
+        {
+            break;
+        }
+
+        offset += size;
+        replay.m_FrameCount++;
+    }
+
+    if (offset != replay.m_Data.size())
+    {
+        LOG_INFO("The input recording %s ends in a partial frame, it is ignored.", fileName);
+    }
+
+    replay.m_Offset = sizeof(header);
+    replay.m_StartTime = glfwGetTime();
+
+    LOG_INFO("Replaying %u frames of input from \"%s\".", replay.m_FrameCount, fileName);
+    return true;
+}
+
+bool ReplayInputFrame(InputReplay& replay, const u32 frame, InputQueue& queue, double& outFrameTime)
+{
+    if (frame >= replay.m_FrameCount)
+    {
+        return false;
+    }
+
+    InputFrameRecord record = {};
+    std::memcpy(&record, replay.m_Data.data() + replay.m_Offset, sizeof(record));
+    if (record.m_Frame != frame)
+    {
+        LOG_ERROR("The replay is at frame %u, frame %u was requested.", record.m_Frame, frame);
+        return false;
+    }
+
+    const u8* const events = replay.m_Data.data() + replay.m_Offset + sizeof(record);
+    const double pollTime = replay.m_StartTime + record.m_Time;
+
+    queue.m_Events.clear();
+    for (u32 i = 0; i < record.m_EventCount; ++i)
+    {
+        InputEventRecord event = {};
+        std::memcpy(&event, events + scast<size_t>(i) * sizeof(InputEventRecord), sizeof(event));
+        queue.m_Events.push_back({
+            scast<InputEventType>(event.m_Type),
+            pollTime + event.m_Time,
+            event.m_Code,
+            event.m_Action,
+            event.m_X,
+            event.m_Y,
+        });
+    }
+
+    replay.m_Offset += sizeof(record) + scast<size_t>(record.m_EventCount) * sizeof(InputEventRecord);
+    outFrameTime = record.m_FrameTime;
+    return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <fstream>
+#include <vector>
+
+#include "common.h"
+#include "input/input.h"
+
+// Input recording and replay. The recorder saves the events of every frame after they are polled, together with
+// the time the simulation advanced by in that frame. The replay puts them back into the InputQueue in place of the
+// live events, so the actions, the camera and the fixed timestep see exactly the same input and run exactly the same
+// ticks as the recorded session.
+//
+// File format (.o3dinput, little endian):
+//   InputRecordingHeader
+//   for every frame:
+//     InputFrameRecord
+//     InputEventRecord events[eventCount]
+
+constexpr u32 INPUT_RECORDING_MAGIC = 0x4944334f; // "O3DI"
+constexpr u32 INPUT_RECORDING_VERSION = 1;
+
+struct InputRecordingHeader
+{
+    u32 m_Magic;
+    u32 m_Version;
+    double m_TickDuration; // Replays need the same simulation rate to be deterministic.
+};
+
+struct InputFrameRecord
+{
+    u32 m_Frame;
+    u32 m_EventCount;
+    double m_FrameTime; // Seconds the fixed timestep advanced by.
+    double m_Time;      // Seconds from the start of the recording to when the events were polled.
+};
+
+struct InputEventRecord
+{
+    float m_Time; // Seconds relative to the m_Time of the frame, so usually negative.
+    float m_X;
+    float m_Y;
+    i16 m_Code;
+    u8 m_Type;
+    u8 m_Action;
+};
+
+static_assert(sizeof(InputEventRecord) == 16, "Input event records are expected to be packed.");
+
+struct InputRecorder
+{
+    std::ofstream m_File;
+    double m_StartTime = 0.0;
+    u32 m_FrameCount = 0;
+    std::vector<InputEventRecord> m_Events; // Scratch space of the frame being written.
+};
+
+struct InputReplay
+{
+    std::vector<u8> m_Data;
+    size_t m_Offset = 0;    // Next frame record in m_Data.
+    u32 m_FrameCount = 0;   // Complete frames in the file.
+    double m_StartTime = 0.0;
+};
+
+bool StartInputRecording(InputRecorder& recorder, const char* const fileName, const double tickDuration);
+
+// Call once per frame, after the events are polled and before they are processed.
+void RecordInputFrame(InputRecorder& recorder, const u32 frame, const double frameTime, const InputQueue& queue);
+
+void StopInputRecording(InputRecorder& recorder);
+
+// Reads the whole recording. Fails if it was made with another simulation rate.
+bool LoadInputReplay(InputReplay& replay, const char* const fileName, const double tickDuration);
+
+// Replaces the events in the queue with the ones recorded for `frame` and returns the recorded frame time. Returns
+// false, leaving the queue alone, when the recording has no such frame.
+bool ReplayInputFrame(InputReplay& replay, const u32 frame, InputQueue& queue, double& outFrameTime);
@@ -0,0 +1,470 @@
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "binary_log.h"
+#include "common.h"
+
+constexpr u64 LOG_RING_SIZE = 64 * 1024;   // Bytes per thread.
+constexpr u64 LOG_RECORD_ALIGNMENT = 16;
+constexpr u16 LOG_RECORD_PADDING = 0xffff; // Level of the filler record at the end of the ring.
+constexpr u16 LOG_RECORD_BINARY = 0x8000;  // Level flag of binary log messages.
+constexpr auto LOG_FLUSH_INTERVAL = std::chrono::milliseconds(5);
+constexpr const char* BINARY_LOG_FILE_NAME = "log.o3dlog";
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "The log ring size must be a power of two.");
+
+// Records are a header followed by the message, padded to LOG_RECORD_ALIGNMENT. A record never wraps around the
+// end of the ring, the space left at the end is skipped with a padding record instead. Binary log messages start
+// with their BinaryLogPrefix, followed by the encoded arguments.
+struct LogRecordHeader
+{
+    u64 m_Time; // Nanoseconds on the steady clock.
+    u32 m_Size; // Of the whole record.
+    u16 m_Level;
+    u16 m_Length;
+};
+
+static_assert(sizeof(LogRecordHeader) == LOG_RECORD_ALIGNMENT, "The record header must fill one alignment unit.");
+
+struct BinaryLogPrefix
+{
+    u64 m_FormatId;
+    const char* m_Format;
+};
+
+// Single producer, single consumer ring. The owning thread writes, the flusher reads.
+struct LogRing
+{
+    alignas(64) std::atomic<u64> m_WriteIndex = 0;
+    alignas(64) std::atomic<u64> m_ReadIndex = 0;
+    std::atomic<u32> m_Dropped = 0;
+    alignas(LOG_RECORD_ALIGNMENT) u8 m_Data[LOG_RING_SIZE];
+};
+
+struct LogEntry
+{
+    u64 m_Time;
+    Internal::LogLevel m_Level;
+    bool m_Binary;
+    BinaryLogPrefix m_Prefix;
+    std::string m_Text; // The encoded arguments for binary messages.
+};
+
+struct AsyncLogger
+{
+    std::atomic<bool> m_Running = false;
+    std::atomic<u32> m_ActiveWriters = 0; // Threads between checking m_Running and publishing a record.
+
+    std::mutex m_RingsMutex;
+    std::vector<std::unique_ptr<LogRing>> m_Rings;
+
+    std::thread m_Flusher;
+    std::mutex m_WakeMutex;
+    std::condition_variable m_WakeCondition;
+    bool m_StopRequested = false;
+
+    // Maps the steady clock to the wall clock, both sampled at start.
+    u64 m_SteadyStart = 0;
+    std::chrono::system_clock::time_point m_WallStart;
+
+    u64 m_ReportedDrops = 0;
+
+    std::ofstream m_BinaryFile;
+    std::unordered_set<u64> m_WrittenFormats;
+};
+
+static AsyncLogger g_Logger;
+static thread_local LogRing* t_LogRing = nullptr;
+
+static u64 GetSteadyTime()
+{
+    return scast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count());
+}
+
+// SECTION: Output
+static void WriteLogLine(
+    const Internal::LogLevel level,
+    const std::chrono::system_clock::time_point time,
+    const char* const text
+)
+{
+    const std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    const u32 milliseconds = scast<u32>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count() % 1000
+    );
+
+    std::tm localTime = {};
+#if defined(_WIN32)
+    localtime_s(&localTime, &seconds);
+#else
+    localtime_r(&seconds, &localTime);
+#endif
+
+    char timestamp[32] = {};
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &localTime);
+
+    std::FILE* outStream = nullptr;
+    const char* logLevelStr = nullptr;
+    const char* color = nullptr;
+
+    switch (level)
+    {
+    case Internal::LogLevel::ERROR:
+    {
+        outStream = stderr;
+        logLevelStr = "ERROR";
+        color = Internal::LOG_COLOR_RED;
+    } break;
+
+    case Internal::LogLevel::INFO:
+    {
+        outStream = stdout;
+        logLevelStr = "INFO";
+        color = Internal::LOG_COLOR_GREEN;
+    } break;
+
+    default:
+    {
+        outStream = stdout;
+        logLevelStr = "UNKNOWN";
+        color = Internal::LOG_COLOR_GREEN;
+    } break;
+    }
+
+    std::fprintf(
+        outStream,
+        "%s[%s] %s.%03u: %s%s\n",
+        color,
+        logLevelStr,
+        timestamp,
+        milliseconds,
+        text,
+        Internal::LOG_COLOR_RESET);
+}
+
+// SECTION: Rings
+static LogRing* GetLogRing()
+{
+    if (t_LogRing == nullptr)
+    {
+        std::unique_ptr<LogRing> ring = std::make_unique<LogRing>();
+
+        const std::lock_guard<std::mutex> lock(g_Logger.m_RingsMutex);
+        t_LogRing = ring.get();
+        g_Logger.m_Rings.push_back(std::move(ring));
+    }
+
+    return t_LogRing;
+}
+
+// `prefix` is written before `message`, both count towards the length of the record.
+static bool PushLogRecord(
+    LogRing& ring,
+    const u16 level,
+    const void* const prefix,
+    const size_t prefixLength,
+    const void* const message,
+    const size_t messageLength
+)
+{
+    const size_t length = prefixLength + messageLength;
+    const u64 size = (sizeof(LogRecordHeader) + length + LOG_RECORD_ALIGNMENT - 1) & ~(LOG_RECORD_ALIGNMENT - 1);
+    u64 write = ring.m_WriteIndex.load(std::memory_order_relaxed);
+    const u64 read = ring.m_ReadIndex.load(std::memory_order_acquire);
+
+    // Skip the end of the ring if the record doesn't fit there.
+    const u64 contiguous = LOG_RING_SIZE - (write & (LOG_RING_SIZE - 1));
+    const u64 padding = contiguous < size ? contiguous : 0;
+    if (LOG_RING_SIZE - (write - read) < size + padding)
+    {
+        return false;
+    }
+
+    if (padding > 0)
+    {
+        const LogRecordHeader filler = { 0, scast<u32>(padding), LOG_RECORD_PADDING, 0 };
+        std::memcpy(ring.m_Data + (write & (LOG_RING_SIZE - 1)), &filler, sizeof(filler));
+        write += padding;
+    }
+
+    u8* const record = ring.m_Data + (write & (LOG_RING_SIZE - 1));
+    const LogRecordHeader header = { GetSteadyTime(), scast<u32>(size), level, scast<u16>(length) };
+    std::memcpy(record, &header, sizeof(header));
+    if (prefixLength > 0)
+    {
+        std::memcpy(record + sizeof(header), prefix, prefixLength);
+    }
+    std::memcpy(record + sizeof(header) + prefixLength, message, messageLength);
+
+    ring.m_WriteIndex.store(write + size, std::memory_order_release);
+    return true;
+}
+
+static void DrainLogRing(LogRing& ring, std::vector<LogEntry>& entries)
+{
+    const u64 write = ring.m_WriteIndex.load(std::memory_order_acquire);
+    u64 read = ring.m_ReadIndex.load(std::memory_order_relaxed);
+
+    while (read != write)
+    {
+        const u8* const record = ring.m_Data + (read & (LOG_RING_SIZE - 1));
+        LogRecordHeader header = {};
+        std::memcpy(&header, record, sizeof(header));
+
+        if (header.m_Level != LOG_RECORD_PADDING)
+        {
+            LogEntry entry = { header.m_Time, scast<Internal::LogLevel>(header.m_Level & ~LOG_RECORD_BINARY), false };
+            const u8* text = record + sizeof(header);
+            u32 textLength = header.m_Length;
+            if (header.m_Level & LOG_RECORD_BINARY)
+            {
+                entry.m_Binary = true;
+                std::memcpy(&entry.m_Prefix, text, sizeof(BinaryLogPrefix));
+                text += sizeof(BinaryLogPrefix);
+                textLength -= sizeof(BinaryLogPrefix);
+            }
+            entry.m_Text.assign(rcast<const char*>(text), textLength);
+            entries.push_back(std::move(entry));
+        }
+
+        read += header.m_Size;
+    }
+
+    ring.m_ReadIndex.store(read, std::memory_order_release);
+}
+
+// SECTION: Binary log
+template<typename T>
+static void WriteBinaryLogValue(const T value)
+{
+    g_Logger.m_BinaryFile.write(rcast<const char*>(&value), sizeof(value));
+}
+
+#if O3D_BINARY_LOG
+static void OpenBinaryLog(const char* const fileName)
+{
+    g_Logger.m_BinaryFile.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!g_Logger.m_BinaryFile)
+    {
+        WriteLogLine(Internal::LogLevel::ERROR, std::chrono::system_clock::now(), "Failed to open the binary log.");
+        return;
+    }
+
+    g_Logger.m_WrittenFormats.clear();
+
+    const BinaryLogHeader header =
+    {
+        .m_Magic = BINARY_LOG_MAGIC,
+        .m_Version = BINARY_LOG_VERSION,
+        .m_SteadyStart = g_Logger.m_SteadyStart,
+        .m_WallStart = scast<i64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            g_Logger.m_WallStart.time_since_epoch()
+        ).count()),
+    };
+    WriteBinaryLogValue(header);
+}
+#endif // O3D_BINARY_LOG
+
+static void WriteBinaryLogEntry(const LogEntry& entry)
+{
+    // The format string goes into the log the first time it is used, the messages only refer to its ID.
+    if (g_Logger.m_WrittenFormats.insert(entry.m_Prefix.m_FormatId).second)
+    {
+        const u32 length = scast<u32>(std::strlen(entry.m_Prefix.m_Format));
+        WriteBinaryLogValue(BinaryLogRecordType::Format);
+        WriteBinaryLogValue(entry.m_Prefix.m_FormatId);
+        WriteBinaryLogValue(length);
+        g_Logger.m_BinaryFile.write(entry.m_Prefix.m_Format, length);
+    }
+
+    WriteBinaryLogValue(BinaryLogRecordType::Message);
+    WriteBinaryLogValue(entry.m_Prefix.m_FormatId);
+    WriteBinaryLogValue(entry.m_Time);
+    WriteBinaryLogValue(scast<u8>(entry.m_Level));
+    WriteBinaryLogValue(scast<u16>(entry.m_Text.size()));
+    g_Logger.m_BinaryFile.write(entry.m_Text.data(), entry.m_Text.size());
+}
+
+// Writes everything queued so far, in time order across the threads.
+static void FlushLogRings()
+{
+    std::vector<LogEntry> entries;
+    u64 drops = 0;
+    {
+        const std::lock_guard<std::mutex> lock(g_Logger.m_RingsMutex);
+        for (const std::unique_ptr<LogRing>& ring : g_Logger.m_Rings)
+        {
+            DrainLogRing(*ring, entries);
+            drops += ring->m_Dropped.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const LogEntry& a, const LogEntry& b)
+    {
+        return a.m_Time < b.m_Time;
+    });
+
+    for (const LogEntry& entry : entries)
+    {
+        if (entry.m_Binary)
+        {
+            if (g_Logger.m_BinaryFile.is_open())
+            {
+                WriteBinaryLogEntry(entry);
+            }
+            continue;
+        }
+
+        const auto sinceStart = std::chrono::nanoseconds(entry.m_Time - g_Logger.m_SteadyStart);
+        WriteLogLine(
+            entry.m_Level,
+            g_Logger.m_WallStart + std::chrono::duration_cast<std::chrono::system_clock::duration>(sinceStart),
+            entry.m_Text.c_str()
+        );
+    }
+
+    if (drops != g_Logger.m_ReportedDrops)
+    {
+        char text[96];
+        std::snprintf(
+            text,
+            sizeof(text),
+            "Dropped %llu log messages, the log rings were full.",
+            scast<unsigned long long>(drops - g_Logger.m_ReportedDrops)
+        );
+        WriteLogLine(Internal::LogLevel::ERROR, std::chrono::system_clock::now(), text);
+
+        if (g_Logger.m_BinaryFile.is_open())
+        {
+            WriteBinaryLogValue(BinaryLogRecordType::Dropped);
+            WriteBinaryLogValue(drops - g_Logger.m_ReportedDrops);
+        }
+
+        g_Logger.m_ReportedDrops = drops;
+    }
+
+    std::fflush(stdout);
+    if (g_Logger.m_BinaryFile.is_open())
+    {
+        g_Logger.m_BinaryFile.flush();
+    }
+}
+
+static void LogFlusherLoop()
+{
+    std::unique_lock<std::mutex> lock(g_Logger.m_WakeMutex);
+    while (!g_Logger.m_StopRequested)
+    {
+        g_Logger.m_WakeCondition.wait_for(lock, LOG_FLUSH_INTERVAL);
+
+        lock.unlock();
+        FlushLogRings();
+        lock.lock();
+    }
+}
+
+// SECTION: Interface
+void StartAsyncLogging()
+{
+    if (g_Logger.m_Running.load())
+    {
+        return;
+    }
+
+    g_Logger.m_SteadyStart = GetSteadyTime();
+    g_Logger.m_WallStart = std::chrono::system_clock::now();
+    g_Logger.m_StopRequested = false;
+#if O3D_BINARY_LOG
+    OpenBinaryLog(BINARY_LOG_FILE_NAME);
+#endif // O3D_BINARY_LOG
+    g_Logger.m_Flusher = std::thread(LogFlusherLoop);
+    g_Logger.m_Running.store(true);
+}
+
+void StopAsyncLogging()
+{
+    if (!g_Logger.m_Running.load())
+    {
+        return;
+    }
+
+    // Wait out the threads that are still publishing, then nothing new enters the rings.
+    g_Logger.m_Running.store(false);
+    while (g_Logger.m_ActiveWriters.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(g_Logger.m_WakeMutex);
+        g_Logger.m_StopRequested = true;
+    }
+    g_Logger.m_WakeCondition.notify_one();
+    g_Logger.m_Flusher.join();
+
+    FlushLogRings();
+
+    if (g_Logger.m_BinaryFile.is_open())
+    {
+        g_Logger.m_BinaryFile.close();
+    }
+}
+
+void Internal::WriteLogMessage(const Internal::LogLevel level, const char* const message, const size_t length)
+{
+    g_Logger.m_ActiveWriters.fetch_add(1);
+    if (!g_Logger.m_Running.load())
+    {
+        g_Logger.m_ActiveWriters.fetch_sub(1);
+        WriteLogLine(level, std::chrono::system_clock::now(), message);
+        return;
+    }
+
+    LogRing* const ring = GetLogRing();
+    if (!PushLogRecord(*ring, scast<u16>(level), nullptr, 0, message, length))
+    {
+        ring->m_Dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    g_Logger.m_ActiveWriters.fetch_sub(1);
+}
+
+bool Internal::WriteBinaryLogMessage(
+    const Internal::LogLevel level,
+    const std::uint64_t formatId,
+    const char* const format,
+    const std::uint8_t* const args,
+    const size_t size)
+{
+    g_Logger.m_ActiveWriters.fetch_add(1);
+    if (!g_Logger.m_Running.load())
+    {
+        g_Logger.m_ActiveWriters.fetch_sub(1);
+        return false;
+    }
+
+    const BinaryLogPrefix prefix = { formatId, format };
+    LogRing* const ring = GetLogRing();
+    if (!PushLogRecord(*ring, scast<u16>(level) | LOG_RECORD_BINARY, &prefix, sizeof(prefix), args, size))
+    {
+        ring->m_Dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    g_Logger.m_ActiveWriters.fetch_sub(1);
+    return true;
+}
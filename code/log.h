@@ -1,6 +1,20 @@
 #pragma once
 #include <cstdio>
-#include <ctime>
+#include <cstddef>
+#include <cstdint>
+
+// NOTE(sbalse): Messages are formatted on the calling thread and handed to the asynchronous backend (see
+// StartAsyncLogging()), which writes them from a background thread. While the backend isn't running they are
+// written synchronously.
+// With O3D_BINARY_LOG defined, messages aren't formatted at all: the ID of the format string and the raw arguments
+// are written to a binary log (see binary_log.h), which tools/log_decoder.cpp turns into text.
+
+// Starts the background thread that writes the log. Every thread that logs gets its own lock-free ring, messages
+// that don't fit are dropped and counted instead of blocking the caller.
+void StartAsyncLogging();
+
+// Writes the pending messages and stops the background thread. Later messages are written synchronously.
+void StopAsyncLogging();
 
 // NOTE(sbalse): Not meant to be used outside of this file.
 namespace Internal
@@ -15,68 +29,64 @@ namespace Internal
     constexpr const char* LOG_COLOR_GREEN = "\033[32m";
     constexpr const char* LOG_COLOR_RED = "\033[31m";
 
-    void GetTimestamp(char* const buffer, const size_t size)
-    {
-        const std::time_t now = std::time(nullptr);
-        std::tm localTime = {};
-        localtime_s(&localTime, &now);
-        std::strftime(buffer, size, "%Y-%m-%d %H:%M:%S", &localTime);
-    }
+    constexpr size_t LOG_MESSAGE_SIZE = 1024;
+
+    // Queues a formatted message, see log.cpp.
+    void WriteLogMessage(const LogLevel level, const char* const message, const size_t length);
+
+    // Queues a message for the binary log. Returns false if the asynchronous backend isn't running.
+    bool WriteBinaryLogMessage(
+        const LogLevel level,
+        const std::uint64_t formatId,
+        const char* const format,
+        const std::uint8_t* const args,
+        const size_t size);
 
     template<typename... Args>
     void LogMessage(
         const LogLevel level,
-        const char* color,
         const char* format,
         const Args... args)
     {
-        constexpr size_t timestampSize = 32;
-        char timestamp[timestampSize] = {};
-        GetTimestamp(timestamp, timestampSize);
-
-        constexpr size_t messageSize = 1024;
-        char message[messageSize] = {};
+        char message[LOG_MESSAGE_SIZE] = {};
+        int length = 0;
         if constexpr (sizeof...(args) > 0)
         {
-            std::snprintf(message, messageSize, format, args...);
+            length = std::snprintf(message, LOG_MESSAGE_SIZE, format, args...);
         }
         else
         {
-            std::snprintf(message, messageSize, "%s", format);
+            length = std::snprintf(message, LOG_MESSAGE_SIZE, "%s", format);
         }
 
-        std::FILE* outStream = nullptr;
-        const char* logLevelStr = nullptr;
-
-        switch (level)
-        {
-        case LogLevel::ERROR:
+        if (length < 0)
         {
-            outStream = stderr;
-            logLevelStr = "ERROR";
-        } break;
+            return;
+        }
 
-        case LogLevel::INFO:
-        {
-            outStream = stdout;
-            logLevelStr = "INFO";
-        } break;
+        WriteLogMessage(level, message, length < int(LOG_MESSAGE_SIZE) ? size_t(length) : LOG_MESSAGE_SIZE - 1);
+    }
+} // namespace Internal
+
+#if O3D_BINARY_LOG
+#include "binary_log.h"
+
+namespace Internal
+{
+    template<typename... Args>
+    void LogBinaryMessage(
+        const LogLevel level,
+        const LogFormatString format,
+        const Args... args)
+    {
+        std::uint8_t buffer[LOG_MESSAGE_SIZE];
+        size_t size = 0;
+        ((size = EncodeBinaryLogArg(buffer, LOG_MESSAGE_SIZE, size, args)), ...);
 
-        default:
+        if (!WriteBinaryLogMessage(level, format.m_Id, format.m_Format, buffer, size))
         {
-            outStream = stdout;
-            logLevelStr = "UNKNOWN";
-        } break;
+            LogMessage(level, format.m_Format, args...);
         }
-
-        std::fprintf(
-            outStream,
-            "%s[%s] %s: %s%s\n",
-            color,
-            logLevelStr,
-            timestamp,
-            message,
-            LOG_COLOR_RESET);
     }
 } // namespace Internal
 
@@ -84,11 +94,25 @@ namespace Internal
 #define LOG_INFO(...) \
 do \
 { \
-    LogMessage(Internal::LogLevel::INFO, Internal::LOG_COLOR_GREEN, __VA_ARGS__); \
+    LogBinaryMessage(Internal::LogLevel::INFO, __VA_ARGS__); \
+} while (0);
+
+#define LOG_ERROR(...) \
+do \
+{ \
+    LogBinaryMessage(Internal::LogLevel::ERROR, __VA_ARGS__); \
+} while (0);
+#else
+  // NOTE(sbalse): Macros for logging.
+#define LOG_INFO(...) \
+do \
+{ \
+    LogMessage(Internal::LogLevel::INFO, __VA_ARGS__); \
 } while (0);
 
 #define LOG_ERROR(...) \
 do \
 { \
-    LogMessage(Internal::LogLevel::ERROR, Internal::LOG_COLOR_RED, __VA_ARGS__); \
+    LogMessage(Internal::LogLevel::ERROR, __VA_ARGS__); \
 } while (0);
+#endif // O3D_BINARY_LOG
@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <cmath>
+#include <vector>
 
 #include <glad/glad.h> // glad.h must be included *before* any OpenGL stuff.
 #include <GLFW/glfw3.h>
@@ -11,23 +15,103 @@
 
 #include "common.h"
 #include "camera.h"
+#include "input/actions.h"
+#include "input/input.h"
+#include "input/recording.h"
 #include "graphics/vao.h"
 #include "graphics/vbo.h"
 #include "graphics/ebo.h"
+#include "graphics/framebuffer.h"
+#include "graphics/gbuffer.h"
+#include "graphics/clustered_lighting.h"
+#include "graphics/command_list.h"
+#include "graphics/headless.h"
+#include "graphics/image_compare.h"
+#include "graphics/render_graph.h"
+#include "graphics/render_thread.h"
 #include "graphics/shader.h"
 #include "graphics/texture.h"
+#include "core/budgets.h"
+#include "core/flythrough.h"
+#include "core/frame_arena.h"
+#include "core/frame_pacer.h"
+#include "core/jobs.h"
+#include "core/metrics.h"
+#include "core/profiler.h"
+#include "core/timestep.h"
+#include "ecs/ecs.h"
+#include "geometry/mesh.h"
+#include "scene/bounds.h"
+#include "scene/bvh.h"
+#include "scene/camera_path.h"
+#include "scene/components.h"
+#include "scene/culling.h"
+#include "scene/frustum.h"
+#include "scene/occlusion.h"
+#include "scene/transform.h"
 
 // Timestamp: https://youtu.be/45MIykWJ-C4
 
+#if _DEBUG
+constexpr const char* WINDOW_TITLE = "O3D [DEBUG]";
+#else
+constexpr const char* WINDOW_TITLE = "O3D [RELEASE]";
+#endif // _DEBUG
+
 enum class RenderMethod
 {
     Fill,
     Wireframe,
 };
 
+enum class ShadingPath
+{
+    Forward,  // The meshes shade their own fragments, see default.frag.
+    Deferred, // The meshes fill the G-buffer, then every pixel is shaded once, see graphics/gbuffer.h.
+};
+
 static int g_WindowWidth = 1024;
 static int g_WindowHeight = 720;
 static GLFWwindow* g_Window = nullptr;
+static bool g_GLLoaded = false; // A context exists and the OpenGL functions are loaded, so GL objects can be freed.
+
+// Headless mode renders a fixed number of frames into g_HeadlessTarget without a window, then saves the last one.
+constexpr u32 HEADLESS_DEFAULT_FRAME_COUNT = 120;
+constexpr const char* HEADLESS_DEFAULT_OUTPUT = "headless.ppm";
+
+// Flythrough mode moves the camera along a scripted path instead of the input, one simulation tick per frame, and
+// saves the timings and counters of every frame. By default it runs until the end of the path.
+constexpr const char* FLYTHROUGH_ORBIT_PATH = "orbit"; // Name of the built-in path.
+constexpr float FLYTHROUGH_ORBIT_RADIUS = 3.0f;
+constexpr float FLYTHROUGH_ORBIT_HEIGHT = 1.5f;
+constexpr float FLYTHROUGH_ORBIT_DURATION = 10.0f;
+constexpr const char* FLYTHROUGH_DEFAULT_CSV = "flythrough.csv";
+
+// Regression runs compare the last headless frame with a golden image and the metrics with budgets.
+constexpr const char* GOLDEN_DIFF_IMAGE = "golden_diff.ppm";
+
+struct LaunchOptions
+{
+    bool m_Headless = false;
+    u32 m_FrameCount = 0; // 0 picks the default of the mode.
+    const char* m_OutputImage = HEADLESS_DEFAULT_OUTPUT;
+    const char* m_CameraPath = nullptr; // Camera path file or FLYTHROUGH_ORBIT_PATH, null without a flythrough.
+    const char* m_FlythroughCsv = FLYTHROUGH_DEFAULT_CSV;
+    const char* m_RecordInput = nullptr; // Input recording to write.
+    const char* m_ReplayInput = nullptr; // Input recording to replay instead of the live input, for its length.
+    const char* m_GoldenImage = nullptr; // Expected last frame of a headless run.
+    bool m_UpdateGolden = false;         // Saves the last frame as the golden image instead of comparing it.
+    const char* m_Budgets = nullptr;     // Metric budgets of the run, see core/budgets.h.
+    u32 m_DynamicLights = 0;             // Extra point lights circling over the scene.
+    bool m_Deferred = false;             // Starts with the deferred shading path.
+    const char* m_MetricsSocket = nullptr; // Path the metrics are served on, no server if null.
+};
+
+static LaunchOptions g_Options = {};
+static Framebuffer g_HeadlessTarget = {};
+static CameraPath g_CameraPath = {};
+static FlythroughRecorder g_Flythrough = {};
+static std::vector<MetricBudget> g_Budgets;
 
 static u32 g_VAO = -1;
 static u32 g_VBO = -1;
@@ -37,11 +121,111 @@ static u32 g_LightVBO = -1;
 static u32 g_LightEBO = -1;
 static u32 g_DefaultShader = -1;
 static u32 g_LightShader = -1;
+static u32 g_GBufferShader = -1;
+static u32 g_DeferredLightingShader = -1;
+static u32 g_FullscreenVAO = -1; // Empty, the lighting pass triangle is made up in the vertex shader.
+static RenderGraph g_RenderGraph = {};
 static Texture g_Texture = {};
 static Texture g_TextureSpecular = {};
 static Camera g_Camera = {};
 
+constexpr float CAMERA_FOV = 45.0f;
+constexpr float CAMERA_NEAR = 0.1f;
+constexpr float CAMERA_FAR = 100.0f;
+
+constexpr u32 MESH_LOD_COUNT = 4;
+constexpr float MESH_LOD_REDUCTION = 0.5f; // Fraction of the triangles kept by every LOD.
+static LODMesh g_PlaneMesh = {};
+static LODMesh g_LightMesh = {};
+
 static RenderMethod g_RenderMethod = RenderMethod::Fill;
+static ShadingPath g_ShadingPath = ShadingPath::Forward;
+
+// The simulation runs at a fixed rate, rendering interpolates between the last two simulation ticks.
+constexpr double SIMULATION_TICK_RATE = 60.0;
+constexpr u32 SIMULATION_MAX_TICKS_PER_FRAME = 8;
+static FixedTimestep g_Timestep = {};
+static glm::vec3 g_PreviousCameraPosition = glm::vec3(0.0f);
+
+// Frame rate of the CPU frame limiter when it is switched on.
+constexpr double FRAME_LIMITER_FPS = 60.0;
+constexpr double FRAME_STATS_INTERVAL = 0.5; // Seconds between updates of the stats in the window title.
+constexpr const char* PROFILE_TRACE_FILE = "profile.json";
+constexpr const char* PROFILE_SUMMARY_FILE = "profile.txt";
+constexpr const char* METRICS_CSV_FILE = "metrics.csv";
+constexpr const char* METRICS_JSON_FILE = "metrics.json";
+static FramePacer g_FramePacer = {};
+static double g_LastFrameStatsTime = 0.0;
+
+static World g_World = {};
+static TransformHierarchy g_Transforms = {};
+static CullingSet g_CullingSet = {};
+static BVH g_SceneBVH = {};                    // Items are culling indices, see BoundsComponent.
+static std::vector<Entity> g_CullableEntities; // Entity of each culling index.
+static std::vector<u32> g_VisibleObjects;
+static OcclusionBuffer g_Occlusion = {};
+static bool g_OcclusionCulling = true;
+
+// The main light reaches the whole scene, the dynamic lights of --lights only their surroundings.
+constexpr float MAIN_LIGHT_RADIUS = 10.0f;
+constexpr float DYNAMIC_LIGHT_RADIUS = 0.6f;
+constexpr float DYNAMIC_LIGHT_INTENSITY = 0.5f;
+static ClusteredLighting g_Lighting = {};
+static bool g_LoggedDroppedLights = false; // Dropped lights are reported once, not every frame.
+
+// Uniform blocks of default.vert and light.vert, in std140 layout. The frame block is the first slot of the uniform
+// stream of a snapshot, followed by one draw block per visible object.
+constexpr u32 FRAME_UNIFORM_BINDING = 0;
+constexpr u32 DRAW_UNIFORM_BINDING = 1;
+
+struct FrameUniforms
+{
+    glm::mat4 m_CamMatrix;
+};
+
+struct DrawUniforms
+{
+    glm::mat4 m_Model;
+};
+
+// Visible objects recorded into one command list by one job.
+constexpr u32 DRAW_RECORD_BATCH_SIZE = 256;
+
+// Which of the visible meshes a pass draws.
+enum class MeshPass : u32
+{
+    All,     // Forward path.
+    GBuffer, // Deferred path, the meshes of the default shader go into the G-buffer.
+    Forward, // Deferred path, the other meshes after the lighting pass.
+    Count,
+};
+
+// Everything the render thread needs to draw a frame, see graphics/render_thread.h. The game thread culls the scene
+// and records the draws while it fills the snapshot, so the render thread never reads the world.
+struct RenderSnapshot
+{
+    Camera m_Camera;
+    i32 m_Width;
+    i32 m_Height;
+    RenderMethod m_RenderMethod;
+    ShadingPath m_ShadingPath;
+    PresentMode m_PresentMode;
+    u64 m_ProfilerFrame;
+    UniformStream m_Uniforms;
+    std::vector<CommandList> m_CommandLists[scast<u32>(MeshPass::Count)]; // One per batch of visible objects.
+    std::vector<PointLight> m_Lights; // Interpolated like the meshes they light.
+};
+
+static RenderThread g_RenderThread = {};
+static RenderSnapshot g_RenderSnapshots[RENDER_SNAPSHOT_COUNT] = {};
+static PresentMode g_AppliedPresentMode = PresentMode::VSync; // Swap interval of the context.
+static double g_LastSwapTime = 0.0;                           // Seconds the last swap blocked the render thread.
+static std::atomic<bool> g_DeferredFailed = false;            // The render thread fell back to forward shading.
+
+static InputQueue g_InputQueue = {};
+static ActionMap g_Actions = {};
+static InputRecorder g_InputRecorder = {};
+static InputReplay g_InputReplay = {};
 
 constexpr float VERTICES[] =
 { //     COORDINATES     /        COLORS           /   TexCoord   /       Normals
@@ -85,58 +269,354 @@ constexpr u32 LIGHT_INDICES[] =
     4, 6, 7
 };
 
-// Gets called when the window is resized.
+// Simplification cost of the attributes after the position: color, texture coordinates and normal.
+constexpr float ATTRIBUTE_WEIGHTS[] =
+{
+    0.1f, 0.1f, 0.1f,
+    1.0f, 1.0f,
+    0.5f, 0.5f, 0.5f,
+};
+
+// Gets called when the window is resized. The render thread gets the new size with the next snapshot.
 static void FrameBufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
     g_WindowWidth = width;
     g_WindowHeight = height;
 }
 
+static bool ParseLaunchOptions(const int argc, char** argv, LaunchOptions& outOptions)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            outOptions.m_Headless = true;
+        }
+        else if (std::strcmp(argv[i], "--frames") == 0 && hasValue)
+        {
+            outOptions.m_FrameCount = scast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && hasValue)
+        {
+            outOptions.m_OutputImage = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--flythrough") == 0 && hasValue)
+        {
+            outOptions.m_CameraPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--csv") == 0 && hasValue)
+        {
+            outOptions.m_FlythroughCsv = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--record") == 0 && hasValue)
+        {
+            outOptions.m_RecordInput = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0 && hasValue)
+        {
+            outOptions.m_ReplayInput = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--golden") == 0 && hasValue)
+        {
+            outOptions.m_GoldenImage = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--update-golden") == 0)
+        {
+            outOptions.m_UpdateGolden = true;
+        }
+        else if (std::strcmp(argv[i], "--budgets") == 0 && hasValue)
+        {
+            outOptions.m_Budgets = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--lights") == 0 && hasValue)
+        {
+            outOptions.m_DynamicLights = scast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--deferred") == 0)
+        {
+            outOptions.m_Deferred = true;
+        }
+        else if (std::strcmp(argv[i], "--metrics-socket") == 0 && hasValue)
+        {
+            outOptions.m_MetricsSocket = argv[++i];
+        }
+        else
+        {
+            LOG_ERROR("Unknown option \"%s\".", argv[i]);
+            LOG_ERROR(
+                "Usage: %s [--headless] [--frames <count>] [--output <image.ppm>] [--flythrough <path.txt|orbit>] "
+                "[--csv <results.csv>] [--record <input.o3dinput>] [--replay <input.o3dinput>] "
+                "[--golden <image.ppm> [--update-golden]] [--budgets <budgets.txt>] [--lights <count>] "
+                "[--deferred] [--metrics-socket <path>]",
+                argv[0]
+            );
+            return false;
+        }
+    }
+
+    if (outOptions.m_GoldenImage != nullptr && !outOptions.m_Headless)
+    {
+        LOG_ERROR("--golden needs --headless.");
+        return false;
+    }
+
+    return true;
+}
+
+// Creates the window, or the headless context and its render target, and loads OpenGL.
+static bool CreateRenderContext()
+{
+    if (g_Options.m_Headless)
+    {
+        if (!CreateHeadlessContext(g_WindowWidth, g_WindowHeight))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        g_Window = glfwCreateWindow(g_WindowWidth, g_WindowHeight, WINDOW_TITLE, nullptr, nullptr);
+        if (g_Window == nullptr)
+        {
+            LOG_ERROR("Failed to create GLFW window.");
+            return false;
+        }
+
+        glfwMakeContextCurrent(g_Window);
+
+        // Flythroughs measure the frame, not the refresh rate of the display.
+        QueryPresentModes(g_FramePacer);
+        const PresentMode presentMode = g_Options.m_CameraPath != nullptr ? PresentMode::Immediate : PresentMode::VSync;
+        g_AppliedPresentMode = SetPresentMode(g_FramePacer, presentMode);
+        ApplyPresentMode(g_AppliedPresentMode);
+    }
+
+    // SECTION: Initialize GLAD.
+    const GLADloadproc loader = g_Options.m_Headless ? GetHeadlessProcAddress : (GLADloadproc)glfwGetProcAddress;
+    if (!gladLoadGLLoader(loader))
+    {
+        LOG_ERROR("Failed to initialize GLAD.");
+        return false;
+    }
+    g_GLLoaded = true;
+
+    if (g_Options.m_Headless)
+    {
+        g_HeadlessTarget = CreateFramebuffer(g_WindowWidth, g_WindowHeight);
+        if (g_HeadlessTarget.m_Id == 0)
+        {
+            return false;
+        }
+
+        BindFramebuffer(g_HeadlessTarget);
+    }
+
+    return true;
+}
+
+// Makes the OpenGL context current on the calling thread, or releases it, see graphics/render_thread.h.
+static bool SetRenderContextCurrent(const bool current)
+{
+    if (g_Options.m_Headless)
+    {
+        return SetHeadlessContextCurrent(current);
+    }
+
+    glfwMakeContextCurrent(current ? g_Window : nullptr);
+    return true;
+}
+
+// Loads the camera path of a flythrough and the input of a replay, picks the frame count if it wasn't given and
+// starts the input recording.
+static bool PrepareScriptedRun()
+{
+    if (g_Options.m_CameraPath != nullptr)
+    {
+        if (std::strcmp(g_Options.m_CameraPath, FLYTHROUGH_ORBIT_PATH) == 0)
+        {
+            g_CameraPath = CreateOrbitCameraPath(
+                FLYTHROUGH_ORBIT_RADIUS,
+                FLYTHROUGH_ORBIT_HEIGHT,
+                FLYTHROUGH_ORBIT_DURATION
+            );
+        }
+        else if (!LoadCameraPath(g_Options.m_CameraPath, g_CameraPath))
+        {
+            return false;
+        }
+    }
+
+    // Same expression as in CreateFixedTimestep(), the replay compares the tick durations exactly.
+    const double tickDuration = 1.0 / SIMULATION_TICK_RATE;
+    if (g_Options.m_ReplayInput != nullptr && !LoadInputReplay(g_InputReplay, g_Options.m_ReplayInput, tickDuration))
+    {
+        return false;
+    }
+
+    // A replay ends with its recording, a flythrough with its path.
+    if (g_Options.m_ReplayInput != nullptr)
+    {
+        g_Options.m_FrameCount = g_Options.m_FrameCount == 0
+            ? g_InputReplay.m_FrameCount
+            : std::min(g_Options.m_FrameCount, g_InputReplay.m_FrameCount);
+    }
+    else if (g_Options.m_FrameCount == 0)
+    {
+        g_Options.m_FrameCount = g_Options.m_CameraPath != nullptr
+            ? scast<u32>(GetCameraPathDuration(g_CameraPath) * SIMULATION_TICK_RATE) + 1
+            : HEADLESS_DEFAULT_FRAME_COUNT;
+    }
+
+    if (g_Options.m_CameraPath != nullptr)
+    {
+        g_Flythrough.m_Frames.reserve(g_Options.m_FrameCount);
+        LOG_INFO("Flying along \"%s\" for %u frames.", g_Options.m_CameraPath, g_Options.m_FrameCount);
+    }
+
+    if (g_Options.m_Budgets != nullptr && !LoadMetricBudgets(g_Options.m_Budgets, g_Budgets))
+    {
+        return false;
+    }
+
+    if (g_Options.m_RecordInput != nullptr
+        && !StartInputRecording(g_InputRecorder, g_Options.m_RecordInput, tickDuration))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Adds one of the lights of --lights. The lights are spread over the plane by the golden angle and get colors all
+// around the hue circle, the same ones every run.
+static void CreateDynamicLight(const u32 index)
+{
+    constexpr float goldenRatio = 0.618034f;
+    const float spread = std::fmod(index * goldenRatio, 1.0f);
+
+    const float hue = spread * 6.0f;
+    const glm::vec3 color = glm::clamp(
+        glm::abs(glm::mod(glm::vec3(hue, hue + 4.0f, hue + 2.0f), 6.0f) - 3.0f) - 1.0f,
+        0.0f,
+        1.0f
+    );
+
+    const OrbitComponent orbit =
+    {
+        .m_Center = glm::vec3(0.0f, 0.1f + 0.1f * (index % 3), 0.0f),
+        .m_Radius = 0.1f + 0.9f * std::sqrt(spread),
+        .m_Speed = (index % 2 == 0 ? 1.0f : -1.0f) * (0.5f + std::fmod(index * 0.37f, 1.0f)),
+        .m_Phase = index * 2.39996f,
+    };
+
+    CreateEntityWith(
+        g_World,
+        NameComponent{ "Dynamic light" },
+        TransformComponent{
+            CreateTransform(
+                g_Transforms,
+                TRANSFORM_NO_PARENT,
+                orbit.m_Center,
+                glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                glm::vec3(1.0f)
+            )
+        },
+        LightComponent{ PointLight{ orbit.m_Center, DYNAMIC_LIGHT_RADIUS, color, DYNAMIC_LIGHT_INTENSITY } },
+        orbit
+    );
+}
+
 static bool Initialize()
 {
     // SECTION: Initialize GLFW.
+    // Headless runs only use GLFW for its clock and pass the platform with no display.
+    if (g_Options.m_Headless)
+    {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-#if _DEBUG
-    constexpr const char* WINDOW_TITLE = "O3D [DEBUG]";
-#else
-    constexpr const char* WINDOW_TITLE = "O3D [RELEASE]";
-#endif // _DEBUG
+    // SECTION: Initialize the job system.
+    InitializeJobSystem(0);
+    InitializeFrameArena(FRAME_ARENA_DEFAULT_SIZE);
 
-    g_Window = glfwCreateWindow(g_WindowWidth, g_WindowHeight, WINDOW_TITLE, nullptr, nullptr);
-    if (g_Window == nullptr)
+    if (!PrepareScriptedRun() || !CreateRenderContext())
     {
-        LOG_ERROR("Failed to create GLFW window.");
         return false;
     }
 
-    glfwMakeContextCurrent(g_Window);
+    glViewport(0, 0, g_WindowWidth, g_WindowHeight); // Set viewport.
 
-    // SECTION: Initialize GLAD.
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    InitializeProfiler();
+    InitializeMetrics(g_Options.m_MetricsSocket);
+
+    if (g_Window != nullptr)
     {
-        LOG_ERROR("Failed to initialize GLAD.");
-        return false;
+        glfwSetFramebufferSizeCallback(g_Window, FrameBufferSizeCallback); // Set window resize callback.
+
+        AttachInputQueue(g_InputQueue, g_Window);
     }
+    BindDefaultActions(g_Actions);
 
-    glViewport(0, 0, g_WindowWidth, g_WindowHeight); // Set viewport.
+    glEnable(GL_DEPTH_TEST);
 
-    glfwSetFramebufferSizeCallback(g_Window, FrameBufferSizeCallback); // Set window resize callback.
+    // SECTION: Decode the textures on the workers while the rest is set up.
+    stbi_set_flip_vertically_on_load(true); // OpenGL reads images from bottom-left corder to top-right corner.
+                                            // Whereas STB_Image by default reads them from the top-left corner
+                                            // to the bottom-right corner. So we use this to make STB_Image's
+                                            // behaviour more similar to OpenGL.
 
-    glEnable(GL_DEPTH_TEST);
+    TextureImage textureImage = {};
+    TextureImage textureSpecularImage = {};
+    JobCounter textureDecode;
+    RunJob([&textureImage]() { LoadTextureImage("textures/planks.png", textureImage); }, &textureDecode, JobAffinity::Any);
+    RunJob(
+        [&textureSpecularImage]() { LoadTextureImage("textures/planksSpec.png", textureSpecularImage); },
+        &textureDecode,
+        JobAffinity::Any
+    );
 
     // SECTION: Create default shader.
     g_DefaultShader = CreateShader("shaders/default.vert", "shaders/default.frag");
 
+    // SECTION: Create the shaders of the deferred path. The geometry pass shares the vertex shader of the default
+    // shader.
+    g_GBufferShader = CreateShader("shaders/default.vert", "shaders/gbuffer.frag");
+    g_DeferredLightingShader = CreateShader("shaders/deferred_lighting.vert", "shaders/deferred_lighting.frag");
+    g_FullscreenVAO = CreateVAO();
+    g_ShadingPath = g_Options.m_Deferred ? ShadingPath::Deferred : ShadingPath::Forward;
+
+    // SECTION: Build the LOD chains of the meshes.
+    g_PlaneMesh = BuildMeshLODs(
+        VERTICES,
+        sizeof(VERTICES) / (11 * sizeof(float)),
+        11,
+        INDICES,
+        sizeof(INDICES) / sizeof(u32),
+        MESH_LOD_COUNT,
+        MESH_LOD_REDUCTION,
+        ATTRIBUTE_WEIGHTS
+    );
+    g_LightMesh = BuildMeshLODs(
+        LIGHT_VERTICES,
+        sizeof(LIGHT_VERTICES) / (3 * sizeof(float)),
+        3,
+        LIGHT_INDICES,
+        sizeof(LIGHT_INDICES) / sizeof(u32),
+        MESH_LOD_COUNT,
+        MESH_LOD_REDUCTION,
+        nullptr
+    );
+
     g_VAO = CreateVAO();
     BindVAO(g_VAO);
 
     g_VBO = CreateVBO(VERTICES, sizeof(VERTICES));
-    g_EBO = CreateEBO(INDICES, sizeof(INDICES));
+    g_EBO = CreateEBO(g_PlaneMesh.m_Indices.data(), g_PlaneMesh.m_Indices.size() * sizeof(u32));
 
     LinkAttrib(g_VBO, 0, 3, GL_FLOAT, 11 * sizeof(float), (void*)0); // Coordinates
     LinkAttrib(g_VBO, 1, 3, GL_FLOAT, 11 * sizeof(float), (void*)(3 * sizeof(float))); // Colors
@@ -155,7 +635,7 @@ static bool Initialize()
 
     g_LightVBO = CreateVBO(LIGHT_VERTICES, sizeof(LIGHT_VERTICES));
 
-    g_LightEBO = CreateEBO(LIGHT_INDICES, sizeof(LIGHT_INDICES));
+    g_LightEBO = CreateEBO(g_LightMesh.m_Indices.data(), g_LightMesh.m_Indices.size() * sizeof(u32));
 
     LinkAttrib(g_LightVBO, 0, 3, GL_FLOAT, 3 * sizeof(float), (void*)0);
 
@@ -166,20 +646,8 @@ static bool Initialize()
     // SECTION: Pass values to shader uniforms.
     const glm::vec4 lightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
     const glm::vec3 lightPos = glm::vec3(0.5f, 0.5f, 0.5f);
-    glm::mat4 lightModel = glm::mat4(1.0f);
-    lightModel = glm::translate(lightModel, lightPos);
-
-    const glm::vec3 pyramidPos = glm::vec3(0.0f, 0.0f, 0.0f);
-    glm::mat4 pyramidModel = glm::mat4(1.0f);
-    pyramidModel = glm::translate(pyramidModel, pyramidPos);
 
     ActivateShader(g_LightShader);
-    glUniformMatrix4fv(
-        glGetUniformLocation(g_LightShader, "model"),
-        1,
-        GL_FALSE,
-        glm::value_ptr(lightModel)
-    );
     glUniform4f(
         glGetUniformLocation(g_LightShader, "lightColor"),
         lightColor.x,
@@ -188,115 +656,529 @@ static bool Initialize()
         lightColor.w
     );
 
-    ActivateShader(g_DefaultShader);
-    glUniformMatrix4fv(
-        glGetUniformLocation(g_DefaultShader, "model"),
-        1,
-        GL_FALSE,
-        glm::value_ptr(pyramidModel)
-    );
-    glUniform4f(
-        glGetUniformLocation(g_DefaultShader, "lightColor"),
-        lightColor.x,
-        lightColor.y,
-        lightColor.z,
-        lightColor.w
+    // The default shader gets its lights from the clusters, see Render().
+    CreateClusteredLighting(g_Lighting);
+
+    // The meshes get their camera and model matrices from uniform blocks, see graphics/command_list.h.
+    InitializeCommandLists();
+
+    // SECTION: Scene entities.
+    constexpr glm::quat identityRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+
+    constexpr u32 vertexCount = sizeof(VERTICES) / (11 * sizeof(float));
+    CreateEntityWith(
+        g_World,
+        NameComponent{ "Plane" },
+        TransformComponent{
+            CreateTransform(g_Transforms, TRANSFORM_NO_PARENT, glm::vec3(0.0f), identityRotation, glm::vec3(1.0f))
+        },
+        MeshComponent{
+            g_VAO,
+            g_DefaultShader,
+            g_PlaneMesh.m_LODs.data(),
+            scast<u32>(g_PlaneMesh.m_LODs.size()),
+            0,
+            true
+        },
+        BoundsComponent{
+            ComputeAABB(VERTICES, vertexCount, 11),
+            ComputeBoundingSphere(VERTICES, vertexCount, 11),
+            0
+        },
+        OccluderComponent{ VERTICES, 11, INDICES, sizeof(INDICES) / sizeof(u32) }
     );
-    glUniform3f(
-        glGetUniformLocation(g_DefaultShader, "lightPos"),
-        lightPos.x,
-        lightPos.y,
-        lightPos.z
+
+    constexpr u32 lightVertexCount = sizeof(LIGHT_VERTICES) / (3 * sizeof(float));
+    CreateEntityWith(
+        g_World,
+        NameComponent{ "Light" },
+        TransformComponent{
+            CreateTransform(g_Transforms, TRANSFORM_NO_PARENT, lightPos, identityRotation, glm::vec3(1.0f))
+        },
+        MeshComponent{
+            g_LightVAO,
+            g_LightShader,
+            g_LightMesh.m_LODs.data(),
+            scast<u32>(g_LightMesh.m_LODs.size()),
+            0,
+            false
+        },
+        BoundsComponent{
+            ComputeAABB(LIGHT_VERTICES, lightVertexCount, 3),
+            ComputeBoundingSphere(LIGHT_VERTICES, lightVertexCount, 3),
+            0
+        },
+        LightComponent{ PointLight{ lightPos, MAIN_LIGHT_RADIUS, glm::vec3(lightColor), lightColor.w } }
     );
 
+    for (u32 i = 0; i < g_Options.m_DynamicLights; ++i)
+    {
+        CreateDynamicLight(i);
+    }
+
+    UpdateWorldMatrices(g_Transforms);
+
+    // Register the world space bounds of every entity for culling and scene queries.
+    std::vector<AABB> sceneBounds;
+    ForEach<TransformComponent, BoundsComponent>(g_World, [&](
+        const Entity entity,
+        const TransformComponent& transform,
+        BoundsComponent& bounds)
+    {
+        const glm::mat4& world = GetWorldMatrix(g_Transforms, transform.m_Node);
+        const AABB worldBounds = TransformAABB(bounds.m_Local, world);
+
+        bounds.m_CullingIndex = AddCullable(
+            g_CullingSet,
+            worldBounds,
+            TransformBoundingSphere(bounds.m_LocalSphere, world)
+        );
+        sceneBounds.push_back(worldBounds);
+        g_CullableEntities.push_back(entity);
+    });
+
+    BuildBVH(g_SceneBVH, sceneBounds.data(), scast<u32>(sceneBounds.size()));
+    g_VisibleObjects.resize(g_CullingSet.m_Count);
+
     // SECTION: Texture
-    stbi_set_flip_vertically_on_load(true); // OpenGL reads images from bottom-left corder to top-right corner.
-                                            // Whereas STB_Image by default reads them from the top-left corner
-                                            // to the bottom-right corner. So we use this to make STB_Image's
-                                            // behaviour more similar to OpenGL.
+    // The upload needs the GL context, so it runs on the main thread once both images are decoded.
+    JobCounter textureUpload;
+    RunJobAfter(textureDecode, [&textureImage, &textureSpecularImage]()
+    {
+        g_Texture = CreateTextureFromImage(textureImage, GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE);
+        SetTextureUnit(g_DefaultShader, "tex0", 0);
+        SetTextureUnit(g_GBufferShader, "tex0", 0);
 
-    g_Texture = CreateTexture(
-        "textures/planks.png",
-        GL_TEXTURE_2D,
-        0,
-        GL_RGBA,
-        GL_UNSIGNED_BYTE
-    );
-    SetTextureUnit(g_DefaultShader, "tex0", 0);
+        g_TextureSpecular = CreateTextureFromImage(textureSpecularImage, GL_TEXTURE_2D, 1, GL_RED, GL_UNSIGNED_BYTE);
+        SetTextureUnit(g_DefaultShader, "tex1", 1);
+        SetTextureUnit(g_GBufferShader, "tex1", 1);
 
-    g_TextureSpecular = CreateTexture(
-        "textures/planksSpec.png",
-        GL_TEXTURE_2D,
-        1,
-        GL_RED,
-        GL_UNSIGNED_BYTE
-    );
-    SetTextureUnit(g_DefaultShader, "tex1", 1);
+        FreeTextureImage(textureImage);
+        FreeTextureImage(textureSpecularImage);
+    }, &textureUpload, JobAffinity::MainThread);
+    WaitForCounter(textureUpload);
 
     // SECTION: Camera
     g_Camera = CreateCamera(g_WindowWidth, g_WindowHeight, glm::vec3(0.0f, 0.0f, 2.0f));
+    g_PreviousCameraPosition = g_Camera.m_Position;
+
+    // SECTION: Simulation clock
+    g_Timestep = CreateFixedTimestep(SIMULATION_TICK_RATE, SIMULATION_MAX_TICKS_PER_FRAME);
 
     return true;
 }
 
-static void ProcessInput(const float dt)
+// Handles the per-frame input. Camera movement is part of the simulation, see Update().
+// `frameTime` is the time the simulation advances by in this frame, a replay replaces it with the recorded one.
+static void ProcessInput(const u32 frameIndex, double& frameTime)
 {
+    PROFILE_SCOPE("ProcessInput");
+    METRIC_SCOPE(Metric::ProcessInputTime);
+
     glfwPollEvents();
 
-    // Escape to close.
-    if (glfwGetKey(g_Window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+    // Everything after this point can't tell replayed input from live input.
+    if (g_Options.m_ReplayInput != nullptr)
+    {
+        ReplayInputFrame(g_InputReplay, frameIndex, g_InputQueue, frameTime);
+    }
+    RecordInputFrame(g_InputRecorder, frameIndex, frameTime, g_InputQueue);
+
+    ProcessInputEvents(g_Actions, g_InputQueue);
+    ClearInputEvents(g_InputQueue);
+
+    if (ConsumeActionPress(g_Actions, InputAction::Quit) && g_Window != nullptr)
     {
         glfwSetWindowShouldClose(g_Window, true);
     }
-    // 1 to switch to wireframe render.
-    else if (glfwGetKey(g_Window, GLFW_KEY_1) == GLFW_PRESS)
+
+    if (ConsumeActionPress(g_Actions, InputAction::WireframeMode) && g_RenderMethod != RenderMethod::Wireframe)
+    {
+        g_RenderMethod = RenderMethod::Wireframe;
+        LOG_INFO("Set RenderMethod to \"RenderMethod::Wireframe\"");
+    }
+
+    if (ConsumeActionPress(g_Actions, InputAction::FillMode) && g_RenderMethod != RenderMethod::Fill)
+    {
+        g_RenderMethod = RenderMethod::Fill;
+        LOG_INFO("Set RenderMethod to \"RenderMethod::Fill\"");
+    }
+
+    if (ConsumeActionPress(g_Actions, InputAction::ForwardShading) && g_ShadingPath != ShadingPath::Forward)
+    {
+        g_ShadingPath = ShadingPath::Forward;
+        LOG_INFO("Set ShadingPath to \"ShadingPath::Forward\"");
+    }
+
+    if (ConsumeActionPress(g_Actions, InputAction::DeferredShading) && g_ShadingPath != ShadingPath::Deferred)
+    {
+        g_ShadingPath = ShadingPath::Deferred;
+        LOG_INFO("Set ShadingPath to \"ShadingPath::Deferred\"");
+    }
+
+    // Mouse look is applied every frame rather than every tick, so it never waits for the simulation.
+    SetCursorCaptured(g_InputQueue, IsActionDown(g_Actions, InputAction::Look));
+    float lookX = 0.0f;
+    float lookY = 0.0f;
+    ConsumeLookDelta(g_Actions, lookX, lookY);
+    if (g_Options.m_CameraPath == nullptr)
+    {
+        RotateCamera(g_Camera, lookX, lookY);
+    }
+
+    // Pick the object in the center of the view.
+    if (ConsumeActionPress(g_Actions, InputAction::Pick))
+    {
+        const BVHRayHit hit = RaycastBVH(g_SceneBVH, g_Camera.m_Position, g_Camera.m_Orientation, 100.0f);
+        if (hit.m_Item != BVH_INVALID_INDEX)
+        {
+            const NameComponent* const name = GetComponent<NameComponent>(g_World, g_CullableEntities[hit.m_Item]);
+            LOG_INFO("Picked \"%s\" at distance %.2f.", name ? name->m_Name : "?", hit.m_Distance);
+        }
+    }
+
+    if (ConsumeActionPress(g_Actions, InputAction::CyclePresentMode))
+    {
+        const PresentMode next = g_FramePacer.m_PresentMode == PresentMode::VSync ? PresentMode::Immediate
+            : g_FramePacer.m_PresentMode == PresentMode::Immediate ? PresentMode::AdaptiveVSync
+            : PresentMode::VSync;
+        LOG_INFO("Set PresentMode to \"%s\"", GetPresentModeName(SetPresentMode(g_FramePacer, next)));
+    }
+
+    if (ConsumeActionPress(g_Actions, InputAction::ToggleFrameLimiter))
+    {
+        const bool enable = g_FramePacer.m_TargetFrameTime == 0.0;
+        SetTargetFrameRate(g_FramePacer, enable ? FRAME_LIMITER_FPS : 0.0);
+        if (enable)
+        {
+            LOG_INFO("Limited the frame rate to %.0f FPS.", FRAME_LIMITER_FPS);
+        }
+        else
+        {
+            LOG_INFO("Removed the frame rate limit.");
+        }
+    }
+
+    if (ConsumeActionPress(g_Actions, InputAction::ToggleOcclusionCulling))
     {
-        if (g_RenderMethod != RenderMethod::Wireframe)
+        g_OcclusionCulling = !g_OcclusionCulling;
+        LOG_INFO("Occlusion culling %s.", g_OcclusionCulling ? "enabled" : "disabled");
+    }
+
+    if (ConsumeActionPress(g_Actions, InputAction::SaveProfile))
+    {
+        if (SaveChromeTrace(PROFILE_TRACE_FILE) && SaveProfilerSummary(PROFILE_SUMMARY_FILE))
         {
-            g_RenderMethod = RenderMethod::Wireframe;
-            LOG_INFO("Set RenderMethod to \"RenderMethod::Wireframe\"");
+            LOG_INFO("Saved the profile to \"%s\" and \"%s\".", PROFILE_TRACE_FILE, PROFILE_SUMMARY_FILE);
         }
+        LogProfilerSummary();
     }
-    // 2 to switch to filled render.
-    else if (glfwGetKey(g_Window, GLFW_KEY_2) == GLFW_PRESS)
+
+    if (ConsumeActionPress(g_Actions, InputAction::SaveMetrics))
     {
-        if (g_RenderMethod != RenderMethod::Fill)
+        if (SaveMetricsCsv(METRICS_CSV_FILE) && SaveMetricsJson(METRICS_JSON_FILE))
         {
-            g_RenderMethod = RenderMethod::Fill;
-            LOG_INFO("Set RenderMethod to \"RenderMethod::Fill\"");
+            LOG_INFO("Saved the metrics to \"%s\" and \"%s\".", METRICS_CSV_FILE, METRICS_JSON_FILE);
         }
     }
+}
 
-    UpdateCameraInput(g_Camera, g_Window, dt);
+// Simulation time of the latest tick. Flythrough frames are exactly one tick long, see main().
+static double GetFlythroughTime()
+{
+    return scast<double>(g_Timestep.m_TickCount - 1) * g_Timestep.m_TickDuration;
 }
 
+// Advances the simulation by one fixed tick.
 static void Update(const float dt)
 {
+    PROFILE_SCOPE("Update");
+    METRIC_SCOPE(Metric::UpdateTime);
+
+    g_PreviousCameraPosition = g_Camera.m_Position;
+
+    if (g_Options.m_CameraPath != nullptr)
+    {
+        // Sampled at the simulation time, never the wall clock, so every run sees the same camera. The run starts at
+        // the first key, which a path file may put later than 0.
+        SampleCameraPath(
+            g_CameraPath,
+            g_CameraPath.m_Keys.front().m_Time + scast<float>(GetFlythroughTime()),
+            g_Camera.m_Position,
+            g_Camera.m_Orientation
+        );
+    }
+    else
+    {
+        auto axis = [](const InputAction positive, const InputAction negative)
+        {
+            return (IsActionDown(g_Actions, positive) ? 1.0f : 0.0f)
+                - (IsActionDown(g_Actions, negative) ? 1.0f : 0.0f);
+        };
+        MoveCamera(
+            g_Camera,
+            glm::vec3(
+                axis(InputAction::MoveRight, InputAction::MoveLeft),
+                axis(InputAction::MoveUp, InputAction::MoveDown),
+                axis(InputAction::MoveForward, InputAction::MoveBackward)
+            ),
+            dt
+        );
+    }
+
+    const float time = scast<float>(scast<double>(g_Timestep.m_TickCount) * g_Timestep.m_TickDuration);
+    ForEach<TransformComponent, OrbitComponent>(g_World, [time](
+        const Entity entity,
+        const TransformComponent& transform,
+        const OrbitComponent& orbit)
+    {
+        const float angle = orbit.m_Phase + orbit.m_Speed * time;
+        SetLocalPosition(
+            g_Transforms,
+            transform.m_Node,
+            orbit.m_Center + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * orbit.m_Radius
+        );
+    });
+
+    UpdateWorldMatricesParallel(g_Transforms);
+
+    // Move the bounds of the entities whose world matrix changed.
+    ForEach<TransformComponent, BoundsComponent>(g_World, [](
+        const Entity entity,
+        const TransformComponent& transform,
+        const BoundsComponent& bounds)
+    {
+        if (!DidWorldMatrixChange(g_Transforms, transform.m_Node))
+        {
+            return;
+        }
+
+        const glm::mat4& world = GetWorldMatrix(g_Transforms, transform.m_Node);
+        const AABB worldBounds = TransformAABB(bounds.m_Local, world);
+
+        SetCullableBounds(
+            g_CullingSet,
+            bounds.m_CullingIndex,
+            worldBounds,
+            TransformBoundingSphere(bounds.m_LocalSphere, world)
+        );
+        UpdateBVHItem(g_SceneBVH, bounds.m_CullingIndex, worldBounds);
+    });
+
+    RefitBVH(g_SceneBVH);
 }
 
-static void Render()
+// Records the draws of the visible objects [begin, end) into the command lists of their batch.
+static void RecordVisibleMeshes(RenderSnapshot& snapshot, const float alpha, const u32 begin, const u32 end)
 {
-    glClearColor(0.07f, 0.13f, 0.17f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    PROFILE_SCOPE("RecordVisibleMeshes");
+
+    const Camera& camera = snapshot.m_Camera;
+    const bool deferred = snapshot.m_ShadingPath == ShadingPath::Deferred;
+    const u32 batch = begin / DRAW_RECORD_BATCH_SIZE;
+
+    for (u32 i = begin; i < end; ++i)
+    {
+        const Entity entity = g_CullableEntities[g_VisibleObjects[i]];
+        MeshComponent* const mesh = GetComponent<MeshComponent>(g_World, entity);
+        const TransformComponent* const transform = GetComponent<TransformComponent>(g_World, entity);
+        const BoundsComponent* const bounds = GetComponent<BoundsComponent>(g_World, entity);
+        if (mesh == nullptr || transform == nullptr || bounds == nullptr)
+        {
+            continue;
+        }
+
+        const glm::mat4 model = GetInterpolatedWorldMatrix(g_Transforms, transform->m_Node, alpha);
+
+        // Pick the LOD from the distance to the closest point of the bounding sphere.
+        const BoundingSphere sphere = TransformBoundingSphere(bounds->m_LocalSphere, model);
+        const float scale = glm::max(
+            glm::length(glm::vec3(model[0])),
+            glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])))
+        );
+        const float distance = glm::max(
+            glm::length(sphere.m_Center - camera.m_Position) - sphere.m_Radius,
+            CAMERA_NEAR
+        );
+        mesh->m_CurrentLOD = SelectMeshLOD(
+            mesh->m_LODs,
+            mesh->m_LODCount,
+            camera,
+            distance,
+            scale,
+            mesh->m_CurrentLOD
+        );
+        const MeshLOD& lod = mesh->m_LODs[mesh->m_CurrentLOD];
+
+        // The deferred path lights the meshes of the default shader in the G-buffer, the others are drawn forward.
+        const bool gbufferMesh = mesh->m_Shader == g_DefaultShader;
+        const MeshPass pass = !deferred ? MeshPass::All : gbufferMesh ? MeshPass::GBuffer : MeshPass::Forward;
+        CommandList& list = snapshot.m_CommandLists[scast<u32>(pass)][batch];
+
+        if (list.m_Count == 0)
+        {
+            RecordUniformBlockRange(list, FRAME_UNIFORM_BINDING, snapshot.m_Uniforms, 0);
+        }
+
+        rcast<DrawUniforms*>(GetUniformSlot(snapshot.m_Uniforms, i + 1))->m_Model = model;
+
+        RecordBindProgram(list, pass == MeshPass::GBuffer ? g_GBufferShader : mesh->m_Shader);
+        if (mesh->m_Textured)
+        {
+            RecordBindTexture(list, g_Texture);
+            RecordBindTexture(list, g_TextureSpecular);
+        }
+        RecordBindVertexArray(list, mesh->m_VAO);
+        RecordUniformBlockRange(list, DRAW_UNIFORM_BINDING, snapshot.m_Uniforms, i + 1);
+        RecordDrawIndexed(list, lod.m_IndexOffset, lod.m_IndexCount);
+    }
+}
+
+// Resolves what the frame draws on the game thread: interpolates the camera, culls the scene, records the draws and
+// copies the lights into `snapshot`, `alpha` of the way from the previous simulation tick to the latest one.
+static void BuildRenderSnapshot(RenderSnapshot& snapshot, const float alpha)
+{
+    PROFILE_SCOPE("BuildRenderSnapshot");
+    METRIC_SCOPE(Metric::SnapshotTime);
+
+    // The render thread couldn't compile the deferred frame.
+    if (g_DeferredFailed.exchange(false))
+    {
+        g_ShadingPath = ShadingPath::Forward;
+    }
+
+    Camera& camera = snapshot.m_Camera;
+    camera = g_Camera;
+    camera.m_Position = glm::mix(g_PreviousCameraPosition, g_Camera.m_Position, alpha);
 
     UpdateCameraMatrix(
-        g_Camera,
-        45.0f,
-        0.1f,
-        100.0f
+        camera,
+        CAMERA_FOV,
+        CAMERA_NEAR,
+        CAMERA_FAR
     );
 
-    ActivateShader(g_DefaultShader);
+    snapshot.m_Width = g_WindowWidth;
+    snapshot.m_Height = g_WindowHeight;
+    snapshot.m_RenderMethod = g_RenderMethod;
+    snapshot.m_ShadingPath = g_ShadingPath;
+    snapshot.m_PresentMode = g_FramePacer.m_PresentMode;
+    snapshot.m_ProfilerFrame = GetProfilerFrameIndex();
 
-    ExportCameraMatrixToShader(g_Camera, g_DefaultShader, "camMatrix");
+    // Only submit the objects that intersect the camera frustum.
+    u32 visibleCount = 0;
+    {
+        PROFILE_SCOPE("FrustumCulling");
+        const Frustum frustum = ExtractFrustumPlanes(camera.m_CameraMatrix);
+        visibleCount = CullFrustumParallel(g_CullingSet, frustum, g_VisibleObjects.data());
+    }
 
-    // Set texture.
-    BindTexture(g_Texture);
-    BindTexture(g_TextureSpecular);
+    // Then drop the ones hidden behind the occluders. Occluders use the latest simulation state, like the culling
+    // bounds, so an object is never hidden by where an occluder is about to be.
+    if (g_OcclusionCulling)
+    {
+        PROFILE_SCOPE("OcclusionCulling");
 
-    BindVAO(g_VAO);
+        BeginOcclusionFrame(g_Occlusion, camera.m_CameraMatrix);
+        ForEach<TransformComponent, OccluderComponent>(g_World, [](
+            const Entity entity,
+            const TransformComponent& transform,
+            const OccluderComponent& occluder)
+        {
+            AddOccluder(
+                g_Occlusion,
+                occluder.m_Vertices,
+                occluder.m_Stride,
+                occluder.m_Indices,
+                occluder.m_IndexCount,
+                GetWorldMatrix(g_Transforms, transform.m_Node)
+            );
+        });
+        RasterizeOccluders(g_Occlusion);
+
+        visibleCount = CullOccluded(g_Occlusion, g_CullingSet, g_VisibleObjects.data(), visibleCount);
+    }
+
+    // Every batch of visible objects is recorded by its own job into its own command lists, and every object
+    // writes its own slot of the uniform stream, so the jobs share nothing.
+    {
+        PROFILE_SCOPE("RecordDraws");
+
+        snapshot.m_Uniforms = CreateUniformStream(
+            visibleCount + 1,
+            scast<u32>(std::max(sizeof(FrameUniforms), sizeof(DrawUniforms)))
+        );
+        rcast<FrameUniforms*>(GetUniformSlot(snapshot.m_Uniforms, 0))->m_CamMatrix = camera.m_CameraMatrix;
+
+        const u32 batchCount = (visibleCount + DRAW_RECORD_BATCH_SIZE - 1) / DRAW_RECORD_BATCH_SIZE;
+        for (std::vector<CommandList>& lists : snapshot.m_CommandLists)
+        {
+            lists.assign(batchCount, {});
+        }
+
+        ParallelFor(visibleCount, DRAW_RECORD_BATCH_SIZE, [&snapshot, alpha](const u32 begin, const u32 end)
+        {
+            RecordVisibleMeshes(snapshot, alpha, begin, end);
+        });
+    }
+
+    snapshot.m_Lights.clear();
+    ForEach<TransformComponent, LightComponent>(g_World, [&snapshot, alpha](
+        const Entity entity,
+        const TransformComponent& transform,
+        const LightComponent& light)
+    {
+        PointLight& frameLight = snapshot.m_Lights.emplace_back(light.m_Light);
+        frameLight.m_Position = glm::vec3(GetInterpolatedWorldMatrix(g_Transforms, transform.m_Node, alpha)[3]);
+    });
+}
+
+// Shades every covered pixel of the G-buffer once into the bound frame target, and copies the depth along.
+static void DrawDeferredLighting(const RenderGraph& graph, const GBuffer& gbuffer, const RenderSnapshot& snapshot)
+{
+    ActivateShader(g_DeferredLightingShader);
+    const glm::mat4 inverseCamera = glm::inverse(snapshot.m_Camera.m_CameraMatrix);
+    glUniformMatrix4fv(
+        glGetUniformLocation(g_DeferredLightingShader, "invCamMatrix"),
+        1,
+        GL_FALSE,
+        glm::value_ptr(inverseCamera)
+    );
+    BindGBufferTextures(graph, gbuffer);
+
+    // The triangle covers the screen whatever the render method, and writes the depth of the G-buffer.
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDepthFunc(GL_ALWAYS);
+
+    BindVAO(g_FullscreenVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    AddMetric(Metric::DrawCalls, 1);
+    AddMetric(Metric::Triangles, 1);
+
+    glDepthFunc(GL_LESS);
+    if (snapshot.m_RenderMethod == RenderMethod::Wireframe)
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    }
+}
+
+// Replays the command lists recorded for `pass`.
+static void DrawVisibleMeshes(const RenderSnapshot& snapshot, const MeshPass pass)
+{
+    const std::vector<CommandList>& lists = snapshot.m_CommandLists[scast<u32>(pass)];
+    ExecuteCommandLists(lists.data(), scast<u32>(lists.size()));
+}
 
-    if (g_RenderMethod == RenderMethod::Wireframe)
+// Draws a snapshot, on the render thread.
+static void Render(const RenderSnapshot& snapshot)
+{
+    PROFILE_SCOPE("Render");
+    METRIC_SCOPE(Metric::RenderTime);
+
+    glClearColor(0.07f, 0.13f, 0.17f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    if (snapshot.m_RenderMethod == RenderMethod::Wireframe)
     {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
@@ -305,23 +1187,191 @@ static void Render()
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     }
 
-    glDrawElements(GL_TRIANGLES, sizeof(INDICES) / sizeof(u32), GL_UNSIGNED_INT, 0);
-
-    ActivateShader(g_LightShader);
+    const Camera& camera = snapshot.m_Camera;
+    const bool deferred = snapshot.m_ShadingPath == ShadingPath::Deferred;
 
-    ExportCameraMatrixToShader(g_Camera, g_LightShader, "camMatrix");
+    // Sort the lights into the clusters of this view.
+    {
+        PROFILE_SCOPE("LightAssignment");
+
+        UpdateClusterBounds(
+            g_Lighting,
+            camera.m_ProjectionMatrix,
+            CAMERA_NEAR,
+            CAMERA_FAR,
+            snapshot.m_Width,
+            snapshot.m_Height
+        );
+        AssignLightsToClusters(
+            g_Lighting,
+            camera.m_ViewMatrix,
+            snapshot.m_Lights.data(),
+            scast<u32>(snapshot.m_Lights.size())
+        );
+        if (g_Lighting.m_DroppedLights > 0 && !g_LoggedDroppedLights)
+        {
+            LOG_ERROR(
+                "%u lights or light references are over the cluster limits and were dropped.",
+                g_Lighting.m_DroppedLights
+            );
+            g_LoggedDroppedLights = true;
+        }
+        UploadClusteredLighting(g_Lighting);
+
+        // Whichever shader of the path lights the meshes.
+        const u32 litShader = deferred ? g_DeferredLightingShader : g_DefaultShader;
+        SetClusterUniforms(g_Lighting, litShader);
+        glProgramUniform3fv(
+            litShader,
+            glGetUniformLocation(litShader, "camPos"),
+            1,
+            glm::value_ptr(camera.m_Position)
+        );
+    }
 
-    BindVAO(g_LightVAO);
+    // The uniforms of all the recorded draws go up at once.
+    UploadUniformStream(snapshot.m_Uniforms);
 
-    glDrawElements(GL_TRIANGLES, sizeof(LIGHT_INDICES) / sizeof(u32), GL_UNSIGNED_INT, 0);
+    {
+        PROFILE_SCOPE("Draw");
+        PROFILE_GPU_SCOPE("Draw");
+
+        // The window, or g_HeadlessTarget in headless runs. Cleared at the start of the frame.
+        BeginRenderGraph(g_RenderGraph);
+        u32 frameTarget = ImportRenderTarget(
+            g_RenderGraph,
+            "Frame",
+            g_Options.m_Headless ? g_HeadlessTarget.m_Id : 0,
+            snapshot.m_Width,
+            snapshot.m_Height
+        );
+
+        if (deferred)
+        {
+            GBuffer gbuffer = CreateGBufferTargets(g_RenderGraph, snapshot.m_Width, snapshot.m_Height);
+
+            const u32 geometryPass = AddRenderPass(g_RenderGraph, "GBuffer", [&snapshot](const RenderGraph& graph)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                DrawVisibleMeshes(snapshot, MeshPass::GBuffer);
+            });
+            WriteGBuffer(g_RenderGraph, geometryPass, gbuffer);
+
+            const u32 lightingPass = AddRenderPass(g_RenderGraph, "DeferredLighting", [&snapshot, gbuffer](
+                const RenderGraph& graph)
+            {
+                DrawDeferredLighting(graph, gbuffer, snapshot);
+            });
+            ReadGBuffer(g_RenderGraph, lightingPass, gbuffer);
+            frameTarget = WriteRenderTarget(g_RenderGraph, lightingPass, frameTarget);
+
+            const u32 forwardPass = AddRenderPass(g_RenderGraph, "Forward", [&snapshot](const RenderGraph& graph)
+            {
+                DrawVisibleMeshes(snapshot, MeshPass::Forward);
+            });
+            frameTarget = WriteRenderTarget(g_RenderGraph, forwardPass, frameTarget);
+        }
+        else
+        {
+            const u32 forwardPass = AddRenderPass(g_RenderGraph, "Forward", [&snapshot](const RenderGraph& graph)
+            {
+                DrawVisibleMeshes(snapshot, MeshPass::All);
+            });
+            frameTarget = WriteRenderTarget(g_RenderGraph, forwardPass, frameTarget);
+        }
 
-    glfwSwapBuffers(g_Window);
+        if (CompileRenderGraph(g_RenderGraph))
+        {
+            ExecuteRenderGraph(g_RenderGraph);
+        }
+        else if (deferred)
+        {
+            // The game thread switches to forward shading with the next snapshot it builds.
+            LOG_ERROR("Falling back to forward shading.");
+            g_DeferredFailed = true;
+        }
+    }
 
     UnbindVAO();
 }
 
+// Hands the frame to the driver. Kept out of Render() so its time, which includes waiting for vsync, is reported
+// on its own.
+static void PresentFrame()
+{
+    PROFILE_SCOPE("SwapBuffers");
+    METRIC_SCOPE(Metric::SwapBuffersTime);
+
+    // Headless frames stay in g_HeadlessTarget.
+    if (g_Window != nullptr)
+    {
+        const double swapStart = glfwGetTime();
+        glfwSwapBuffers(g_Window);
+        g_LastSwapTime = glfwGetTime() - swapStart;
+    }
+}
+
+// Renders and presents one snapshot, called on the render thread for every submitted frame.
+static void RenderFrame(const void* const frame)
+{
+    const RenderSnapshot& snapshot = *scast<const RenderSnapshot*>(frame);
+
+    // The swap interval belongs to the context, so it can only change here.
+    if (g_Window != nullptr && snapshot.m_PresentMode != g_AppliedPresentMode)
+    {
+        ApplyPresentMode(snapshot.m_PresentMode);
+        g_AppliedPresentMode = snapshot.m_PresentMode;
+    }
+
+    BeginProfilerGpuFrame(snapshot.m_ProfilerFrame);
+    Render(snapshot);
+    PresentFrame();
+    EndProfilerGpuFrame();
+}
+
+// Shows the frame statistics in the window title.
+static void UpdateFrameStats(const double now)
+{
+    if (g_Window == nullptr || now - g_LastFrameStatsTime < FRAME_STATS_INTERVAL)
+    {
+        return;
+    }
+
+    g_LastFrameStatsTime = now;
+
+    const FrameStats stats = GetFrameStats(g_FramePacer);
+
+    char title[256];
+    snprintf(
+        title,
+        sizeof(title),
+        "%s | %.0f FPS | %.2f ms (min %.2f, max %.2f, p99 %.2f) | work %.2f ms | %s%s",
+        WINDOW_TITLE,
+        stats.m_Fps,
+        stats.m_AverageMs,
+        stats.m_MinMs,
+        stats.m_MaxMs,
+        stats.m_P99Ms,
+        stats.m_AverageWorkMs,
+        GetPresentModeName(g_FramePacer.m_PresentMode),
+        g_FramePacer.m_TargetFrameTime > 0.0 ? " | limited" : ""
+    );
+    glfwSetWindowTitle(g_Window, title);
+}
+
 static void FreeResources()
 {
+    ShutdownProfiler();
+    ShutdownMetrics();
+    DestroyWorld(g_World);
+
+    // Initialization can fail before there is a context, e.g. on a bad --replay path.
+    if (!g_GLLoaded)
+    {
+        return;
+    }
+
+    DeleteFramebuffer(g_HeadlessTarget);
     DeleteVAO(g_VAO);
     DeleteEBO(g_EBO);
     DeleteVBO(g_VBO);
@@ -330,30 +1380,204 @@ static void FreeResources()
     DeleteEBO(g_LightVBO);
     DeleteVBO(g_LightEBO);
     DeleteShader(g_LightShader);
+    DeleteShader(g_GBufferShader);
+    DeleteShader(g_DeferredLightingShader);
+    DeleteVAO(g_FullscreenVAO);
+    DestroyRenderGraph(g_RenderGraph);
     DeleteTexture(g_Texture);
+    DeleteClusteredLighting(g_Lighting);
+    ShutdownCommandLists();
 }
 
-int main()
+// Compares the last headless frame with the golden image. The differences are saved to GOLDEN_DIFF_IMAGE if they
+// are over the tolerance.
+static bool CheckGoldenImage(const std::vector<u8>& pixels)
 {
+    std::vector<u8> golden;
+    i32 width = 0;
+    i32 height = 0;
+    if (!LoadImagePPM(g_Options.m_GoldenImage, golden, width, height))
+    {
+        return false;
+    }
+
+    if (width != g_HeadlessTarget.m_Width || height != g_HeadlessTarget.m_Height)
+    {
+        LOG_ERROR(
+            "The golden image is %dx%d, the frame is %dx%d.",
+            width,
+            height,
+            g_HeadlessTarget.m_Width,
+            g_HeadlessTarget.m_Height
+        );
+        return false;
+    }
+
+    const ImageTolerance tolerance = {};
+    std::vector<u8> diffImage;
+    const ImageDiff diff = CompareImages(golden.data(), pixels.data(), width, height, tolerance, &diffImage);
+    if (IsImageDiffWithinTolerance(diff, tolerance))
+    {
+        LOG_INFO(
+            "The frame matches \"%s\": %.3f%% of the pixels differ, max delta E %.2f.",
+            g_Options.m_GoldenImage,
+            diff.m_DifferentFraction * 100.0f,
+            diff.m_MaxDeltaE
+        );
+        return true;
+    }
+
+    LOG_ERROR(
+        "The frame doesn't match \"%s\": %.3f%% of the pixels differ (%.3f%% allowed), mean delta E %.2f, max %.2f.",
+        g_Options.m_GoldenImage,
+        diff.m_DifferentFraction * 100.0f,
+        tolerance.m_MaxDifferentFraction * 100.0f,
+        diff.m_MeanDeltaE,
+        diff.m_MaxDeltaE
+    );
+    if (SaveImagePPM(GOLDEN_DIFF_IMAGE, diffImage.data(), width, height))
+    {
+        LOG_ERROR("The differences are marked in \"%s\".", GOLDEN_DIFF_IMAGE);
+    }
+
+    return false;
+}
+
+// Saves the last headless frame, and checks it against the golden image or replaces the golden image with it.
+static bool FinishHeadlessRun()
+{
+    std::vector<u8> pixels;
+    if (!ReadFramebufferPixels(g_HeadlessTarget, pixels))
+    {
+        LOG_ERROR("Failed to read back the headless frame.");
+        return false;
+    }
+
+    const i32 width = g_HeadlessTarget.m_Width;
+    const i32 height = g_HeadlessTarget.m_Height;
+    if (!SaveImagePPM(g_Options.m_OutputImage, pixels.data(), width, height))
+    {
+        return false;
+    }
+
+    LOG_INFO("Saved the last frame to \"%s\".", g_Options.m_OutputImage);
+
+    if (g_Options.m_GoldenImage == nullptr)
+    {
+        return true;
+    }
+
+    if (g_Options.m_UpdateGolden)
+    {
+        if (!SaveImagePPM(g_Options.m_GoldenImage, pixels.data(), width, height))
+        {
+            return false;
+        }
+
+        LOG_INFO("Updated the golden image \"%s\".", g_Options.m_GoldenImage);
+        return true;
+    }
+
+    return CheckGoldenImage(pixels);
+}
+
+int main(int argc, char** argv)
+{
+    StartAsyncLogging();
+
     int exitCode = EXIT_SUCCESS;
 
-    if (const bool init = Initialize(); init)
+    if (!ParseLaunchOptions(argc, argv, g_Options))
     {
+        StopAsyncLogging();
+        return EXIT_FAILURE;
+    }
+
+    // The render thread draws the snapshots the game thread builds, see graphics/render_thread.h.
+    void* const snapshots[RENDER_SNAPSHOT_COUNT] = { &g_RenderSnapshots[0], &g_RenderSnapshots[1] };
+    const bool init = Initialize()
+        && StartRenderThread(g_RenderThread, RenderFrame, SetRenderContextCurrent, snapshots);
+    if (init)
+    {
+        const bool flythrough = g_Options.m_CameraPath != nullptr;
+        const bool fixedFrameCount = g_Options.m_Headless || flythrough || g_Options.m_ReplayInput != nullptr;
+
         double prevTime = glfwGetTime();
-        double currTime = prevTime;
-        double deltaTime = 0.0;
+        u32 frameIndex = 0;
 
-        while (!glfwWindowShouldClose(g_Window))
+        while (fixedFrameCount
+            ? frameIndex < g_Options.m_FrameCount && (g_Window == nullptr || !glfwWindowShouldClose(g_Window))
+            : !glfwWindowShouldClose(g_Window))
         {
-            currTime = glfwGetTime();
-            deltaTime = currTime - prevTime;
-            prevTime = currTime;
+            // The limiter waits before the input is sampled, so the input is as fresh as possible.
+            const double frameStart = WaitForNextFrame(g_FramePacer);
+            BeginProfilerFrame();
+            const double frameTime = frameStart - prevTime;
+            prevTime = frameStart;
+
+            // A flythrough advances exactly one tick per frame however long the frame took, so every run simulates
+            // and draws the same frames. A replay advances by the recorded frame times.
+            double simulationTime = flythrough ? g_Timestep.m_TickDuration : frameTime;
+            ProcessInput(frameIndex, simulationTime);
+
+            const u32 tickCount = AdvanceFixedTimestep(g_Timestep, simulationTime);
+            for (u32 tick = 0; tick < tickCount; ++tick)
+            {
+                Update(scast<float>(g_Timestep.m_TickDuration));
+            }
+
+            // Nothing is left to interpolate in a flythrough, the latest tick is drawn as is.
+            RenderSnapshot& snapshot = *scast<RenderSnapshot*>(AcquireRenderSnapshot(g_RenderThread));
+            BuildRenderSnapshot(snapshot, flythrough ? 1.0f : GetFixedTimestepAlpha(g_Timestep));
+
+            // The previous frame is drawn while this one was simulated. It finishes before the frame is closed, so
+            // the metrics and the frame arena of a frame are never touched by both threads.
+            const double renderWaitStart = glfwGetTime();
+            WaitForRenderThread(g_RenderThread);
+            const double renderWait = glfwGetTime() - renderWaitStart;
+
+            RunMainThreadJobs();
+
+            const u64 profilerFrame = GetProfilerFrameIndex();
+            EndProfilerFrame();
+            // The swap ends the render thread's frame, so the end of the wait is spent blocked in it, not working.
+            EndFrame(g_FramePacer, std::min(renderWait, g_LastSwapTime));
+            AdvanceFrameArena();
+            EndMetricsFrame(frameTime);
+            UpdateFrameStats(frameStart);
+
+            if (flythrough)
+            {
+                RecordFlythroughFrame(g_Flythrough, profilerFrame, GetFlythroughTime(), g_Camera.m_Position);
+                UpdateFlythroughGpuTimes(g_Flythrough);
+            }
+
+            SubmitRenderSnapshot(g_RenderThread);
+            frameIndex++;
+        }
+
+        // Draws the last frame and brings the context back for the readbacks.
+        StopRenderThread(g_RenderThread);
+        EndMetricsRenderFrame();
+        StopInputRecording(g_InputRecorder);
 
-            ProcessInput(scast<float>(deltaTime));
+        if (flythrough)
+        {
+            FinishFlythrough(g_Flythrough);
+            if (!SaveFlythroughCsv(g_Flythrough, g_Options.m_FlythroughCsv))
+            {
+                exitCode = EXIT_FAILURE;
+            }
+        }
 
-            Update(scast<float>(deltaTime));
+        if (g_Options.m_Headless && !FinishHeadlessRun())
+        {
+            exitCode = EXIT_FAILURE;
+        }
 
-            Render();
+        if (g_Options.m_Budgets != nullptr && !CheckMetricBudgets(g_Budgets))
+        {
+            exitCode = EXIT_FAILURE;
         }
     }
     else
@@ -363,9 +1587,16 @@ int main()
 
     LOG_INFO("Shutting down...");
 
+    DetachInputQueue(g_InputQueue);
+    ShutdownJobSystem();
+
     FreeResources();
+    ShutdownFrameArena();
+    DestroyHeadlessContext();
 
     glfwTerminate();
 
+    StopAsyncLogging();
+
     return exitCode;
 }
@@ -0,0 +1,89 @@
+#include "scene/bounds.h"
+
+#include <algorithm>
+#include <cmath>
+
+AABB ComputeAABB(const float* const vertices, const u32 vertexCount, const u32 stride)
+{
+    AABB result = {};
+
+    if (vertexCount == 0)
+    {
+        return result;
+    }
+
+    result.m_Min = glm::vec3(vertices[0], vertices[1], vertices[2]);
+    result.m_Max = result.m_Min;
+
+    for (u32 i = 1; i < vertexCount; ++i)
+    {
+        const float* const position = vertices + (i * stride);
+        const glm::vec3 p = glm::vec3(position[0], position[1], position[2]);
+        result.m_Min = glm::min(result.m_Min, p);
+        result.m_Max = glm::max(result.m_Max, p);
+    }
+
+    return result;
+}
+
+BoundingSphere ComputeBoundingSphere(const float* const vertices, const u32 vertexCount, const u32 stride)
+{
+    const AABB aabb = ComputeAABB(vertices, vertexCount, stride);
+
+    BoundingSphere result = {};
+    result.m_Center = (aabb.m_Min + aabb.m_Max) * 0.5f;
+
+    // The AABB center is not the optimal center, but the radius is exact for it, which is tighter than
+    // the half-diagonal of the box for most meshes.
+    float maxDistanceSq = 0.0f;
+    for (u32 i = 0; i < vertexCount; ++i)
+    {
+        const float* const position = vertices + (i * stride);
+        const glm::vec3 offset = glm::vec3(position[0], position[1], position[2]) - result.m_Center;
+        maxDistanceSq = std::max(maxDistanceSq, glm::dot(offset, offset));
+    }
+
+    result.m_Radius = std::sqrt(maxDistanceSq);
+
+    return result;
+}
+
+AABB TransformAABB(const AABB& aabb, const glm::mat4& transform)
+{
+    // Transform the center and project the extents onto the absolute rotation/scale basis
+    // (Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems 1990).
+    const glm::vec3 center = (aabb.m_Min + aabb.m_Max) * 0.5f;
+    const glm::vec3 extents = (aabb.m_Max - aabb.m_Min) * 0.5f;
+
+    const glm::vec3 newCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+    const glm::mat3 absBasis = glm::mat3(
+        glm::abs(glm::vec3(transform[0])),
+        glm::abs(glm::vec3(transform[1])),
+        glm::abs(glm::vec3(transform[2]))
+    );
+    const glm::vec3 newExtents = absBasis * extents;
+
+    const AABB result =
+    {
+        .m_Min = newCenter - newExtents,
+        .m_Max = newCenter + newExtents,
+    };
+
+    return result;
+}
+
+BoundingSphere TransformBoundingSphere(const BoundingSphere& sphere, const glm::mat4& transform)
+{
+    const float scaleX = glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0]));
+    const float scaleY = glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]));
+    const float scaleZ = glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]));
+    const float maxScale = std::sqrt(std::max(scaleX, std::max(scaleY, scaleZ)));
+
+    const BoundingSphere result =
+    {
+        .m_Center = glm::vec3(transform * glm::vec4(sphere.m_Center, 1.0f)),
+        .m_Radius = sphere.m_Radius * maxScale,
+    };
+
+    return result;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "common.h"
+
+// Axis-aligned bounding box.
+struct AABB
+{
+    glm::vec3 m_Min;
+    glm::vec3 m_Max;
+};
+
+struct BoundingSphere
+{
+    glm::vec3 m_Center;
+    float m_Radius;
+};
+
+// Computes the AABB of the positions in an interleaved vertex array.
+// The position is expected to be the first 3 floats of each vertex, `stride` is in floats.
+AABB ComputeAABB(const float* const vertices, const u32 vertexCount, const u32 stride);
+
+// Computes a bounding sphere centered on the AABB of the positions in an interleaved vertex array.
+BoundingSphere ComputeBoundingSphere(const float* const vertices, const u32 vertexCount, const u32 stride);
+
+// Transforms an AABB and returns the AABB enclosing the result.
+AABB TransformAABB(const AABB& aabb, const glm::mat4& transform);
+
+// Transforms a bounding sphere. Non-uniform scale grows the radius by the largest axis scale.
+BoundingSphere TransformBoundingSphere(const BoundingSphere& sphere, const glm::mat4& transform);
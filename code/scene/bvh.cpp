@@ -0,0 +1,620 @@
+#include "scene/bvh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+#include "core/jobs.h"
+
+constexpr u32 BVH_BIN_COUNT = 16;
+constexpr u32 BVH_MAX_LEAF_SIZE = 4;      // Leaves are never split below this many items.
+constexpr u32 BVH_FORCE_SPLIT_SIZE = 32;  // Leaves are always split above this many items, even if SAH disagrees.
+constexpr u32 BVH_MAX_DEPTH = 64;         // Bounds the traversal stacks.
+constexpr u32 BVH_PARALLEL_THRESHOLD = 4096; // Subtrees with more items than this are built on another thread.
+constexpr float BVH_TRAVERSAL_COST = 1.0f; // Relative to the cost of testing one item.
+constexpr u32 BVH_INSIDE_FLAG = 0x80000000u;
+
+struct BVHBuildContext
+{
+    BVH* m_BVH;
+    std::vector<glm::vec3> m_Centroids;
+    std::atomic<u32> m_NodesUsed;
+};
+
+struct BVHBin
+{
+    glm::vec3 m_Min = glm::vec3(FLT_MAX);
+    glm::vec3 m_Max = glm::vec3(-FLT_MAX);
+    u32 m_Count = 0;
+};
+
+static float BVHSurfaceArea(const glm::vec3& min, const glm::vec3& max)
+{
+    const glm::vec3 e = glm::max(max - min, glm::vec3(0.0f));
+    return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+static void ComputeBVHLeafBounds(BVH& bvh, BVHNode& node)
+{
+    node.m_Min = glm::vec3(FLT_MAX);
+    node.m_Max = glm::vec3(-FLT_MAX);
+
+    for (u32 i = 0; i < node.m_Count; ++i)
+    {
+        const AABB& bounds = bvh.m_ItemBounds[bvh.m_ItemIndices[node.m_LeftOrFirst + i]];
+        node.m_Min = glm::min(node.m_Min, bounds.m_Min);
+        node.m_Max = glm::max(node.m_Max, bounds.m_Max);
+    }
+}
+
+static void MakeBVHLeaf(BVH& bvh, const u32 nodeIndex)
+{
+    const BVHNode& node = bvh.m_Nodes[nodeIndex];
+    for (u32 i = 0; i < node.m_Count; ++i)
+    {
+        bvh.m_ItemLeaves[bvh.m_ItemIndices[node.m_LeftOrFirst + i]] = nodeIndex;
+    }
+}
+
+static void BuildBVHNode(BVHBuildContext& context, const u32 nodeIndex, const u32 depth)
+{
+    BVH& bvh = *context.m_BVH;
+    BVHNode& node = bvh.m_Nodes[nodeIndex];
+
+    ComputeBVHLeafBounds(bvh, node);
+
+    if (node.m_Count <= BVH_MAX_LEAF_SIZE || depth >= BVH_MAX_DEPTH - 1)
+    {
+        MakeBVHLeaf(bvh, nodeIndex);
+        return;
+    }
+
+    const u32 first = node.m_LeftOrFirst;
+    const u32 count = node.m_Count;
+
+    // SECTION: Find the cheapest split plane with binned SAH over the item centroids.
+    glm::vec3 centroidMin = glm::vec3(FLT_MAX);
+    glm::vec3 centroidMax = glm::vec3(-FLT_MAX);
+    for (u32 i = first; i < first + count; ++i)
+    {
+        const glm::vec3& centroid = context.m_Centroids[bvh.m_ItemIndices[i]];
+        centroidMin = glm::min(centroidMin, centroid);
+        centroidMax = glm::max(centroidMax, centroid);
+    }
+
+    float bestCost = FLT_MAX;
+    i32 bestAxis = -1;
+    u32 bestSplit = 0;
+
+    for (i32 axis = 0; axis < 3; ++axis)
+    {
+        const float extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.0f)
+        {
+            continue;
+        }
+
+        const float scale = BVH_BIN_COUNT / extent;
+
+        BVHBin bins[BVH_BIN_COUNT] = {};
+        for (u32 i = first; i < first + count; ++i)
+        {
+            const u32 item = bvh.m_ItemIndices[i];
+            const u32 bin = std::min(
+                BVH_BIN_COUNT - 1,
+                scast<u32>((context.m_Centroids[item][axis] - centroidMin[axis]) * scale)
+            );
+            bins[bin].m_Min = glm::min(bins[bin].m_Min, bvh.m_ItemBounds[item].m_Min);
+            bins[bin].m_Max = glm::max(bins[bin].m_Max, bvh.m_ItemBounds[item].m_Max);
+            bins[bin].m_Count++;
+        }
+
+        // Sweep from both sides to get the area and count left and right of every plane between bins.
+        float leftArea[BVH_BIN_COUNT - 1], rightArea[BVH_BIN_COUNT - 1];
+        u32 leftCount[BVH_BIN_COUNT - 1], rightCount[BVH_BIN_COUNT - 1];
+        BVHBin left = {}, right = {};
+        for (u32 i = 0; i < BVH_BIN_COUNT - 1; ++i)
+        {
+            left.m_Count += bins[i].m_Count;
+            left.m_Min = glm::min(left.m_Min, bins[i].m_Min);
+            left.m_Max = glm::max(left.m_Max, bins[i].m_Max);
+            leftCount[i] = left.m_Count;
+            leftArea[i] = BVHSurfaceArea(left.m_Min, left.m_Max);
+
+            const u32 j = BVH_BIN_COUNT - 1 - i;
+            right.m_Count += bins[j].m_Count;
+            right.m_Min = glm::min(right.m_Min, bins[j].m_Min);
+            right.m_Max = glm::max(right.m_Max, bins[j].m_Max);
+            rightCount[j - 1] = right.m_Count;
+            rightArea[j - 1] = BVHSurfaceArea(right.m_Min, right.m_Max);
+        }
+
+        for (u32 i = 0; i < BVH_BIN_COUNT - 1; ++i)
+        {
+            if (leftCount[i] == 0 || rightCount[i] == 0)
+            {
+                continue;
+            }
+
+            const float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = i;
+            }
+        }
+    }
+
+    const float nodeArea = BVHSurfaceArea(node.m_Min, node.m_Max);
+    const float leafCost = count * nodeArea;
+    const float splitCost = BVH_TRAVERSAL_COST * nodeArea + bestCost;
+
+    if (splitCost >= leafCost && count <= BVH_FORCE_SPLIT_SIZE)
+    {
+        MakeBVHLeaf(bvh, nodeIndex);
+        return;
+    }
+
+    // SECTION: Partition the items.
+    u32 leftCount = 0;
+    if (bestAxis >= 0)
+    {
+        const float scale = BVH_BIN_COUNT / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+        u32* const begin = bvh.m_ItemIndices.data() + first;
+        u32* const middle = std::partition(begin, begin + count, [&](const u32 item)
+        {
+            const u32 bin = std::min(
+                BVH_BIN_COUNT - 1,
+                scast<u32>((context.m_Centroids[item][bestAxis] - centroidMin[bestAxis]) * scale)
+            );
+            return bin <= bestSplit;
+        });
+        leftCount = scast<u32>(middle - begin);
+    }
+
+    if (leftCount == 0 || leftCount == count)
+    {
+        // All centroids coincide, any split is as good as another.
+        leftCount = count / 2;
+    }
+
+    const u32 leftIndex = context.m_NodesUsed.fetch_add(2);
+    const u32 rightIndex = leftIndex + 1;
+
+    BVHNode& leftNode = bvh.m_Nodes[leftIndex];
+    leftNode.m_LeftOrFirst = first;
+    leftNode.m_Count = leftCount;
+
+    BVHNode& rightNode = bvh.m_Nodes[rightIndex];
+    rightNode.m_LeftOrFirst = first + leftCount;
+    rightNode.m_Count = count - leftCount;
+
+    bvh.m_Parents[leftIndex] = nodeIndex;
+    bvh.m_Parents[rightIndex] = nodeIndex;
+
+    node.m_LeftOrFirst = leftIndex;
+    node.m_Count = 0;
+
+    // The children work on disjoint item ranges and allocate nodes atomically, so large subtrees can be
+    // built concurrently.
+    if (count > BVH_PARALLEL_THRESHOLD)
+    {
+        JobCounter leftBuild;
+        RunJob(
+            [&context, leftIndex, depth]() { BuildBVHNode(context, leftIndex, depth + 1); },
+            &leftBuild,
+            JobAffinity::Any
+        );
+        BuildBVHNode(context, rightIndex, depth + 1);
+        WaitForCounter(leftBuild);
+    }
+    else
+    {
+        BuildBVHNode(context, leftIndex, depth + 1);
+        BuildBVHNode(context, rightIndex, depth + 1);
+    }
+}
+
+void BuildBVH(BVH& bvh, const AABB* const bounds, const u32 count)
+{
+    bvh.m_ItemBounds.assign(bounds, bounds + count);
+    bvh.m_ItemIndices.resize(count);
+    std::iota(bvh.m_ItemIndices.begin(), bvh.m_ItemIndices.end(), 0);
+    bvh.m_ItemLeaves.assign(count, BVH_INVALID_INDEX);
+    bvh.m_DirtyLeaves.clear();
+
+    // A binary tree with N leaves has at most 2N - 1 nodes, plus the unused node 1.
+    const u32 maxNodes = std::max(2 * count, 2u);
+    bvh.m_Nodes.assign(maxNodes, BVHNode{});
+    bvh.m_Parents.assign(maxNodes, BVH_INVALID_INDEX);
+
+    if (count == 0)
+    {
+        bvh.m_NodeCount = 0;
+        bvh.m_Nodes.clear();
+        bvh.m_Parents.clear();
+        bvh.m_DirtyFlags.clear();
+        bvh.m_BuildCost = 0.0f;
+        return;
+    }
+
+    BVHBuildContext context = {};
+    context.m_BVH = &bvh;
+    context.m_Centroids.resize(count);
+    for (u32 i = 0; i < count; ++i)
+    {
+        context.m_Centroids[i] = (bounds[i].m_Min + bounds[i].m_Max) * 0.5f;
+    }
+    context.m_NodesUsed = 2;
+
+    BVHNode& root = bvh.m_Nodes[0];
+    root.m_LeftOrFirst = 0;
+    root.m_Count = count;
+
+    BuildBVHNode(context, 0, 0);
+
+    bvh.m_NodeCount = context.m_NodesUsed;
+    bvh.m_Nodes.resize(bvh.m_NodeCount);
+    bvh.m_Parents.resize(bvh.m_NodeCount);
+    bvh.m_DirtyFlags.assign(bvh.m_NodeCount, 0);
+    bvh.m_BuildCost = ComputeBVHCost(bvh);
+}
+
+void UpdateBVHItem(BVH& bvh, const u32 item, const AABB& bounds)
+{
+    bvh.m_ItemBounds[item] = bounds;
+
+    const u32 leaf = bvh.m_ItemLeaves[item];
+    if (!bvh.m_DirtyFlags[leaf])
+    {
+        bvh.m_DirtyFlags[leaf] = 1;
+        bvh.m_DirtyLeaves.push_back(leaf);
+    }
+}
+
+void RefitBVH(BVH& bvh)
+{
+    for (const u32 leaf : bvh.m_DirtyLeaves)
+    {
+        bvh.m_DirtyFlags[leaf] = 0;
+        ComputeBVHLeafBounds(bvh, bvh.m_Nodes[leaf]);
+
+        // Walk up until an ancestor's bounds don't change. Everything above it is still valid.
+        u32 nodeIndex = bvh.m_Parents[leaf];
+        while (nodeIndex != BVH_INVALID_INDEX)
+        {
+            BVHNode& node = bvh.m_Nodes[nodeIndex];
+            const BVHNode& left = bvh.m_Nodes[node.m_LeftOrFirst];
+            const BVHNode& right = bvh.m_Nodes[node.m_LeftOrFirst + 1];
+
+            const glm::vec3 newMin = glm::min(left.m_Min, right.m_Min);
+            const glm::vec3 newMax = glm::max(left.m_Max, right.m_Max);
+            if (newMin == node.m_Min && newMax == node.m_Max)
+            {
+                break;
+            }
+
+            node.m_Min = newMin;
+            node.m_Max = newMax;
+            nodeIndex = bvh.m_Parents[nodeIndex];
+        }
+    }
+
+    bvh.m_DirtyLeaves.clear();
+}
+
+float ComputeBVHCost(const BVH& bvh)
+{
+    if (bvh.m_NodeCount == 0)
+    {
+        return 0.0f;
+    }
+
+    const BVHNode& root = bvh.m_Nodes[0];
+    const float rootArea = BVHSurfaceArea(root.m_Min, root.m_Max);
+    if (rootArea <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    float cost = 0.0f;
+    for (u32 i = 0; i < bvh.m_NodeCount; ++i)
+    {
+        if (i == 1)
+        {
+            continue;
+        }
+
+        const BVHNode& node = bvh.m_Nodes[i];
+        const float area = BVHSurfaceArea(node.m_Min, node.m_Max);
+        cost += node.m_Count == 0 ? BVH_TRAVERSAL_COST * area : node.m_Count * area;
+    }
+
+    return cost / rootArea;
+}
+
+enum class BVHFrustumResult
+{
+    Outside,
+    Intersecting,
+    Inside
+};
+
+static BVHFrustumResult TestBVHNodeFrustum(const BVHNode& node, const Frustum& frustum)
+{
+    const glm::vec3 center = (node.m_Min + node.m_Max) * 0.5f;
+    const glm::vec3 extents = (node.m_Max - node.m_Min) * 0.5f;
+
+    BVHFrustumResult result = BVHFrustumResult::Inside;
+    for (const glm::vec4& plane : frustum.m_Planes)
+    {
+        const glm::vec3 normal = glm::vec3(plane);
+        const float distance = glm::dot(normal, center) + plane.w;
+        const float radius = glm::dot(glm::abs(normal), extents);
+
+        if (distance < -radius)
+        {
+            return BVHFrustumResult::Outside;
+        }
+
+        if (distance < radius)
+        {
+            result = BVHFrustumResult::Intersecting;
+        }
+    }
+
+    return result;
+}
+
+static void AppendBVHLeafItems(const BVH& bvh, const BVHNode& node, std::vector<u32>& outItems)
+{
+    outItems.insert(
+        outItems.end(),
+        bvh.m_ItemIndices.begin() + node.m_LeftOrFirst,
+        bvh.m_ItemIndices.begin() + node.m_LeftOrFirst + node.m_Count
+    );
+}
+
+void QueryBVHFrustum(const BVH& bvh, const Frustum& frustum, std::vector<u32>& outItems)
+{
+    if (bvh.m_NodeCount == 0)
+    {
+        return;
+    }
+
+    // Entries with BVH_INSIDE_FLAG set are entirely inside the frustum and need no further tests.
+    u32 stack[BVH_MAX_DEPTH + 1];
+    u32 stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const u32 entry = stack[--stackSize];
+        const BVHNode& node = bvh.m_Nodes[entry & ~BVH_INSIDE_FLAG];
+        u32 insideFlag = entry & BVH_INSIDE_FLAG;
+
+        if (!insideFlag)
+        {
+            const BVHFrustumResult result = TestBVHNodeFrustum(node, frustum);
+            if (result == BVHFrustumResult::Outside)
+            {
+                continue;
+            }
+
+            if (result == BVHFrustumResult::Inside)
+            {
+                insideFlag = BVH_INSIDE_FLAG;
+            }
+        }
+
+        if (node.m_Count > 0)
+        {
+            if (insideFlag)
+            {
+                AppendBVHLeafItems(bvh, node, outItems);
+            }
+            else
+            {
+                for (u32 i = 0; i < node.m_Count; ++i)
+                {
+                    const u32 item = bvh.m_ItemIndices[node.m_LeftOrFirst + i];
+                    const AABB& bounds = bvh.m_ItemBounds[item];
+                    const BVHNode itemNode = { bounds.m_Min, 0, bounds.m_Max, 1 };
+                    if (TestBVHNodeFrustum(itemNode, frustum) != BVHFrustumResult::Outside)
+                    {
+                        outItems.push_back(item);
+                    }
+                }
+            }
+        }
+        else
+        {
+            stack[stackSize++] = node.m_LeftOrFirst | insideFlag;
+            stack[stackSize++] = (node.m_LeftOrFirst + 1) | insideFlag;
+        }
+    }
+}
+
+static bool OverlapsBVHBox(const glm::vec3& min, const glm::vec3& max, const AABB& range)
+{
+    return glm::all(glm::lessThanEqual(min, range.m_Max)) && glm::all(glm::greaterThanEqual(max, range.m_Min));
+}
+
+static bool OverlapsBVHSphere(const glm::vec3& min, const glm::vec3& max, const BoundingSphere& range)
+{
+    const glm::vec3 closest = glm::clamp(range.m_Center, min, max);
+    const glm::vec3 offset = closest - range.m_Center;
+    return glm::dot(offset, offset) <= range.m_Radius * range.m_Radius;
+}
+
+template<typename OverlapFn>
+static void QueryBVHOverlap(const BVH& bvh, const OverlapFn& overlaps, std::vector<u32>& outItems)
+{
+    if (bvh.m_NodeCount == 0)
+    {
+        return;
+    }
+
+    u32 stack[BVH_MAX_DEPTH + 1];
+    u32 stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const BVHNode& node = bvh.m_Nodes[stack[--stackSize]];
+        if (!overlaps(node.m_Min, node.m_Max))
+        {
+            continue;
+        }
+
+        if (node.m_Count > 0)
+        {
+            for (u32 i = 0; i < node.m_Count; ++i)
+            {
+                const u32 item = bvh.m_ItemIndices[node.m_LeftOrFirst + i];
+                const AABB& bounds = bvh.m_ItemBounds[item];
+                if (overlaps(bounds.m_Min, bounds.m_Max))
+                {
+                    outItems.push_back(item);
+                }
+            }
+        }
+        else
+        {
+            stack[stackSize++] = node.m_LeftOrFirst;
+            stack[stackSize++] = node.m_LeftOrFirst + 1;
+        }
+    }
+}
+
+void QueryBVHRange(const BVH& bvh, const AABB& range, std::vector<u32>& outItems)
+{
+    QueryBVHOverlap(
+        bvh,
+        [&](const glm::vec3& min, const glm::vec3& max) { return OverlapsBVHBox(min, max, range); },
+        outItems
+    );
+}
+
+void QueryBVHRange(const BVH& bvh, const BoundingSphere& range, std::vector<u32>& outItems)
+{
+    QueryBVHOverlap(
+        bvh,
+        [&](const glm::vec3& min, const glm::vec3& max) { return OverlapsBVHSphere(min, max, range); },
+        outItems
+    );
+}
+
+// Returns the distance along the ray to the box, or FLT_MAX when it is missed.
+static float IntersectBVHRayBox(
+    const glm::vec3& origin,
+    const glm::vec3& invDirection,
+    const glm::vec3& min,
+    const glm::vec3& max,
+    const float maxDistance
+)
+{
+    float enter = 0.0f;
+    float exit = maxDistance;
+    for (u32 axis = 0; axis < 3; ++axis)
+    {
+        // Parallel to the slab: 0 * inf would be NaN when the origin is on one of its planes, so test it directly.
+        if (std::isinf(invDirection[axis]))
+        {
+            if (origin[axis] < min[axis] || origin[axis] > max[axis])
+            {
+                return FLT_MAX;
+            }
+            continue;
+        }
+
+        const float t0 = (min[axis] - origin[axis]) * invDirection[axis];
+        const float t1 = (max[axis] - origin[axis]) * invDirection[axis];
+        enter = std::max(enter, std::min(t0, t1));
+        exit = std::min(exit, std::max(t0, t1));
+    }
+
+    return enter <= exit ? enter : FLT_MAX;
+}
+
+BVHRayHit RaycastBVH(const BVH& bvh, const glm::vec3& origin, const glm::vec3& direction, const float maxDistance)
+{
+    BVHRayHit result = {};
+
+    if (bvh.m_NodeCount == 0)
+    {
+        return result;
+    }
+
+    const glm::vec3 invDirection = 1.0f / direction;
+    float closest = maxDistance;
+    bool hasHit = false;
+
+    u32 stack[BVH_MAX_DEPTH + 1];
+    u32 stackSize = 0;
+    if (IntersectBVHRayBox(origin, invDirection, bvh.m_Nodes[0].m_Min, bvh.m_Nodes[0].m_Max, closest) != FLT_MAX)
+    {
+        stack[stackSize++] = 0;
+    }
+
+    while (stackSize > 0)
+    {
+        const BVHNode& node = bvh.m_Nodes[stack[--stackSize]];
+
+        if (node.m_Count > 0)
+        {
+            for (u32 i = 0; i < node.m_Count; ++i)
+            {
+                const u32 item = bvh.m_ItemIndices[node.m_LeftOrFirst + i];
+                const AABB& bounds = bvh.m_ItemBounds[item];
+                const float distance = IntersectBVHRayBox(origin, invDirection, bounds.m_Min, bounds.m_Max, closest);
+                if (distance == FLT_MAX)
+                {
+                    continue;
+                }
+
+                // The first hit may lie exactly at maxDistance, later ones have to be strictly closer.
+                if (!hasHit || distance < closest)
+                {
+                    hasHit = true;
+                    closest = distance;
+                    result.m_Item = item;
+                    result.m_Distance = distance;
+                }
+            }
+
+            continue;
+        }
+
+        // Visit the nearer child first so the farther one is more likely to be rejected by the closest hit.
+        u32 nearIndex = node.m_LeftOrFirst;
+        u32 farIndex = node.m_LeftOrFirst + 1;
+        float nearDistance = IntersectBVHRayBox(
+            origin, invDirection, bvh.m_Nodes[nearIndex].m_Min, bvh.m_Nodes[nearIndex].m_Max, closest
+        );
+        float farDistance = IntersectBVHRayBox(
+            origin, invDirection, bvh.m_Nodes[farIndex].m_Min, bvh.m_Nodes[farIndex].m_Max, closest
+        );
+
+        if (farDistance < nearDistance)
+        {
+            std::swap(nearIndex, farIndex);
+            std::swap(nearDistance, farDistance);
+        }
+
+        if (farDistance != FLT_MAX)
+        {
+            stack[stackSize++] = farIndex;
+        }
+
+        if (nearDistance != FLT_MAX)
+        {
+            stack[stackSize++] = nearIndex;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <new>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "common.h"
+#include "scene/bounds.h"
+#include "scene/frustum.h"
+
+// A 32 byte node. Siblings are allocated as an adjacent pair starting on an even index, so both children of a
+// node share one 64 byte cache line and a traversal step touches a single line.
+struct alignas(32) BVHNode
+{
+    glm::vec3 m_Min;
+    u32 m_LeftOrFirst; // Index of the left child (the right child is m_LeftOrFirst + 1) or of the first item for leaves.
+    glm::vec3 m_Max;
+    u32 m_Count;       // Number of items in a leaf, 0 for interior nodes.
+};
+
+static_assert(sizeof(BVHNode) == 32, "Two BVH nodes must fit in one cache line.");
+
+constexpr u32 BVH_INVALID_INDEX = ~0u;
+constexpr size_t BVH_CACHE_LINE_SIZE = 64;
+
+// Standard allocator starting every allocation on a cache line. std::allocator only aligns to alignof(BVHNode), which
+// would let the sibling pairs straddle two lines.
+template<typename T>
+struct CacheLineAllocator
+{
+    using value_type = T;
+
+    CacheLineAllocator() = default;
+
+    template<typename U>
+    CacheLineAllocator(const CacheLineAllocator<U>&) {}
+
+    T* allocate(const size_t count)
+    {
+        return scast<T*>(::operator new(sizeof(T) * count, std::align_val_t(BVH_CACHE_LINE_SIZE)));
+    }
+
+    void deallocate(T* const pointer, const size_t)
+    {
+        ::operator delete(pointer, std::align_val_t(BVH_CACHE_LINE_SIZE));
+    }
+
+    template<typename U>
+    bool operator==(const CacheLineAllocator<U>&) const { return true; }
+};
+
+// Bounding volume hierarchy over a set of items identified by index, built with the surface area heuristic.
+// Moving items are handled by refitting the bounds of the affected nodes; rebuild when the tree quality
+// (see ComputeBVHCost()) has degraded too much.
+struct BVH
+{
+    // Node 0 is the root, node 1 is unused so the sibling pairs start on a cache line.
+    std::vector<BVHNode, CacheLineAllocator<BVHNode>> m_Nodes;
+    std::vector<u32> m_Parents;    // Parent of each node, for refitting.
+    std::vector<u32> m_ItemIndices; // Leaves reference ranges of this array.
+    std::vector<AABB> m_ItemBounds; // Indexed by item.
+    std::vector<u32> m_ItemLeaves;  // Leaf containing each item.
+    std::vector<u32> m_DirtyLeaves;
+    std::vector<u8> m_DirtyFlags;   // Per node, set for the nodes in m_DirtyLeaves.
+    u32 m_NodeCount = 0;
+    float m_BuildCost = 0.0f;       // SAH cost right after the last build.
+};
+
+struct BVHRayHit
+{
+    u32 m_Item = BVH_INVALID_INDEX;
+    float m_Distance = 0.0f;
+};
+
+// Builds the hierarchy from scratch over `count` items. Large subtrees are built in parallel.
+void BuildBVH(BVH& bvh, const AABB* const bounds, const u32 count);
+
+// Sets the bounds of an item. The tree is not updated until RefitBVH() is called.
+void UpdateBVHItem(BVH& bvh, const u32 item, const AABB& bounds);
+
+// Refits the bounds of the leaves of all items updated since the last refit and of their ancestors.
+void RefitBVH(BVH& bvh);
+
+// Returns the SAH cost of the tree. Compare with `m_BuildCost` to decide when to rebuild.
+float ComputeBVHCost(const BVH& bvh);
+
+// Appends the items whose bounds intersect the frustum to `outItems`.
+void QueryBVHFrustum(const BVH& bvh, const Frustum& frustum, std::vector<u32>& outItems);
+
+// Appends the items whose bounds overlap the box to `outItems`.
+void QueryBVHRange(const BVH& bvh, const AABB& range, std::vector<u32>& outItems);
+
+// Appends the items whose bounds overlap the sphere to `outItems`.
+void QueryBVHRange(const BVH& bvh, const BoundingSphere& range, std::vector<u32>& outItems);
+
+// Returns the closest item whose bounds are hit by the ray, or an invalid hit.
+BVHRayHit RaycastBVH(const BVH& bvh, const glm::vec3& origin, const glm::vec3& direction, const float maxDistance);
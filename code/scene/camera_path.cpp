@@ -0,0 +1,136 @@
+#include "scene/camera_path.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <glm/gtc/constants.hpp>
+
+constexpr u32 CAMERA_ORBIT_KEY_COUNT = 16;
+
+bool LoadCameraPath(const char* const fileName, CameraPath& outPath)
+{
+    std::ifstream in(fileName);
+    if (!in)
+    {
+        LOG_ERROR("Failed to open camera path: %s.", fileName);
+        return false;
+    }
+
+    outPath.m_Keys.clear();
+
+    std::string line;
+    for (u32 lineNumber = 1; std::getline(in, line); ++lineNumber)
+    {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+
+        CameraPathKey key = {};
+        std::istringstream fields(line);
+        if (!(fields
+            >> key.m_Time
+            >> key.m_Position.x >> key.m_Position.y >> key.m_Position.z
+            >> key.m_Target.x >> key.m_Target.y >> key.m_Target.z))
+        {
+            LOG_ERROR("%s(%u): Expected \"time x y z targetX targetY targetZ\".", fileName, lineNumber);
+            return false;
+        }
+
+        if (!outPath.m_Keys.empty() && key.m_Time <= outPath.m_Keys.back().m_Time)
+        {
+            LOG_ERROR("%s(%u): Key times must be ascending.", fileName, lineNumber);
+            return false;
+        }
+
+        outPath.m_Keys.push_back(key);
+    }
+
+    if (outPath.m_Keys.empty())
+    {
+        LOG_ERROR("Camera path has no keys: %s.", fileName);
+        return false;
+    }
+
+    return true;
+}
+
+CameraPath CreateOrbitCameraPath(const float radius, const float height, const float duration)
+{
+    CameraPath result = {};
+    result.m_Keys.reserve(CAMERA_ORBIT_KEY_COUNT + 1);
+
+    for (u32 i = 0; i <= CAMERA_ORBIT_KEY_COUNT; ++i)
+    {
+        const float t = scast<float>(i) / CAMERA_ORBIT_KEY_COUNT;
+        const float angle = t * glm::two_pi<float>();
+
+        CameraPathKey key = {};
+        key.m_Time = t * duration;
+        key.m_Position = glm::vec3(glm::sin(angle) * radius, height, glm::cos(angle) * radius);
+        key.m_Target = glm::vec3(0.0f);
+        result.m_Keys.push_back(key);
+    }
+
+    return result;
+}
+
+float GetCameraPathDuration(const CameraPath& path)
+{
+    return path.m_Keys.empty() ? 0.0f : path.m_Keys.back().m_Time - path.m_Keys.front().m_Time;
+}
+
+static glm::vec3 CatmullRom(
+    const glm::vec3& p0,
+    const glm::vec3& p1,
+    const glm::vec3& p2,
+    const glm::vec3& p3,
+    const float t)
+{
+    const float t2 = t * t;
+    const float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1)
+        + (p2 - p0) * t
+        + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2
+        + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+void SampleCameraPath(const CameraPath& path, const float time, glm::vec3& outPosition, glm::vec3& outOrientation)
+{
+    const std::vector<CameraPathKey>& keys = path.m_Keys;
+    if (keys.empty())
+    {
+        return;
+    }
+
+    // Find the segment [i, i + 1] that contains the time.
+    const u32 last = scast<u32>(keys.size()) - 1;
+    u32 i = 0;
+    while (i < last && keys[i + 1].m_Time <= time)
+    {
+        ++i;
+    }
+
+    glm::vec3 target = keys[i].m_Target;
+    outPosition = keys[i].m_Position;
+    if (i < last && time > keys[i].m_Time)
+    {
+        // The end keys are repeated as the outer control points.
+        const CameraPathKey& k0 = keys[i > 0 ? i - 1 : 0];
+        const CameraPathKey& k1 = keys[i];
+        const CameraPathKey& k2 = keys[i + 1];
+        const CameraPathKey& k3 = keys[i + 1 < last ? i + 2 : last];
+        const float t = (time - k1.m_Time) / (k2.m_Time - k1.m_Time);
+
+        outPosition = CatmullRom(k0.m_Position, k1.m_Position, k2.m_Position, k3.m_Position, t);
+        target = CatmullRom(k0.m_Target, k1.m_Target, k2.m_Target, k3.m_Target, t);
+    }
+
+    const glm::vec3 direction = target - outPosition;
+    if (glm::dot(direction, direction) > 1e-8f)
+    {
+        outOrientation = glm::normalize(direction);
+    }
+}
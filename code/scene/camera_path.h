@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "common.h"
+
+// Scripted camera movement for reproducible runs. The keys are passed through by a Catmull-Rom spline, so the
+// camera moves smoothly without the keys having to be authored with tangents.
+struct CameraPathKey
+{
+    float m_Time;         // Seconds, ascending. The path starts at the first key, not necessarily at 0.
+    glm::vec3 m_Position;
+    glm::vec3 m_Target;   // Point the camera looks at.
+};
+
+struct CameraPath
+{
+    std::vector<CameraPathKey> m_Keys;
+};
+
+// Loads a path from a text file with one key per line: "time x y z targetX targetY targetZ". Empty lines and lines
+// starting with '#' are skipped.
+bool LoadCameraPath(const char* const fileName, CameraPath& outPath);
+
+// Built-in path circling the origin once in `duration` seconds.
+CameraPath CreateOrbitCameraPath(const float radius, const float height, const float duration);
+
+// Seconds from the first to the last key.
+float GetCameraPathDuration(const CameraPath& path);
+
+// Position and view direction at `time`, clamped to the ends of the path.
+void SampleCameraPath(const CameraPath& path, const float time, glm::vec3& outPosition, glm::vec3& outOrientation);
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "common.h"
+#include "geometry/mesh.h"
+#include "graphics/clustered_lighting.h"
+#include "scene/bounds.h"
+
+// Components of the scene entities. See ecs/ecs.h.
+
+struct NameComponent
+{
+    const char* m_Name;
+};
+
+// Links an entity to its node in the transform hierarchy.
+struct TransformComponent
+{
+    u32 m_Node;
+};
+
+// A mesh drawn by Render(). The LODs are ranges of the index buffer bound to the VAO, see geometry/mesh.h.
+struct MeshComponent
+{
+    u32 m_VAO;
+    u32 m_Shader;
+    const MeshLOD* m_LODs; // Points at mesh data that outlives the entity.
+    u32 m_LODCount;
+    u32 m_CurrentLOD;
+    bool m_Textured;
+};
+
+// Local space bounds of the mesh and the index of the entity in the culling set and the scene BVH.
+struct BoundsComponent
+{
+    AABB m_Local;
+    BoundingSphere m_LocalSphere;
+    u32 m_CullingIndex;
+};
+
+// A point light at the position of the entity. m_Light.m_Position is filled in from the transform every frame.
+struct LightComponent
+{
+    PointLight m_Light;
+};
+
+// Moves the entity on a horizontal circle around m_Center, driven by the simulation time.
+struct OrbitComponent
+{
+    glm::vec3 m_Center;
+    float m_Radius;
+    float m_Speed; // Radians per second.
+    float m_Phase;
+};
+
+// Geometry rasterized into the software occlusion buffer. Points at mesh data that outlives the entity.
+struct OccluderComponent
+{
+    const float* m_Vertices;
+    u32 m_Stride; // In floats.
+    const u32* m_Indices;
+    u32 m_IndexCount;
+};
@@ -0,0 +1,297 @@
+#include "scene/culling.h"
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX__)
+#define O3D_CULLING_AVX 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define O3D_CULLING_SSE 1
+#include <emmintrin.h>
+#endif
+
+#include "core/frame_arena.h"
+#include "core/jobs.h"
+#include "core/profiler.h"
+
+static void GrowCullingSet(CullingSet& set)
+{
+    const size_t newSize = set.m_SphereX.size() + CULLING_BATCH_SIZE;
+
+    set.m_SphereX.resize(newSize, 0.0f);
+    set.m_SphereY.resize(newSize, 0.0f);
+    set.m_SphereZ.resize(newSize, 0.0f);
+    set.m_SphereRadius.resize(newSize, 0.0f);
+    set.m_BoxCenterX.resize(newSize, 0.0f);
+    set.m_BoxCenterY.resize(newSize, 0.0f);
+    set.m_BoxCenterZ.resize(newSize, 0.0f);
+    set.m_BoxExtentX.resize(newSize, 0.0f);
+    set.m_BoxExtentY.resize(newSize, 0.0f);
+    set.m_BoxExtentZ.resize(newSize, 0.0f);
+}
+
+u32 AddCullable(CullingSet& set, const AABB& bounds, const BoundingSphere& sphere)
+{
+    if (set.m_Count == set.m_SphereX.size())
+    {
+        GrowCullingSet(set);
+    }
+
+    const u32 result = set.m_Count++;
+    SetCullableBounds(set, result, bounds, sphere);
+
+    return result;
+}
+
+void SetCullableBounds(CullingSet& set, const u32 index, const AABB& bounds, const BoundingSphere& sphere)
+{
+    const glm::vec3 center = (bounds.m_Min + bounds.m_Max) * 0.5f;
+    const glm::vec3 extents = (bounds.m_Max - bounds.m_Min) * 0.5f;
+
+    set.m_SphereX[index] = sphere.m_Center.x;
+    set.m_SphereY[index] = sphere.m_Center.y;
+    set.m_SphereZ[index] = sphere.m_Center.z;
+    set.m_SphereRadius[index] = sphere.m_Radius;
+    set.m_BoxCenterX[index] = center.x;
+    set.m_BoxCenterY[index] = center.y;
+    set.m_BoxCenterZ[index] = center.z;
+    set.m_BoxExtentX[index] = extents.x;
+    set.m_BoxExtentY[index] = extents.y;
+    set.m_BoxExtentZ[index] = extents.z;
+}
+
+void ClearCullingSet(CullingSet& set)
+{
+    set.m_Count = 0;
+}
+
+// Returns a bit mask with one bit set for every lane of the batch starting at `batchStart` that is in range.
+static u32 CullingLaneMask(const u32 batchStart, const u32 end, const u32 batchSize)
+{
+    const u32 remaining = end - batchStart;
+    return remaining >= batchSize ? ((1u << batchSize) - 1) : ((1u << remaining) - 1);
+}
+
+// Appends `batchStart + lane` to `outVisible` for every bit set in `mask`. Returns the new visible count.
+static u32 CompactVisibleBatch(u32 mask, const u32 batchStart, u32* const outVisible, u32 visibleCount)
+{
+    while (mask != 0)
+    {
+        outVisible[visibleCount++] = batchStart + std::countr_zero(mask);
+        mask &= mask - 1;
+    }
+
+    return visibleCount;
+}
+
+u32 CullFrustumRange(
+    const CullingSet& set,
+    const Frustum& frustum,
+    const u32 first,
+    const u32 count,
+    u32* const outVisible
+)
+{
+    constexpr u32 planeCount = scast<u32>(FrustumPlane::Count);
+
+    const u32 end = first + count;
+    u32 visibleCount = 0;
+
+    // An object is visible when both its sphere and its box are on the inner side of every plane.
+    // The box is tested as a center/extents pair: its projected radius onto the plane normal is
+    // |n.x| * e.x + |n.y| * e.y + |n.z| * e.z.
+#if O3D_CULLING_AVX
+    constexpr u32 batchSize = 8;
+
+    __m256 planeX[planeCount], planeY[planeCount], planeZ[planeCount], planeW[planeCount];
+    __m256 absPlaneX[planeCount], absPlaneY[planeCount], absPlaneZ[planeCount];
+    for (u32 p = 0; p < planeCount; ++p)
+    {
+        const glm::vec4& plane = frustum.m_Planes[p];
+        planeX[p] = _mm256_set1_ps(plane.x);
+        planeY[p] = _mm256_set1_ps(plane.y);
+        planeZ[p] = _mm256_set1_ps(plane.z);
+        planeW[p] = _mm256_set1_ps(plane.w);
+        absPlaneX[p] = _mm256_set1_ps(std::abs(plane.x));
+        absPlaneY[p] = _mm256_set1_ps(std::abs(plane.y));
+        absPlaneZ[p] = _mm256_set1_ps(std::abs(plane.z));
+    }
+
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (u32 i = first; i < end; i += batchSize)
+    {
+        const __m256 sphereX = _mm256_loadu_ps(&set.m_SphereX[i]);
+        const __m256 sphereY = _mm256_loadu_ps(&set.m_SphereY[i]);
+        const __m256 sphereZ = _mm256_loadu_ps(&set.m_SphereZ[i]);
+        const __m256 sphereRadius = _mm256_loadu_ps(&set.m_SphereRadius[i]);
+        const __m256 boxX = _mm256_loadu_ps(&set.m_BoxCenterX[i]);
+        const __m256 boxY = _mm256_loadu_ps(&set.m_BoxCenterY[i]);
+        const __m256 boxZ = _mm256_loadu_ps(&set.m_BoxCenterZ[i]);
+        const __m256 extentX = _mm256_loadu_ps(&set.m_BoxExtentX[i]);
+        const __m256 extentY = _mm256_loadu_ps(&set.m_BoxExtentY[i]);
+        const __m256 extentZ = _mm256_loadu_ps(&set.m_BoxExtentZ[i]);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (u32 p = 0; p < planeCount; ++p)
+        {
+            __m256 sphereDist = _mm256_add_ps(_mm256_mul_ps(sphereX, planeX[p]), planeW[p]);
+            sphereDist = _mm256_add_ps(sphereDist, _mm256_mul_ps(sphereY, planeY[p]));
+            sphereDist = _mm256_add_ps(sphereDist, _mm256_mul_ps(sphereZ, planeZ[p]));
+            sphereDist = _mm256_add_ps(sphereDist, sphereRadius);
+
+            __m256 boxDist = _mm256_add_ps(_mm256_mul_ps(boxX, planeX[p]), planeW[p]);
+            boxDist = _mm256_add_ps(boxDist, _mm256_mul_ps(boxY, planeY[p]));
+            boxDist = _mm256_add_ps(boxDist, _mm256_mul_ps(boxZ, planeZ[p]));
+            boxDist = _mm256_add_ps(boxDist, _mm256_mul_ps(extentX, absPlaneX[p]));
+            boxDist = _mm256_add_ps(boxDist, _mm256_mul_ps(extentY, absPlaneY[p]));
+            boxDist = _mm256_add_ps(boxDist, _mm256_mul_ps(extentZ, absPlaneZ[p]));
+
+            const __m256 insidePlane = _mm256_and_ps(
+                _mm256_cmp_ps(sphereDist, zero, _CMP_GE_OQ),
+                _mm256_cmp_ps(boxDist, zero, _CMP_GE_OQ)
+            );
+            inside = _mm256_and_ps(inside, insidePlane);
+
+            if (_mm256_movemask_ps(inside) == 0)
+            {
+                break;
+            }
+        }
+
+        const u32 mask = scast<u32>(_mm256_movemask_ps(inside)) & CullingLaneMask(i, end, batchSize);
+        visibleCount = CompactVisibleBatch(mask, i, outVisible, visibleCount);
+    }
+#elif O3D_CULLING_SSE
+    constexpr u32 batchSize = 4;
+
+    __m128 planeX[planeCount], planeY[planeCount], planeZ[planeCount], planeW[planeCount];
+    __m128 absPlaneX[planeCount], absPlaneY[planeCount], absPlaneZ[planeCount];
+    for (u32 p = 0; p < planeCount; ++p)
+    {
+        const glm::vec4& plane = frustum.m_Planes[p];
+        planeX[p] = _mm_set1_ps(plane.x);
+        planeY[p] = _mm_set1_ps(plane.y);
+        planeZ[p] = _mm_set1_ps(plane.z);
+        planeW[p] = _mm_set1_ps(plane.w);
+        absPlaneX[p] = _mm_set1_ps(std::abs(plane.x));
+        absPlaneY[p] = _mm_set1_ps(std::abs(plane.y));
+        absPlaneZ[p] = _mm_set1_ps(std::abs(plane.z));
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+
+    for (u32 i = first; i < end; i += batchSize)
+    {
+        const __m128 sphereX = _mm_loadu_ps(&set.m_SphereX[i]);
+        const __m128 sphereY = _mm_loadu_ps(&set.m_SphereY[i]);
+        const __m128 sphereZ = _mm_loadu_ps(&set.m_SphereZ[i]);
+        const __m128 sphereRadius = _mm_loadu_ps(&set.m_SphereRadius[i]);
+        const __m128 boxX = _mm_loadu_ps(&set.m_BoxCenterX[i]);
+        const __m128 boxY = _mm_loadu_ps(&set.m_BoxCenterY[i]);
+        const __m128 boxZ = _mm_loadu_ps(&set.m_BoxCenterZ[i]);
+        const __m128 extentX = _mm_loadu_ps(&set.m_BoxExtentX[i]);
+        const __m128 extentY = _mm_loadu_ps(&set.m_BoxExtentY[i]);
+        const __m128 extentZ = _mm_loadu_ps(&set.m_BoxExtentZ[i]);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for (u32 p = 0; p < planeCount; ++p)
+        {
+            __m128 sphereDist = _mm_add_ps(_mm_mul_ps(sphereX, planeX[p]), planeW[p]);
+            sphereDist = _mm_add_ps(sphereDist, _mm_mul_ps(sphereY, planeY[p]));
+            sphereDist = _mm_add_ps(sphereDist, _mm_mul_ps(sphereZ, planeZ[p]));
+            sphereDist = _mm_add_ps(sphereDist, sphereRadius);
+
+            __m128 boxDist = _mm_add_ps(_mm_mul_ps(boxX, planeX[p]), planeW[p]);
+            boxDist = _mm_add_ps(boxDist, _mm_mul_ps(boxY, planeY[p]));
+            boxDist = _mm_add_ps(boxDist, _mm_mul_ps(boxZ, planeZ[p]));
+            boxDist = _mm_add_ps(boxDist, _mm_mul_ps(extentX, absPlaneX[p]));
+            boxDist = _mm_add_ps(boxDist, _mm_mul_ps(extentY, absPlaneY[p]));
+            boxDist = _mm_add_ps(boxDist, _mm_mul_ps(extentZ, absPlaneZ[p]));
+
+            const __m128 insidePlane = _mm_and_ps(
+                _mm_cmpge_ps(sphereDist, zero),
+                _mm_cmpge_ps(boxDist, zero)
+            );
+            inside = _mm_and_ps(inside, insidePlane);
+
+            if (_mm_movemask_ps(inside) == 0)
+            {
+                break;
+            }
+        }
+
+        const u32 mask = scast<u32>(_mm_movemask_ps(inside)) & CullingLaneMask(i, end, batchSize);
+        visibleCount = CompactVisibleBatch(mask, i, outVisible, visibleCount);
+    }
+#else
+    for (u32 i = first; i < end; ++i)
+    {
+        bool inside = true;
+
+        for (u32 p = 0; p < planeCount && inside; ++p)
+        {
+            const glm::vec4& plane = frustum.m_Planes[p];
+
+            const float sphereDist = set.m_SphereX[i] * plane.x + set.m_SphereY[i] * plane.y
+                + set.m_SphereZ[i] * plane.z + plane.w + set.m_SphereRadius[i];
+
+            const float boxDist = set.m_BoxCenterX[i] * plane.x + set.m_BoxCenterY[i] * plane.y
+                + set.m_BoxCenterZ[i] * plane.z + plane.w
+                + set.m_BoxExtentX[i] * std::abs(plane.x)
+                + set.m_BoxExtentY[i] * std::abs(plane.y)
+                + set.m_BoxExtentZ[i] * std::abs(plane.z);
+
+            inside = sphereDist >= 0.0f && boxDist >= 0.0f;
+        }
+
+        if (inside)
+        {
+            outVisible[visibleCount++] = i;
+        }
+    }
+#endif
+
+    return visibleCount;
+}
+
+u32 CullFrustum(const CullingSet& set, const Frustum& frustum, u32* const outVisible)
+{
+    return CullFrustumRange(set, frustum, 0, set.m_Count, outVisible);
+}
+
+u32 CullFrustumParallel(const CullingSet& set, const Frustum& frustum, u32* const outVisible)
+{
+    static_assert(CULLING_PARALLEL_BATCH_SIZE % CULLING_BATCH_SIZE == 0);
+
+    if (set.m_Count <= CULLING_PARALLEL_BATCH_SIZE)
+    {
+        return CullFrustum(set, frustum, outVisible);
+    }
+
+    // Every range writes its visible indices to its own slice of the output, then the slices are packed in order.
+    FrameVector<u32> rangeVisibleCounts((set.m_Count + CULLING_PARALLEL_BATCH_SIZE - 1) / CULLING_PARALLEL_BATCH_SIZE, 0);
+    ParallelFor(set.m_Count, CULLING_PARALLEL_BATCH_SIZE, [&](const u32 begin, const u32 end)
+    {
+        PROFILE_SCOPE("CullFrustumRange");
+        rangeVisibleCounts[begin / CULLING_PARALLEL_BATCH_SIZE] =
+            CullFrustumRange(set, frustum, begin, end - begin, outVisible + begin);
+    });
+
+    u32 visibleCount = 0;
+    for (u32 range = 0; range < rangeVisibleCounts.size(); ++range)
+    {
+        const u32* const rangeVisible = outVisible + range * CULLING_PARALLEL_BATCH_SIZE;
+        if (rangeVisible != outVisible + visibleCount)
+        {
+            std::memmove(outVisible + visibleCount, rangeVisible, rangeVisibleCounts[range] * sizeof(u32));
+        }
+        visibleCount += rangeVisibleCounts[range];
+    }
+
+    return visibleCount;
+}
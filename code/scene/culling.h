@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include "common.h"
+#include "scene/bounds.h"
+#include "scene/frustum.h"
+
+// Number of objects tested per batch. The arrays of a culling set are padded to a multiple of this so the
+// SIMD path never has to special case the tail.
+constexpr u32 CULLING_BATCH_SIZE = 8;
+
+// Number of objects per job when culling on the job system.
+constexpr u32 CULLING_PARALLEL_BATCH_SIZE = 4096;
+
+// World space bounds of a set of objects in structure-of-arrays layout, so a batch of objects can be tested
+// against a plane with a handful of SIMD instructions.
+struct CullingSet
+{
+    std::vector<float> m_SphereX;
+    std::vector<float> m_SphereY;
+    std::vector<float> m_SphereZ;
+    std::vector<float> m_SphereRadius;
+
+    std::vector<float> m_BoxCenterX;
+    std::vector<float> m_BoxCenterY;
+    std::vector<float> m_BoxCenterZ;
+    std::vector<float> m_BoxExtentX;
+    std::vector<float> m_BoxExtentY;
+    std::vector<float> m_BoxExtentZ;
+
+    u32 m_Count = 0;
+};
+
+// Adds an object to the culling set and returns its index.
+u32 AddCullable(CullingSet& set, const AABB& bounds, const BoundingSphere& sphere);
+
+// Updates the world space bounds of an object, e.g. after it moved.
+void SetCullableBounds(CullingSet& set, const u32 index, const AABB& bounds, const BoundingSphere& sphere);
+
+// Removes all objects from the culling set, keeping the allocated memory.
+void ClearCullingSet(CullingSet& set);
+
+// Tests the objects in [first, first + count) against the frustum and writes the indices of the visible
+// ones to `outVisible` in ascending order. Returns the number of visible objects.
+// `first` must be a multiple of CULLING_BATCH_SIZE and `outVisible` must have room for `count` indices.
+u32 CullFrustumRange(
+    const CullingSet& set,
+    const Frustum& frustum,
+    const u32 first,
+    const u32 count,
+    u32* const outVisible
+);
+
+// Tests every object in the set against the frustum. See CullFrustumRange().
+u32 CullFrustum(const CullingSet& set, const Frustum& frustum, u32* const outVisible);
+
+// Same as CullFrustum() but large sets are split into CULLING_PARALLEL_BATCH_SIZE ranges culled on the job system.
+// The result is identical to CullFrustum().
+u32 CullFrustumParallel(const CullingSet& set, const Frustum& frustum, u32* const outVisible);
@@ -0,0 +1,26 @@
+#include "scene/frustum.h"
+
+Frustum ExtractFrustumPlanes(const glm::mat4& viewProjection)
+{
+    // Gribb & Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix".
+    // GLM matrices are column major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i]).
+    const glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+    const glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+    const glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+    const glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+    Frustum result = {};
+    result.m_Planes[scast<u32>(FrustumPlane::Left)] = row3 + row0;
+    result.m_Planes[scast<u32>(FrustumPlane::Right)] = row3 - row0;
+    result.m_Planes[scast<u32>(FrustumPlane::Bottom)] = row3 + row1;
+    result.m_Planes[scast<u32>(FrustumPlane::Top)] = row3 - row1;
+    result.m_Planes[scast<u32>(FrustumPlane::Near)] = row3 + row2; // OpenGL clip space z is in [-w, w].
+    result.m_Planes[scast<u32>(FrustumPlane::Far)] = row3 - row2;
+
+    for (glm::vec4& plane : result.m_Planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    return result;
+}
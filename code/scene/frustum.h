@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "common.h"
+
+enum class FrustumPlane : u32
+{
+    Left,
+    Right,
+    Bottom,
+    Top,
+    Near,
+    Far,
+    Count
+};
+
+// The planes are stored as (normal, distance) with normalized normals pointing into the frustum,
+// so a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0.
+struct Frustum
+{
+    glm::vec4 m_Planes[scast<u32>(FrustumPlane::Count)];
+};
+
+// Extracts the world space frustum planes from a view-projection matrix (e.g. `Camera::m_CameraMatrix`).
+Frustum ExtractFrustumPlanes(const glm::mat4& viewProjection);
@@ -0,0 +1,429 @@
+#include "scene/occlusion.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define O3D_OCCLUSION_SSE 1
+#include <emmintrin.h>
+#endif
+
+#include "core/jobs.h"
+#include "core/profiler.h"
+
+// Hi-Z levels that fit inside a tile are built by the tile's job, the rest once all tiles are done.
+constexpr u32 OCCLUSION_TILE_LEVEL_COUNT = 6;
+
+// Window depth the nearest corner of a tested box is pulled toward the camera by. An occluder's bounds tie with its
+// own rasterized depth (flat ones like the ground plane everywhere), and rounding must not turn a tie into occluded.
+constexpr float OCCLUSION_DEPTH_BIAS = 1e-5f;
+
+static_assert(OCCLUSION_WIDTH % OCCLUSION_TILE_WIDTH == 0 && OCCLUSION_HEIGHT % OCCLUSION_TILE_HEIGHT == 0);
+static_assert(OCCLUSION_TILE_WIDTH % 4 == 0, "Tiles are rasterized 4 pixels at a time.");
+static_assert((OCCLUSION_TILE_WIDTH >> (OCCLUSION_TILE_LEVEL_COUNT - 1)) >= 1);
+static_assert((OCCLUSION_TILE_HEIGHT >> (OCCLUSION_TILE_LEVEL_COUNT - 1)) >= 1);
+static_assert((OCCLUSION_HEIGHT >> (OCCLUSION_LEVEL_COUNT - 1)) >= 1);
+
+static u32 GetOcclusionLevelWidth(const u32 level)
+{
+    return OCCLUSION_WIDTH >> level;
+}
+
+static u32 GetOcclusionLevelHeight(const u32 level)
+{
+    return OCCLUSION_HEIGHT >> level;
+}
+
+void BeginOcclusionFrame(OcclusionBuffer& buffer, const glm::mat4& viewProjection)
+{
+    buffer.m_ViewProjection = viewProjection;
+    buffer.m_Triangles.clear();
+
+    for (std::vector<u32>& bin : buffer.m_TileBins)
+    {
+        bin.clear();
+    }
+
+    for (u32 level = 0; level < OCCLUSION_LEVEL_COUNT; ++level)
+    {
+        buffer.m_Levels[level].assign(GetOcclusionLevelWidth(level) * GetOcclusionLevelHeight(level), 1.0f);
+    }
+}
+
+// Projects a clip space position to pixels and window depth.
+static glm::vec3 ProjectOcclusionVertex(const glm::vec4& clip)
+{
+    const float invW = 1.0f / clip.w;
+    return glm::vec3(
+        (clip.x * invW * 0.5f + 0.5f) * OCCLUSION_WIDTH,
+        (clip.y * invW * 0.5f + 0.5f) * OCCLUSION_HEIGHT,
+        clip.z * invW * 0.5f + 0.5f
+    );
+}
+
+static void BinOcclusionTriangle(OcclusionBuffer& buffer, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+{
+    const float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (std::abs(area) < 1e-6f)
+    {
+        return;
+    }
+
+    const float minX = std::min({ v0.x, v1.x, v2.x });
+    const float maxX = std::max({ v0.x, v1.x, v2.x });
+    const float minY = std::min({ v0.y, v1.y, v2.y });
+    const float maxY = std::max({ v0.y, v1.y, v2.y });
+    if (maxX < 0.0f || maxY < 0.0f || minX >= OCCLUSION_WIDTH || minY >= OCCLUSION_HEIGHT)
+    {
+        return;
+    }
+
+    const u32 index = scast<u32>(buffer.m_Triangles.size());
+    buffer.m_Triangles.push_back({ { v0, v1, v2 } });
+
+    // Clamp in float, vertices close to the near plane can be far outside the buffer.
+    const u32 tileX0 = scast<u32>(std::max(minX, 0.0f)) / OCCLUSION_TILE_WIDTH;
+    const u32 tileY0 = scast<u32>(std::max(minY, 0.0f)) / OCCLUSION_TILE_HEIGHT;
+    const u32 tileX1 = scast<u32>(std::min(maxX, OCCLUSION_WIDTH - 1.0f)) / OCCLUSION_TILE_WIDTH;
+    const u32 tileY1 = scast<u32>(std::min(maxY, OCCLUSION_HEIGHT - 1.0f)) / OCCLUSION_TILE_HEIGHT;
+
+    for (u32 tileY = tileY0; tileY <= tileY1; ++tileY)
+    {
+        for (u32 tileX = tileX0; tileX <= tileX1; ++tileX)
+        {
+            buffer.m_TileBins[tileY * OCCLUSION_TILES_X + tileX].push_back(index);
+        }
+    }
+}
+
+void AddOccluder(
+    OcclusionBuffer& buffer,
+    const float* const vertices,
+    const u32 stride,
+    const u32* const indices,
+    const u32 indexCount,
+    const glm::mat4& model
+)
+{
+    const glm::mat4 modelViewProjection = buffer.m_ViewProjection * model;
+
+    for (u32 i = 0; i + 2 < indexCount; i += 3)
+    {
+        glm::vec4 clip[3];
+        u32 insideCount = 0;
+        for (u32 corner = 0; corner < 3; ++corner)
+        {
+            const float* const position = vertices + indices[i + corner] * stride;
+            clip[corner] = modelViewProjection * glm::vec4(position[0], position[1], position[2], 1.0f);
+            insideCount += clip[corner].z >= -clip[corner].w ? 1 : 0;
+        }
+
+        if (insideCount == 0)
+        {
+            continue;
+        }
+
+        if (insideCount == 3)
+        {
+            BinOcclusionTriangle(
+                buffer,
+                ProjectOcclusionVertex(clip[0]),
+                ProjectOcclusionVertex(clip[1]),
+                ProjectOcclusionVertex(clip[2])
+            );
+            continue;
+        }
+
+        // Clip against the near plane (z = -w). The result has 3 or 4 vertices.
+        glm::vec3 polygon[4];
+        u32 polygonCount = 0;
+        for (u32 corner = 0; corner < 3; ++corner)
+        {
+            const glm::vec4& a = clip[corner];
+            const glm::vec4& b = clip[(corner + 1) % 3];
+            const float distanceA = a.z + a.w;
+            const float distanceB = b.z + b.w;
+
+            if (distanceA >= 0.0f)
+            {
+                polygon[polygonCount++] = ProjectOcclusionVertex(a);
+            }
+
+            if ((distanceA >= 0.0f) != (distanceB >= 0.0f))
+            {
+                const float t = distanceA / (distanceA - distanceB);
+                polygon[polygonCount++] = ProjectOcclusionVertex(a + (b - a) * t);
+            }
+        }
+
+        for (u32 corner = 2; corner < polygonCount; ++corner)
+        {
+            BinOcclusionTriangle(buffer, polygon[0], polygon[corner - 1], polygon[corner]);
+        }
+    }
+}
+
+// Rasterizes a triangle into the part of the depth buffer inside [tileX0, tileX1) x [tileY0, tileY1).
+// Pixels are sampled at their centers and keep the nearest depth.
+static void RasterizeOcclusionTriangle(
+    float* const depth,
+    const OcclusionTriangle& triangle,
+    const u32 tileX0,
+    const u32 tileY0,
+    const u32 tileX1,
+    const u32 tileY1
+)
+{
+    glm::vec3 v0 = triangle.m_Vertices[0];
+    glm::vec3 v1 = triangle.m_Vertices[1];
+    glm::vec3 v2 = triangle.m_Vertices[2];
+
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (area < 0.0f)
+    {
+        std::swap(v1, v2);
+        area = -area;
+    }
+
+    // Edge functions A * x + B * y + C, positive inside the counter-clockwise triangle.
+    const glm::vec3* const edgeStart[3] = { &v0, &v1, &v2 };
+    const glm::vec3* const edgeEnd[3] = { &v1, &v2, &v0 };
+    float edgeA[3], edgeB[3], edgeC[3];
+    for (u32 e = 0; e < 3; ++e)
+    {
+        edgeA[e] = edgeStart[e]->y - edgeEnd[e]->y;
+        edgeB[e] = edgeEnd[e]->x - edgeStart[e]->x;
+        edgeC[e] = -(edgeA[e] * edgeStart[e]->x + edgeB[e] * edgeStart[e]->y);
+    }
+
+    // Depth plane z = depthA * x + depthB * y + depthC.
+    const float depthA = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+    const float depthB = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+    const float depthC = v0.z - depthA * v0.x - depthB * v0.y;
+
+    const float minX = std::min({ v0.x, v1.x, v2.x });
+    const float maxX = std::max({ v0.x, v1.x, v2.x });
+    const float minY = std::min({ v0.y, v1.y, v2.y });
+    const float maxY = std::max({ v0.y, v1.y, v2.y });
+
+    // Rows are processed in groups of 4 pixels starting at a multiple of 4.
+    const u32 x0 = scast<u32>(std::clamp(minX, scast<float>(tileX0), scast<float>(tileX1))) & ~3u;
+    const u32 x1 = scast<u32>(std::clamp(std::ceil(maxX), scast<float>(tileX0), scast<float>(tileX1)));
+    const u32 y0 = scast<u32>(std::clamp(minY, scast<float>(tileY0), scast<float>(tileY1)));
+    const u32 y1 = scast<u32>(std::clamp(std::ceil(maxY), scast<float>(tileY0), scast<float>(tileY1)));
+
+#if O3D_OCCLUSION_SSE
+    const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 a0 = _mm_set1_ps(edgeA[0]), a1 = _mm_set1_ps(edgeA[1]), a2 = _mm_set1_ps(edgeA[2]);
+    const __m128 depthStepX = _mm_set1_ps(depthA);
+
+    for (u32 y = y0; y < y1; ++y)
+    {
+        const float pixelY = y + 0.5f;
+        const __m128 rowE0 = _mm_set1_ps(edgeB[0] * pixelY + edgeC[0]);
+        const __m128 rowE1 = _mm_set1_ps(edgeB[1] * pixelY + edgeC[1]);
+        const __m128 rowE2 = _mm_set1_ps(edgeB[2] * pixelY + edgeC[2]);
+        const __m128 rowDepth = _mm_set1_ps(depthB * pixelY + depthC);
+        float* const row = depth + y * OCCLUSION_WIDTH;
+
+        for (u32 x = x0; x < x1; x += 4)
+        {
+            const __m128 pixelX = _mm_add_ps(_mm_set1_ps(scast<float>(x)), laneOffsets);
+
+            const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, pixelX), rowE0);
+            const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, pixelX), rowE1);
+            const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, pixelX), rowE2);
+            const __m128 inside = _mm_and_ps(
+                _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                _mm_cmpge_ps(e2, zero)
+            );
+            if (_mm_movemask_ps(inside) == 0)
+            {
+                continue;
+            }
+
+            const __m128 triangleDepth = _mm_add_ps(_mm_mul_ps(depthStepX, pixelX), rowDepth);
+            const __m128 oldDepth = _mm_loadu_ps(row + x);
+            const __m128 newDepth = _mm_min_ps(oldDepth, triangleDepth);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, newDepth), _mm_andnot_ps(inside, oldDepth)));
+        }
+    }
+#else
+    for (u32 y = y0; y < y1; ++y)
+    {
+        const float pixelY = y + 0.5f;
+        float* const row = depth + y * OCCLUSION_WIDTH;
+
+        for (u32 x = x0; x < x1; ++x)
+        {
+            const float pixelX = x + 0.5f;
+            if (edgeA[0] * pixelX + edgeB[0] * pixelY + edgeC[0] < 0.0f
+                || edgeA[1] * pixelX + edgeB[1] * pixelY + edgeC[1] < 0.0f
+                || edgeA[2] * pixelX + edgeB[2] * pixelY + edgeC[2] < 0.0f)
+            {
+                continue;
+            }
+
+            row[x] = std::min(row[x], depthA * pixelX + depthB * pixelY + depthC);
+        }
+    }
+#endif
+}
+
+// Computes the texels [x0, x1) x [y0, y1) of a Hi-Z level from the level below.
+static void BuildOcclusionLevel(OcclusionBuffer& buffer, const u32 level, const u32 x0, const u32 y0, const u32 x1, const u32 y1)
+{
+    const float* const source = buffer.m_Levels[level - 1].data();
+    const u32 sourceWidth = GetOcclusionLevelWidth(level - 1);
+    float* const target = buffer.m_Levels[level].data();
+    const u32 targetWidth = GetOcclusionLevelWidth(level);
+
+    for (u32 y = y0; y < y1; ++y)
+    {
+        const float* const sourceRow0 = source + (2 * y) * sourceWidth;
+        const float* const sourceRow1 = sourceRow0 + sourceWidth;
+
+        for (u32 x = x0; x < x1; ++x)
+        {
+            target[y * targetWidth + x] = std::max(
+                std::max(sourceRow0[2 * x], sourceRow0[2 * x + 1]),
+                std::max(sourceRow1[2 * x], sourceRow1[2 * x + 1])
+            );
+        }
+    }
+}
+
+void RasterizeOccluders(OcclusionBuffer& buffer)
+{
+    ParallelFor(OCCLUSION_TILE_COUNT, 1, [&buffer](const u32 begin, const u32 end)
+    {
+        PROFILE_SCOPE("RasterizeOcclusionTiles");
+
+        for (u32 tile = begin; tile < end; ++tile)
+        {
+            const u32 tileX0 = (tile % OCCLUSION_TILES_X) * OCCLUSION_TILE_WIDTH;
+            const u32 tileY0 = (tile / OCCLUSION_TILES_X) * OCCLUSION_TILE_HEIGHT;
+
+            for (const u32 triangle : buffer.m_TileBins[tile])
+            {
+                RasterizeOcclusionTriangle(
+                    buffer.m_Levels[0].data(),
+                    buffer.m_Triangles[triangle],
+                    tileX0,
+                    tileY0,
+                    tileX0 + OCCLUSION_TILE_WIDTH,
+                    tileY0 + OCCLUSION_TILE_HEIGHT
+                );
+            }
+
+            for (u32 level = 1; level < OCCLUSION_TILE_LEVEL_COUNT; ++level)
+            {
+                BuildOcclusionLevel(
+                    buffer,
+                    level,
+                    tileX0 >> level,
+                    tileY0 >> level,
+                    (tileX0 + OCCLUSION_TILE_WIDTH) >> level,
+                    (tileY0 + OCCLUSION_TILE_HEIGHT) >> level
+                );
+            }
+        }
+    });
+
+    for (u32 level = OCCLUSION_TILE_LEVEL_COUNT; level < OCCLUSION_LEVEL_COUNT; ++level)
+    {
+        BuildOcclusionLevel(buffer, level, 0, 0, GetOcclusionLevelWidth(level), GetOcclusionLevelHeight(level));
+    }
+}
+
+bool IsOccluded(const OcclusionBuffer& buffer, const AABB& bounds)
+{
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    float minDepth = FLT_MAX;
+
+    for (u32 corner = 0; corner < 8; ++corner)
+    {
+        const glm::vec4 clip = buffer.m_ViewProjection * glm::vec4(
+            corner & 1 ? bounds.m_Max.x : bounds.m_Min.x,
+            corner & 2 ? bounds.m_Max.y : bounds.m_Min.y,
+            corner & 4 ? bounds.m_Max.z : bounds.m_Min.z,
+            1.0f
+        );
+
+        // Boxes crossing the near plane are close enough to always be drawn.
+        if (clip.z < -clip.w || clip.w <= 0.0f)
+        {
+            return false;
+        }
+
+        const glm::vec3 window = ProjectOcclusionVertex(clip);
+        minX = std::min(minX, window.x);
+        maxX = std::max(maxX, window.x);
+        minY = std::min(minY, window.y);
+        maxY = std::max(maxY, window.y);
+        minDepth = std::min(minDepth, window.z);
+    }
+
+    if (maxX < 0.0f || maxY < 0.0f || minX >= OCCLUSION_WIDTH || minY >= OCCLUSION_HEIGHT)
+    {
+        return false;
+    }
+
+    minDepth -= OCCLUSION_DEPTH_BIAS;
+
+    const u32 x0 = scast<u32>(std::max(minX, 0.0f));
+    const u32 y0 = scast<u32>(std::max(minY, 0.0f));
+    const u32 x1 = scast<u32>(std::min(maxX, OCCLUSION_WIDTH - 1.0f));
+    const u32 y1 = scast<u32>(std::min(maxY, OCCLUSION_HEIGHT - 1.0f));
+
+    // Pick the finest level where the rectangle covers at most 2x2 texels.
+    u32 level = 0;
+    while (level + 1 < OCCLUSION_LEVEL_COUNT && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+    {
+        level++;
+    }
+
+    const float* const texels = buffer.m_Levels[level].data();
+    const u32 width = GetOcclusionLevelWidth(level);
+    for (u32 y = y0 >> level; y <= (y1 >> level); ++y)
+    {
+        for (u32 x = x0 >> level; x <= (x1 >> level); ++x)
+        {
+            if (texels[y * width + x] >= minDepth)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+u32 CullOccluded(const OcclusionBuffer& buffer, const CullingSet& set, u32* const visible, const u32 visibleCount)
+{
+    std::vector<u8> occluded(visibleCount, 0);
+    ParallelFor(visibleCount, 256, [&](const u32 begin, const u32 end)
+    {
+        for (u32 i = begin; i < end; ++i)
+        {
+            const u32 object = visible[i];
+            const glm::vec3 center = glm::vec3(set.m_BoxCenterX[object], set.m_BoxCenterY[object], set.m_BoxCenterZ[object]);
+            const glm::vec3 extents = glm::vec3(set.m_BoxExtentX[object], set.m_BoxExtentY[object], set.m_BoxExtentZ[object]);
+
+            occluded[i] = IsOccluded(buffer, { center - extents, center + extents }) ? 1 : 0;
+        }
+    });
+
+    u32 result = 0;
+    for (u32 i = 0; i < visibleCount; ++i)
+    {
+        if (!occluded[i])
+        {
+            visible[result++] = visible[i];
+        }
+    }
+
+    return result;
+}
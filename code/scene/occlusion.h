@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "common.h"
+#include "scene/bounds.h"
+#include "scene/culling.h"
+
+// Software occlusion culling.
+// Occluder triangles are rasterized on the CPU into a low resolution depth buffer, split into screen tiles that
+// are rasterized in parallel. A hierarchical-Z pyramid (max depth per texel) is built on top of it, and the
+// bounds of every potentially visible object are tested against the pyramid before anything is submitted.
+// Depth is stored as window depth in [0, 1], larger is farther.
+
+constexpr u32 OCCLUSION_WIDTH = 256;
+constexpr u32 OCCLUSION_HEIGHT = 128;
+constexpr u32 OCCLUSION_TILE_WIDTH = 64;
+constexpr u32 OCCLUSION_TILE_HEIGHT = 32;
+constexpr u32 OCCLUSION_TILES_X = OCCLUSION_WIDTH / OCCLUSION_TILE_WIDTH;
+constexpr u32 OCCLUSION_TILES_Y = OCCLUSION_HEIGHT / OCCLUSION_TILE_HEIGHT;
+constexpr u32 OCCLUSION_TILE_COUNT = OCCLUSION_TILES_X * OCCLUSION_TILES_Y;
+constexpr u32 OCCLUSION_LEVEL_COUNT = 8; // 256x128 down to 2x1.
+
+// A triangle after projection: x and y in pixels, z is window depth.
+struct OcclusionTriangle
+{
+    glm::vec3 m_Vertices[3];
+};
+
+struct OcclusionBuffer
+{
+    glm::mat4 m_ViewProjection = glm::mat4(1.0f);
+
+    // Level 0 is the rasterized depth, every following level holds the max of 2x2 texels of the previous one.
+    std::vector<float> m_Levels[OCCLUSION_LEVEL_COUNT];
+
+    std::vector<OcclusionTriangle> m_Triangles;
+    std::vector<u32> m_TileBins[OCCLUSION_TILE_COUNT]; // Indices of the triangles overlapping each tile.
+};
+
+// Clears the buffer for a new frame seen through `viewProjection`.
+void BeginOcclusionFrame(OcclusionBuffer& buffer, const glm::mat4& viewProjection);
+
+// Projects and bins the triangles of an occluder. Positions are the first 3 floats of each vertex, `stride` is in
+// floats. Occluders are double sided.
+void AddOccluder(
+    OcclusionBuffer& buffer,
+    const float* const vertices,
+    const u32 stride,
+    const u32* const indices,
+    const u32 indexCount,
+    const glm::mat4& model
+);
+
+// Rasterizes the binned occluders on the job system and builds the Hi-Z pyramid.
+void RasterizeOccluders(OcclusionBuffer& buffer);
+
+// Returns true when the world space box is completely hidden behind the rasterized occluders.
+bool IsOccluded(const OcclusionBuffer& buffer, const AABB& bounds);
+
+// Removes the occluded objects from a list of culling set indices, e.g. the output of CullFrustum(), keeping the
+// order. Returns the new count.
+u32 CullOccluded(const OcclusionBuffer& buffer, const CullingSet& set, u32* const visible, const u32 visibleCount);
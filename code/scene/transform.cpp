@@ -0,0 +1,263 @@
+#include "scene/transform.h"
+
+#include <algorithm>
+
+#include "core/jobs.h"
+
+// Root groups are handed out to jobs in batches of roughly this many nodes.
+constexpr u32 TRANSFORM_PARALLEL_BATCH_NODES = 1024;
+// Smaller scales, e.g. a node hidden by scaling it to 0, aren't interpolated.
+constexpr float TRANSFORM_MIN_INTERPOLATED_SCALE = 1e-6f;
+
+static void MarkTransformDirty(TransformHierarchy& hierarchy, const u32 node)
+{
+    hierarchy.m_Dirty[node] = 1;
+    hierarchy.m_GroupDirty[hierarchy.m_Groups[node]] = 1;
+}
+
+u32 CreateTransform(
+    TransformHierarchy& hierarchy,
+    const u32 parent,
+    const glm::vec3& position,
+    const glm::quat& rotation,
+    const glm::vec3& scale
+)
+{
+    const u32 result = scast<u32>(hierarchy.m_Parents.size());
+
+    u32 group = 0;
+    if (parent == TRANSFORM_NO_PARENT)
+    {
+        group = hierarchy.m_GroupCount++;
+        hierarchy.m_GroupDirty.push_back(0);
+    }
+    else
+    {
+        group = hierarchy.m_Groups[parent];
+    }
+
+    hierarchy.m_LocalPositions.push_back(position);
+    hierarchy.m_LocalRotations.push_back(rotation);
+    hierarchy.m_LocalScales.push_back(scale);
+    hierarchy.m_Parents.push_back(parent);
+    hierarchy.m_Groups.push_back(group);
+    hierarchy.m_Dirty.push_back(0);
+    hierarchy.m_ChangedUpdate.push_back(TRANSFORM_NEVER_UPDATED);
+    hierarchy.m_WorldMatrices.push_back(glm::mat4(1.0f));
+    hierarchy.m_PreviousWorldMatrices.push_back(glm::mat4(1.0f));
+    hierarchy.m_GroupOrderDirty = true;
+
+    MarkTransformDirty(hierarchy, result);
+
+    return result;
+}
+
+void SetLocalPosition(TransformHierarchy& hierarchy, const u32 node, const glm::vec3& position)
+{
+    hierarchy.m_LocalPositions[node] = position;
+    MarkTransformDirty(hierarchy, node);
+}
+
+void SetLocalRotation(TransformHierarchy& hierarchy, const u32 node, const glm::quat& rotation)
+{
+    hierarchy.m_LocalRotations[node] = rotation;
+    MarkTransformDirty(hierarchy, node);
+}
+
+void SetLocalScale(TransformHierarchy& hierarchy, const u32 node, const glm::vec3& scale)
+{
+    hierarchy.m_LocalScales[node] = scale;
+    MarkTransformDirty(hierarchy, node);
+}
+
+static void RebuildTransformGroupOrder(TransformHierarchy& hierarchy)
+{
+    const u32 nodeCount = scast<u32>(hierarchy.m_Parents.size());
+
+    // Counting sort by group. It is stable, so every group stays in topological order.
+    hierarchy.m_GroupOffsets.assign(hierarchy.m_GroupCount + 1, 0);
+    for (u32 i = 0; i < nodeCount; ++i)
+    {
+        hierarchy.m_GroupOffsets[hierarchy.m_Groups[i] + 1]++;
+    }
+
+    for (u32 group = 0; group < hierarchy.m_GroupCount; ++group)
+    {
+        hierarchy.m_GroupOffsets[group + 1] += hierarchy.m_GroupOffsets[group];
+    }
+
+    std::vector<u32> cursor(hierarchy.m_GroupOffsets.begin(), hierarchy.m_GroupOffsets.end() - 1);
+    hierarchy.m_GroupOrder.resize(nodeCount);
+    for (u32 i = 0; i < nodeCount; ++i)
+    {
+        hierarchy.m_GroupOrder[cursor[hierarchy.m_Groups[i]]++] = i;
+    }
+
+    hierarchy.m_GroupOrderDirty = false;
+}
+
+static glm::mat4 ComposeLocalMatrix(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    glm::mat4 result = glm::mat4_cast(rotation);
+    result[0] *= scale.x;
+    result[1] *= scale.y;
+    result[2] *= scale.z;
+    result[3] = glm::vec4(position, 1.0f);
+    return result;
+}
+
+// Updates the groups in [firstGroup, lastGroup). Groups never share nodes, so disjoint ranges can run concurrently.
+static void UpdateTransformGroups(TransformHierarchy& hierarchy, const u32 firstGroup, const u32 lastGroup)
+{
+    const u32 updateIndex = hierarchy.m_UpdateIndex;
+
+    for (u32 group = firstGroup; group < lastGroup; ++group)
+    {
+        if (!hierarchy.m_GroupDirty[group])
+        {
+            continue;
+        }
+
+        hierarchy.m_GroupDirty[group] = 0;
+
+        const u32 end = hierarchy.m_GroupOffsets[group + 1];
+        for (u32 i = hierarchy.m_GroupOffsets[group]; i < end; ++i)
+        {
+            const u32 node = hierarchy.m_GroupOrder[i];
+            const u32 parent = hierarchy.m_Parents[node];
+            const bool parentChanged = parent != TRANSFORM_NO_PARENT
+                && hierarchy.m_ChangedUpdate[parent] == updateIndex;
+
+            if (!hierarchy.m_Dirty[node] && !parentChanged)
+            {
+                continue;
+            }
+
+            const glm::mat4 local = ComposeLocalMatrix(
+                hierarchy.m_LocalPositions[node],
+                hierarchy.m_LocalRotations[node],
+                hierarchy.m_LocalScales[node]
+            );
+
+            const glm::mat4 world = parent == TRANSFORM_NO_PARENT
+                ? local
+                : hierarchy.m_WorldMatrices[parent] * local;
+
+            // A new node has no previous state to interpolate from.
+            hierarchy.m_PreviousWorldMatrices[node] = hierarchy.m_ChangedUpdate[node] == TRANSFORM_NEVER_UPDATED
+                ? world
+                : hierarchy.m_WorldMatrices[node];
+            hierarchy.m_WorldMatrices[node] = world;
+            hierarchy.m_ChangedUpdate[node] = updateIndex;
+            hierarchy.m_Dirty[node] = 0;
+        }
+    }
+}
+
+static void BeginTransformUpdate(TransformHierarchy& hierarchy)
+{
+    if (hierarchy.m_GroupOrderDirty)
+    {
+        RebuildTransformGroupOrder(hierarchy);
+    }
+
+    hierarchy.m_UpdateIndex++;
+}
+
+void UpdateWorldMatrices(TransformHierarchy& hierarchy)
+{
+    BeginTransformUpdate(hierarchy);
+    UpdateTransformGroups(hierarchy, 0, hierarchy.m_GroupCount);
+}
+
+void UpdateWorldMatricesParallel(TransformHierarchy& hierarchy)
+{
+    BeginTransformUpdate(hierarchy);
+
+    // Split the groups into batches of similar node counts and hand the batches to the job system.
+    std::vector<u32> batchEnds;
+    u32 batchNodes = 0;
+    for (u32 group = 0; group < hierarchy.m_GroupCount; ++group)
+    {
+        batchNodes += hierarchy.m_GroupOffsets[group + 1] - hierarchy.m_GroupOffsets[group];
+        if (batchNodes >= TRANSFORM_PARALLEL_BATCH_NODES || group + 1 == hierarchy.m_GroupCount)
+        {
+            batchEnds.push_back(group + 1);
+            batchNodes = 0;
+        }
+    }
+
+    ParallelFor(scast<u32>(batchEnds.size()), 1, [&](const u32 begin, const u32 end)
+    {
+        const u32 firstGroup = begin == 0 ? 0 : batchEnds[begin - 1];
+        UpdateTransformGroups(hierarchy, firstGroup, batchEnds[end - 1]);
+    });
+}
+
+bool DidWorldMatrixChange(const TransformHierarchy& hierarchy, const u32 node)
+{
+    return hierarchy.m_ChangedUpdate[node] == hierarchy.m_UpdateIndex;
+}
+
+const glm::mat4& GetWorldMatrix(const TransformHierarchy& hierarchy, const u32 node)
+{
+    return hierarchy.m_WorldMatrices[node];
+}
+
+glm::mat4 GetInterpolatedWorldMatrix(const TransformHierarchy& hierarchy, const u32 node, const float alpha)
+{
+    // Nodes that didn't move in the last update have nothing to blend.
+    if (!DidWorldMatrixChange(hierarchy, node))
+    {
+        return hierarchy.m_WorldMatrices[node];
+    }
+
+    const glm::mat4& previous = hierarchy.m_PreviousWorldMatrices[node];
+    const glm::mat4& current = hierarchy.m_WorldMatrices[node];
+
+    glm::vec3 previousScale = glm::vec3(
+        glm::length(glm::vec3(previous[0])),
+        glm::length(glm::vec3(previous[1])),
+        glm::length(glm::vec3(previous[2]))
+    );
+    glm::vec3 currentScale = glm::vec3(
+        glm::length(glm::vec3(current[0])),
+        glm::length(glm::vec3(current[1])),
+        glm::length(glm::vec3(current[2]))
+    );
+
+    // A collapsed axis has no rotation to recover, and a matrix that turns mirrored (or back) can't be reached by
+    // rotating, so both snap to the current matrix.
+    const float previousDeterminant = glm::determinant(glm::mat3(previous));
+    const float currentDeterminant = glm::determinant(glm::mat3(current));
+    if (std::min({ previousScale.x, previousScale.y, previousScale.z }) < TRANSFORM_MIN_INTERPOLATED_SCALE
+        || std::min({ currentScale.x, currentScale.y, currentScale.z }) < TRANSFORM_MIN_INTERPOLATED_SCALE
+        || (previousDeterminant < 0.0f) != (currentDeterminant < 0.0f))
+    {
+        return current;
+    }
+
+    // Mirrored on both ends: a negative X scale leaves a proper rotation in the columns.
+    if (currentDeterminant < 0.0f)
+    {
+        previousScale.x = -previousScale.x;
+        currentScale.x = -currentScale.x;
+    }
+
+    const glm::quat previousRotation = glm::quat_cast(glm::mat3(
+        glm::vec3(previous[0]) / previousScale.x,
+        glm::vec3(previous[1]) / previousScale.y,
+        glm::vec3(previous[2]) / previousScale.z
+    ));
+    const glm::quat currentRotation = glm::quat_cast(glm::mat3(
+        glm::vec3(current[0]) / currentScale.x,
+        glm::vec3(current[1]) / currentScale.y,
+        glm::vec3(current[2]) / currentScale.z
+    ));
+
+    return ComposeLocalMatrix(
+        glm::mix(glm::vec3(previous[3]), glm::vec3(current[3]), alpha),
+        glm::slerp(previousRotation, currentRotation, alpha),
+        glm::mix(previousScale, currentScale, alpha)
+    );
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "common.h"
+
+constexpr u32 TRANSFORM_NO_PARENT = ~0u;
+constexpr u32 TRANSFORM_NEVER_UPDATED = ~0u; // m_ChangedUpdate of a node whose world matrix was never computed.
+
+// Transform nodes in structure-of-arrays layout.
+// A node can only be parented to an existing node, so the arrays are always in topological order (parents before
+// children) and world matrices are computed in one forward pass. Nodes are additionally grouped by their root;
+// groups are independent of each other and are the unit of work for skipping clean trees and for parallel updates.
+struct TransformHierarchy
+{
+    std::vector<glm::vec3> m_LocalPositions;
+    std::vector<glm::quat> m_LocalRotations;
+    std::vector<glm::vec3> m_LocalScales;
+    std::vector<u32> m_Parents;
+    std::vector<u32> m_Groups;        // Index of the root group of each node.
+    std::vector<u8> m_Dirty;          // Local transform changed since the last update.
+    std::vector<u32> m_ChangedUpdate; // Value of m_UpdateIndex when the world matrix was last recomputed.
+    std::vector<glm::mat4> m_WorldMatrices;
+    std::vector<glm::mat4> m_PreviousWorldMatrices; // World matrix before the last recompute, for interpolation.
+
+    // Node indices sorted by group, in topological order within each group. Rebuilt when nodes are added.
+    std::vector<u32> m_GroupOrder;
+    std::vector<u32> m_GroupOffsets;  // Range of m_GroupOrder per group, one extra entry at the end.
+    std::vector<u8> m_GroupDirty;     // A node of the group has a dirty local transform.
+    u32 m_GroupCount = 0;
+    bool m_GroupOrderDirty = false;
+
+    u32 m_UpdateIndex = 0;
+};
+
+// Creates a node and returns its index. `parent` must be TRANSFORM_NO_PARENT or an existing node.
+u32 CreateTransform(
+    TransformHierarchy& hierarchy,
+    const u32 parent,
+    const glm::vec3& position,
+    const glm::quat& rotation,
+    const glm::vec3& scale
+);
+
+void SetLocalPosition(TransformHierarchy& hierarchy, const u32 node, const glm::vec3& position);
+void SetLocalRotation(TransformHierarchy& hierarchy, const u32 node, const glm::quat& rotation);
+void SetLocalScale(TransformHierarchy& hierarchy, const u32 node, const glm::vec3& scale);
+
+// Recomputes the world matrices of the dirty nodes and their descendants. Clean subtrees are skipped.
+void UpdateWorldMatrices(TransformHierarchy& hierarchy);
+
+// Same as UpdateWorldMatrices() but independent root groups are updated in parallel on the job system.
+void UpdateWorldMatricesParallel(TransformHierarchy& hierarchy);
+
+// Returns true when the world matrix of the node was recomputed by the last update.
+bool DidWorldMatrixChange(const TransformHierarchy& hierarchy, const u32 node);
+
+const glm::mat4& GetWorldMatrix(const TransformHierarchy& hierarchy, const u32 node);
+
+// Blends the world matrix of the node from its value before the last update (alpha 0) to the current one (alpha 1).
+// Translation and scale are interpolated linearly and rotation spherically, so matrices with shear aren't supported.
+// The current matrix is returned as is when either matrix has a zero scale or only one of them is mirrored.
+glm::mat4 GetInterpolatedWorldMatrix(const TransformHierarchy& hierarchy, const u32 node, const float alpha);
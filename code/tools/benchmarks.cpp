@@ -0,0 +1,747 @@
+// Microbenchmarks of the engine's CPU hot paths.
+// Usage: benchmarks [--filter <text>] [--json <results.json>] [--baseline <results.json>] [--threshold <percent>]
+// Run it from the data directory, the texture and shader benchmarks read the engine's files. With a baseline, the
+// benchmarks that got slower by more than the threshold are reported and the exit code is 1.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <stb_image.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "common.h"
+#include "camera.h"
+#include "core/frame_arena.h"
+#include "core/jobs.h"
+#include "geometry/mesh.h"
+#include "graphics/command_list.h"
+#include "graphics/shader.h"
+#include "graphics/texture.h"
+#include "scene/bounds.h"
+#include "scene/bvh.h"
+#include "scene/culling.h"
+#include "scene/frustum.h"
+#include "scene/transform.h"
+
+constexpr u32 BENCHMARK_SAMPLES = 5;
+constexpr double BENCHMARK_SAMPLE_TIME = 0.1;    // Seconds per sample once the iteration count is calibrated.
+constexpr double BENCHMARK_CALIBRATION_TIME = 0.01;
+constexpr double BENCHMARK_DEFAULT_THRESHOLD = 10.0; // Percent.
+
+constexpr u32 BENCHMARK_OBJECT_COUNT = 16384;    // Objects in the culling and BVH scenes.
+constexpr u32 BENCHMARK_TRANSFORM_ROOTS = 64;
+constexpr u32 BENCHMARK_TRANSFORM_CHILDREN = 63; // Per root.
+constexpr u32 BENCHMARK_RECORD_BATCH_SIZE = 256;  // Draws per command list when recording in parallel.
+
+// SECTION: Allocation counting.
+// Every operator new of the process goes through these, so a benchmark's allocations are the difference of the
+// counters around its timed loop. Plain malloc() calls, like the ones in stb_image, aren't counted.
+
+static std::atomic<u64> g_AllocationCount = 0;
+static std::atomic<u64> g_AllocationBytes = 0;
+
+static void* AllocateCounted(const size_t size, const size_t alignment)
+{
+    g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+    g_AllocationBytes.fetch_add(size, std::memory_order_relaxed);
+
+    const size_t bytes = size == 0 ? 1 : size;
+#if defined(_MSC_VER)
+    // Everything goes through _aligned_malloc(), so FreeCounted() doesn't need to know how a block was allocated.
+    void* const result = _aligned_malloc(bytes, std::max(alignment, alignof(std::max_align_t)));
+#else
+    void* const result = alignment > alignof(std::max_align_t)
+        ? std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment)
+        : std::malloc(bytes);
+#endif
+    if (result == nullptr)
+    {
+        std::fprintf(stderr, "Out of memory allocating %zu bytes.\n", size);
+        std::abort();
+    }
+
+    return result;
+}
+
+static void FreeCounted(void* const pointer)
+{
+#if defined(_MSC_VER)
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void* operator new(const size_t size) { return AllocateCounted(size, alignof(std::max_align_t)); }
+void* operator new[](const size_t size) { return AllocateCounted(size, alignof(std::max_align_t)); }
+void* operator new(const size_t size, const std::align_val_t alignment)
+{
+    return AllocateCounted(size, scast<size_t>(alignment));
+}
+void* operator new[](const size_t size, const std::align_val_t alignment)
+{
+    return AllocateCounted(size, scast<size_t>(alignment));
+}
+void operator delete(void* const pointer) noexcept { FreeCounted(pointer); }
+void operator delete[](void* const pointer) noexcept { FreeCounted(pointer); }
+void operator delete(void* const pointer, size_t) noexcept { FreeCounted(pointer); }
+void operator delete[](void* const pointer, size_t) noexcept { FreeCounted(pointer); }
+void operator delete(void* const pointer, const std::align_val_t) noexcept { FreeCounted(pointer); }
+void operator delete[](void* const pointer, const std::align_val_t) noexcept { FreeCounted(pointer); }
+void operator delete(void* const pointer, size_t, const std::align_val_t) noexcept { FreeCounted(pointer); }
+void operator delete[](void* const pointer, size_t, const std::align_val_t) noexcept { FreeCounted(pointer); }
+
+// SECTION: Harness.
+
+// Handed to a benchmark, which does its setup, then runs m_Iterations operations between StartBenchmarkTimer()
+// and StopBenchmarkTimer().
+struct BenchmarkRun
+{
+    u64 m_Iterations = 0;
+    u64 m_ItemsPerOp = 0;  // Objects, nodes... processed by one operation, for the throughput.
+    u64 m_BytesPerOp = 0;
+    bool m_Skipped = false;
+
+    std::chrono::steady_clock::time_point m_Start;
+    double m_Elapsed = 0.0;
+    u64 m_StartAllocations = 0;
+    u64 m_StartAllocationBytes = 0;
+    u64 m_Allocations = 0;
+    u64 m_AllocationBytes = 0;
+};
+
+struct Benchmark
+{
+    const char* m_Name;
+    std::function<void(BenchmarkRun&)> m_Function;
+};
+
+struct BenchmarkResult
+{
+    std::string m_Name;
+    u64 m_Iterations;
+    double m_NsPerOp;     // Median of the samples.
+    double m_MinNsPerOp;
+    double m_AllocationsPerOp;
+    double m_AllocationBytesPerOp;
+    double m_OpsPerSecond;
+    double m_ItemsPerSecond;
+    double m_MegabytesPerSecond;
+};
+
+static void StartBenchmarkTimer(BenchmarkRun& run)
+{
+    run.m_StartAllocations = g_AllocationCount.load(std::memory_order_relaxed);
+    run.m_StartAllocationBytes = g_AllocationBytes.load(std::memory_order_relaxed);
+    run.m_Start = std::chrono::steady_clock::now();
+}
+
+static void StopBenchmarkTimer(BenchmarkRun& run)
+{
+    run.m_Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - run.m_Start).count();
+    run.m_Allocations = g_AllocationCount.load(std::memory_order_relaxed) - run.m_StartAllocations;
+    run.m_AllocationBytes = g_AllocationBytes.load(std::memory_order_relaxed) - run.m_StartAllocationBytes;
+}
+
+// Keeps the compiler from dropping a computation whose result is otherwise unused.
+template<typename T>
+static void DoNotOptimize(const T& value)
+{
+    static volatile u8 sink = 0;
+    sink = sink + *rcast<const volatile u8*>(&value);
+}
+
+static BenchmarkRun RunBenchmarkOnce(const Benchmark& benchmark, const u64 iterations)
+{
+    BenchmarkRun run = {};
+    run.m_Iterations = iterations;
+    benchmark.m_Function(run);
+    return run;
+}
+
+// Calibrates the iteration count, then takes the samples. Returns false if the benchmark skipped itself.
+static bool RunBenchmark(const Benchmark& benchmark, BenchmarkResult& outResult)
+{
+    u64 iterations = 1;
+    BenchmarkRun run = RunBenchmarkOnce(benchmark, iterations);
+    while (!run.m_Skipped && run.m_Elapsed < BENCHMARK_CALIBRATION_TIME && iterations < (1ull << 40))
+    {
+        iterations *= 2;
+        run = RunBenchmarkOnce(benchmark, iterations);
+    }
+
+    if (run.m_Skipped)
+    {
+        return false;
+    }
+
+    const double perOp = std::max(run.m_Elapsed / scast<double>(iterations), 1e-9);
+    iterations = std::max<u64>(1, scast<u64>(BENCHMARK_SAMPLE_TIME / perOp));
+
+    std::vector<double> samples;
+    u64 allocations = 0;
+    u64 allocationBytes = 0;
+    for (u32 sample = 0; sample < BENCHMARK_SAMPLES; ++sample)
+    {
+        run = RunBenchmarkOnce(benchmark, iterations);
+        samples.push_back(run.m_Elapsed * 1e9 / scast<double>(iterations));
+        allocations += run.m_Allocations;
+        allocationBytes += run.m_AllocationBytes;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    const double totalOps = scast<double>(iterations) * BENCHMARK_SAMPLES;
+    outResult.m_Name = benchmark.m_Name;
+    outResult.m_Iterations = iterations;
+    outResult.m_NsPerOp = samples[samples.size() / 2];
+    outResult.m_MinNsPerOp = samples.front();
+    outResult.m_AllocationsPerOp = scast<double>(allocations) / totalOps;
+    outResult.m_AllocationBytesPerOp = scast<double>(allocationBytes) / totalOps;
+    outResult.m_OpsPerSecond = 1e9 / outResult.m_NsPerOp;
+    outResult.m_ItemsPerSecond = outResult.m_OpsPerSecond * scast<double>(run.m_ItemsPerOp);
+    outResult.m_MegabytesPerSecond = outResult.m_OpsPerSecond * scast<double>(run.m_BytesPerOp) / (1024.0 * 1024.0);
+    return true;
+}
+
+// SECTION: Scenes shared by the benchmarks.
+
+// A grid of unit boxes around the origin, so a camera at the origin sees part of it.
+static std::vector<AABB> CreateBenchmarkBounds()
+{
+    std::vector<AABB> result;
+    result.reserve(BENCHMARK_OBJECT_COUNT);
+
+    const u32 side = scast<u32>(std::cbrt(scast<double>(BENCHMARK_OBJECT_COUNT))) + 1;
+    for (u32 i = 0; i < BENCHMARK_OBJECT_COUNT; ++i)
+    {
+        const glm::vec3 center = glm::vec3(
+            scast<float>(i % side),
+            scast<float>((i / side) % side),
+            scast<float>(i / (side * side))
+        ) * 3.0f - glm::vec3(scast<float>(side) * 1.5f);
+        result.push_back({ center - glm::vec3(0.5f), center + glm::vec3(0.5f) });
+    }
+
+    return result;
+}
+
+static Frustum CreateBenchmarkFrustum()
+{
+    Camera camera = CreateCamera(1024, 720, glm::vec3(0.0f));
+    UpdateCameraMatrix(camera, 45.0f, 0.1f, 100.0f);
+    return ExtractFrustumPlanes(camera.m_CameraMatrix);
+}
+
+static void CreateBenchmarkCullingSet(CullingSet& outSet)
+{
+    for (const AABB& bounds : CreateBenchmarkBounds())
+    {
+        const glm::vec3 center = (bounds.m_Min + bounds.m_Max) * 0.5f;
+        AddCullable(outSet, bounds, { center, glm::length(bounds.m_Max - center) });
+    }
+}
+
+static void CreateBenchmarkHierarchy(TransformHierarchy& outHierarchy)
+{
+    constexpr glm::quat identity = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    for (u32 root = 0; root < BENCHMARK_TRANSFORM_ROOTS; ++root)
+    {
+        // Chains of four nodes below every root.
+        const u32 rootNode = CreateTransform(
+            outHierarchy,
+            TRANSFORM_NO_PARENT,
+            glm::vec3(scast<float>(root), 0.0f, 0.0f),
+            identity,
+            glm::vec3(1.0f)
+        );
+        u32 previous = rootNode;
+        for (u32 child = 0; child < BENCHMARK_TRANSFORM_CHILDREN; ++child)
+        {
+            previous = CreateTransform(
+                outHierarchy,
+                child % 4 == 0 ? rootNode : previous,
+                glm::vec3(0.0f, 1.0f, 0.0f),
+                glm::angleAxis(0.01f, glm::vec3(0.0f, 1.0f, 0.0f)),
+                glm::vec3(1.0f)
+            );
+        }
+    }
+    UpdateWorldMatrices(outHierarchy);
+}
+
+static u64 GetFileSize(const char* const fileName)
+{
+    std::error_code error;
+    const std::uintmax_t size = std::filesystem::file_size(fileName, error);
+    return error ? 0 : scast<u64>(size);
+}
+
+// SECTION: Benchmarks.
+
+static void BenchUpdateCameraMatrix(BenchmarkRun& run)
+{
+    Camera camera = CreateCamera(1024, 720, glm::vec3(0.0f, 0.0f, 2.0f));
+
+    StartBenchmarkTimer(run);
+    for (u64 i = 0; i < run.m_Iterations; ++i)
+    {
+        camera.m_Position.x += 0.0001f;
+        UpdateCameraMatrix(camera, 45.0f, 0.1f, 100.0f);
+        DoNotOptimize(camera.m_CameraMatrix);
+    }
+    StopBenchmarkTimer(run);
+}
+
+// The per-tick camera input: a mouse look and a movement step.
+static void BenchCameraInput(BenchmarkRun& run)
+{
+    Camera camera = CreateCamera(1024, 720, glm::vec3(0.0f, 0.0f, 2.0f));
+
+    StartBenchmarkTimer(run);
+    for (u64 i = 0; i < run.m_Iterations; ++i)
+    {
+        RotateCamera(camera, (i & 1) ? 3.0f : -3.0f, 0.5f);
+        MoveCamera(camera, glm::vec3(1.0f, 0.0f, 1.0f), 1.0f / 60.0f);
+        DoNotOptimize(camera.m_Orientation);
+    }
+    StopBenchmarkTimer(run);
+}
+
+static void BenchDecodeTexture(BenchmarkRun& run, const char* const fileName)
+{
+    run.m_BytesPerOp = GetFileSize(fileName);
+    if (run.m_BytesPerOp == 0)
+    {
+        run.m_Skipped = true;
+        return;
+    }
+
+    stbi_set_flip_vertically_on_load(true);
+
+    StartBenchmarkTimer(run);
+    for (u64 i = 0; i < run.m_Iterations; ++i)
+    {
+        TextureImage image = {};
+        LoadTextureImage(fileName, image);
+        DoNotOptimize(image.m_Width);
+        FreeTextureImage(image);
+    }
+    StopBenchmarkTimer(run);
+}
+
+static void BenchLoadShaderSources(BenchmarkRun& run)
+{
+    constexpr const char* vertexFile = "shaders/default.vert";
+    constexpr const char* fragmentFile = "shaders/default.frag";
+    run.m_BytesPerOp = GetFileSize(vertexFile) + GetFileSize(fragmentFile);
+    if (run.m_BytesPerOp == 0)
+    {
+        run.m_Skipped = true;
+        return;
+    }
+
+    StartBenchmarkTimer(run);
+    for (u64 i = 0; i < run.m_Iterations; ++i)
+    {
+        const std::string vertexCode = GetFileContents(vertexFile);
+        const std::string fragmentCode = GetFileContents(fragmentFile);
+        DoNotOptimize(vertexCode.size() + fragmentCode.size());
+    }
+    StopBenchmarkTimer(run);
+}
+
+static void BenchCullFrustum(BenchmarkRun& run, const bool parallel)
+{
+    CullingSet set = {};
+    CreateBenchmarkCullingSet(set);
+    const Frustum frustum = CreateBenchmarkFrustum();
+    std::vector<u32> visible(set.m_Count);
+    run.m_ItemsPerOp = set.m_Count;
+
+    StartBenchmarkTimer(run);
+    for (u64 i = 0; i < run.m_Iterations; ++i)
+    {
+        const u32 count = parallel
+            ? CullFrustumParallel(set, frustum, visible.data())
+            : CullFrustum(set, frustum, visible.data());
+        DoNotOptimize(count);
+        AdvanceFrameArena();
+    }
+    StopBenchmarkTimer(run);
+}
+
+static void BenchBuildBVH(BenchmarkRun& run)
+{
+    const std::vector<AABB> bounds = CreateBenchmarkBounds();
+    run.m_ItemsPerOp = bounds.size();
+
+    StartBenchmarkTimer(run);
+    for (u64 i = 0; i < run.m_Iterations; ++i)
+    {
+        BVH bvh = {};
+        BuildBVH(bvh, bounds.data(), scast<u32>(bounds.size()));
+        DoNotOptimize(bvh.m_NodeCount);
+    }
+    StopBenchmarkTimer(run);
+}
+
+static void BenchQueryBVHFrustum(BenchmarkRun& run)
+{
+    const std::vector<AABB> bounds = CreateBenchmarkBounds();
+    BVH bvh = {};
+    BuildBVH(bvh, bounds.data(), scast<u32>(bounds.size()));
+    const Frustum frustum = CreateBenchmarkFrustum();
+    std::vector<u32> items;
+    items.reserve(bounds.size());
+    run.m_ItemsPerOp = bounds.size();
+
+    StartBenchmarkTimer(run);
+    for (u64 i = 0; i < run.m_Iterations; ++i)
+    {
+        items.clear();
+        QueryBVHFrustum(bvh, frustum, items);
+        DoNotOptimize(items.size());
+    }
+    StopBenchmarkTimer(run);
+}
+
+// Moves every root, so the whole hierarchy is recomputed by each update.
+static void BenchUpdateTransforms(BenchmarkRun& run, const bool parallel)
+{
+    TransformHierarchy hierarchy = {};
+    CreateBenchmarkHierarchy(hierarchy);
+    run.m_ItemsPerOp = hierarchy.m_Parents.size();
+
+    StartBenchmarkTimer(run);
+    for (u64 i = 0; i < run.m_Iterations; ++i)
+    {
+        for (u32 node = 0; node < hierarchy.m_Parents.size(); ++node)
+        {
+            if (hierarchy.m_Parents[node] == TRANSFORM_NO_PARENT)
+            {
+                SetLocalPosition(hierarchy, node, glm::vec3(scast<float>(node), scast<float>(i & 7), 0.0f));
+            }
+        }
+
+        if (parallel)
+        {
+            UpdateWorldMatricesParallel(hierarchy);
+        }
+        else
+        {
+            UpdateWorldMatrices(hierarchy);
+        }
+        DoNotOptimize(hierarchy.m_WorldMatrices.back());
+    }
+    StopBenchmarkTimer(run);
+}
+
+static void BenchSelectMeshLOD(BenchmarkRun& run)
+{
+    const MeshLOD lods[] =
+    {
+        { 0, 3000, 0.0f },
+        { 3000, 1500, 0.01f },
+        { 4500, 750, 0.05f },
+        { 5250, 375, 0.2f },
+    };
+    Camera camera = CreateCamera(1024, 720, glm::vec3(0.0f));
+    UpdateCameraMatrix(camera, 45.0f, 0.1f, 100.0f);
+
+    u32 lod = 0;
+    StartBenchmarkTimer(run);
+    for (u64 i = 0; i < run.m_Iterations; ++i)
+    {
+        const float distance = 0.5f + scast<float>(i % 1024) * 0.1f;
+        lod = SelectMeshLOD(lods, 4, camera, distance, 1.0f, lod);
+        DoNotOptimize(lod);
+    }
+    StopBenchmarkTimer(run);
+}
+
+// Records the draws [begin, end) the way the engine records a textured mesh. Only the command stream is measured, the
+// objects are never bound to anything.
+static void RecordBenchmarkDraws(
+    CommandList& list,
+    const UniformStream& stream,
+    const std::vector<glm::mat4>& models,
+    const u32 begin,
+    const u32 end
+)
+{
+    for (u32 i = begin; i < end; ++i)
+    {
+        std::memcpy(GetUniformSlot(stream, i), &models[i], sizeof(glm::mat4));
+        RecordBindProgram(list, 1);
+        RecordBindTexture(list, { 1, GL_TEXTURE_2D, 0 });
+        RecordBindTexture(list, { 2, GL_TEXTURE_2D, 1 });
+        RecordBindVertexArray(list, 1);
+        RecordUniformBlockRange(list, 1, stream, i);
+        RecordDrawIndexed(list, 0, 36);
+    }
+}
+
+static void BenchRecordDraws(BenchmarkRun& run, const bool parallel)
+{
+    const std::vector<AABB> bounds = CreateBenchmarkBounds();
+    std::vector<glm::mat4> models;
+    models.reserve(bounds.size());
+    for (const AABB& box : bounds)
+    {
+        glm::mat4& model = models.emplace_back(1.0f);
+        model[3] = glm::vec4((box.m_Min + box.m_Max) * 0.5f, 1.0f);
+    }
+
+    const u32 count = scast<u32>(models.size());
+    const u32 batchCount = (count + BENCHMARK_RECORD_BATCH_SIZE - 1) / BENCHMARK_RECORD_BATCH_SIZE;
+    run.m_ItemsPerOp = count;
+
+    StartBenchmarkTimer(run);
+    for (u64 i = 0; i < run.m_Iterations; ++i)
+    {
+        const UniformStream stream = CreateUniformStream(count, sizeof(glm::mat4));
+        FrameVector<CommandList> lists(batchCount, CommandList{});
+        if (parallel)
+        {
+            ParallelFor(count, BENCHMARK_RECORD_BATCH_SIZE, [&](const u32 begin, const u32 end)
+            {
+                RecordBenchmarkDraws(lists[begin / BENCHMARK_RECORD_BATCH_SIZE], stream, models, begin, end);
+            });
+        }
+        else
+        {
+            RecordBenchmarkDraws(lists[0], stream, models, 0, count);
+        }
+        DoNotOptimize(lists[0].m_Count);
+        AdvanceFrameArena();
+    }
+    StopBenchmarkTimer(run);
+}
+
+static std::vector<Benchmark> CreateBenchmarks()
+{
+    return {
+        { "camera/UpdateCameraMatrix", BenchUpdateCameraMatrix },
+        { "camera/RotateAndMoveCamera", BenchCameraInput },
+        { "texture/Decode/planksSpec", [](BenchmarkRun& run) { BenchDecodeTexture(run, "textures/planksSpec.png"); } },
+        { "texture/Decode/pop_cat", [](BenchmarkRun& run) { BenchDecodeTexture(run, "textures/pop_cat.png"); } },
+        { "shader/GetFileContents", BenchLoadShaderSources },
+        { "culling/CullFrustum", [](BenchmarkRun& run) { BenchCullFrustum(run, false); } },
+        { "culling/CullFrustumParallel", [](BenchmarkRun& run) { BenchCullFrustum(run, true); } },
+        { "bvh/BuildBVH", BenchBuildBVH },
+        { "bvh/QueryBVHFrustum", BenchQueryBVHFrustum },
+        { "transform/UpdateWorldMatrices", [](BenchmarkRun& run) { BenchUpdateTransforms(run, false); } },
+        { "transform/UpdateWorldMatricesParallel", [](BenchmarkRun& run) { BenchUpdateTransforms(run, true); } },
+        { "mesh/SelectMeshLOD", BenchSelectMeshLOD },
+        { "commands/RecordDraws", [](BenchmarkRun& run) { BenchRecordDraws(run, false); } },
+        { "commands/RecordDrawsParallel", [](BenchmarkRun& run) { BenchRecordDraws(run, true); } },
+    };
+}
+
+// SECTION: Output.
+
+static bool SaveBenchmarkResults(const char* const fileName, const std::vector<BenchmarkResult>& results)
+{
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out)
+    {
+        LOG_ERROR("Failed to open file for writing: %s.", fileName);
+        return false;
+    }
+
+    // One benchmark per line, LoadBenchmarkBaseline() relies on it.
+    out << "{\n  \"benchmarks\": [\n";
+    char line[512];
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchmarkResult& result = results[i];
+        std::snprintf(
+            line,
+            sizeof(line),
+            "    { \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, "
+            "\"allocs_per_op\": %.3f, \"alloc_bytes_per_op\": %.1f, \"ops_per_sec\": %.1f, \"items_per_sec\": %.1f, "
+            "\"mb_per_sec\": %.3f }%s\n",
+            result.m_Name.c_str(),
+            scast<unsigned long long>(result.m_Iterations),
+            result.m_NsPerOp,
+            result.m_MinNsPerOp,
+            result.m_AllocationsPerOp,
+            result.m_AllocationBytesPerOp,
+            result.m_OpsPerSecond,
+            result.m_ItemsPerSecond,
+            result.m_MegabytesPerSecond,
+            i + 1 < results.size() ? "," : ""
+        );
+        out << line;
+    }
+    out << "  ]\n}\n";
+
+    if (!out)
+    {
+        LOG_ERROR("Failed to write benchmark results: %s.", fileName);
+        return false;
+    }
+
+    return true;
+}
+
+// Reads the ns/op of every benchmark from a file written by SaveBenchmarkResults().
+static bool LoadBenchmarkBaseline(const char* const fileName, std::unordered_map<std::string, double>& outNsPerOp)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in)
+    {
+        LOG_ERROR("Failed to open file: %s.", fileName);
+        return false;
+    }
+
+    constexpr const char* nameKey = "\"name\": \"";
+    constexpr const char* timeKey = "\"ns_per_op\": ";
+    std::string line;
+    while (std::getline(in, line))
+    {
+        const size_t name = line.find(nameKey);
+        const size_t time = line.find(timeKey);
+        if (name == std::string::npos || time == std::string::npos)
+        {
+            continue;
+        }
+
+        const size_t nameStart = name + std::strlen(nameKey);
+        const size_t nameEnd = line.find('"', nameStart);
+        if (nameEnd == std::string::npos)
+        {
+            continue;
+        }
+
+        outNsPerOp[line.substr(nameStart, nameEnd - nameStart)] =
+            std::strtod(line.c_str() + time + std::strlen(timeKey), nullptr);
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = nullptr;
+    const char* jsonFile = nullptr;
+    const char* baselineFile = nullptr;
+    double threshold = BENCHMARK_DEFAULT_THRESHOLD;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--filter") == 0 && hasValue)
+        {
+            filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--json") == 0 && hasValue)
+        {
+            jsonFile = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--baseline") == 0 && hasValue)
+        {
+            baselineFile = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--threshold") == 0 && hasValue)
+        {
+            threshold = std::strtod(argv[++i], nullptr);
+        }
+        else
+        {
+            std::fprintf(
+                stderr,
+                "Usage: %s [--filter <text>] [--json <results.json>] [--baseline <results.json>] "
+                "[--threshold <percent>]\n",
+                argv[0]
+            );
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::unordered_map<std::string, double> baseline;
+    if (baselineFile != nullptr && !LoadBenchmarkBaseline(baselineFile, baseline))
+    {
+        return EXIT_FAILURE;
+    }
+
+    InitializeJobSystem(0);
+    InitializeFrameArena(FRAME_ARENA_DEFAULT_SIZE);
+
+    std::printf(
+        "%-40s %12s %12s %10s %14s %14s %16s\n",
+        "benchmark",
+        "ns/op",
+        "min ns/op",
+        "allocs/op",
+        "items/s",
+        "MB/s",
+        "baseline"
+    );
+
+    std::vector<BenchmarkResult> results;
+    u32 regressions = 0;
+    for (const Benchmark& benchmark : CreateBenchmarks())
+    {
+        if (filter != nullptr && std::strstr(benchmark.m_Name, filter) == nullptr)
+        {
+            continue;
+        }
+
+        BenchmarkResult result = {};
+        if (!RunBenchmark(benchmark, result))
+        {
+            std::printf("%-40s skipped, its data files are missing\n", benchmark.m_Name);
+            continue;
+        }
+
+        char comparison[32] = "-";
+        const auto base = baseline.find(result.m_Name);
+        if (base != baseline.end() && base->second > 0.0)
+        {
+            const double change = (result.m_NsPerOp - base->second) / base->second * 100.0;
+            const bool regressed = change > threshold;
+            std::snprintf(comparison, sizeof(comparison), "%+.1f%%%s", change, regressed ? " SLOWER" : "");
+            regressions += regressed ? 1 : 0;
+        }
+
+        std::printf(
+            "%-40s %12.1f %12.1f %10.2f %14.0f %14.2f %16s\n",
+            result.m_Name.c_str(),
+            result.m_NsPerOp,
+            result.m_MinNsPerOp,
+            result.m_AllocationsPerOp,
+            result.m_ItemsPerSecond,
+            result.m_MegabytesPerSecond,
+            comparison
+        );
+        results.push_back(result);
+    }
+
+    ShutdownFrameArena();
+    ShutdownJobSystem();
+
+    if (jsonFile != nullptr && !SaveBenchmarkResults(jsonFile, results))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (regressions > 0)
+    {
+        std::printf("%u benchmarks are more than %.1f%% slower than the baseline.\n", regressions, threshold);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,361 @@
+// Turns a binary log written by a build with O3D_BINARY_LOG into text, see binary_log.h.
+// Usage: log_decoder <log.o3dlog> [output.txt]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "binary_log.h"
+#include "common.h"
+
+// Reads values out of the loaded file. Reading past the end sets m_Failed and returns zeros.
+struct BinaryLogReader
+{
+    const u8* m_Data;
+    size_t m_Size;
+    size_t m_Offset;
+    bool m_Failed;
+};
+
+template<typename T>
+static T ReadBinaryLogValue(BinaryLogReader& reader)
+{
+    T value = {};
+    if (reader.m_Offset + sizeof(T) > reader.m_Size)
+    {
+        reader.m_Failed = true;
+        reader.m_Offset = reader.m_Size;
+        return value;
+    }
+
+    std::memcpy(&value, reader.m_Data + reader.m_Offset, sizeof(T));
+    reader.m_Offset += sizeof(T);
+    return value;
+}
+
+static const u8* ReadBinaryLogBytes(BinaryLogReader& reader, const size_t size)
+{
+    if (reader.m_Offset + size > reader.m_Size)
+    {
+        reader.m_Failed = true;
+        reader.m_Offset = reader.m_Size;
+        return nullptr;
+    }
+
+    const u8* const bytes = reader.m_Data + reader.m_Offset;
+    reader.m_Offset += size;
+    return bytes;
+}
+
+static bool IsFloatConversion(const char conversion)
+{
+    return std::strchr("fFeEgGaA", conversion) != nullptr;
+}
+
+static bool IsSignedConversion(const char conversion)
+{
+    return conversion == 'd' || conversion == 'i';
+}
+
+// Formats one conversion of the format string. `spec` is everything from the '%' up to, but without, the length
+// modifier and the conversion character.
+static void FormatBinaryLogArg(std::string& out, std::string spec, const char conversion, BinaryLogReader& args)
+{
+    char text[1024];
+    text[0] = '\0';
+
+    const BinaryLogArgType type = scast<BinaryLogArgType>(ReadBinaryLogValue<u8>(args));
+    if (args.m_Failed)
+    {
+        out += "<missing>";
+        return;
+    }
+
+    switch (type)
+    {
+    case BinaryLogArgType::Int32:
+    case BinaryLogArgType::UInt32:
+    case BinaryLogArgType::Int64:
+    case BinaryLogArgType::UInt64:
+    {
+        const bool wide = type == BinaryLogArgType::Int64 || type == BinaryLogArgType::UInt64;
+        const bool isSigned = type == BinaryLogArgType::Int32 || type == BinaryLogArgType::Int64;
+        long long signedValue = 0;
+        unsigned long long unsignedValue = 0;
+        if (wide)
+        {
+            const u64 value = ReadBinaryLogValue<u64>(args);
+            signedValue = scast<long long>(scast<i64>(value));
+            unsignedValue = value;
+        }
+        else
+        {
+            const u32 value = ReadBinaryLogValue<u32>(args);
+            signedValue = isSigned ? scast<long long>(scast<i32>(value)) : scast<long long>(value);
+            unsignedValue = value;
+        }
+
+        if (IsFloatConversion(conversion))
+        {
+            spec += conversion;
+            std::snprintf(text, sizeof(text), spec.c_str(), isSigned ? double(signedValue) : double(unsignedValue));
+        }
+        else if (conversion == 'c')
+        {
+            spec += 'c';
+            std::snprintf(text, sizeof(text), spec.c_str(), scast<int>(signedValue));
+        }
+        else if (IsSignedConversion(conversion) || conversion == 's' || conversion == 'p')
+        {
+            spec += isSigned ? "lld" : "llu";
+            if (isSigned)
+            {
+                std::snprintf(text, sizeof(text), spec.c_str(), signedValue);
+            }
+            else
+            {
+                std::snprintf(text, sizeof(text), spec.c_str(), unsignedValue);
+            }
+        }
+        else
+        {
+            // Unsigned conversions (u, x, X, o) print the value with the width it was logged with.
+            spec += "ll";
+            spec += conversion;
+            const unsigned long long value = isSigned && !wide ? scast<u32>(signedValue) : unsignedValue;
+            std::snprintf(text, sizeof(text), spec.c_str(), value);
+        }
+    } break;
+
+    case BinaryLogArgType::Double:
+    {
+        const double value = ReadBinaryLogValue<double>(args);
+        spec += IsFloatConversion(conversion) ? conversion : 'g';
+        std::snprintf(text, sizeof(text), spec.c_str(), value);
+    } break;
+
+    case BinaryLogArgType::Pointer:
+    {
+        const u64 value = ReadBinaryLogValue<u64>(args);
+        std::snprintf(text, sizeof(text), "0x%016llx", scast<unsigned long long>(value));
+    } break;
+
+    case BinaryLogArgType::String:
+    {
+        const u16 length = ReadBinaryLogValue<u16>(args);
+        const u8* const bytes = ReadBinaryLogBytes(args, length);
+        const std::string value = bytes ? std::string(rcast<const char*>(bytes), length) : std::string();
+        spec += 's';
+        std::snprintf(text, sizeof(text), spec.c_str(), value.c_str());
+    } break;
+
+    default:
+    {
+        args.m_Failed = true;
+        std::snprintf(text, sizeof(text), "<bad argument type %u>", scast<u32>(type));
+    } break;
+    }
+
+    if (args.m_Failed)
+    {
+        out += "<missing>";
+        return;
+    }
+
+    out += text;
+}
+
+// Runs the printf format string over the encoded arguments.
+static std::string FormatBinaryLogMessage(const std::string& format, const u8* const data, const size_t size)
+{
+    BinaryLogReader args = { data, size, 0, false };
+    std::string result;
+
+    for (size_t i = 0; i < format.size(); ++i)
+    {
+        if (format[i] != '%')
+        {
+            result += format[i];
+            continue;
+        }
+
+        if (i + 1 < format.size() && format[i + 1] == '%')
+        {
+            result += '%';
+            ++i;
+            continue;
+        }
+
+        // Flags, width and precision are kept. A '*' takes its value from the next argument.
+        std::string spec = "%";
+        size_t j = i + 1;
+        for (; j < format.size() && std::strchr("-+ #0123456789.*", format[j]); ++j)
+        {
+            if (format[j] == '*')
+            {
+                BinaryLogReader star = args;
+                ReadBinaryLogValue<u8>(star);
+                spec += std::to_string(scast<i32>(ReadBinaryLogValue<u32>(star)));
+                args = star;
+            }
+            else
+            {
+                spec += format[j];
+            }
+        }
+
+        // The length modifiers are replaced by the width the argument was logged with.
+        while (j < format.size() && std::strchr("hlLqjzt", format[j]))
+        {
+            ++j;
+        }
+
+        if (j >= format.size())
+        {
+            result += spec;
+            break;
+        }
+
+        FormatBinaryLogArg(result, spec, format[j], args);
+        i = j;
+    }
+
+    return result;
+}
+
+static void WriteDecodedLine(
+    std::ostream& out,
+    const BinaryLogHeader& header,
+    const u64 time,
+    const u8 level,
+    const std::string& text
+)
+{
+    const i64 wallTime = header.m_WallStart + scast<i64>(time - header.m_SteadyStart);
+    const std::time_t seconds = scast<std::time_t>(wallTime / 1000000000);
+    const u32 milliseconds = scast<u32>((wallTime / 1000000) % 1000);
+
+    std::tm localTime = {};
+#if defined(_WIN32)
+    localtime_s(&localTime, &seconds);
+#else
+    localtime_r(&seconds, &localTime);
+#endif
+
+    char timestamp[32] = {};
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &localTime);
+
+    const char* const levelName = level == scast<u8>(Internal::LogLevel::ERROR) ? "ERROR"
+        : level == scast<u8>(Internal::LogLevel::INFO) ? "INFO"
+        : "UNKNOWN";
+
+    char prefix[64];
+    std::snprintf(prefix, sizeof(prefix), "[%s] %s.%03u: ", levelName, timestamp, milliseconds);
+    out << prefix << text << '\n';
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <log.o3dlog> [output.txt]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in)
+    {
+        std::fprintf(stderr, "Failed to open file: %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<u8> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    BinaryLogReader reader = { data.data(), data.size(), 0, false };
+
+    const BinaryLogHeader header = ReadBinaryLogValue<BinaryLogHeader>(reader);
+    if (reader.m_Failed || header.m_Magic != BINARY_LOG_MAGIC || header.m_Version != BINARY_LOG_VERSION)
+    {
+        std::fprintf(stderr, "Not a supported binary log: %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream outFile;
+    if (argc > 2)
+    {
+        outFile.open(argv[2], std::ios::binary);
+        if (!outFile)
+        {
+            std::fprintf(stderr, "Failed to open file for writing: %s.\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream& out = argc > 2 ? outFile : std::cout;
+
+    // Formats always come before their first use, so one pass is enough.
+    std::unordered_map<u64, std::string> formats;
+    u64 messageCount = 0;
+    while (reader.m_Offset < reader.m_Size && !reader.m_Failed)
+    {
+        const BinaryLogRecordType type = scast<BinaryLogRecordType>(ReadBinaryLogValue<u8>(reader));
+        switch (type)
+        {
+        case BinaryLogRecordType::Format:
+        {
+            const u64 id = ReadBinaryLogValue<u64>(reader);
+            const u32 length = ReadBinaryLogValue<u32>(reader);
+            const u8* const bytes = ReadBinaryLogBytes(reader, length);
+            if (bytes)
+            {
+                formats[id] = std::string(rcast<const char*>(bytes), length);
+            }
+        } break;
+
+        case BinaryLogRecordType::Message:
+        {
+            const u64 id = ReadBinaryLogValue<u64>(reader);
+            const u64 time = ReadBinaryLogValue<u64>(reader);
+            const u8 level = ReadBinaryLogValue<u8>(reader);
+            const u16 size = ReadBinaryLogValue<u16>(reader);
+            const u8* const args = ReadBinaryLogBytes(reader, size);
+            if (!args)
+            {
+                break;
+            }
+
+            const auto format = formats.find(id);
+            const std::string text = format != formats.end()
+                ? FormatBinaryLogMessage(format->second, args, size)
+                : "<unknown format " + std::to_string(id) + ">";
+            WriteDecodedLine(out, header, time, level, text);
+            messageCount++;
+        } break;
+
+        case BinaryLogRecordType::Dropped:
+        {
+            const u64 count = ReadBinaryLogValue<u64>(reader);
+            out << "[ERROR] " << count << " messages were dropped here.\n";
+        } break;
+
+        default:
+        {
+            std::fprintf(stderr, "Corrupt record at offset %zu, stopping.\n", reader.m_Offset - 1);
+            reader.m_Failed = true;
+        } break;
+        }
+    }
+
+    if (reader.m_Failed && reader.m_Offset >= reader.m_Size)
+    {
+        std::fprintf(stderr, "The log ends in the middle of a record, it was probably cut short.\n");
+    }
+
+    out.flush();
+    std::fprintf(stderr, "Decoded %llu messages.\n", scast<unsigned long long>(messageCount));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,390 @@
+// Checks of the scene queries, the entity storage and the mesh files against answers known by construction.
+// Usage: scene_tests
+// Every failed check is logged and the exit code is 1. Built by projects/scene_tests and by the CMake build, which
+// registers it with ctest.
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "common.h"
+#include "core/jobs.h"
+#include "ecs/ecs.h"
+#include "geometry/mesh.h"
+#include "scene/bounds.h"
+#include "scene/bvh.h"
+#include "scene/occlusion.h"
+#include "scene/transform.h"
+
+constexpr u32 SCENE_TEST_BOX_COUNT = 64; // Unit boxes along +X, 2 units apart.
+constexpr u32 SCENE_TEST_VIEW_COUNT = 64; // Camera positions around the occluders.
+constexpr u32 SCENE_TEST_GRID_SIDE = 9; // Vertices per side of the mesh written to a file.
+
+// A quad of 2x2 units in the XZ plane, like the engine's ground plane.
+constexpr float SCENE_TEST_QUAD_VERTICES[] =
+{
+    -1.0f, 0.0f,  1.0f,
+    -1.0f, 0.0f, -1.0f,
+     1.0f, 0.0f, -1.0f,
+     1.0f, 0.0f,  1.0f,
+};
+
+constexpr u32 SCENE_TEST_QUAD_INDICES[] =
+{
+    0, 1, 2,
+    0, 2, 3,
+};
+
+struct SceneTestSmallComponent
+{
+    u32 m_Value;
+};
+
+// A row of it with its entity can't fit in a chunk.
+struct SceneTestHugeComponent
+{
+    u8 m_Data[ECS_CHUNK_SIZE];
+};
+
+static u32 g_FailedChecks = 0;
+
+#define SCENE_CHECK(condition)                                                       \
+    do                                                                               \
+    {                                                                                \
+        if (!(condition))                                                            \
+        {                                                                            \
+            LOG_ERROR("%s:%d: check failed: %s", __FILE__, __LINE__, #condition);    \
+            ++g_FailedChecks;                                                        \
+        }                                                                            \
+    } while (false)
+
+static void CreateSceneTestBVH(BVH& outBVH)
+{
+    std::vector<AABB> bounds;
+    for (u32 i = 0; i < SCENE_TEST_BOX_COUNT; ++i)
+    {
+        const glm::vec3 center = glm::vec3(scast<float>(i) * 2.0f, 0.0f, 0.0f);
+        bounds.push_back({ center - glm::vec3(0.5f), center + glm::vec3(0.5f) });
+    }
+
+    BuildBVH(outBVH, bounds.data(), scast<u32>(bounds.size()));
+}
+
+static void TestRaycastBVH()
+{
+    BVH bvh;
+    CreateSceneTestBVH(bvh);
+
+    // Misses have to stay invalid, whatever the distance limit.
+    const BVHRayHit above = RaycastBVH(bvh, glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 100.0f);
+    SCENE_CHECK(above.m_Item == BVH_INVALID_INDEX);
+
+    const BVHRayHit aside = RaycastBVH(bvh, glm::vec3(-5.0f, 2.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), FLT_MAX);
+    SCENE_CHECK(aside.m_Item == BVH_INVALID_INDEX);
+
+    // Through the root's bounds but between two boxes.
+    const BVHRayHit between = RaycastBVH(bvh, glm::vec3(1.0f, 5.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), FLT_MAX);
+    SCENE_CHECK(between.m_Item == BVH_INVALID_INDEX);
+
+    const BVHRayHit tooShort = RaycastBVH(bvh, glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 1.0f);
+    SCENE_CHECK(tooShort.m_Item == BVH_INVALID_INDEX);
+
+    // Along the row, the first box is the closest.
+    const BVHRayHit along = RaycastBVH(bvh, glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 1000.0f);
+    SCENE_CHECK(along.m_Item == 0);
+    SCENE_CHECK(glm::abs(along.m_Distance - 4.5f) < 1e-4f);
+
+    // Backwards from the end of the row, the last one.
+    const glm::vec3 end = glm::vec3(scast<float>(SCENE_TEST_BOX_COUNT) * 2.0f, 0.0f, 0.0f);
+    const BVHRayHit back = RaycastBVH(bvh, end, glm::vec3(-1.0f, 0.0f, 0.0f), 1000.0f);
+    SCENE_CHECK(back.m_Item == SCENE_TEST_BOX_COUNT - 1);
+
+    // A hit exactly at the distance limit counts.
+    const BVHRayHit limit = RaycastBVH(bvh, glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 4.5f);
+    SCENE_CHECK(limit.m_Item == 0);
+
+    // Straight down onto box 10.
+    const BVHRayHit down = RaycastBVH(bvh, glm::vec3(20.0f, 5.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), 1000.0f);
+    SCENE_CHECK(down.m_Item == 10);
+
+    // Rays starting on a slab of a flat box, parallel to it, hit it the same on every axis.
+    const AABB flatBounds[] =
+    {
+        { glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(1.0f, 0.0f, 1.0f) },
+        { glm::vec3(9.0f, -1.0f, -1.0f), glm::vec3(9.0f, 1.0f, 1.0f) },
+    };
+    BVH flat;
+    BuildBVH(flat, flatBounds, 2);
+    const BVHRayHit alongX = RaycastBVH(flat, glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 1000.0f);
+    SCENE_CHECK(alongX.m_Item == 0 && glm::abs(alongX.m_Distance - 4.0f) < 1e-4f);
+    const BVHRayHit alongZ = RaycastBVH(flat, glm::vec3(0.0f, 0.0f, -5.0f), glm::vec3(0.0f, 0.0f, 1.0f), 1000.0f);
+    SCENE_CHECK(alongZ.m_Item == 0 && glm::abs(alongZ.m_Distance - 4.0f) < 1e-4f);
+    const BVHRayHit alongY = RaycastBVH(flat, glm::vec3(9.0f, -5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 1000.0f);
+    SCENE_CHECK(alongY.m_Item == 1 && glm::abs(alongY.m_Distance - 4.0f) < 1e-4f);
+    const BVHRayHit backZ = RaycastBVH(flat, glm::vec3(9.0f, 0.0f, 5.0f), glm::vec3(0.0f, 0.0f, -1.0f), 1000.0f);
+    SCENE_CHECK(backZ.m_Item == 1 && glm::abs(backZ.m_Distance - 4.0f) < 1e-4f);
+
+    // An empty hierarchy hits nothing.
+    BVH empty;
+    BuildBVH(empty, nullptr, 0);
+    const BVHRayHit none = RaycastBVH(empty, glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 1000.0f);
+    SCENE_CHECK(none.m_Item == BVH_INVALID_INDEX);
+}
+
+static void TestBVHNodeAlignment()
+{
+    BVH bvh;
+    CreateSceneTestBVH(bvh);
+
+    // The sibling pairs have to start on a cache line, see BVHNode.
+    SCENE_CHECK(rcast<uintptr_t>(bvh.m_Nodes.data()) % BVH_CACHE_LINE_SIZE == 0);
+}
+
+static glm::mat4 CreateSceneTestViewProjection(const glm::vec3& position, const glm::vec3& target)
+{
+    return glm::perspective(glm::radians(45.0f), 2.0f, 0.1f, 100.0f)
+        * glm::lookAt(position, target, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+static void TestOcclusion()
+{
+    OcclusionBuffer buffer;
+
+    // An occluder never hides itself, from wherever the ground plane is seen. The plane stays in front of the near
+    // plane, boxes crossing it are never tested.
+    const glm::mat4 groundModel = glm::scale(glm::mat4(1.0f), glm::vec3(5.0f, 1.0f, 5.0f));
+    const AABB groundBounds = { glm::vec3(-5.0f, 0.0f, -5.0f), glm::vec3(5.0f, 0.0f, 5.0f) };
+    u32 hiddenGroundViews = 0;
+    for (u32 view = 0; view < SCENE_TEST_VIEW_COUNT; ++view)
+    {
+        const float angle = scast<float>(view) / SCENE_TEST_VIEW_COUNT * glm::two_pi<float>();
+        const float height = 0.5f + scast<float>(view % 8);
+        const glm::vec3 position = glm::vec3(std::cos(angle) * 15.0f, height, std::sin(angle) * 15.0f);
+
+        BeginOcclusionFrame(buffer, CreateSceneTestViewProjection(position, glm::vec3(0.0f)));
+        AddOccluder(buffer, SCENE_TEST_QUAD_VERTICES, 3, SCENE_TEST_QUAD_INDICES, 6, groundModel);
+        RasterizeOccluders(buffer);
+        hiddenGroundViews += IsOccluded(buffer, groundBounds) ? 1 : 0;
+    }
+    SCENE_CHECK(hiddenGroundViews == 0);
+
+    // A wall facing the camera hides a box behind it, but not one in front of it.
+    const glm::mat4 wallModel = glm::rotate(
+        glm::scale(glm::mat4(1.0f), glm::vec3(5.0f, 5.0f, 1.0f)),
+        glm::half_pi<float>(),
+        glm::vec3(1.0f, 0.0f, 0.0f)
+    );
+    BeginOcclusionFrame(buffer, CreateSceneTestViewProjection(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f)));
+    AddOccluder(buffer, SCENE_TEST_QUAD_VERTICES, 3, SCENE_TEST_QUAD_INDICES, 6, wallModel);
+    RasterizeOccluders(buffer);
+
+    SCENE_CHECK(IsOccluded(buffer, { glm::vec3(-0.5f, -0.5f, -5.5f), glm::vec3(0.5f, 0.5f, -4.5f) }));
+    SCENE_CHECK(!IsOccluded(buffer, { glm::vec3(-0.5f, -0.5f, 4.5f), glm::vec3(0.5f, 0.5f, 5.5f) }));
+    SCENE_CHECK(!IsOccluded(buffer, { glm::vec3(-5.0f, -5.0f, 0.0f), glm::vec3(5.0f, 5.0f, 0.0f) }));
+}
+
+static void TestOversizedComponent()
+{
+    static const SceneTestHugeComponent huge = {};
+    World world;
+
+    const Entity entity = CreateEntityWith(world, SceneTestSmallComponent{ 7 });
+    const size_t archetypeCount = world.m_Archetypes.size();
+
+    // Creating the entity fails every time, and no archetype is left behind to be written past.
+    for (u32 i = 0; i < 4; ++i)
+    {
+        SCENE_CHECK(CreateEntityWith(world, huge) == NULL_ENTITY);
+        SCENE_CHECK(CreateEntity(world, MakeComponentMask<SceneTestSmallComponent, SceneTestHugeComponent>())
+            == NULL_ENTITY);
+    }
+    SCENE_CHECK(world.m_Archetypes.size() == archetypeCount);
+
+    // Adding the component fails and leaves the entity as it was.
+    SCENE_CHECK(AddComponent(world, entity, huge) == nullptr);
+    SCENE_CHECK(IsEntityAlive(world, entity));
+    SCENE_CHECK(GetComponent<SceneTestHugeComponent>(world, entity) == nullptr);
+    const SceneTestSmallComponent* const small = GetComponent<SceneTestSmallComponent>(world, entity);
+    SCENE_CHECK(small != nullptr && small->m_Value == 7);
+
+    DestroyWorld(world);
+}
+
+static bool AreSceneTestMatricesEqual(const glm::mat4& a, const glm::mat4& b)
+{
+    for (u32 column = 0; column < 4; ++column)
+    {
+        for (u32 row = 0; row < 4; ++row)
+        {
+            // Also false for NaN.
+            if (!(std::abs(a[column][row] - b[column][row]) < 1e-4f))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Updates the node from `from` to `to` and returns the matrix halfway between the two updates.
+static glm::mat4 InterpolateSceneTestScale(const glm::vec3& from, const glm::vec3& to, glm::mat4& outCurrent)
+{
+    TransformHierarchy hierarchy;
+    const glm::quat rotation = glm::angleAxis(0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+    const u32 node = CreateTransform(hierarchy, TRANSFORM_NO_PARENT, glm::vec3(1.0f, 2.0f, 3.0f), rotation, from);
+    UpdateWorldMatrices(hierarchy);
+
+    SetLocalScale(hierarchy, node, to);
+    SetLocalRotation(hierarchy, node, glm::angleAxis(1.0f, glm::vec3(0.0f, 1.0f, 0.0f)));
+    UpdateWorldMatrices(hierarchy);
+
+    outCurrent = GetWorldMatrix(hierarchy, node);
+    return GetInterpolatedWorldMatrix(hierarchy, node, 0.5f);
+}
+
+// True when the halfway matrix is the current one, i.e. the node wasn't interpolated.
+static bool SnapsToCurrentScale(const glm::vec3& from, const glm::vec3& to)
+{
+    glm::mat4 current;
+    const glm::mat4 halfway = InterpolateSceneTestScale(from, to, current);
+    return AreSceneTestMatricesEqual(halfway, current);
+}
+
+static void TestInterpolatedTransforms()
+{
+    // Scaling a node to 0 hides it right away instead of producing NaNs.
+    SCENE_CHECK(SnapsToCurrentScale(glm::vec3(1.0f), glm::vec3(0.0f, 1.0f, 1.0f)));
+    SCENE_CHECK(SnapsToCurrentScale(glm::vec3(1.0f, 0.0f, 1.0f), glm::vec3(1.0f)));
+
+    // Turning mirrored can't be interpolated either.
+    SCENE_CHECK(SnapsToCurrentScale(glm::vec3(1.0f), glm::vec3(-1.0f, 1.0f, 1.0f)));
+    SCENE_CHECK(SnapsToCurrentScale(glm::vec3(1.0f, 1.0f, -1.0f), glm::vec3(1.0f)));
+
+    // Mirrored on both ends blends like any other node and stays mirrored.
+    glm::mat4 current;
+    const glm::mat4 mirrored = InterpolateSceneTestScale(
+        glm::vec3(-1.0f, 1.0f, 1.0f),
+        glm::vec3(-3.0f, 1.0f, 1.0f),
+        current
+    );
+    const glm::mat4 expected = glm::scale(
+        glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f)), 0.75f, glm::vec3(0.0f, 1.0f, 0.0f)),
+        glm::vec3(-2.0f, 1.0f, 1.0f)
+    );
+    SCENE_CHECK(AreSceneTestMatricesEqual(mirrored, expected));
+}
+
+static bool AreSceneTestMeshesEqual(const LODMesh& a, const LODMesh& b)
+{
+    if (a.m_Stride != b.m_Stride || a.m_VertexCount != b.m_VertexCount || a.m_Vertices != b.m_Vertices
+        || a.m_Indices != b.m_Indices || a.m_LODs.size() != b.m_LODs.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.m_LODs.size(); ++i)
+    {
+        if (a.m_LODs[i].m_IndexOffset != b.m_LODs[i].m_IndexOffset
+            || a.m_LODs[i].m_IndexCount != b.m_LODs[i].m_IndexCount
+            || a.m_LODs[i].m_Error != b.m_LODs[i].m_Error)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void TestMeshFiles()
+{
+    // A flat grid with texture coordinates, which simplifies into a few LODs.
+    std::vector<float> vertices;
+    std::vector<u32> indices;
+    for (u32 z = 0; z < SCENE_TEST_GRID_SIDE; ++z)
+    {
+        for (u32 x = 0; x < SCENE_TEST_GRID_SIDE; ++x)
+        {
+            const float u = scast<float>(x) / (SCENE_TEST_GRID_SIDE - 1);
+            const float v = scast<float>(z) / (SCENE_TEST_GRID_SIDE - 1);
+            vertices.insert(vertices.end(), { u * 2.0f - 1.0f, 0.0f, v * 2.0f - 1.0f, u, v });
+
+            if (x + 1 < SCENE_TEST_GRID_SIDE && z + 1 < SCENE_TEST_GRID_SIDE)
+            {
+                const u32 corner = z * SCENE_TEST_GRID_SIDE + x;
+                const u32 below = corner + SCENE_TEST_GRID_SIDE;
+                indices.insert(indices.end(), { corner, below, corner + 1, corner + 1, below, below + 1 });
+            }
+        }
+    }
+
+    const LODMesh mesh = BuildMeshLODs(
+        vertices.data(),
+        SCENE_TEST_GRID_SIDE * SCENE_TEST_GRID_SIDE,
+        5,
+        indices.data(),
+        scast<u32>(indices.size()),
+        MESH_MAX_LODS,
+        0.5f,
+        nullptr
+    );
+    SCENE_CHECK(mesh.m_LODs.size() > 1);
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "scene_tests.o3dmesh";
+    const std::string fileName = path.string();
+
+    // What is saved loads back the same.
+    LODMesh loaded;
+    SCENE_CHECK(SaveMeshFile(fileName.c_str(), mesh));
+    SCENE_CHECK(LoadMeshFile(fileName.c_str(), loaded));
+    SCENE_CHECK(AreSceneTestMeshesEqual(mesh, loaded));
+
+    // A truncated file is rejected.
+    const std::uintmax_t size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - sizeof(MeshLOD));
+    SCENE_CHECK(!LoadMeshFile(fileName.c_str(), loaded));
+
+    // So are indices and LOD ranges outside of the mesh, they would end up in draw calls.
+    LODMesh badIndex = mesh;
+    badIndex.m_Indices.back() = badIndex.m_VertexCount;
+    SCENE_CHECK(SaveMeshFile(fileName.c_str(), badIndex));
+    SCENE_CHECK(!LoadMeshFile(fileName.c_str(), loaded));
+
+    LODMesh badRange = mesh;
+    badRange.m_LODs.back().m_IndexCount += 3;
+    SCENE_CHECK(SaveMeshFile(fileName.c_str(), badRange));
+    SCENE_CHECK(!LoadMeshFile(fileName.c_str(), loaded));
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+}
+
+int main()
+{
+    InitializeJobSystem(0);
+
+    TestRaycastBVH();
+    TestBVHNodeAlignment();
+    TestOcclusion();
+    TestOversizedComponent();
+    TestInterpolatedTransforms();
+    TestMeshFiles();
+
+    ShutdownJobSystem();
+
+    if (g_FailedChecks > 0)
+    {
+        std::printf("%u scene checks failed.\n", g_FailedChecks);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("All scene checks passed.\n");
+    return EXIT_SUCCESS;
+}
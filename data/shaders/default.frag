@@ -15,29 +15,78 @@ out vec4 FragColor;
 // Which texture units to use, specified from C++.
 uniform sampler2D tex0;
 uniform sampler2D tex1;
-// Color of the light, specified from C++.
-uniform vec4 lightColor;
-// Position of the light, specified from C++.
-uniform vec3 lightPos;
 // Position of the camera, specified from C++.
 uniform vec3 camPos;
 
+// Clustered lighting, see graphics/clustered_lighting.h.
+struct PointLight
+{
+    vec4 positionRadius;  // World space position, and the distance past which the light has no effect.
+    vec4 colorIntensity;
+};
+
+layout (std430, binding = 0) readonly buffer ClusterLights { PointLight lights[]; };
+layout (std430, binding = 1) readonly buffer ClusterRecords { uvec2 clusters[]; }; // Offset and light count.
+layout (std430, binding = 2) readonly buffer ClusterIndices { uint lightIndices[]; };
+
+uniform uvec3 clusterGrid;
+uniform vec2 clusterScreenSize;
+uniform float clusterDepthScale;
+uniform float clusterDepthBias;
+uniform float clusterNear;
+uniform float clusterFar;
+
+// View space depth of the fragment.
+float LinearDepth()
+{
+    float ndc = gl_FragCoord.z * 2.0f - 1.0f;
+    return 2.0f * clusterNear * clusterFar / (clusterFar + clusterNear - ndc * (clusterFar - clusterNear));
+}
+
+uint ClusterIndex()
+{
+    uvec2 tile = uvec2(clamp(gl_FragCoord.xy / clusterScreenSize * vec2(clusterGrid.xy), vec2(0.0f), vec2(clusterGrid.xy - 1u)));
+    uint slice = uint(clamp(log(LinearDepth()) * clusterDepthScale + clusterDepthBias, 0.0f, float(clusterGrid.z - 1u)));
+    return (slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;
+}
+
 void main()
 {
+    vec4 albedo = texture(tex0, texCoord);
+    float specularMap = texture(tex1, texCoord).r;
+
     // Ambient lighting.
     float ambient = 0.20f;
+    float specularLight = 0.50f;
 
-    // Diffuse lighting.
     vec3 myNormal = normalize(normal);
-    vec3 lightDir = normalize(lightPos - currPos);
-    float diffuse = max(dot(normal, lightDir), 0.0f);
-
-    // Specular lighting
-    float specularLight = 0.50f;
     vec3 viewDir = normalize(camPos - currPos);
-    vec3 reflectionDir = reflect(-lightDir, myNormal);
-    float specAmount = pow(max(dot(viewDir, reflectionDir), 0.0f), 16);
-    float specular = specAmount * specularLight;
 
-    FragColor = (texture(tex0, texCoord) * (diffuse + ambient) + texture(tex1, texCoord).r * specular) * lightColor;
+    vec3 result = albedo.rgb * ambient;
+
+    // Only the lights of the cluster can reach the fragment.
+    uvec2 cluster = clusters[ClusterIndex()];
+    for (uint i = 0u; i < cluster.y; ++i)
+    {
+        PointLight light = lights[lightIndices[cluster.x + i]];
+
+        vec3 toLight = light.positionRadius.xyz - currPos;
+        float distance = length(toLight);
+        float falloff = clamp(1.0f - pow(distance / light.positionRadius.w, 4.0f), 0.0f, 1.0f);
+        falloff *= falloff;
+
+        // Diffuse lighting.
+        vec3 lightDir = toLight / max(distance, 0.0001f);
+        float diffuse = max(dot(myNormal, lightDir), 0.0f);
+
+        // Specular lighting.
+        vec3 reflectionDir = reflect(-lightDir, myNormal);
+        float specAmount = pow(max(dot(viewDir, reflectionDir), 0.0f), 16);
+        float specular = specAmount * specularLight;
+
+        vec3 radiance = light.colorIntensity.rgb * light.colorIntensity.a * falloff;
+        result += (albedo.rgb * diffuse + specularMap * specular) * radiance;
+    }
+
+    FragColor = vec4(result, albedo.a);
 }
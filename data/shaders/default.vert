@@ -10,10 +10,10 @@ out vec2 texCoord; // Output a texture coordinate for the fragment shader.
 out vec3 normal; // Output the normal for the fragment shader.
 out vec3 currPos; // Output the current position for the fragment shader.
 
-// Input camera matrix (which is the view + projection matrix) from C++.
-uniform mat4 camMatrix;
-// Input model matrix from C++.
-uniform mat4 model;
+// Input camera matrix (which is the view + projection matrix) from C++, the same for the whole frame.
+layout (std140, binding = 0) uniform FrameUniforms { mat4 camMatrix; };
+// Input model matrix from C++, one block per draw.
+layout (std140, binding = 1) uniform DrawUniforms { mat4 model; };
 
 void main()
 {
@@ -0,0 +1,115 @@
+#version 440 core
+
+// Lighting pass of the deferred path, one fragment per pixel. Shades the G-buffer written by gbuffer.frag with the
+// lights of the pixel's cluster, the same lists and lighting as default.frag.
+
+out vec4 FragColor;
+
+// G-buffer targets, see graphics/gbuffer.h.
+layout (binding = 0) uniform sampler2D gNormal;
+layout (binding = 1) uniform sampler2D gAlbedoSpec;
+layout (binding = 2) uniform sampler2D gDepth;
+
+// Position of the camera, specified from C++.
+uniform vec3 camPos;
+// Inverse of the view + projection matrix, rebuilds the position from the depth.
+uniform mat4 invCamMatrix;
+
+// Clustered lighting, see graphics/clustered_lighting.h.
+struct PointLight
+{
+    vec4 positionRadius;  // World space position, and the distance past which the light has no effect.
+    vec4 colorIntensity;
+};
+
+layout (std430, binding = 0) readonly buffer ClusterLights { PointLight lights[]; };
+layout (std430, binding = 1) readonly buffer ClusterRecords { uvec2 clusters[]; }; // Offset and light count.
+layout (std430, binding = 2) readonly buffer ClusterIndices { uint lightIndices[]; };
+
+uniform uvec3 clusterGrid;
+uniform vec2 clusterScreenSize;
+uniform float clusterDepthScale;
+uniform float clusterDepthBias;
+uniform float clusterNear;
+uniform float clusterFar;
+
+// View space depth of a depth buffer value.
+float LinearDepth(float depth)
+{
+    float ndc = depth * 2.0f - 1.0f;
+    return 2.0f * clusterNear * clusterFar / (clusterFar + clusterNear - ndc * (clusterFar - clusterNear));
+}
+
+uint ClusterIndex(float depth)
+{
+    uvec2 tile = uvec2(clamp(gl_FragCoord.xy / clusterScreenSize * vec2(clusterGrid.xy), vec2(0.0f), vec2(clusterGrid.xy - 1u)));
+    uint slice = uint(clamp(log(LinearDepth(depth)) * clusterDepthScale + clusterDepthBias, 0.0f, float(clusterGrid.z - 1u)));
+    return (slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;
+}
+
+// Inverse of EncodeOctahedral() in gbuffer.frag.
+vec3 DecodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0f);
+    n.xy += vec2(n.x >= 0.0f ? -t : t, n.y >= 0.0f ? -t : t);
+    return normalize(n);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+
+    // Nothing was drawn here, keep the clear color.
+    if (depth == 1.0f)
+    {
+        discard;
+    }
+
+    vec4 albedoSpec = texelFetch(gAlbedoSpec, pixel, 0);
+    vec3 albedo = albedoSpec.rgb;
+    float specularMap = albedoSpec.a;
+    vec3 myNormal = DecodeOctahedral(texelFetch(gNormal, pixel, 0).xy * 2.0f - 1.0f);
+
+    vec4 clipPos = vec4(gl_FragCoord.xy / clusterScreenSize * 2.0f - 1.0f, depth * 2.0f - 1.0f, 1.0f);
+    vec4 worldPos = invCamMatrix * clipPos;
+    vec3 currPos = worldPos.xyz / worldPos.w;
+
+    // Ambient lighting.
+    float ambient = 0.20f;
+    float specularLight = 0.50f;
+
+    vec3 viewDir = normalize(camPos - currPos);
+
+    vec3 result = albedo * ambient;
+
+    // Only the lights of the cluster can reach the pixel.
+    uvec2 cluster = clusters[ClusterIndex(depth)];
+    for (uint i = 0u; i < cluster.y; ++i)
+    {
+        PointLight light = lights[lightIndices[cluster.x + i]];
+
+        vec3 toLight = light.positionRadius.xyz - currPos;
+        float distance = length(toLight);
+        float falloff = clamp(1.0f - pow(distance / light.positionRadius.w, 4.0f), 0.0f, 1.0f);
+        falloff *= falloff;
+
+        // Diffuse lighting.
+        vec3 lightDir = toLight / max(distance, 0.0001f);
+        float diffuse = max(dot(myNormal, lightDir), 0.0f);
+
+        // Specular lighting.
+        vec3 reflectionDir = reflect(-lightDir, myNormal);
+        float specAmount = pow(max(dot(viewDir, reflectionDir), 0.0f), 16);
+        float specular = specAmount * specularLight;
+
+        vec3 radiance = light.colorIntensity.rgb * light.colorIntensity.a * falloff;
+        result += (albedo * diffuse + specularMap * specular) * radiance;
+    }
+
+    FragColor = vec4(result, 1.0f);
+
+    // Forward draws after this pass, like the light cube, are depth tested against the scene.
+    gl_FragDepth = depth;
+}
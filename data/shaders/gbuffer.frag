@@ -0,0 +1,32 @@
+#version 440 core
+
+// Geometry pass of the deferred path, see graphics/gbuffer.h. Runs after default.vert.
+
+// Input a texture coordinate from the vertex shader.
+in vec2 texCoord;
+// Input a normal from the vertex shader.
+in vec3 normal;
+
+// Octahedral normal, remapped to [0, 1].
+layout (location = 0) out vec2 NormalOut;
+// Albedo in rgb, specular intensity in a.
+layout (location = 1) out vec4 AlbedoSpecOut;
+
+// Which texture units to use, specified from C++.
+uniform sampler2D tex0;
+uniform sampler2D tex1;
+
+// Folds the unit sphere onto the [-1, 1] square: the upper half is projected onto the octahedron, the lower half is
+// mirrored into the corners.
+vec2 EncodeOctahedral(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 signs = vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+    return n.z >= 0.0f ? n.xy : (1.0f - abs(n.yx)) * signs;
+}
+
+void main()
+{
+    NormalOut = EncodeOctahedral(normalize(normal)) * 0.5f + 0.5f;
+    AlbedoSpecOut = vec4(texture(tex0, texCoord).rgb, texture(tex1, texCoord).r);
+}
@@ -2,8 +2,8 @@
 
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 model;
-uniform mat4 camMatrix;
+layout (std140, binding = 0) uniform FrameUniforms { mat4 camMatrix; };
+layout (std140, binding = 1) uniform DrawUniforms { mat4 model; };
 
 void main()
 {